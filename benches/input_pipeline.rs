@@ -0,0 +1,221 @@
+//! Benchmarks for the input → keylog pipeline
+//!
+//! The agent is a binary-only crate, so the pure data-path modules are mounted
+//! here by path rather than imported from a library target. Covered stages, on
+//! synthetic high-rate mouse traces with interleaved typing:
+//! - evdev translation (`EventCoalescer::feed`, Linux only)
+//! - `InputEvent` msgpack serialization
+//! - the segment journal: buffer drain + append per flush, then the single
+//!   read-back at rotation (the I/O behind `flush_event_buffer` /
+//!   `collect_segment_events`) for a 1-hour segment
+//! - keylog encoding of a segment's events, as persisted at rotation for upload
+//!
+//! Run with `cargo bench --bench input_pipeline`.
+
+#![allow(dead_code)]
+
+#[cfg(target_os = "linux")]
+#[path = "../src/input/coalescer.rs"]
+mod coalescer;
+#[path = "../src/data/mod.rs"]
+mod data;
+#[cfg(target_os = "linux")]
+#[path = "../src/input/policy.rs"]
+mod policy;
+
+use std::hint::black_box;
+
+use criterion::{criterion_group, criterion_main, BatchSize, Criterion, Throughput};
+use data::{
+    EventJournal, EventType, InputEvent, InputEventBuffer, KeyEvent, KeylogFormat, MouseMoveEvent,
+};
+
+/// Events the engine drains to the journal per flush (its buffer threshold)
+const FLUSH_EVERY: usize = 10_000;
+
+/// A gaming-mouse trace at `mouse_hz` for `secs`, with a keystroke pair about
+/// every 150 ms. Deltas wander deterministically so encoders see realistic
+/// (not constant) values.
+fn synthetic_trace(secs: u64, mouse_hz: u64) -> Vec<InputEvent> {
+    let step_us = 1_000_000 / mouse_hz;
+    let total = secs * mouse_hz;
+    let mut events = Vec::with_capacity(total as usize + total as usize / 75);
+    let mut seed: u32 = 0x9e37_79b9;
+    for i in 0..total {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        let timestamp_us = i * step_us;
+        events.push(InputEvent {
+            timestamp_us,
+            event: EventType::MouseMove(MouseMoveEvent {
+                delta_x: f64::from((seed % 15) as i32 - 7),
+                delta_y: f64::from(((seed >> 8) % 9) as i32 - 4),
+            }),
+        });
+        if timestamp_us % 150_000 < step_us {
+            let key = KeyEvent {
+                code: seed % 26,
+                name: format!("Key{}", (b'A' + (seed % 26) as u8) as char),
+            };
+            events.push(InputEvent {
+                timestamp_us,
+                event: EventType::KeyPress(key.clone()),
+            });
+            events.push(InputEvent {
+                timestamp_us: timestamp_us + 40,
+                event: EventType::KeyRelease(key),
+            });
+        }
+    }
+    events
+}
+
+#[cfg(target_os = "linux")]
+fn bench_coalescer(c: &mut Criterion) {
+    use evdev::{InputEventKind, Key, RelativeAxisType, Synchronization};
+
+    // 10 s of a 1 kHz mouse as raw evdev packets (REL_X, REL_Y, SYN_REPORT),
+    // with a key press/release every 150 packets.
+    let mut packets: Vec<(InputEventKind, i32)> = Vec::new();
+    for i in 0..10_000i32 {
+        packets.push((InputEventKind::RelAxis(RelativeAxisType::REL_X), i % 7 - 3));
+        packets.push((InputEventKind::RelAxis(RelativeAxisType::REL_Y), i % 5 - 2));
+        packets.push((
+            InputEventKind::Synchronization(Synchronization::SYN_REPORT),
+            0,
+        ));
+        if i % 150 == 0 {
+            packets.push((InputEventKind::Key(Key::KEY_A), 1));
+            packets.push((InputEventKind::Key(Key::KEY_A), 0));
+        }
+    }
+
+    let mut group = c.benchmark_group("coalescer");
+    group.throughput(Throughput::Elements(packets.len() as u64));
+    group.bench_function("feed_1khz_10s", |b| {
+        let mut out = Vec::with_capacity(4);
+        b.iter(|| {
+            let mut coalescer = coalescer::EventCoalescer::default();
+            let mut emitted = 0usize;
+            for &(kind, value) in &packets {
+                out.clear();
+                coalescer.feed(kind, value, policy::PolicySnapshot::ALL, &mut out);
+                emitted += out.len();
+            }
+            black_box(emitted)
+        })
+    });
+    group.finish();
+}
+
+#[cfg(not(target_os = "linux"))]
+fn bench_coalescer(_c: &mut Criterion) {}
+
+fn bench_serialization(c: &mut Criterion) {
+    // One flush worth of events at 1 kHz
+    let events = synthetic_trace(10, 1_000);
+
+    let mut group = c.benchmark_group("serialize");
+    group.throughput(Throughput::Elements(events.len() as u64));
+    group.bench_function("msgpack_event_each", |b| {
+        b.iter(|| {
+            let mut bytes = 0usize;
+            for event in &events {
+                bytes += rmp_serde::to_vec(event).unwrap().len();
+            }
+            black_box(bytes)
+        })
+    });
+    group.bench_function("msgpack_batch", |b| {
+        b.iter(|| black_box(rmp_serde::to_vec(&events).unwrap()))
+    });
+    group.finish();
+}
+
+fn bench_journal(c: &mut Criterion) {
+    let rt = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .unwrap();
+    let dir = std::env::temp_dir().join(format!("cc-bench-{}", std::process::id()));
+    std::fs::create_dir_all(&dir).unwrap();
+    let path = dir.join("input_bench.journal");
+
+    // 1-hour segment at a 250 Hz average mouse rate (~0.9M events)
+    let segment = synthetic_trace(3600, 250);
+
+    let mut group = c.benchmark_group("journal_1h");
+    group.sample_size(10);
+    group.throughput(Throughput::Elements(segment.len() as u64));
+
+    group.bench_function("flush", |b| {
+        b.iter_batched(
+            || segment.clone(),
+            |events| {
+                rt.block_on(async {
+                    let mut journal = EventJournal::create(path.clone()).await.unwrap();
+                    let mut buffer = InputEventBuffer::new();
+                    for event in events {
+                        buffer.push(event);
+                        if buffer.len() >= FLUSH_EVERY {
+                            journal.append(&buffer.drain()).await.unwrap();
+                        }
+                    }
+                    journal.append(&buffer.drain()).await.unwrap();
+                    journal.sync().await.unwrap();
+                })
+            },
+            BatchSize::LargeInput,
+        )
+    });
+
+    // Leave a full journal behind for the read-back benchmark
+    rt.block_on(async {
+        let mut journal = EventJournal::create(path.clone()).await.unwrap();
+        for batch in segment.chunks(FLUSH_EVERY) {
+            journal.append(batch).await.unwrap();
+        }
+        journal.sync().await.unwrap();
+    });
+    group.bench_function("collect", |b| {
+        b.iter(|| {
+            let mut events = rt.block_on(EventJournal::read_all(&path)).unwrap();
+            // collect_segment_events only sorts when an inversion exists
+            if events
+                .windows(2)
+                .any(|w| w[0].timestamp_us > w[1].timestamp_us)
+            {
+                events.sort_by_key(|e| e.timestamp_us);
+            }
+            black_box(events.len())
+        })
+    });
+    group.finish();
+
+    let _ = std::fs::remove_dir_all(&dir);
+}
+
+fn bench_keylog_encode(c: &mut Criterion) {
+    // A 5-minute segment's events, the default upload unit
+    let events = synthetic_trace(300, 500);
+
+    let mut group = c.benchmark_group("keylog_encode_5min");
+    group.sample_size(20);
+    group.throughput(Throughput::Elements(events.len() as u64));
+    for format in [KeylogFormat::Msgpack, KeylogFormat::Columnar] {
+        group.bench_function(format.extension(), |b| {
+            b.iter(|| black_box(format.encode(&events).unwrap()))
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(
+    benches,
+    bench_coalescer,
+    bench_serialization,
+    bench_journal,
+    bench_keylog_encode
+);
+criterion_main!(benches);
@@ -3,7 +3,8 @@
 // Exposes the focused window's (pid, wm_class, title) on a private session-bus name
 // `org.crowdcast.FocusProvider` at `/org/crowdcast/FocusProvider`, plus a `FocusChanged`
 // signal. crowd-cast uses this only to gate input capture (record input only while a
-// configured target app is focused). It performs NO actions on windows, no network, no UI.
+// configured target app is focused), and a `GeometryChanged` signal so it can cache the
+// focused window's geometry between moves. It performs NO actions on windows, no network, no UI.
 //
 // Defensive by design: every shell callback is wrapped so a fault here can never throw
 // into gnome-shell (a crash would take down the whole Wayland session). GNOME 45+ (ESM).
@@ -11,6 +12,7 @@
 import Gio from 'gi://Gio';
 import GLib from 'gi://GLib';
 import {Extension} from 'resource:///org/gnome/shell/extensions/extension.js';
+import * as Main from 'resource:///org/gnome/shell/ui/main.js';
 
 const BUS_NAME = 'org.crowdcast.FocusProvider';
 const OBJ_PATH = '/org/crowdcast/FocusProvider';
@@ -45,6 +47,9 @@ const IFACE = `
       <arg type="s" name="wm_class"/>
       <arg type="s" name="title"/>
     </signal>
+    <signal name="GeometryChanged">
+      <arg type="t" name="window_id"/>
+    </signal>
   </interface>
 </node>`;
 
@@ -57,7 +62,13 @@ export default class CrowdCastFocusExtension extends Extension {
                 Gio.BusType.SESSION, BUS_NAME, Gio.BusNameOwnerFlags.NONE,
                 null, null, null);
             this._focusId = global.display.connect(
-                'notify::focus-window', () => this._emit());
+                'notify::focus-window', () => {
+                    this._trackGeometry();
+                    this._emit();
+                });
+            this._monitorsId = Main.layoutManager.connect(
+                'monitors-changed', () => this._emitGeometry());
+            this._trackGeometry();
             this._emit();
         } catch (e) {
             logError(e, 'crowd-cast-focus: enable failed');
@@ -71,6 +82,11 @@ export default class CrowdCastFocusExtension extends Extension {
                 global.display.disconnect(this._focusId);
                 this._focusId = null;
             }
+            if (this._monitorsId) {
+                Main.layoutManager.disconnect(this._monitorsId);
+                this._monitorsId = null;
+            }
+            this._untrackGeometry();
             if (this._nameId) {
                 Gio.bus_unown_name(this._nameId);
                 this._nameId = 0;
@@ -175,6 +191,45 @@ export default class CrowdCastFocusExtension extends Extension {
         }
     }
 
+    // Follow the focused window's frame so crowd-cast can serve its GetWindowGeometry answer
+    // from a cache until this signals, instead of calling it every poll. Only the focused
+    // window is tracked: the per-app capture fit follows focus, and a focus change already
+    // invalidates crowd-cast's cache via FocusChanged.
+    _trackGeometry() {
+        try {
+            this._untrackGeometry();
+            const w = global.display.focus_window;
+            if (!w)
+                return;
+            this._geomWindow = w;
+            this._geomIds = [
+                w.connect('position-changed', () => this._emitGeometry()),
+                w.connect('size-changed', () => this._emitGeometry()),
+            ];
+        } catch (e) {
+            logError(e, 'crowd-cast-focus: geometry tracking failed');
+        }
+    }
+
+    _untrackGeometry() {
+        try {
+            for (const id of this._geomIds ?? [])
+                this._geomWindow.disconnect(id);
+        } catch (e) {} // the window may already be gone
+        this._geomWindow = null;
+        this._geomIds = null;
+    }
+
+    _emitGeometry() {
+        try {
+            let id = 0;
+            try { id = this._geomWindow?.get_id() || 0; } catch (e) {}
+            this._impl?.emit_signal('GeometryChanged', new GLib.Variant('(t)', [id]));
+        } catch (e) {
+            logError(e, 'crowd-cast-focus: emit failed');
+        }
+    }
+
     _emit() {
         try {
             const [id, pid, cls, title] = this._focused();
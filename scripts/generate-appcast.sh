@@ -14,6 +14,7 @@ CHANNEL="${CROWD_CAST_SPARKLE_CHANNEL:-}"
 PHASED_ROLLOUT_INTERVAL="${CROWD_CAST_SPARKLE_PHASED_ROLLOUT_INTERVAL:-}"
 CRITICAL_UPDATE_VERSION="${CROWD_CAST_SPARKLE_CRITICAL_UPDATE_VERSION:-}"
 OUTPUT_NAME="${CROWD_CAST_SPARKLE_APPCAST_NAME:-appcast.xml}"
+MAXIMUM_DELTAS="${CROWD_CAST_SPARKLE_MAXIMUM_DELTAS:-}"
 EMBED_RELEASE_NOTES=0
 
 usage() {
@@ -32,6 +33,8 @@ Options:
   --critical-update-version <ver>   Mark the update as critical for older versions
   --embed-release-notes             Always embed release notes in the appcast
   --output-name <name>              Appcast filename (default: appcast.xml)
+  --maximum-deltas <n>              Delta updates to generate from the previous archives kept in
+                                    --archives-dir (Sparkle's default is 5; 0 disables them)
   -h, --help                        Show this help
 
 Environment fallbacks:
@@ -44,6 +47,7 @@ Environment fallbacks:
   CROWD_CAST_SPARKLE_PHASED_ROLLOUT_INTERVAL
   CROWD_CAST_SPARKLE_CRITICAL_UPDATE_VERSION
   CROWD_CAST_SPARKLE_APPCAST_NAME
+  CROWD_CAST_SPARKLE_MAXIMUM_DELTAS
 EOF
 }
 
@@ -93,6 +97,10 @@ while [[ $# -gt 0 ]]; do
             OUTPUT_NAME="$2"
             shift 2
             ;;
+        --maximum-deltas)
+            MAXIMUM_DELTAS="$2"
+            shift 2
+            ;;
         -h|--help)
             usage
             exit 0
@@ -173,6 +181,12 @@ if [[ "$EMBED_RELEASE_NOTES" -eq 1 ]]; then
     ARGS+=(--embed-release-notes)
 fi
 
+# generate_appcast diffs the newest archive against the older ones in the directory and writes
+# signed .delta files next to them; they must be uploaded with the archives.
+if [[ -n "$MAXIMUM_DELTAS" ]]; then
+    ARGS+=(--maximum-deltas "$MAXIMUM_DELTAS")
+fi
+
 echo "Generating Sparkle appcast in $ARCHIVES_DIR..."
 "$GENERATE_APPCAST" "${ARGS[@]}" "$ARCHIVES_DIR"
 
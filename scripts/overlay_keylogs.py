@@ -3,6 +3,7 @@ import argparse
 import json
 import math
 import os
+import struct
 import subprocess
 import sys
 import tempfile
@@ -99,16 +100,106 @@ def format_ass_time(seconds: float) -> str:
     return f"{h}:{m:02d}:{s:02d}.{cs:02d}"
 
 
+COLUMNAR_MAGIC = b"CCKL"
+COLUMNAR_VERSION = 1
+COLUMNAR_COLUMN_COUNT = 15
+COLUMNAR_TAGS = {
+    0: "ContextChanged",
+    1: "KeyPress",
+    2: "KeyRelease",
+    3: "MousePress",
+    4: "MouseRelease",
+    5: "MouseMove",
+    6: "MouseScroll",
+    7: "Metadata",
+    8: "Redacted",
+}
+COLUMNAR_BUTTONS = {0: "Left", 1: "Right", 2: "Middle"}
+
+
+class _Column:
+    def __init__(self, buf: bytes):
+        self.buf = buf
+        self.pos = 0
+
+    def take(self, n: int) -> bytes:
+        assert self.pos + n <= len(self.buf), "Truncated columnar keylog."
+        out = self.buf[self.pos : self.pos + n]
+        self.pos += n
+        return out
+
+    def varint(self) -> int:
+        value = 0
+        shift = 0
+        while True:
+            byte = self.take(1)[0]
+            value |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                return value
+            shift += 7
+
+    def zigzag(self) -> int:
+        raw = self.varint()
+        return (raw >> 1) ^ -(raw & 1)
+
+    def f64(self) -> float:
+        return struct.unpack("<d", self.take(8))[0]
+
+
+def decode_columnar(blob: bytes) -> list:
+    """Decode a columnar keylog (see src/data/columnar.rs) into the same
+    [timestamp_us, [event_type, event_data]] entries the msgpack format holds."""
+    import zstandard
+
+    assert blob[4] == COLUMNAR_VERSION, f"Unsupported columnar keylog version {blob[4]}."
+    body = zstandard.ZstdDecompressor().decompressobj().decompress(blob[5:])
+    header = _Column(body)
+    count = header.varint()
+    name_count = header.varint()
+    (
+        tags, timestamps, key_names, key_codes, key_name_idx, button_ids, button_x,
+        button_y, move_dx, move_dy, scroll_dx, scroll_dy, scroll_x, scroll_y, other,
+    ) = [_Column(header.take(header.varint())) for _ in range(COLUMNAR_COLUMN_COUNT)]
+
+    names = [key_names.take(key_names.varint()).decode("utf-8") for _ in range(name_count)]
+
+    data = []
+    timestamp_us = 0
+    for _ in range(count):
+        timestamp_us += timestamps.zigzag()
+        event_type = COLUMNAR_TAGS[tags.take(1)[0]]
+        if event_type in ("KeyPress", "KeyRelease"):
+            event = [event_type, [key_codes.varint(), names[key_name_idx.varint()]]]
+        elif event_type in ("MousePress", "MouseRelease"):
+            button_id = button_ids.varint()
+            button = COLUMNAR_BUTTONS.get(button_id, {"Other": button_id - 3})
+            event = [event_type, [button, button_x.f64(), button_y.f64()]]
+        elif event_type == "MouseMove":
+            event = [event_type, [move_dx.f64(), move_dy.f64()]]
+        elif event_type == "MouseScroll":
+            event = [event_type, [scroll_dx.zigzag(), scroll_dy.zigzag(), scroll_x.f64(), scroll_y.f64()]]
+        else:
+            event = msgpack.unpackb(other.take(other.varint()), raw=False)
+        data.append([timestamp_us, event])
+    return data
+
+
 def load_input_chunk(path: str) -> dict:
-    """Load input events from msgpack file.
+    """Load input events from a msgpack or columnar (.cckl) keylog.
 
-    The file contains an array of events in tuple format:
+    A msgpack file contains an array of events in tuple format:
     [timestamp_us, [event_type, event_data]]
 
     For KeyPress/KeyRelease: [timestamp_us, ['KeyPress', [code, name]]]
+
+    Columnar files are decoded into the same shape (requires `zstandard`).
     """
     with open(path, "rb") as handle:
-        data = msgpack.unpackb(handle.read(), raw=False)
+        blob = handle.read()
+    if blob.startswith(COLUMNAR_MAGIC):
+        data = decode_columnar(blob)
+    else:
+        data = msgpack.unpackb(blob, raw=False)
     assert isinstance(data, list), "Input file does not contain an array of events."
 
     normalized_events = []
@@ -741,7 +832,7 @@ def build_cursor_events(
 def main() -> int:
     parser = argparse.ArgumentParser(description="Overlay keylogs on screen captures.")
     parser.add_argument("--video", help="Path to screen capture video (mp4/mkv).")
-    parser.add_argument("--input", required=True, help="Path to input msgpack log.")
+    parser.add_argument("--input", required=True, help="Path to input keylog (msgpack or columnar .cckl).")
     output_group = parser.add_mutually_exclusive_group(required=True)
     output_group.add_argument("--output", help="Output video path (burned-in overlays).")
     output_group.add_argument("--ass-out", help="Write ASS subtitles to this path.")
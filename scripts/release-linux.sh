@@ -10,6 +10,11 @@
 # Artifact names are kept consistent with packaging/linux/install.sh:
 #   crowd-cast-agent-x86_64                      (the binary)
 #   obs-bundle-<abi>-x86_64.tar.zst              (the libobs bundle)
+#   crowd-cast-agent-x86_64.from-<sha16>.zst     (optional delta from an earlier binary)
+#
+# Deltas are zstd --patch-from patches, listed under binary.deltas in the signed manifest and keyed
+# by the SHA-256 of the binary they apply to. They are written to --out-dir and must be hosted next
+# to the binary. Clients without a matching delta download the full binary as before.
 set -euo pipefail
 
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
@@ -30,6 +35,7 @@ NOTES=""
 CRITICAL="false"
 MIN_VERSION=""
 SIGNER=""
+DELTA_FROM=()
 
 usage() {
     cat <<EOF
@@ -54,6 +60,7 @@ Options:
   --critical             Mark this release critical (forward-compat flag)
   --minimum-version <v>  Minimum version allowed to skip this update (forward-compat)
   --signer <path>        Path to cc-sign-manifest (default: build it with --features release-tools)
+  --delta-from <path>    An earlier release binary to offer a delta patch from (repeatable)
   -h, --help             Show this help
 EOF
 }
@@ -73,6 +80,7 @@ while [[ $# -gt 0 ]]; do
         --critical) CRITICAL="true"; shift ;;
         --minimum-version) MIN_VERSION="$2"; shift 2 ;;
         --signer) SIGNER="$2"; shift 2 ;;
+        --delta-from) DELTA_FROM+=("$2"); shift 2 ;;
         -h|--help) usage; exit 0 ;;
         *) echo "Unknown option: $1" >&2; usage; exit 1 ;;
     esac
@@ -88,6 +96,9 @@ err() { echo "error: $*" >&2; exit 1; }
 [[ -n "$KEY_FILE" && -f "$KEY_FILE" ]] || err "signing key file not found (set --key-file or \$CROWD_CAST_ED_PRIVATE_KEY_FILE)"
 command -v sha256sum >/dev/null 2>&1 || err "'sha256sum' is required"
 command -v python3   >/dev/null 2>&1 || err "'python3' is required (manifest JSON assembly)"
+if [[ ${#DELTA_FROM[@]} -gt 0 ]]; then
+    command -v zstd >/dev/null 2>&1 || err "'zstd' is required for --delta-from"
+fi
 
 # Build the signer on demand if not provided. It needs the release-tools feature.
 if [[ -z "$SIGNER" ]]; then
@@ -111,22 +122,49 @@ BUNDLE_SHA="$(sha256sum "$BUNDLE" | awk '{print $1}')"
 mkdir -p "$OUT_DIR"
 MANIFEST="$OUT_DIR/appcast-linux.json"
 
+# One delta per distinct earlier binary, as "from_sha256 url sha256" lines for the manifest. A
+# patch that isn't clearly smaller than the binary itself isn't worth offering.
+DELTAS=""
+BIN_SIZE="$(stat -c %s "$BINARY")"
+for old in "${DELTA_FROM[@]}"; do
+    [[ -f "$old" ]] || err "delta base not found: $old"
+    old_sha="$(sha256sum "$old" | awk '{print $1}')"
+    if [[ "$old_sha" == "$BIN_SHA" ]] || grep -q "^$old_sha " <<<"$DELTAS"; then
+        continue
+    fi
+    patch_name="$BIN_NAME.from-${old_sha:0:16}.zst"
+    zstd -q -19 -f --patch-from="$old" "$BINARY" -o "$OUT_DIR/$patch_name"
+    patch_size="$(stat -c %s "$OUT_DIR/$patch_name")"
+    if (( patch_size * 2 > BIN_SIZE )); then
+        echo ">> skipping delta from $old ($patch_size bytes is not worth it)" >&2
+        rm -f "$OUT_DIR/$patch_name"
+        continue
+    fi
+    patch_sha="$(sha256sum "$OUT_DIR/$patch_name" | awk '{print $1}')"
+    DELTAS+="$old_sha $DOWNLOAD_BASE/$patch_name $patch_sha"$'\n'
+    echo ">> delta from $old_sha: $patch_name ($patch_size bytes)" >&2
+done
+
 # Assemble the manifest with python3 so notes/strings are JSON-escaped correctly. The byte content
 # written here is EXACTLY what gets signed and uploaded — do not reformat it afterwards.
 BIN_URL="$BIN_URL" \
 BUNDLE_URL="$BUNDLE_URL" \
 VERSION="$VERSION" BUILD="$BUILD" ABI="$ABI" NOTES="$NOTES" \
 CRITICAL="$CRITICAL" MIN_VERSION="$MIN_VERSION" \
-BIN_SHA="$BIN_SHA" BUNDLE_SHA="$BUNDLE_SHA" \
+BIN_SHA="$BIN_SHA" BUNDLE_SHA="$BUNDLE_SHA" DELTAS="$DELTAS" \
 python3 - "$MANIFEST" <<'PY'
 import json, os, sys
+deltas = [
+    {"from_sha256": from_sha, "url": url, "sha256": sha}
+    for from_sha, url, sha in (line.split() for line in os.environ["DELTAS"].splitlines() if line)
+]
 manifest = {
     "version": os.environ["VERSION"],
     "build": int(os.environ["BUILD"]),
     "notes": os.environ.get("NOTES", ""),
     "critical": os.environ["CRITICAL"] == "true",
     "minimum_version": os.environ.get("MIN_VERSION", ""),
-    "binary": {"url": os.environ["BIN_URL"], "sha256": os.environ["BIN_SHA"]},
+    "binary": {"url": os.environ["BIN_URL"], "sha256": os.environ["BIN_SHA"], "deltas": deltas},
     "bundle": {"abi": os.environ["ABI"], "url": os.environ["BUNDLE_URL"], "sha256": os.environ["BUNDLE_SHA"]},
 }
 with open(sys.argv[1], "w", encoding="utf-8") as f:
@@ -143,3 +181,4 @@ echo "   binary sha256=$BIN_SHA"
 echo "   bundle sha256=$BUNDLE_SHA"
 echo "   binary url=$BIN_URL"
 echo "   bundle url=$BUNDLE_URL"
+echo "   binary deltas=$(grep -c . <<<"$DELTAS" || true)"
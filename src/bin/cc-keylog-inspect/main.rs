@@ -0,0 +1,403 @@
+//! Offline QA tool: inspect recorded keylogs and check them against their video.
+//!
+//! Stream-decodes each `input_<segment>.{msgpack,cckl}` keylog through the agent's own decoders
+//! (`data::KeylogFormat::for_each_event`, so it can never disagree with what the agent wrote) and
+//! reports per-segment event rates, gaps, `Redacted` spans, the `ContextChanged` timeline and, when
+//! the segment's `recording_<segment>.{mp4,mov}` sits next to it, whether the keylog fits inside
+//! the video's duration. Memory per segment is bounded by the running statistics, not the event
+//! count; directories are walked recursively and their segments inspected in parallel.
+//!
+//! Build/run (kept out of normal app builds behind a feature):
+//!   cargo build --release --features qa-tools --bin cc-keylog-inspect
+//!   ./cc-keylog-inspect ~/.local/share/crowd-cast/recordings
+//!   ./cc-keylog-inspect --json --jobs 8 <keylog or directory>... > report.jsonl
+//!
+//! Exits non-zero if any keylog failed to decode or showed an issue, so it can gate a dataset
+//! export. `scripts/overlay_keylogs.py` remains the tool for visual spot checks.
+
+// The pure data module is mounted by path, as the benches do; the binary uses only part of it.
+#![allow(dead_code)]
+
+#[path = "../../data/mod.rs"]
+mod data;
+mod mp4;
+mod stats;
+
+use std::io::Write;
+use std::path::{Path, PathBuf};
+use std::process::ExitCode;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::mpsc;
+
+use serde::Serialize;
+
+use data::KeylogFormat;
+use stats::{SegmentStats, StatsBuilder};
+
+fn usage() -> String {
+    "usage: cc-keylog-inspect [--json] [--jobs <n>] [--gap-secs <s>] [--tolerance-secs <s>]\n\
+     \x20                        [--video <path>] <keylog or directory>...\n\
+     \n\
+     Directories are searched recursively for input_*.msgpack / input_*.cckl. Each keylog is\n\
+     checked against recording_<segment>.mp4/.mov in the same directory, or against --video\n\
+     when a single keylog is given. --gap-secs (default 5) is the pause reported as a long gap;\n\
+     --tolerance-secs (default 1) is how far events may run past the end of the video.\n\
+     --json prints one JSON object per keylog instead of the text report."
+        .to_string()
+}
+
+struct Options {
+    json: bool,
+    jobs: usize,
+    gap_us: u64,
+    tolerance_us: u64,
+    video: Option<PathBuf>,
+}
+
+/// Everything reported for one keylog
+#[derive(Serialize)]
+struct Report {
+    keylog: PathBuf,
+    format: Option<KeylogFormat>,
+    video: Option<PathBuf>,
+    video_duration_us: Option<u64>,
+    /// Video time after the last event (negative: events run past the video)
+    video_tail_us: Option<i64>,
+    mean_events_per_sec: f64,
+    stats: Option<SegmentStats>,
+    error: Option<String>,
+    issues: Vec<String>,
+}
+
+fn secs_arg(value: Option<String>, name: &str) -> Result<u64, String> {
+    let value = value.ok_or_else(|| format!("{name} needs a value"))?;
+    let secs: f64 = value
+        .parse()
+        .ok()
+        .filter(|s: &f64| s.is_finite() && *s >= 0.0)
+        .ok_or_else(|| format!("{name} must be a non-negative number of seconds"))?;
+    Ok((secs * 1e6) as u64)
+}
+
+fn run() -> Result<bool, String> {
+    let mut opts = Options {
+        json: false,
+        jobs: std::thread::available_parallelism().map_or(1, |n| n.get()),
+        gap_us: 5_000_000,
+        tolerance_us: 1_000_000,
+        video: None,
+    };
+    let mut inputs: Vec<PathBuf> = Vec::new();
+
+    let mut args = std::env::args().skip(1);
+    while let Some(arg) = args.next() {
+        match arg.as_str() {
+            "--json" => opts.json = true,
+            "--jobs" => {
+                opts.jobs = args
+                    .next()
+                    .and_then(|v| v.parse().ok())
+                    .filter(|&n: &usize| n > 0)
+                    .ok_or("--jobs needs a positive number")?
+            }
+            "--gap-secs" => opts.gap_us = secs_arg(args.next(), "--gap-secs")?,
+            "--tolerance-secs" => opts.tolerance_us = secs_arg(args.next(), "--tolerance-secs")?,
+            "--video" => {
+                opts.video = Some(args.next().ok_or("--video needs a value")?.into());
+            }
+            "-h" | "--help" => {
+                println!("{}", usage());
+                return Ok(true);
+            }
+            other if other.starts_with("--") => {
+                return Err(format!("unknown argument: {other}\n\n{}", usage()))
+            }
+            path => inputs.push(path.into()),
+        }
+    }
+    if inputs.is_empty() {
+        return Err(format!("no keylogs given\n\n{}", usage()));
+    }
+
+    let mut keylogs = Vec::new();
+    for input in &inputs {
+        if input.is_dir() {
+            collect_keylogs(input, &mut keylogs)
+                .map_err(|e| format!("failed to list {}: {e}", input.display()))?;
+        } else {
+            keylogs.push(input.clone());
+        }
+    }
+    keylogs.sort();
+    if opts.video.is_some() && keylogs.len() != 1 {
+        return Err("--video needs exactly one keylog".to_string());
+    }
+
+    // Workers pull keylogs off a shared index; the main thread prints reports
+    // as they arrive, so output order follows completion, not the listing.
+    let next = AtomicUsize::new(0);
+    let (tx, rx) = mpsc::channel();
+    let mut totals = Totals::default();
+    std::thread::scope(|scope| {
+        for _ in 0..opts.jobs.min(keylogs.len()) {
+            let tx = tx.clone();
+            let (next, keylogs, opts) = (&next, &keylogs, &opts);
+            scope.spawn(move || loop {
+                let i = next.fetch_add(1, Ordering::Relaxed);
+                let Some(keylog) = keylogs.get(i) else { break };
+                if tx.send(inspect(keylog, opts)).is_err() {
+                    break;
+                }
+            });
+        }
+        drop(tx);
+
+        let stdout = std::io::stdout();
+        let mut out = stdout.lock();
+        for report in rx {
+            totals.add(&report);
+            let written = if opts.json {
+                serde_json::to_string(&report)
+                    .map_err(std::io::Error::other)
+                    .and_then(|line| writeln!(out, "{line}"))
+            } else {
+                print_report(&mut out, &report)
+            };
+            if written.is_err() {
+                // stdout closed (e.g. piped into `head`); stop quietly
+                break;
+            }
+        }
+    });
+
+    eprintln!(
+        "{} keylog(s), {} event(s): {} failed to decode, {} with issues",
+        totals.keylogs, totals.events, totals.errors, totals.with_issues
+    );
+    Ok(totals.errors == 0 && totals.with_issues == 0)
+}
+
+#[derive(Default)]
+struct Totals {
+    keylogs: usize,
+    events: u64,
+    errors: usize,
+    with_issues: usize,
+}
+
+impl Totals {
+    fn add(&mut self, report: &Report) {
+        self.keylogs += 1;
+        self.events += report.stats.as_ref().map_or(0, |s| s.events);
+        if report.error.is_some() {
+            self.errors += 1;
+        } else if !report.issues.is_empty() {
+            self.with_issues += 1;
+        }
+    }
+}
+
+/// Append every keylog under `dir` (recursively) to `out`
+fn collect_keylogs(dir: &Path, out: &mut Vec<PathBuf>) -> std::io::Result<()> {
+    for entry in std::fs::read_dir(dir)? {
+        let entry = entry?;
+        let path = entry.path();
+        if entry.file_type()?.is_dir() {
+            collect_keylogs(&path, out)?;
+        } else if segment_id(&path).is_some() && KeylogFormat::from_path(&path).is_some() {
+            out.push(path);
+        }
+    }
+    Ok(())
+}
+
+/// Segment ID of an `input_<segment>.<ext>` keylog
+fn segment_id(keylog: &Path) -> Option<&str> {
+    keylog.file_stem()?.to_str()?.strip_prefix("input_")
+}
+
+/// The segment's recording next to its keylog
+fn sibling_video(keylog: &Path) -> Option<PathBuf> {
+    let segment = segment_id(keylog)?;
+    let dir = keylog.parent()?;
+    ["mp4", "mov"]
+        .iter()
+        .map(|ext| dir.join(format!("recording_{segment}.{ext}")))
+        .find(|p| p.is_file())
+}
+
+fn inspect(keylog: &Path, opts: &Options) -> Report {
+    let mut report = Report {
+        keylog: keylog.to_path_buf(),
+        format: KeylogFormat::from_path(keylog),
+        video: opts.video.clone().or_else(|| sibling_video(keylog)),
+        video_duration_us: None,
+        video_tail_us: None,
+        mean_events_per_sec: 0.0,
+        stats: None,
+        error: None,
+        issues: Vec::new(),
+    };
+    let Some(format) = report.format else {
+        report.error = Some("not a keylog (.msgpack or .cckl expected)".to_string());
+        return report;
+    };
+
+    let mut builder = StatsBuilder::new(opts.gap_us);
+    let decoded = std::fs::File::open(keylog)
+        .map_err(anyhow::Error::from)
+        .and_then(|file| {
+            format.for_each_event(file, |event| {
+                builder.push(&event);
+                Ok(())
+            })
+        });
+    if let Err(e) = decoded {
+        report.error = Some(format!("{e:#}"));
+        return report;
+    }
+    let stats = builder.finish();
+
+    if stats.events == 0 {
+        report.issues.push("no events".to_string());
+    }
+    if stats.events > 0 && stats.counts.metadata == 0 {
+        report.issues.push("no segment metadata event".to_string());
+    }
+    if stats.out_of_order > 0 {
+        report
+            .issues
+            .push(format!("{} event(s) out of order", stats.out_of_order));
+    }
+
+    match &report.video {
+        Some(video) => match mp4::duration_us(video) {
+            Ok(Some(duration)) => {
+                report.video_duration_us = Some(duration);
+                if let Some(last) = stats.last_us {
+                    report.video_tail_us = Some(duration as i64 - last as i64);
+                    if last > duration + opts.tolerance_us {
+                        report.issues.push(format!(
+                            "events run {:.3}s past the end of the video",
+                            (last - duration) as f64 / 1e6
+                        ));
+                    }
+                }
+            }
+            Ok(None) => report
+                .issues
+                .push(format!("no duration in video {}", video.display())),
+            Err(e) => report
+                .issues
+                .push(format!("cannot read video {}: {e}", video.display())),
+        },
+        None => report.issues.push("no video found".to_string()),
+    }
+
+    report.mean_events_per_sec = stats.mean_events_per_sec();
+    report.stats = Some(stats);
+    report
+}
+
+fn secs(us: u64) -> f64 {
+    us as f64 / 1e6
+}
+
+fn print_report(out: &mut impl Write, report: &Report) -> std::io::Result<()> {
+    writeln!(out, "{}", report.keylog.display())?;
+    if let Some(error) = &report.error {
+        writeln!(out, "  ERROR: {error}")?;
+        return writeln!(out);
+    }
+    let Some(stats) = &report.stats else {
+        return writeln!(out);
+    };
+
+    let c = &stats.counts;
+    writeln!(
+        out,
+        "  events     {} over {:.3}s ({:.1}/s mean, {}/s peak)",
+        stats.events,
+        secs(stats.span_us()),
+        report.mean_events_per_sec,
+        stats.peak_events_per_sec
+    )?;
+    writeln!(
+        out,
+        "  types      key {}/{}  button {}/{}  move {}  scroll {}  context {}  metadata {}  redacted {}",
+        c.key_press,
+        c.key_release,
+        c.mouse_press,
+        c.mouse_release,
+        c.mouse_move,
+        c.mouse_scroll,
+        c.context_changed,
+        c.metadata,
+        c.redacted
+    )?;
+    writeln!(
+        out,
+        "  gaps       largest {:.3}s, {} long totalling {:.3}s",
+        secs(stats.largest_gap_us),
+        stats.long_gaps,
+        secs(stats.long_gap_total_us)
+    )?;
+    if stats.unreleased_keys > 0 || stats.orphan_releases > 0 {
+        writeln!(
+            out,
+            "  keys       {} still held at end, {} released without a press",
+            stats.unreleased_keys, stats.orphan_releases
+        )?;
+    }
+    for span in &stats.redacted {
+        writeln!(
+            out,
+            "  redacted   {:.3}s-{:.3}s ({}){}",
+            secs(span.start_us),
+            secs(span.end_us),
+            span.reason,
+            if span.open {
+                ", open at segment end"
+            } else {
+                ""
+            }
+        )?;
+    }
+    for ctx in &stats.contexts {
+        writeln!(
+            out,
+            "  context    {:>9.3}s  {}",
+            secs(ctx.start_us),
+            ctx.app_id
+        )?;
+    }
+    for (app, dwell) in &stats.dwell_us {
+        writeln!(out, "  dwell      {:>9.3}s  {app}", secs(*dwell))?;
+    }
+    match (&report.video, report.video_duration_us) {
+        (Some(video), Some(duration)) => writeln!(
+            out,
+            "  video      {:.3}s, {:.3}s after the last event ({})",
+            secs(duration),
+            report.video_tail_us.unwrap_or(0) as f64 / 1e6,
+            video.display()
+        )?,
+        (Some(video), None) => writeln!(out, "  video      {}", video.display())?,
+        (None, _) => {}
+    }
+    for issue in &report.issues {
+        writeln!(out, "  ISSUE: {issue}")?;
+    }
+    writeln!(out)
+}
+
+fn main() -> ExitCode {
+    match run() {
+        Ok(true) => ExitCode::SUCCESS,
+        Ok(false) => ExitCode::FAILURE,
+        Err(e) => {
+            eprintln!("error: {e}");
+            ExitCode::from(2)
+        }
+    }
+}
@@ -0,0 +1,362 @@
+//! Minimal MP4/MOV box walker: just enough to read a recording's duration
+//!
+//! Regular recordings carry it in `mvhd`. Fragmented ones (progressive
+//! upload) leave `mvhd` empty and describe each fragment in a `moof`, so there
+//! the duration is the furthest track end reached by any `traf`. Only the few
+//! boxes involved are read; media data is seeked past, and a box cut short by
+//! a recording still being written ends the walk.
+
+use std::collections::HashMap;
+use std::fs::File;
+use std::io::{self, BufReader, Read, Seek, SeekFrom};
+use std::path::Path;
+
+/// Leaf boxes larger than this are not loaded (none of the parsed ones get
+/// anywhere near it outside of corrupt files)
+const MAX_LEAF_BOX: u64 = 64 << 20;
+
+const TFHD_BASE_DATA_OFFSET: u32 = 0x01;
+const TFHD_SAMPLE_DESCRIPTION_INDEX: u32 = 0x02;
+const TFHD_DEFAULT_SAMPLE_DURATION: u32 = 0x08;
+const TRUN_DATA_OFFSET: u32 = 0x01;
+const TRUN_FIRST_SAMPLE_FLAGS: u32 = 0x04;
+const TRUN_SAMPLE_DURATION: u32 = 0x100;
+const TRUN_SAMPLE_SIZE: u32 = 0x200;
+const TRUN_SAMPLE_FLAGS: u32 = 0x400;
+const TRUN_SAMPLE_CTO: u32 = 0x800;
+
+/// Duration of the recording at `path` in microseconds, or `None` if it
+/// describes none
+pub fn duration_us(path: &Path) -> io::Result<Option<u64>> {
+    let file = File::open(path)?;
+    let len = file.metadata()?.len();
+    read_duration_us(BufReader::new(file), len)
+}
+
+pub fn read_duration_us(mut reader: impl Read + Seek, len: u64) -> io::Result<Option<u64>> {
+    let mut walker = Walker::default();
+    walker.walk(&mut reader, 0, len)?;
+    Ok(walker.duration_us())
+}
+
+#[derive(Default)]
+struct Walker {
+    movie_timescale: u32,
+    movie_duration: u64,
+    /// `mehd`, in the movie timescale
+    fragment_duration: u64,
+    /// Track ID of the `trak` being walked
+    current_track: u32,
+    track_timescales: HashMap<u32, u32>,
+    default_sample_durations: HashMap<u32, u32>,
+    /// `traf` state: track ID, its default sample duration, its decode time
+    fragment_track: u32,
+    fragment_default_duration: Option<u32>,
+    fragment_decode_time: Option<u64>,
+    /// Furthest decode time reached per track, in the track timescale
+    track_ends: HashMap<u32, u64>,
+}
+
+impl Walker {
+    fn walk(&mut self, reader: &mut (impl Read + Seek), start: u64, end: u64) -> io::Result<()> {
+        let mut pos = start;
+        while pos + 8 <= end {
+            reader.seek(SeekFrom::Start(pos))?;
+            let mut header = [0u8; 8];
+            if read_full(reader, &mut header)? < header.len() {
+                break;
+            }
+            let mut size = u32::from_be_bytes(header[..4].try_into().unwrap()) as u64;
+            let kind: [u8; 4] = header[4..].try_into().unwrap();
+            let mut body = pos + 8;
+            if size == 1 {
+                let mut large = [0u8; 8];
+                if read_full(reader, &mut large)? < large.len() {
+                    break;
+                }
+                size = u64::from_be_bytes(large);
+                body += 8;
+            } else if size == 0 {
+                size = end - pos;
+            }
+            let box_end = pos.saturating_add(size);
+            if box_end < body || box_end > end {
+                // Truncated (still being written) or corrupt
+                break;
+            }
+
+            match &kind {
+                b"moov" | b"trak" | b"mdia" | b"mvex" | b"moof" => {
+                    self.walk(reader, body, box_end)?
+                }
+                b"traf" => {
+                    self.fragment_track = 0;
+                    self.fragment_default_duration = None;
+                    self.fragment_decode_time = None;
+                    self.walk(reader, body, box_end)?;
+                }
+                b"mvhd" | b"tkhd" | b"mdhd" | b"mehd" | b"trex" | b"tfhd" | b"tfdt" | b"trun" => {
+                    let len = box_end - body;
+                    if len <= MAX_LEAF_BOX {
+                        let mut payload = vec![0u8; len as usize];
+                        reader.read_exact(&mut payload)?;
+                        // A malformed leaf only loses that box's information
+                        let _ = self.leaf(&kind, &mut Fields(&payload));
+                    }
+                }
+                _ => {}
+            }
+            pos = box_end;
+        }
+        Ok(())
+    }
+
+    fn leaf(&mut self, kind: &[u8; 4], f: &mut Fields) -> Option<()> {
+        let (version, flags) = f.full_box()?;
+        match kind {
+            b"mvhd" => {
+                let (timescale, duration) = f.timescale_duration(version)?;
+                self.movie_timescale = timescale;
+                self.movie_duration = duration;
+            }
+            b"mdhd" => {
+                let (timescale, _) = f.timescale_duration(version)?;
+                self.track_timescales.insert(self.current_track, timescale);
+            }
+            b"tkhd" => {
+                f.skip(if version == 1 { 16 } else { 8 })?;
+                self.current_track = f.u32()?;
+            }
+            b"mehd" => {
+                self.fragment_duration = f.versioned(version)?;
+            }
+            b"trex" => {
+                let track = f.u32()?;
+                f.skip(4)?;
+                self.default_sample_durations.insert(track, f.u32()?);
+            }
+            b"tfhd" => {
+                self.fragment_track = f.u32()?;
+                if flags & TFHD_BASE_DATA_OFFSET != 0 {
+                    f.skip(8)?;
+                }
+                if flags & TFHD_SAMPLE_DESCRIPTION_INDEX != 0 {
+                    f.skip(4)?;
+                }
+                if flags & TFHD_DEFAULT_SAMPLE_DURATION != 0 {
+                    self.fragment_default_duration = Some(f.u32()?);
+                }
+            }
+            b"tfdt" => {
+                self.fragment_decode_time = Some(f.versioned(version)?);
+            }
+            b"trun" => {
+                let count = f.u32()?;
+                if flags & TRUN_DATA_OFFSET != 0 {
+                    f.skip(4)?;
+                }
+                if flags & TRUN_FIRST_SAMPLE_FLAGS != 0 {
+                    f.skip(4)?;
+                }
+                let default = self
+                    .fragment_default_duration
+                    .or_else(|| {
+                        self.default_sample_durations
+                            .get(&self.fragment_track)
+                            .copied()
+                    })
+                    .unwrap_or(0) as u64;
+                let mut total = 0u64;
+                for _ in 0..count {
+                    if flags & TRUN_SAMPLE_DURATION != 0 {
+                        total += f.u32()? as u64;
+                    } else {
+                        total += default;
+                    }
+                    for field in [TRUN_SAMPLE_SIZE, TRUN_SAMPLE_FLAGS, TRUN_SAMPLE_CTO] {
+                        if flags & field != 0 {
+                            f.skip(4)?;
+                        }
+                    }
+                }
+                // Without a tfdt, a run continues where the track left off
+                let track_end = self.track_ends.entry(self.fragment_track).or_default();
+                let start = self.fragment_decode_time.unwrap_or(*track_end);
+                let end = start + total;
+                *track_end = (*track_end).max(end);
+                self.fragment_decode_time = Some(end);
+            }
+            _ => {}
+        }
+        Some(())
+    }
+
+    fn duration_us(&self) -> Option<u64> {
+        let mut best = None;
+        let mut consider = |value: u64, timescale: u32| {
+            if value > 0 && timescale > 0 {
+                let us = (value as u128 * 1_000_000 / timescale as u128) as u64;
+                best = Some(best.map_or(us, |b: u64| b.max(us)));
+            }
+        };
+        consider(self.movie_duration, self.movie_timescale);
+        consider(self.fragment_duration, self.movie_timescale);
+        for (track, &end) in &self.track_ends {
+            let timescale = self
+                .track_timescales
+                .get(track)
+                .copied()
+                .unwrap_or(self.movie_timescale);
+            consider(end, timescale);
+        }
+        best
+    }
+}
+
+/// Read up to `buf.len()` bytes, stopping early only at end of file
+fn read_full(reader: &mut impl Read, buf: &mut [u8]) -> io::Result<usize> {
+    let mut filled = 0;
+    while filled < buf.len() {
+        match reader.read(&mut buf[filled..]) {
+            Ok(0) => break,
+            Ok(n) => filled += n,
+            Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    Ok(filled)
+}
+
+/// Big-endian field cursor over a box payload
+struct Fields<'a>(&'a [u8]);
+
+impl Fields<'_> {
+    fn take(&mut self, n: usize) -> Option<&[u8]> {
+        if self.0.len() < n {
+            return None;
+        }
+        let (head, rest) = self.0.split_at(n);
+        self.0 = rest;
+        Some(head)
+    }
+
+    fn skip(&mut self, n: usize) -> Option<()> {
+        self.take(n).map(|_| ())
+    }
+
+    fn u32(&mut self) -> Option<u32> {
+        Some(u32::from_be_bytes(self.take(4)?.try_into().ok()?))
+    }
+
+    fn u64(&mut self) -> Option<u64> {
+        Some(u64::from_be_bytes(self.take(8)?.try_into().ok()?))
+    }
+
+    /// `(version, flags)` of a full box
+    fn full_box(&mut self) -> Option<(u8, u32)> {
+        let word = self.u32()?;
+        Some(((word >> 24) as u8, word & 0x00ff_ffff))
+    }
+
+    /// A field that is 64-bit in version 1 boxes and 32-bit otherwise
+    fn versioned(&mut self, version: u8) -> Option<u64> {
+        if version == 1 {
+            self.u64()
+        } else {
+            self.u32().map(u64::from)
+        }
+    }
+
+    /// `mvhd`/`mdhd`: skip the creation and modification times, then read the
+    /// timescale and duration
+    fn timescale_duration(&mut self, version: u8) -> Option<(u32, u64)> {
+        self.skip(if version == 1 { 16 } else { 8 })?;
+        let timescale = self.u32()?;
+        Some((timescale, self.versioned(version)?))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Cursor;
+
+    fn boxed(kind: &[u8; 4], payload: &[u8]) -> Vec<u8> {
+        let mut out = ((payload.len() + 8) as u32).to_be_bytes().to_vec();
+        out.extend_from_slice(kind);
+        out.extend_from_slice(payload);
+        out
+    }
+
+    fn full(kind: &[u8; 4], version: u8, flags: u32, fields: &[u8]) -> Vec<u8> {
+        let mut payload = ((version as u32) << 24 | flags).to_be_bytes().to_vec();
+        payload.extend_from_slice(fields);
+        boxed(kind, &payload)
+    }
+
+    fn be32(values: &[u32]) -> Vec<u8> {
+        values.iter().flat_map(|v| v.to_be_bytes()).collect()
+    }
+
+    fn duration(file: &[u8]) -> Option<u64> {
+        read_duration_us(Cursor::new(file), file.len() as u64).unwrap()
+    }
+
+    #[test]
+    fn regular_recording_uses_mvhd() {
+        let mut file = boxed(b"ftyp", b"isom\0\0\0\0");
+        file.extend(boxed(b"mdat", &[0u8; 64]));
+        // creation, modification, timescale 1000, duration 5.5 s
+        file.extend(boxed(
+            b"moov",
+            &full(b"mvhd", 0, 0, &be32(&[0, 0, 1000, 5500])),
+        ));
+        assert_eq!(duration(&file), Some(5_500_000));
+    }
+
+    #[test]
+    fn fragmented_recording_uses_the_furthest_fragment() {
+        let mut trak = full(b"tkhd", 0, 0, &be32(&[0, 0, 1]));
+        trak.extend(boxed(
+            b"mdia",
+            &full(b"mdhd", 0, 0, &be32(&[0, 0, 90_000, 0])),
+        ));
+        let mut moov = full(b"mvhd", 0, 0, &be32(&[0, 0, 1000, 0]));
+        moov.extend(boxed(b"trak", &trak));
+        moov.extend(boxed(
+            b"mvex",
+            &full(b"trex", 0, 0, &be32(&[1, 1, 3000, 0, 0])),
+        ));
+        let mut file = boxed(b"moov", &moov);
+
+        // 30 samples at the trex default duration: 0..90000 (1 s)
+        let mut traf = full(b"tfhd", 0, 0, &be32(&[1]));
+        traf.extend(full(b"tfdt", 1, 0, &0u64.to_be_bytes()));
+        traf.extend(full(b"trun", 0, 0, &be32(&[30])));
+        file.extend(boxed(b"moof", &boxed(b"traf", &traf)));
+        file.extend(boxed(b"mdat", &[0u8; 32]));
+
+        // Explicit per-sample durations and sizes, continuing without a tfdt
+        let mut traf = full(b"tfhd", 0, 0, &be32(&[1]));
+        traf.extend(full(
+            b"trun",
+            0,
+            TRUN_SAMPLE_DURATION | TRUN_SAMPLE_SIZE,
+            &be32(&[2, 4500, 100, 4500, 100]),
+        ));
+        file.extend(boxed(b"moof", &boxed(b"traf", &traf)));
+
+        // A fragment still being written is ignored
+        let mut partial = boxed(b"moof", &boxed(b"traf", &traf));
+        partial.truncate(partial.len() - 6);
+        file.extend(partial);
+
+        assert_eq!(duration(&file), Some(1_100_000));
+    }
+
+    #[test]
+    fn file_without_movie_header_has_no_duration() {
+        assert_eq!(duration(&boxed(b"ftyp", b"isom")), None);
+        assert_eq!(duration(&[]), None);
+    }
+}
@@ -0,0 +1,292 @@
+//! Per-segment keylog statistics, accumulated one event at a time
+
+use std::collections::{BTreeMap, HashSet};
+
+use serde::Serialize;
+
+use crate::data::{EventType, InputEvent};
+
+/// Event counts by type
+#[derive(Debug, Default, Serialize)]
+pub struct EventCounts {
+    pub key_press: u64,
+    pub key_release: u64,
+    pub mouse_press: u64,
+    pub mouse_release: u64,
+    pub mouse_move: u64,
+    pub mouse_scroll: u64,
+    pub context_changed: u64,
+    pub metadata: u64,
+    pub redacted: u64,
+}
+
+/// A stretch of withheld input: from a `Redacted` marker until keystrokes or
+/// the app context resume, or the segment ends
+#[derive(Debug, Serialize)]
+pub struct RedactedSpan {
+    pub start_us: u64,
+    pub end_us: u64,
+    pub reason: String,
+    /// Still open when the segment ended
+    pub open: bool,
+}
+
+/// One entry of the frontmost-app timeline
+#[derive(Debug, Serialize)]
+pub struct ContextSpan {
+    pub start_us: u64,
+    pub app_id: String,
+}
+
+#[derive(Debug, Default, Serialize)]
+pub struct SegmentStats {
+    pub events: u64,
+    pub counts: EventCounts,
+    pub first_us: Option<u64>,
+    pub last_us: Option<u64>,
+    /// Events timestamped before their predecessor
+    pub out_of_order: u64,
+    /// Busiest whole second of the segment
+    pub peak_events_per_sec: u64,
+    pub largest_gap_us: u64,
+    /// Gaps between consecutive events longer than the gap threshold
+    pub long_gaps: u64,
+    pub long_gap_total_us: u64,
+    pub redacted: Vec<RedactedSpan>,
+    /// App changes in order, repeats of the current app collapsed
+    pub contexts: Vec<ContextSpan>,
+    /// Time spent in each app, up to the last event
+    pub dwell_us: BTreeMap<String, u64>,
+    /// Keys still held at the end of the segment
+    pub unreleased_keys: u64,
+    /// Releases of keys never seen pressed (e.g. pressed before the segment)
+    pub orphan_releases: u64,
+}
+
+impl SegmentStats {
+    pub fn span_us(&self) -> u64 {
+        match (self.first_us, self.last_us) {
+            (Some(first), Some(last)) => last.saturating_sub(first),
+            _ => 0,
+        }
+    }
+
+    pub fn mean_events_per_sec(&self) -> f64 {
+        match self.span_us() {
+            0 => 0.0,
+            span => self.events as f64 * 1e6 / span as f64,
+        }
+    }
+}
+
+/// Builds [`SegmentStats`] from events in file order, holding only the
+/// running state (current app, held keys, open redaction)
+pub struct StatsBuilder {
+    gap_threshold_us: u64,
+    stats: SegmentStats,
+    /// Whole second currently being counted, and its count so far
+    second: Option<(u64, u64)>,
+    open_redaction: Option<(u64, String)>,
+    current_app: Option<(String, u64)>,
+    held_keys: HashSet<u32>,
+}
+
+impl StatsBuilder {
+    pub fn new(gap_threshold_us: u64) -> Self {
+        Self {
+            gap_threshold_us,
+            stats: SegmentStats::default(),
+            second: None,
+            open_redaction: None,
+            current_app: None,
+            held_keys: HashSet::new(),
+        }
+    }
+
+    pub fn push(&mut self, event: &InputEvent) {
+        let ts = event.timestamp_us;
+        let stats = &mut self.stats;
+        stats.events += 1;
+        stats.first_us.get_or_insert(ts);
+        match stats.last_us {
+            Some(last) if ts < last => stats.out_of_order += 1,
+            Some(last) => {
+                let gap = ts - last;
+                stats.largest_gap_us = stats.largest_gap_us.max(gap);
+                if gap > self.gap_threshold_us {
+                    stats.long_gaps += 1;
+                    stats.long_gap_total_us += gap;
+                }
+            }
+            None => {}
+        }
+        // Out-of-order events keep the high-water mark, so gaps stay positive
+        stats.last_us = Some(stats.last_us.map_or(ts, |last| last.max(ts)));
+
+        let second = ts / 1_000_000;
+        self.second = match self.second {
+            Some((s, n)) if s == second => Some((s, n + 1)),
+            Some((_, n)) => {
+                stats.peak_events_per_sec = stats.peak_events_per_sec.max(n);
+                Some((second, 1))
+            }
+            None => Some((second, 1)),
+        };
+
+        let counts = &mut stats.counts;
+        match &event.event {
+            EventType::KeyPress(key) => {
+                counts.key_press += 1;
+                self.held_keys.insert(key.code);
+                self.close_redaction(ts);
+            }
+            EventType::KeyRelease(key) => {
+                counts.key_release += 1;
+                if !self.held_keys.remove(&key.code) {
+                    self.stats.orphan_releases += 1;
+                }
+            }
+            EventType::MousePress(_) => counts.mouse_press += 1,
+            EventType::MouseRelease(_) => counts.mouse_release += 1,
+            EventType::MouseMove(_) => counts.mouse_move += 1,
+            EventType::MouseScroll(_) => counts.mouse_scroll += 1,
+            EventType::Metadata(_) => counts.metadata += 1,
+            EventType::ContextChanged(ctx) => {
+                counts.context_changed += 1;
+                self.close_redaction(ts);
+                if self
+                    .current_app
+                    .as_ref()
+                    .is_some_and(|(app, _)| *app == ctx.app_id)
+                {
+                    return;
+                }
+                if let Some((app, since)) = self.current_app.take() {
+                    *self.stats.dwell_us.entry(app).or_default() += ts.saturating_sub(since);
+                }
+                self.stats.contexts.push(ContextSpan {
+                    start_us: ts,
+                    app_id: ctx.app_id.clone(),
+                });
+                self.current_app = Some((ctx.app_id.clone(), ts));
+            }
+            EventType::Redacted(redacted) => {
+                counts.redacted += 1;
+                // Repeated markers inside one gap extend it
+                if self.open_redaction.is_none() {
+                    self.open_redaction = Some((ts, redacted.reason.clone()));
+                }
+            }
+        }
+    }
+
+    fn close_redaction(&mut self, ts: u64) {
+        if let Some((start_us, reason)) = self.open_redaction.take() {
+            self.stats.redacted.push(RedactedSpan {
+                start_us,
+                end_us: ts.max(start_us),
+                reason,
+                open: false,
+            });
+        }
+    }
+
+    pub fn finish(mut self) -> SegmentStats {
+        let end = self.stats.last_us.unwrap_or(0);
+        if let Some((_, n)) = self.second {
+            self.stats.peak_events_per_sec = self.stats.peak_events_per_sec.max(n);
+        }
+        if let Some((start_us, reason)) = self.open_redaction.take() {
+            self.stats.redacted.push(RedactedSpan {
+                start_us,
+                end_us: end.max(start_us),
+                reason,
+                open: true,
+            });
+        }
+        if let Some((app, since)) = self.current_app.take() {
+            *self.stats.dwell_us.entry(app).or_default() += end.saturating_sub(since);
+        }
+        self.stats.unreleased_keys = self.held_keys.len() as u64;
+        self.stats
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::data::{ContextEvent, KeyEvent, RedactedEvent};
+
+    fn at(timestamp_us: u64, event: EventType) -> InputEvent {
+        InputEvent {
+            timestamp_us,
+            event,
+        }
+    }
+
+    fn key(code: u32) -> KeyEvent {
+        KeyEvent {
+            code,
+            name: format!("Key{code}"),
+        }
+    }
+
+    fn app(app_id: &str) -> EventType {
+        EventType::ContextChanged(ContextEvent {
+            app_id: app_id.to_string(),
+        })
+    }
+
+    #[test]
+    fn timeline_gaps_and_redactions() {
+        let events = [
+            at(0, app("term")),
+            at(100_000, EventType::KeyPress(key(1))),
+            at(200_000, EventType::KeyRelease(key(1))),
+            at(
+                1_000_000,
+                EventType::Redacted(RedactedEvent {
+                    reason: "secure-field".into(),
+                }),
+            ),
+            at(8_000_000, EventType::KeyPress(key(2))),
+            at(8_100_000, app("term")),
+            at(9_000_000, app("browser")),
+            at(9_500_000, EventType::KeyRelease(key(3))),
+            at(12_000_000, EventType::KeyRelease(key(2))),
+        ];
+        let mut builder = StatsBuilder::new(5_000_000);
+        for event in &events {
+            builder.push(event);
+        }
+        let stats = builder.finish();
+
+        assert_eq!(stats.events, 9);
+        assert_eq!(stats.span_us(), 12_000_000);
+        assert_eq!(stats.largest_gap_us, 7_000_000);
+        assert_eq!((stats.long_gaps, stats.long_gap_total_us), (1, 7_000_000));
+        assert_eq!(stats.peak_events_per_sec, 3);
+        assert_eq!(stats.redacted.len(), 1);
+        assert_eq!(stats.redacted[0].start_us, 1_000_000);
+        assert_eq!(stats.redacted[0].end_us, 8_000_000);
+        assert!(!stats.redacted[0].open);
+        let apps: Vec<_> = stats.contexts.iter().map(|c| c.app_id.as_str()).collect();
+        assert_eq!(apps, ["term", "browser"]);
+        assert_eq!(stats.dwell_us["term"], 9_000_000);
+        assert_eq!(stats.dwell_us["browser"], 3_000_000);
+        assert_eq!((stats.unreleased_keys, stats.orphan_releases), (0, 1));
+    }
+
+    #[test]
+    fn out_of_order_events_are_counted_not_gapped() {
+        let mut builder = StatsBuilder::new(5_000_000);
+        builder.push(&at(2_000_000, EventType::KeyPress(key(1))));
+        builder.push(&at(1_000_000, EventType::KeyRelease(key(1))));
+        builder.push(&at(2_500_000, EventType::KeyPress(key(1))));
+        let stats = builder.finish();
+        assert_eq!(stats.out_of_order, 1);
+        assert_eq!(stats.largest_gap_us, 500_000);
+        assert_eq!(stats.last_us, Some(2_500_000));
+        assert_eq!(stats.unreleased_keys, 1);
+    }
+}
@@ -24,7 +24,7 @@ use libobs_wrapper::utils::StartupInfo;
 // ObsPath/StartupPaths are only used to redirect OBS runtime paths on macOS/Linux.
 #[cfg(any(target_os = "macos", target_os = "linux"))]
 use libobs_wrapper::utils::{ObsPath, StartupPaths};
-use std::collections::{HashMap, HashSet};
+use std::collections::{HashMap, HashSet, VecDeque};
 #[cfg(not(target_os = "linux"))]
 use std::convert::Infallible;
 use std::path::PathBuf;
@@ -64,6 +64,11 @@ pub struct CaptureContext {
     /// Per-app scenes for single-active-app mode: bundle_id → (scene, source)
     /// All sources run simultaneously; switching apps = activating the target scene.
     app_scenes: HashMap<String, (ObsSceneRef, ScreenCaptureSource)>,
+    /// Apps in `app_scenes`, most recently focused first. Off macOS scenes are created on
+    /// first focus and the ones beyond `warm_app_scene_limit` are torn down from the back.
+    app_scene_recency: VecDeque<String>,
+    /// How many per-app scenes to keep warm off macOS (at least the active one)
+    warm_app_scene_limit: usize,
     /// Empty scene activated when no tracked app is frontmost
     blank_scene: Option<ObsSceneRef>,
     /// GNOME Wayland: owns the Mutter ScreenCast sessions that back the per-app PipeWire
@@ -90,10 +95,20 @@ pub struct CaptureContext {
     /// is a no-op rather than re-applied every focus poll. Linux only.
     #[cfg(target_os = "linux")]
     last_monitor_fit: Option<(String, u32, u32, u32)>,
+    /// The active app's window rect, its monitor's rect and scale, per app, served between
+    /// geometry-change signals instead of re-queried every poll (see `geometry_events`).
+    #[cfg(target_os = "linux")]
+    window_geometry: super::geometry_events::GeometryCache<(
+        super::monitor_layout::Rect,
+        super::monitor_layout::Rect,
+        f64,
+    )>,
     /// Recording output
     recording: Option<RecordingOutput>,
     /// Current recording session info
     current_session: Option<RecordingSession>,
+    /// Session a requested file split will switch to, until the output reports it
+    pending_split_session: Option<String>,
     /// Current capture state
     state: Arc<RwLock<CaptureState>>,
     /// Recording output directory
@@ -132,6 +147,11 @@ pub struct CaptureContext {
     /// Reset with `last_monitor_fit` on every source rebuild.
     #[cfg(target_os = "macos")]
     last_display_uuid: HashMap<String, String>,
+    /// macOS follow-focus: the display each app's focused window was last found on, served
+    /// between geometry-change signals instead of enumerating every window each poll (see
+    /// `geometry_events`).
+    #[cfg(target_os = "macos")]
+    window_geometry: super::geometry_events::GeometryCache<super::mac_geometry::DisplayTarget>,
 }
 
 impl CaptureContext {
@@ -216,6 +236,8 @@ impl CaptureContext {
             scene: None,
             capture_sources: Vec::new(),
             app_scenes: HashMap::new(),
+            app_scene_recency: VecDeque::new(),
+            warm_app_scene_limit: usize::MAX,
             blank_scene: None,
             #[cfg(target_os = "linux")]
             gnome_screencast: None,
@@ -225,8 +247,11 @@ impl CaptureContext {
             gnome_bind_failed: HashMap::new(),
             #[cfg(target_os = "linux")]
             last_monitor_fit: None,
+            #[cfg(target_os = "linux")]
+            window_geometry: super::geometry_events::GeometryCache::new(),
             recording: None,
             current_session: None,
+            pending_split_session: None,
             state: Arc::new(RwLock::new(CaptureState::default())),
             output_directory,
             recording_config: RecordingConfig::default(),
@@ -241,6 +266,8 @@ impl CaptureContext {
             mac_multi_monitor_capture: false,
             #[cfg(target_os = "macos")]
             last_display_uuid: HashMap::new(),
+            #[cfg(target_os = "macos")]
+            window_geometry: super::geometry_events::GeometryCache::new(),
         })
     }
 
@@ -413,8 +440,11 @@ impl CaptureContext {
         // downloaded/extracted bundle (or system install). Both can be redirected via
         // CROWD_CAST_OBS_* env vars. When none are set on Linux, `StartupInfo::default()`
         // already points libobs-wrapper at the system OBS paths.
+        // Plugins the capture mode never uses are left out of libobs' module scan.
         #[cfg(any(target_os = "macos", target_os = "linux"))]
-        if let Some(paths) = obs_startup_paths_from_env() {
+        if let Some(paths) = obs_startup_paths_from_env(&super::plugin_manifest::unused_plugins(
+            self.recording_config.enable_audio,
+        )) {
             startup_info = startup_info.set_startup_paths(paths);
         }
         log_critical_operation("initialize: calling ObsContext::new()");
@@ -434,6 +464,12 @@ impl CaptureContext {
         self.single_active_app_capture = enabled;
     }
 
+    /// Bound the warm per-app scene pool in single-active mode (off macOS). Applies from the
+    /// next focus switch or rebuild; the active app's scene is always kept.
+    pub fn set_warm_app_scene_limit(&mut self, limit: usize) {
+        self.warm_app_scene_limit = limit.max(1);
+    }
+
     /// Enable/disable the macOS multi-monitor capture path (normalized canvas + per-display
     /// fit). Set from `config.capture.mac_multi_monitor_capture` at startup. No-op off macOS.
     pub fn set_mac_multi_monitor_capture(&mut self, enabled: bool) {
@@ -547,14 +583,30 @@ impl CaptureContext {
         }
     }
 
-    /// Create all per-app scenes and a blank scene for single-active-app mode.
-    /// Each tracked app gets its own scene with one SCK source. All sources run
+    /// Create the per-app scenes and a blank scene for single-active-app mode.
+    /// Each tracked app gets its own scene with one capture source. All sources run
     /// simultaneously; switching apps just activates the target scene on channel 0.
+    /// On macOS every running target app gets its scene here; elsewhere only the warm
+    /// set does (the initial active app and the most recently focused others, up to
+    /// `warm_app_scene_limit`), and the rest are created on first focus.
     fn setup_app_scenes(&mut self, initial_active_app: Option<&str>) -> Result<()> {
         if !self.is_initialized() {
             anyhow::bail!("OBS context not initialized");
         }
 
+        #[cfg(not(target_os = "macos"))]
+        let warm: Vec<String> = {
+            let mut warm: Vec<String> =
+                initial_active_app.map(str::to_string).into_iter().collect();
+            for app in self.app_scene_recency.drain(..) {
+                if !warm.contains(&app) {
+                    warm.push(app);
+                }
+            }
+            warm.truncate(self.warm_app_scene_limit);
+            warm
+        };
+
         // Clean up all capture resources (both modes) to prevent cross-mode
         // leaks when switching between single-active and display/multi modes.
         self.app_scenes.clear();
@@ -579,6 +631,7 @@ impl CaptureContext {
         #[cfg(target_os = "macos")]
         {
             self.last_display_uuid.clear();
+            self.window_geometry.clear();
         }
         // Drop any prior Mutter ScreenCast manager (closes its sessions / frees the old
         // nodes) before we rebuild.
@@ -587,6 +640,7 @@ impl CaptureContext {
             self.gnome_screencast = None;
             self.gnome_bound_window.clear();
             self.gnome_bind_failed.clear();
+            self.window_geometry.clear();
         }
         self.capture_sources.clear();
         self.scene = None;
@@ -618,14 +672,7 @@ impl CaptureContext {
 
         let display_uuid = get_main_display_uuid()
             .context("Failed to get main display UUID for application capture")?;
-        let capture_audio = self.recording_config.enable_audio;
         let target_apps = self.target_apps.clone();
-        let restore_tokens = self.restore_tokens.clone();
-
-        let context = self
-            .context
-            .as_mut()
-            .ok_or_else(|| anyhow::anyhow!("OBS context not initialized"))?;
 
         // Only create scenes for apps that are currently running.
         // Apps launched later get their scenes created lazily on first switch.
@@ -672,9 +719,9 @@ impl CaptureContext {
         for bundle_id in &target_apps {
             // macOS: ScreenCaptureKit sources for apps not running at startup must be created
             // in a fresh OBS context (the engine restarts the process to do so), so skip them
-            // here and create them lazily. XComposite (X11) has no such constraint — we
-            // pre-create a scene for every target app, so `needs_scene_for_app` stays false
-            // (no restart) and the source binds its window on creation and each focus switch.
+            // here and create them lazily. XComposite (X11) and Windows have no such
+            // constraint: only the warm set is built here and every other app gets its scene
+            // on first focus (`switch_active_app_capture`), without a restart.
             #[cfg(target_os = "macos")]
             if !running_bundles.contains(bundle_id.as_str()) {
                 debug!("Skipping scene for '{}' (not running)", bundle_id);
@@ -694,33 +741,17 @@ impl CaptureContext {
                 continue;
             }
 
-            let scene_name = Self::build_scene_name(&format!("scene_{}", bundle_id));
-            let mut scene = context
-                .scene(scene_name.as_str())
-                .context("Failed to create scene")?;
+            let canonical_id = Self::canonical_app_id(bundle_id);
+            #[cfg(not(target_os = "macos"))]
+            if !warm.contains(&canonical_id) {
+                continue;
+            }
 
-            let source_name = format!("app_capture_{}", bundle_id);
-            match ScreenCaptureSource::new_application_capture(
-                context,
-                &mut scene,
-                &source_name,
-                bundle_id,
-                &display_uuid,
-                capture_audio,
-                restore_tokens.get(bundle_id).map(|s| s.as_str()),
-            ) {
-                Ok(source) => {
-                    // Key scenes by the canonical id so frontmost-derived lookups
-                    // (also canonical) match regardless of how target_apps is cased.
-                    // On macOS/Linux `canonical_app_id` is the identity, so this is the
-                    // raw bundle id / process name there.
-                    let canonical_id = Self::canonical_app_id(bundle_id);
+            match self.create_app_scene(bundle_id, &display_uuid) {
+                Ok(()) => {
                     if initial_active_app == Some(canonical_id.as_str()) {
-                        Self::activate_scene(&mut scene)?;
-                        self.active_capture_app = Some(canonical_id.clone());
+                        self.active_capture_app = Some(canonical_id);
                     }
-                    info!("Created app scene for '{}'", bundle_id);
-                    self.app_scenes.insert(canonical_id, (scene, source));
                 }
                 Err(e) => {
                     warn!(
@@ -731,6 +762,18 @@ impl CaptureContext {
             }
         }
 
+        #[cfg(not(target_os = "macos"))]
+        {
+            self.app_scene_recency = warm
+                .into_iter()
+                .filter(|app| self.app_scenes.contains_key(app))
+                .collect();
+        }
+        #[cfg(target_os = "macos")]
+        {
+            self.app_scene_recency = self.app_scenes.keys().cloned().collect();
+        }
+
         // Assert the intended program scene: the initial active app's scene, or the blank
         // scene when no tracked app is frontmost.
         match self.active_capture_app.clone() {
@@ -758,6 +801,80 @@ impl CaptureContext {
         Ok(())
     }
 
+    /// Create the scene and capture source for one target app (not activated).
+    fn create_app_scene(&mut self, bundle_id: &str, display_uuid: &str) -> Result<()> {
+        let capture_audio = self.recording_config.enable_audio;
+        let restore_token = self.restore_tokens.get(bundle_id).cloned();
+        let context = self
+            .context
+            .as_mut()
+            .ok_or_else(|| anyhow::anyhow!("OBS context not initialized"))?;
+
+        let scene_name = Self::build_scene_name(&format!("scene_{}", bundle_id));
+        let mut scene = context
+            .scene(scene_name.as_str())
+            .context("Failed to create scene")?;
+        let source_name = format!("app_capture_{}", bundle_id);
+        let source = ScreenCaptureSource::new_application_capture(
+            context,
+            &mut scene,
+            &source_name,
+            bundle_id,
+            display_uuid,
+            capture_audio,
+            restore_token.as_deref(),
+        )?;
+        info!("Created app scene for '{}'", bundle_id);
+        // Key scenes by the canonical id so frontmost-derived lookups (also canonical)
+        // match regardless of how target_apps is cased. On macOS/Linux
+        // `canonical_app_id` is the identity, so this is the raw bundle id / process name.
+        self.app_scenes
+            .insert(Self::canonical_app_id(bundle_id), (scene, source));
+        Ok(())
+    }
+
+    /// Mark `app`'s scene as most recently focused and tear down the least recently
+    /// focused ones beyond `warm_app_scene_limit`. macOS never evicts: an SCK source
+    /// torn down here could only come back through a process restart.
+    fn touch_app_scene(&mut self, app: &str) {
+        self.app_scene_recency.retain(|a| a != app);
+        self.app_scene_recency.push_front(app.to_string());
+        #[cfg(not(target_os = "macos"))]
+        while self.app_scene_recency.len() > self.warm_app_scene_limit {
+            let Some(cold) = self.app_scene_recency.pop_back() else {
+                break;
+            };
+            self.drop_app_scene(&cold);
+        }
+    }
+
+    /// Tear down one (inactive) app's scene and source, releasing its capture session.
+    #[cfg(not(target_os = "macos"))]
+    fn drop_app_scene(&mut self, app: &str) {
+        if self.app_scenes.remove(app).is_none() {
+            return;
+        }
+        #[cfg(target_os = "linux")]
+        {
+            if let Some(window_id) = self.gnome_bound_window.remove(app) {
+                if let Some(gsc) = self.gnome_screencast.as_ref() {
+                    gsc.stop_window(window_id);
+                }
+            }
+            self.gnome_bind_failed.remove(app);
+            self.window_geometry.invalidate(app);
+        }
+        #[cfg(any(target_os = "linux", target_os = "windows"))]
+        if self
+            .last_monitor_fit
+            .as_ref()
+            .is_some_and(|(fit_app, ..)| fit_app == app)
+        {
+            self.last_monitor_fit = None;
+        }
+        info!("Tore down cold app scene for '{}'", app);
+    }
+
     /// Set up capture for display capture mode or legacy multi-source mode.
     /// On Linux, per-app capture must use `setup_app_scenes`; this path is display-only.
     fn setup_display_or_multi_capture(&mut self) -> Result<usize> {
@@ -777,6 +894,7 @@ impl CaptureContext {
         self.capture_sources.clear();
         self.scene = None;
         self.app_scenes.clear();
+        self.app_scene_recency.clear();
         self.blank_scene = None;
         // Leaving per-app mode: drop the Mutter ScreenCast manager (closes its sessions).
         #[cfg(target_os = "linux")]
@@ -1070,6 +1188,35 @@ impl CaptureContext {
         self.recording_config = config;
     }
 
+    /// Enable keyframe-aligned file splitting on recordings started from now on
+    /// (see [`Self::request_segment_split`])
+    pub fn set_split_file_rotation(&mut self, enabled: bool) {
+        self.recording_config.split_file = enabled;
+    }
+
+    /// Record fragmented MP4 (append-only, so it can be uploaded while it grows)
+    /// on recordings started from now on
+    pub fn set_fragmented_mp4(&mut self, enabled: bool) {
+        if enabled {
+            self.recording_config.format =
+                libobs_simple::output::simple::OutputFormat::FragmentedMP4;
+        }
+    }
+
+    /// Swap in a probed hardware encoder on recordings started from now on when
+    /// the output builder settles for software encoding
+    pub fn set_auto_hardware_encoder(&mut self, enabled: bool) {
+        self.recording_config.auto_hardware_encoder = enabled;
+    }
+
+    /// Encode with bitrate rate control at `kbps` instead of constant quality on
+    /// recordings started from now on, so the bitrate can be retargeted while
+    /// recording (see [`Self::set_video_bitrate`])
+    pub fn set_bitrate_rate_control(&mut self, kbps: u32) {
+        self.recording_config.crf = None;
+        self.recording_config.video_bitrate = kbps;
+    }
+
     /// The current recording canvas (base) dimensions in pixels — what OBS composites into,
     /// captured when the video info was last (re)built. With macOS multi-monitor on this is the
     /// normalized envelope; otherwise the display resolution. `(0, 0)` before initialize.
@@ -1227,6 +1374,7 @@ impl CaptureContext {
         };
 
         let session = self.current_session.take();
+        self.pending_split_session = None;
 
         info!("Stopping recording...");
 
@@ -1246,6 +1394,73 @@ impl CaptureContext {
         Ok(session)
     }
 
+    /// Ask the running output to continue into `next_session_id`'s file from its next
+    /// keyframe, keeping the encoder running. Returns `false` when the output can't split
+    /// (the caller then rotates with stop/start). Completion arrives via
+    /// [`Self::take_segment_split`].
+    pub fn request_segment_split(&mut self, next_session_id: &str) -> Result<bool> {
+        let next_path = self.generate_output_path(next_session_id);
+        let Some(recording) = self.recording.as_mut() else {
+            return Ok(false);
+        };
+        let accepted = recording
+            .request_split(&next_path)
+            .context("Failed to request file split")?;
+        if accepted {
+            info!("Requested file split into {:?}", next_path);
+            self.pending_split_session = Some(next_session_id.to_string());
+        }
+        Ok(accepted)
+    }
+
+    /// A requested split the output has completed: `(finished, started)` sessions. The
+    /// started session's `start_time_ns` is the split point, and it becomes the current one.
+    pub fn take_segment_split(&mut self) -> Option<(RecordingSession, RecordingSession)> {
+        let split = self.recording.as_mut()?.take_file_split()?;
+        // Splits only happen on request, so the pending session is always set
+        let session_id = self.pending_split_session.take().unwrap_or_default();
+        let started = RecordingSession {
+            session_id,
+            output_path: split.next_path,
+            start_time_ns: split.frame_time_ns,
+        };
+        let finished = self.current_session.replace(started.clone())?;
+
+        if let Ok(mut state) = self.state.write() {
+            state.recording.output_path = Some(started.output_path.clone());
+        }
+        info!(
+            "Recording split: {:?} -> {:?}",
+            finished.output_path, started.output_path
+        );
+        Some((finished, started))
+    }
+
+    /// Retarget the video bitrate of the running recording, and of recordings started
+    /// later. Returns `false` when no recording is running or its encoder isn't
+    /// bitrate-controlled.
+    pub fn set_video_bitrate(&mut self, kbps: u32) -> Result<bool> {
+        self.recording_config.video_bitrate = kbps;
+        let Some(recording) = self.recording.as_mut() else {
+            return Ok(false);
+        };
+        recording
+            .set_video_bitrate(kbps)
+            .context("Failed to update video bitrate")
+    }
+
+    /// Advance the running recording's hardware encoder trial, if any
+    pub fn poll_encoder_trial(&mut self) {
+        if let Some(recording) = self.recording.as_mut() {
+            recording.poll_encoder_trial();
+        }
+    }
+
+    /// Encoded bytes written by the running recording, if any
+    pub fn recording_total_bytes(&self) -> Option<u64> {
+        self.recording.as_ref().map(|r| r.total_bytes())
+    }
+
     /// Check if currently recording
     pub fn is_recording(&self) -> bool {
         self.recording.as_ref().map_or(false, |r| r.is_recording())
@@ -1323,10 +1538,12 @@ impl CaptureContext {
         }
     }
 
-    /// Check if an app needs a scene created (wasn't running at startup).
+    /// Check if an app needs a scene created (wasn't running at startup). Only ever true on
+    /// macOS: elsewhere a missing scene is created on first focus.
     pub fn needs_scene_for_app(&self, bundle_id: &str) -> bool {
         let canonical = Self::canonical_app_id(bundle_id);
-        self.use_single_active_app_capture()
+        cfg!(target_os = "macos")
+            && self.use_single_active_app_capture()
             && self
                 .target_apps
                 .iter()
@@ -1464,6 +1681,7 @@ impl CaptureContext {
                 "GNOME follow-focus: created scene for '{}' bound to focused window {} (node {})",
                 bundle_id, window_id, node
             );
+            self.touch_app_scene(bundle_id);
         }
 
         self.gnome_bound_window
@@ -1474,6 +1692,7 @@ impl CaptureContext {
         // Re-point changes which window (and possibly which monitor) is captured, so the prior
         // fit no longer applies; force a recompute on the next apply.
         self.last_monitor_fit = None;
+        self.window_geometry.invalidate(bundle_id);
         self.update_capture_state_flags();
         Ok(true)
     }
@@ -1507,7 +1726,8 @@ impl CaptureContext {
     /// geometry comes from the GNOME focus extension (logical coords) or X11/RandR (physical);
     /// the scene scale is derived from the captured buffer size, so HiDPI / fractional scaling
     /// needs no trusted scale factor. De-duped via `last_monitor_fit`; a no-op until the source
-    /// has non-zero dimensions, and off single-active per-app mode. Safe to call every poll.
+    /// has non-zero dimensions, and off single-active per-app mode. Safe to call every poll: the
+    /// geometry is cached (`window_geometry`) until a configure/move or focus change is signalled.
     #[cfg(target_os = "linux")]
     pub fn apply_monitor_fit_to_active(&mut self) {
         use libobs_wrapper::enums::{obs_alignment, ObsBoundsType};
@@ -1520,7 +1740,11 @@ impl CaptureContext {
         let Some(app) = self.active_capture_app.clone() else {
             return;
         };
-        let Some((win, mon, monitor_scale)) = self.active_window_monitor_rects(&app) else {
+        let gnome_screencast = self.gnome_screencast.as_ref();
+        let gnome_bound_window = &self.gnome_bound_window;
+        let Some((win, mon, monitor_scale)) = self.window_geometry.get_or_fetch(&app, || {
+            Self::active_window_monitor_rects(gnome_screencast, gnome_bound_window, &app)
+        }) else {
             return;
         };
         let Some(fit) = super::monitor_layout::fit_for_window(win, mon, monitor_scale) else {
@@ -1570,7 +1794,8 @@ impl CaptureContext {
     /// if geometry isn't resolvable right now — caller skips the fit and retries next poll.
     #[cfg(target_os = "linux")]
     fn active_window_monitor_rects(
-        &self,
+        gnome_screencast: Option<&super::gnome_screencast::GnomeScreenCast>,
+        gnome_bound_window: &HashMap<String, u64>,
         app: &str,
     ) -> Option<(
         super::monitor_layout::Rect,
@@ -1578,8 +1803,8 @@ impl CaptureContext {
         f64,
     )> {
         use super::monitor_layout::Rect;
-        if let Some(gsc) = self.gnome_screencast.as_ref() {
-            let window_id = *self.gnome_bound_window.get(app)?;
+        if let Some(gsc) = gnome_screencast {
+            let window_id = *gnome_bound_window.get(app)?;
             let g = gsc.window_geometry(window_id)?;
             if !g.found {
                 return None;
@@ -1606,8 +1831,9 @@ impl CaptureContext {
         None
     }
 
-    /// Switch to a different app's pre-created scene.
-    /// Instant — just activates the target scene on channel 0.
+    /// Switch to a different app's scene.
+    /// Instant when the scene is warm — just activates it on channel 0. Off macOS a cold
+    /// app's scene is created here first (GNOME creates it in `gnome_ensure_focused_window`).
     pub fn switch_active_app_capture(&mut self, active_app: Option<&str>) -> Result<bool> {
         if !self.use_single_active_app_capture() {
             return Ok(false);
@@ -1620,6 +1846,15 @@ impl CaptureContext {
 
         match &next_app {
             Some(bundle_id) => {
+                #[cfg(not(target_os = "macos"))]
+                if !self.app_scenes.contains_key(bundle_id.as_str()) && !self.is_gnome_dynamic() {
+                    let created = get_main_display_uuid()
+                        .and_then(|display_uuid| self.create_app_scene(bundle_id, &display_uuid));
+                    if let Err(e) = created {
+                        warn!("Failed to create capture source for '{}': {}", bundle_id, e);
+                    }
+                }
+                let warm = self.app_scenes.contains_key(bundle_id.as_str());
                 if let Some((scene, source)) = self.app_scenes.get_mut(bundle_id.as_str()) {
                     // X11: the app's window id is ephemeral and the focused window may have
                     // changed since this scene was created — re-resolve and re-point the
@@ -1645,6 +1880,9 @@ impl CaptureContext {
                     }
                     warn!("No scene for '{}'; showing blank", bundle_id);
                 }
+                if warm {
+                    self.touch_app_scene(bundle_id);
+                }
             }
             None => {
                 if let Some(blank) = self.blank_scene.as_mut() {
@@ -1769,6 +2007,8 @@ impl CaptureContext {
     /// resolved via CGWindowList only when the app is the frontmost app (single-active tracks
     /// frontmost); when it isn't, the current placement is kept to avoid churning as focus flicks
     /// to non-target apps, and the main display is the default only for the first placement.
+    /// The resolution is cached per app (`window_geometry`) until an AX move/resize or focus
+    /// change is signalled, so a still window costs no window-list enumeration per poll.
     ///
     /// De-duped via `last_monitor_fit`; gated on the kill-switch flag AND single-active mode; a
     /// no-op until a scene exists. Safe to call every poll.
@@ -1790,7 +2030,10 @@ impl CaptureContext {
         // back to the main display only for the very first placement of this app.
         let resolved = get_frontmost_app()
             .filter(|f| f.bundle_id == app)
-            .and_then(|f| super::mac_geometry::window_display_for_pid(f.pid));
+            .and_then(|f| {
+                self.window_geometry
+                    .get_or_fetch(&app, || super::mac_geometry::window_display_for_pid(f.pid))
+            });
         let target = match resolved {
             Some(t) => t,
             None => {
@@ -2025,29 +2268,49 @@ fn obs_runtime_root() -> Option<PathBuf> {
     Some(PathBuf::from(home).join("Library/Application Support/dev.crowd-cast.agent/obs/current"))
 }
 
+#[cfg(any(target_os = "macos", target_os = "linux"))]
+fn startup_paths(paths: &super::plugin_manifest::RuntimePaths) -> StartupPaths {
+    StartupPaths::new(
+        ObsPath::new(paths.data.to_string_lossy().as_ref()),
+        ObsPath::new(paths.plugin_bin.to_string_lossy().as_ref()),
+        ObsPath::new(paths.plugin_data.to_string_lossy().as_ref()),
+    )
+}
+
 #[cfg(target_os = "macos")]
-fn obs_startup_paths_from_env() -> Option<StartupPaths> {
+fn obs_startup_paths_from_env(unused_plugins: &[&str]) -> Option<StartupPaths> {
     let runtime_root = obs_runtime_root()?;
+    let plugin_dir = runtime_root.join("obs-plugins");
+
+    // Warm start: the runtime was validated when these were recorded
+    if let Some(paths) = super::plugin_manifest::cached_startup_paths(&plugin_dir, unused_plugins) {
+        info!(
+            "Using external OBS runtime paths from {} (cached)",
+            runtime_root.display()
+        );
+        return Some(startup_paths(&paths));
+    }
 
     if !runtime_root.exists() {
         return None;
     }
 
     let libobs_data = runtime_root.join("data/libobs");
-    let plugin_bin = runtime_root.join("obs-plugins/%module%.plugin/Contents/MacOS");
-    let plugin_data = runtime_root.join("data/obs-plugins/%module%");
-
-    let paths = StartupPaths::new(
-        ObsPath::new(libobs_data.to_string_lossy().as_ref()),
-        ObsPath::new(plugin_bin.to_string_lossy().as_ref()),
-        ObsPath::new(plugin_data.to_string_lossy().as_ref()),
-    );
+    let selected_dir =
+        super::plugin_manifest::selected_plugin_dir(&plugin_dir, ".plugin", unused_plugins)
+            .unwrap_or_else(|| plugin_dir.clone());
+    let paths = super::plugin_manifest::RuntimePaths {
+        data: libobs_data,
+        plugin_bin: selected_dir.join("%module%.plugin/Contents/MacOS"),
+        plugin_data: runtime_root.join("data/obs-plugins/%module%"),
+    };
+    super::plugin_manifest::record_startup_paths(&plugin_dir, unused_plugins, &paths);
 
     info!(
         "Using external OBS runtime paths from {}",
         runtime_root.display()
     );
-    Some(paths)
+    Some(startup_paths(&paths))
 }
 
 /// Compile-time OBS ABI this binary's libobs bindings target (e.g. "32.0.2"), baked by build.rs.
@@ -2075,20 +2338,33 @@ fn bundle_is_present(root: &std::path::Path) -> bool {
 /// StartupPaths for the self-provisioned bundle (tree rooted at `usr/`). Matches the layout
 /// produced by packaging/linux/build-bundle.sh and the legacy CROWD_CAST_OBS_* vars.
 #[cfg(target_os = "linux")]
-fn self_provisioned_startup_paths() -> Option<StartupPaths> {
+fn self_provisioned_startup_paths(unused_plugins: &[&str]) -> Option<StartupPaths> {
     let root = self_provisioned_bundle_root()?;
+    let plugin_dir = root.join("usr/lib/obs-plugins");
+
+    // Warm start: the bundle was validated when these were recorded
+    if let Some(paths) = super::plugin_manifest::cached_startup_paths(&plugin_dir, unused_plugins) {
+        info!(
+            "Using self-provisioned libobs bundle at {} (cached)",
+            root.display()
+        );
+        return Some(startup_paths(&paths));
+    }
+
     if !bundle_is_present(&root) {
         return None;
     }
-    let data = root.join("usr/share/obs/libobs");
-    let plugin_bin = root.join("usr/lib/obs-plugins");
-    let plugin_data = root.join("usr/share/obs/obs-plugins/%module%");
+    let plugin_bin =
+        super::plugin_manifest::selected_plugin_dir(&plugin_dir, ".so", unused_plugins)
+            .unwrap_or_else(|| plugin_dir.clone());
+    let paths = super::plugin_manifest::RuntimePaths {
+        data: root.join("usr/share/obs/libobs"),
+        plugin_bin,
+        plugin_data: root.join("usr/share/obs/obs-plugins/%module%"),
+    };
+    super::plugin_manifest::record_startup_paths(&plugin_dir, unused_plugins, &paths);
     info!("Using self-provisioned libobs bundle at {}", root.display());
-    Some(StartupPaths::new(
-        ObsPath::new(data.to_string_lossy().as_ref()),
-        ObsPath::new(plugin_bin.to_string_lossy().as_ref()),
-        ObsPath::new(plugin_data.to_string_lossy().as_ref()),
-    ))
+    Some(startup_paths(&paths))
 }
 
 /// Resolve libobs runtime paths for Linux, in precedence order:
@@ -2097,11 +2373,12 @@ fn self_provisioned_startup_paths() -> Option<StartupPaths> {
 ///      `CROWD_CAST_OBS_PLUGIN_DATA_PATH`.
 ///   2. The self-provisioned bundle shipped with the binary
 ///      (`~/.local/share/crowd-cast/obs/<abi>/usr/...`, ABI baked at build time) — the default,
-///      so the bare binary needs no env/wrapper.
+///      so the bare binary needs no env/wrapper. Only its plugins outside `unused_plugins`
+///      are loaded (see `plugin_manifest`); the env overrides and a system install load all.
 ///   3. `None` -> `StartupInfo::default()`, which points libobs-wrapper at a system OBS install
 ///      (`/usr/share/obs/libobs` + `/usr/lib/<arch>/obs-plugins`).
 #[cfg(target_os = "linux")]
-fn obs_startup_paths_from_env() -> Option<StartupPaths> {
+fn obs_startup_paths_from_env(unused_plugins: &[&str]) -> Option<StartupPaths> {
     if let (Ok(data), Ok(plugin_bin), Ok(plugin_data)) = (
         std::env::var("CROWD_CAST_OBS_DATA_PATH"),
         std::env::var("CROWD_CAST_OBS_PLUGIN_BIN_PATH"),
@@ -2118,7 +2395,7 @@ fn obs_startup_paths_from_env() -> Option<StartupPaths> {
         ));
     }
 
-    self_provisioned_startup_paths()
+    self_provisioned_startup_paths(unused_plugins)
 }
 
 #[cfg(not(target_os = "linux"))]
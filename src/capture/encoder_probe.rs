@@ -0,0 +1,432 @@
+//! Hardware video encoder probe with a per-machine verdict cache
+//!
+//! The output builder picks an encoder from the codec preference alone, and
+//! where its hardware list misses the machine's GPU encoders (notably VAAPI on
+//! Linux) it silently settles for obs-x264, which can take a whole core. Once
+//! the OBS modules are loaded, the registered video encoders are enumerated
+//! instead, and when the builder chose software but a hardware encoder is
+//! present, the recording runs on the cheapest one not yet ruled out:
+//! 1. an encoder that kept up before on this machine
+//! 2. the preferred codec before the others
+//! 3. a texture encoder (frames stay on the GPU) before a system-memory one
+//!
+//! The swapped-in encoder is on trial for [`TRIAL_WINDOW`] of recording at the
+//! real canvas: if OBS has to skip more than [`MAX_SKIPPED_FRACTION`] of frames
+//! waiting on it, it is marked slow; if the output won't start with it, failed.
+//! Verdicts persist in `encoder_verdicts.json` keyed by output resolution and
+//! frame rate, so a bad encoder costs one trial per profile rather than every
+//! recording, and switching between profiles keeps what each one learned.
+//!
+//! Swapped encoders use bitrate rate control at the configured video bitrate:
+//! the builder's constant-quality mapping is per encoder and not exposed. That
+//! changes the output for constant-quality (CRF) setups, so the swap is opt-in
+//! (`recording.auto_hardware_encoder`).
+
+use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::ffi::{c_char, CStr, CString};
+use std::path::{Path, PathBuf};
+use std::time::{Duration, Instant};
+use tracing::{debug, info, warn};
+
+/// Recording time an encoder is watched before it is judged
+const TRIAL_WINDOW: Duration = Duration::from_secs(10);
+
+/// Share of frames OBS may skip for encoder lag and still count as keeping up
+const MAX_SKIPPED_FRACTION: f64 = 0.02;
+
+/// Encoder implementation family, from the OBS encoder id
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(super) enum EncoderFamily {
+    VideoToolbox,
+    Nvenc,
+    Qsv,
+    Amf,
+    Vaapi,
+    Software,
+}
+
+impl EncoderFamily {
+    fn of(id: &str) -> Self {
+        let id = id.to_ascii_lowercase();
+        if id.contains("videotoolbox") {
+            Self::VideoToolbox
+        } else if id.contains("nvenc") {
+            Self::Nvenc
+        } else if id.contains("qsv") {
+            Self::Qsv
+        } else if id.contains("amf") {
+            Self::Amf
+        } else if id.contains("vaapi") {
+            Self::Vaapi
+        } else {
+            Self::Software
+        }
+    }
+
+    fn is_hardware(self) -> bool {
+        self != Self::Software
+    }
+}
+
+/// A registered OBS video encoder
+#[derive(Debug, Clone)]
+pub(super) struct VideoEncoder {
+    pub id: String,
+    /// "h264", "hevc" or "av1"
+    pub codec: String,
+    pub family: EncoderFamily,
+    /// Takes GPU textures directly (`OBS_ENCODER_CAP_PASS_TEXTURE`)
+    pub texture: bool,
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub(super) enum Verdict {
+    KeepsUp,
+    Slow,
+    Failed,
+}
+
+/// Every usable video encoder the loaded modules registered
+fn registered_video_encoders() -> Vec<VideoEncoder> {
+    let mut encoders = Vec::new();
+    let mut index = 0;
+    loop {
+        let mut id: *const c_char = std::ptr::null();
+        if !unsafe { libobs::obs_enum_encoder_types(index, &mut id) } {
+            break;
+        }
+        index += 1;
+        if id.is_null() {
+            continue;
+        }
+        unsafe {
+            if libobs::obs_get_encoder_type(id) != libobs::obs_encoder_type_OBS_ENCODER_VIDEO {
+                continue;
+            }
+            let caps = libobs::obs_get_encoder_caps(id);
+            if caps & (libobs::OBS_ENCODER_CAP_DEPRECATED | libobs::OBS_ENCODER_CAP_INTERNAL) != 0 {
+                continue;
+            }
+            let codec = libobs::obs_get_encoder_codec(id);
+            if codec.is_null() {
+                continue;
+            }
+            let id = CStr::from_ptr(id).to_string_lossy().into_owned();
+            encoders.push(VideoEncoder {
+                family: EncoderFamily::of(&id),
+                id,
+                codec: CStr::from_ptr(codec).to_string_lossy().into_owned(),
+                texture: caps & libobs::OBS_ENCODER_CAP_PASS_TEXTURE != 0,
+            });
+        }
+    }
+    encoders
+}
+
+/// The hardware encoder to try, best first (see the module docs for the order)
+fn choose<'a>(
+    encoders: &'a [VideoEncoder],
+    preferred_codec: &str,
+    verdicts: &HashMap<String, Verdict>,
+) -> Option<&'a VideoEncoder> {
+    encoders
+        .iter()
+        .filter(|e| e.family.is_hardware())
+        .filter(|e| !matches!(verdicts.get(&e.id), Some(Verdict::Slow | Verdict::Failed)))
+        .min_by_key(|e| {
+            (
+                verdicts.get(&e.id) != Some(&Verdict::KeepsUp),
+                e.codec != preferred_codec,
+                !e.texture,
+            )
+        })
+}
+
+/// Verdicts by output profile (resolution and frame rate), then encoder id
+type VerdictFile = HashMap<String, HashMap<String, Verdict>>;
+
+fn verdicts_path() -> Option<PathBuf> {
+    directories::ProjectDirs::from("dev", "crowd-cast", "agent")
+        .map(|p| p.data_dir().join("encoder_verdicts.json"))
+}
+
+fn read_verdict_file(path: &Path) -> VerdictFile {
+    std::fs::read_to_string(path)
+        .ok()
+        .and_then(|json| serde_json::from_str(&json).ok())
+        .unwrap_or_default()
+}
+
+/// Verdicts for `profile`; those reached at another resolution or rate don't apply
+fn load_verdicts(path: &Path, profile: &str) -> HashMap<String, Verdict> {
+    read_verdict_file(path).remove(profile).unwrap_or_default()
+}
+
+/// Merge one verdict into the file at `path`, keeping every other profile's
+fn store_verdict(path: &Path, profile: &str, id: &str, verdict: Verdict) -> std::io::Result<()> {
+    let mut file = read_verdict_file(path);
+    let verdicts = file.entry(profile.to_string()).or_default();
+    if verdicts.get(id) == Some(&verdict) {
+        return Ok(());
+    }
+    verdicts.insert(id.to_string(), verdict);
+    if let Some(parent) = path.parent() {
+        std::fs::create_dir_all(parent)?;
+    }
+    std::fs::write(path, serde_json::to_string_pretty(&file)?)
+}
+
+fn record_verdict(profile: &str, id: &str, verdict: Verdict) {
+    let Some(path) = verdicts_path() else {
+        return;
+    };
+    if let Err(e) = store_verdict(&path, profile, id, verdict) {
+        warn!("Failed to save encoder verdict for {}: {}", id, e);
+    }
+}
+
+/// `(skipped, total)` frames of the OBS video output so far
+fn video_frame_counts() -> (u32, u32) {
+    unsafe {
+        let video = libobs::obs_get_video();
+        (
+            libobs::video_output_get_skipped_frames(video),
+            libobs::video_output_get_total_frames(video),
+        )
+    }
+}
+
+/// A hardware encoder swapped into the recording output, under evaluation
+pub(super) struct EncoderTrial {
+    /// Our reference to the swapped-in encoder, released on drop
+    encoder: *mut libobs::obs_encoder_t,
+    /// The builder's encoder, still owned by the wrapper
+    original: *mut libobs::obs_encoder_t,
+    id: String,
+    profile: String,
+    /// Frame counts when recording was first seen running
+    baseline: Option<(Instant, u32, u32)>,
+    judged: bool,
+}
+
+// libobs encoder and output calls are thread-safe.
+unsafe impl Send for EncoderTrial {}
+
+impl EncoderTrial {
+    /// Swap a hardware encoder into `output` if the builder settled for a
+    /// software one. `None` leaves the builder's choice in place.
+    pub(super) fn begin(
+        output: *mut libobs::obs_output_t,
+        preferred_codec: &str,
+        bitrate_kbps: u32,
+        fps: u32,
+    ) -> Option<Self> {
+        let original = unsafe { libobs::obs_output_get_video_encoder(output) };
+        if original.is_null() {
+            return None;
+        }
+        let original_id = unsafe { CStr::from_ptr(libobs::obs_encoder_get_id(original)) }
+            .to_string_lossy()
+            .into_owned();
+        if EncoderFamily::of(&original_id).is_hardware() {
+            debug!("Recording on hardware encoder {}", original_id);
+            return None;
+        }
+
+        let profile = unsafe {
+            let video = libobs::obs_get_video();
+            format!(
+                "{}x{}@{}",
+                libobs::video_output_get_width(video),
+                libobs::video_output_get_height(video),
+                fps
+            )
+        };
+        let verdicts = verdicts_path()
+            .map(|path| load_verdicts(&path, &profile))
+            .unwrap_or_default();
+        let encoders = registered_video_encoders();
+        let Some(candidate) = choose(&encoders, preferred_codec, &verdicts) else {
+            warn!(
+                "Recording on software encoder {}: no usable hardware encoder among {:?}",
+                original_id,
+                encoders.iter().map(|e| e.id.as_str()).collect::<Vec<_>>()
+            );
+            return None;
+        };
+
+        let id = CString::new(candidate.id.as_str()).ok()?;
+        let encoder = unsafe {
+            let settings = libobs::obs_data_create();
+            libobs::obs_data_set_string(settings, c"rate_control".as_ptr(), c"CBR".as_ptr());
+            libobs::obs_data_set_int(settings, c"bitrate".as_ptr(), i64::from(bitrate_kbps));
+            let encoder = libobs::obs_video_encoder_create(
+                id.as_ptr(),
+                c"recording_video_hw".as_ptr(),
+                settings,
+                std::ptr::null_mut(),
+            );
+            libobs::obs_data_release(settings);
+            encoder
+        };
+        if encoder.is_null() {
+            warn!("Failed to create hardware encoder {}", candidate.id);
+            record_verdict(&profile, &candidate.id, Verdict::Failed);
+            return None;
+        }
+        unsafe {
+            libobs::obs_encoder_set_video(encoder, libobs::obs_get_video());
+            libobs::obs_output_set_video_encoder(output, encoder);
+        }
+        info!(
+            "Builder chose software encoder {}; recording on hardware encoder {} ({}) instead",
+            original_id, candidate.id, candidate.codec
+        );
+        Some(Self {
+            encoder,
+            original,
+            id: candidate.id.clone(),
+            profile,
+            baseline: None,
+            judged: false,
+        })
+    }
+
+    /// The output wouldn't start on the trial encoder: put the builder's back
+    pub(super) fn fail(&self, output: *mut libobs::obs_output_t) {
+        warn!(
+            "Recording output failed to start on {}; using the default encoder",
+            self.id
+        );
+        record_verdict(&self.profile, &self.id, Verdict::Failed);
+        unsafe { libobs::obs_output_set_video_encoder(output, self.original) };
+    }
+
+    /// Watch the running recording and judge the encoder once the window is up
+    pub(super) fn poll(&mut self) {
+        if self.judged {
+            return;
+        }
+        let (skipped, total) = video_frame_counts();
+        let Some((started, base_skipped, base_total)) = self.baseline else {
+            self.baseline = Some((Instant::now(), skipped, total));
+            return;
+        };
+        if started.elapsed() < TRIAL_WINDOW {
+            return;
+        }
+        self.judged = true;
+        let frames = total.saturating_sub(base_total).max(1);
+        let skipped_fraction = f64::from(skipped.saturating_sub(base_skipped)) / f64::from(frames);
+        let verdict = if skipped_fraction > MAX_SKIPPED_FRACTION {
+            warn!(
+                "Hardware encoder {} skipped {:.1}% of frames at {}; not using it for later \
+                 recordings",
+                self.id,
+                skipped_fraction * 100.0,
+                self.profile
+            );
+            Verdict::Slow
+        } else {
+            info!("Hardware encoder {} keeps up at {}", self.id, self.profile);
+            Verdict::KeepsUp
+        };
+        record_verdict(&self.profile, &self.id, verdict);
+    }
+}
+
+impl Drop for EncoderTrial {
+    fn drop(&mut self) {
+        // Destroying the encoder detaches it from the output
+        unsafe { libobs::obs_encoder_release(self.encoder) };
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn encoder(id: &str, codec: &str, texture: bool) -> VideoEncoder {
+        VideoEncoder {
+            id: id.to_string(),
+            codec: codec.to_string(),
+            family: EncoderFamily::of(id),
+            texture,
+        }
+    }
+
+    #[test]
+    fn prefers_preferred_codec_then_texture_encoders() {
+        let encoders = [
+            encoder("obs_x264", "h264", false),
+            encoder("ffmpeg_vaapi", "h264", false),
+            encoder("ffmpeg_vaapi_tex", "h264", true),
+            encoder("hevc_ffmpeg_vaapi", "hevc", false),
+            encoder("hevc_ffmpeg_vaapi_tex", "hevc", true),
+        ];
+        let verdicts = HashMap::new();
+        assert_eq!(
+            choose(&encoders, "hevc", &verdicts).map(|e| e.id.as_str()),
+            Some("hevc_ffmpeg_vaapi_tex")
+        );
+        assert_eq!(
+            choose(&encoders, "h264", &verdicts).map(|e| e.id.as_str()),
+            Some("ffmpeg_vaapi_tex")
+        );
+    }
+
+    #[test]
+    fn verdicts_rule_out_and_favour_encoders() {
+        let encoders = [
+            encoder("obs_x264", "h264", false),
+            encoder("jim_hevc_nvenc", "hevc", true),
+            encoder("jim_nvenc", "h264", true),
+        ];
+        let mut verdicts = HashMap::new();
+        verdicts.insert("jim_hevc_nvenc".to_string(), Verdict::Slow);
+        assert_eq!(
+            choose(&encoders, "hevc", &verdicts).map(|e| e.id.as_str()),
+            Some("jim_nvenc")
+        );
+        verdicts.insert("jim_nvenc".to_string(), Verdict::Failed);
+        assert!(choose(&encoders, "hevc", &verdicts).is_none());
+
+        verdicts.clear();
+        verdicts.insert("jim_nvenc".to_string(), Verdict::KeepsUp);
+        assert_eq!(
+            choose(&encoders, "hevc", &verdicts).map(|e| e.id.as_str()),
+            Some("jim_nvenc")
+        );
+    }
+
+    #[test]
+    fn verdicts_are_kept_per_profile() {
+        let dir = std::env::temp_dir().join(format!("cc-verdicts-{}", uuid::Uuid::new_v4()));
+        let path = dir.join("encoder_verdicts.json");
+        store_verdict(&path, "1920x1080@30", "jim_nvenc", Verdict::KeepsUp).unwrap();
+        store_verdict(&path, "3840x2160@60", "jim_nvenc", Verdict::Slow).unwrap();
+        store_verdict(&path, "1920x1080@30", "ffmpeg_vaapi", Verdict::Failed).unwrap();
+
+        let hd = load_verdicts(&path, "1920x1080@30");
+        assert_eq!(hd.get("jim_nvenc"), Some(&Verdict::KeepsUp));
+        assert_eq!(hd.get("ffmpeg_vaapi"), Some(&Verdict::Failed));
+        let uhd = load_verdicts(&path, "3840x2160@60");
+        assert_eq!(uhd.get("jim_nvenc"), Some(&Verdict::Slow));
+        assert!(load_verdicts(&path, "1280x720@30").is_empty());
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn classifies_encoder_families() {
+        assert_eq!(
+            EncoderFamily::of("com.apple.videotoolbox.videoencoder.ave.hevc"),
+            EncoderFamily::VideoToolbox
+        );
+        assert_eq!(EncoderFamily::of("obs_qsv11_v2"), EncoderFamily::Qsv);
+        assert_eq!(EncoderFamily::of("h265_texture_amf"), EncoderFamily::Amf);
+        assert_eq!(EncoderFamily::of("obs_x264"), EncoderFamily::Software);
+    }
+}
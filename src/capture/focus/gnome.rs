@@ -6,6 +6,9 @@
 //! before the post-install relogin), the initial `GetFocused` call fails and we retry, so
 //! the provider goes live on its own once the extension appears — no crowd-cast restart.
 //!
+//! The same connection relays the extension's `GeometryChanged` signal to
+//! `geometry_events`, so the per-app monitor fit can cache the focused window's geometry.
+//!
 //! NOTE: this path is authored against the zbus API and compiles, but is not exercised on
 //! this (sway) machine; it needs validation on a GNOME Wayland session.
 
@@ -45,6 +48,9 @@ pub fn spawn(state: Arc<FocusState>) {
                     // on its own once the extension appears (e.g. after the relogin).
                     state.set_live(false);
                     state.set(None);
+                    crate::capture::focus_events::set_push_active(false);
+                    crate::capture::focus_events::notify();
+                    crate::capture::geometry_events::set_push_active(false);
                     tokio::time::sleep(Duration::from_secs(2)).await;
                 }
             });
@@ -64,18 +70,75 @@ async fn run_once(state: &Arc<FocusState>) -> zbus::Result<()> {
         proxy.call("GetFocused", &()).await?;
     state.set_live(true);
     publish(state, window_id, pid, wm_class);
+    crate::capture::focus_events::set_push_active(true);
     tracing::info!("follow-focus(gnome): focus extension connected");
 
     // Event-driven updates.
     let mut signals = proxy.receive_signal("FocusChanged").await?;
-    while let Some(msg) = signals.next().await {
-        let (window_id, pid, wm_class, _title): (u64, i32, String, String) =
-            msg.body().deserialize()?;
-        publish(state, window_id, pid, wm_class);
+    // An extension from before `GeometryChanged` (still loaded until the next relogin after an
+    // upgrade) would never send it, so only subscribe — and let geometry be cached — when the
+    // loaded extension declares it.
+    let mut geometry = if declares_geometry_signal(&conn).await {
+        let stream = proxy.receive_signal("GeometryChanged").await?;
+        crate::capture::geometry_events::set_push_active(true);
+        crate::capture::geometry_events::notify();
+        Some(stream)
+    } else {
+        tracing::info!("follow-focus(gnome): extension predates GeometryChanged; polling geometry");
+        None
+    };
+    loop {
+        tokio::select! {
+            msg = signals.next() => {
+                let Some(msg) = msg else { break };
+                let (window_id, pid, wm_class, _title): (u64, i32, String, String) =
+                    msg.body().deserialize()?;
+                publish(state, window_id, pid, wm_class);
+            }
+            msg = next_or_pending(geometry.as_mut()) => {
+                if msg.is_none() {
+                    break;
+                }
+                crate::capture::geometry_events::notify();
+            }
+        }
     }
     Ok(())
 }
 
+/// Whether the loaded extension's interface has the `GeometryChanged` signal.
+async fn declares_geometry_signal(conn: &zbus::Connection) -> bool {
+    let introspection = async {
+        zbus::fdo::IntrospectableProxy::builder(conn)
+            .destination(BUS_NAME)?
+            .path(OBJ_PATH)?
+            .build()
+            .await?
+            .introspect()
+            .await
+            .map_err(zbus::Error::from)
+    };
+    match introspection.await {
+        Ok(xml) => xml.contains("GeometryChanged"),
+        Err(e) => {
+            tracing::debug!("follow-focus(gnome): introspection failed: {e}");
+            false
+        }
+    }
+}
+
+/// The next message of an optional signal stream; never resolves without one.
+async fn next_or_pending(
+    stream: Option<&mut zbus::proxy::SignalStream<'_>>,
+) -> Option<zbus::Message> {
+    use futures::StreamExt;
+
+    match stream {
+        Some(stream) => stream.next().await,
+        None => std::future::pending().await,
+    }
+}
+
 /// One-shot enumeration of all open windows' `wm_class` via the extension's `ListWindows`.
 /// This is the SAME `get_wm_class()` value the focus signal (and thus the gate) reports, so
 /// the wizard's app list and runtime gating agree by construction — no `.desktop`/wm_class
@@ -122,4 +185,6 @@ fn publish(state: &Arc<FocusState>, window_id: u64, pid: i32, wm_class: String)
             window_id: if window_id > 0 { Some(window_id) } else { None },
         }));
     }
+    // Wake the engine to re-resolve now instead of on its next safety-net poll.
+    crate::capture::focus_events::notify();
 }
@@ -0,0 +1,288 @@
+//! Push notifications for frontmost-app changes
+//!
+//! The engine used to learn about app switches only by polling
+//! `get_frontmost_app` every `poll_interval_ms`, so a switch was noticed up to
+//! one interval late and every idle tick paid for a full foreground query. Each
+//! platform can instead tell us when focus moves:
+//! - **macOS**: `NSWorkspaceDidActivateApplicationNotification`
+//! - **Windows**: `SetWinEventHook(EVENT_SYSTEM_FOREGROUND)`
+//! - **X11**: `PropertyNotify` for `_NET_ACTIVE_WINDOW` on the root window
+//! - **GNOME Wayland**: the focus extension's `FocusChanged` D-Bus signal (see
+//!   `focus::gnome`), which already drives the focus snapshot
+//!
+//! A watcher only signals that focus *may* have changed (bumping
+//! [`generation`]); the engine still resolves the app through
+//! `get_frontmost_app`, so identity rules (self filtering, fail-closed Wayland
+//! identity) live in one place. While a watcher is live the engine reuses its
+//! last resolution until the generation moves, re-querying only on a slow
+//! safety-net interval.
+
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::OnceLock;
+use tokio::sync::Notify;
+
+fn changed() -> &'static Notify {
+    static N: OnceLock<Notify> = OnceLock::new();
+    N.get_or_init(Notify::new)
+}
+
+static PUSH_ACTIVE: AtomicBool = AtomicBool::new(false);
+static GENERATION: AtomicU64 = AtomicU64::new(0);
+
+/// Signal that the focused application may have changed. Cheap and callable
+/// from any thread; repeated calls before the engine wakes coalesce into one.
+pub fn notify() {
+    GENERATION.fetch_add(1, Ordering::SeqCst);
+    changed().notify_one();
+}
+
+/// Count of focus-change signals so far. A cached frontmost resolution taken
+/// at generation `g` is stale once this differs from `g`.
+pub fn generation() -> u64 {
+    GENERATION.load(Ordering::SeqCst)
+}
+
+/// Wait for the next focus-change signal.
+pub async fn wait() {
+    changed().notified().await;
+}
+
+/// Whether a push watcher is currently delivering focus changes. While `false`
+/// the engine must re-resolve the frontmost app on every poll.
+pub fn is_push_active() -> bool {
+    PUSH_ACTIVE.load(Ordering::SeqCst)
+}
+
+/// Mark whether a push watcher is live (set by the watcher itself, so a watcher
+/// that dies falls back to full-rate polling).
+pub(crate) fn set_push_active(active: bool) {
+    PUSH_ACTIVE.store(active, Ordering::SeqCst);
+}
+
+/// Start the platform focus watcher exactly once (idempotent). Failure to start
+/// is logged and leaves the engine on full-rate polling.
+pub fn ensure_started() {
+    static ONCE: OnceLock<()> = OnceLock::new();
+    ONCE.get_or_init(|| {
+        #[cfg(target_os = "macos")]
+        macos_watch::start();
+        #[cfg(target_os = "windows")]
+        windows_watch::start();
+        #[cfg(target_os = "linux")]
+        {
+            // GNOME Wayland pushes through the focus provider (it toggles PUSH_ACTIVE with its
+            // D-Bus connection); other Wayland compositors have no focus source to watch.
+            if !crate::capture::is_wayland_session() {
+                x11_watch::start();
+            }
+        }
+    });
+}
+
+// ============================================================================
+// macOS Implementation
+// ============================================================================
+
+#[cfg(target_os = "macos")]
+mod macos_watch {
+    use objc::declare::ClassDecl;
+    use objc::runtime::{Class, Object, Sel};
+    use objc::{class, msg_send, sel, sel_impl};
+
+    #[link(name = "AppKit", kind = "framework")]
+    extern "C" {
+        static NSWorkspaceDidActivateApplicationNotification: *mut Object;
+    }
+
+    extern "C" fn app_activated(_this: &Object, _cmd: Sel, _notification: *mut Object) {
+        super::notify();
+    }
+
+    fn observer_class() -> Option<&'static Class> {
+        if let Some(cls) = Class::get("CrowdCastFocusObserver") {
+            return Some(cls);
+        }
+        let mut decl = ClassDecl::new("CrowdCastFocusObserver", class!(NSObject))?;
+        unsafe {
+            decl.add_method(
+                sel!(appActivated:),
+                app_activated as extern "C" fn(&Object, Sel, *mut Object),
+            );
+        }
+        Some(decl.register())
+    }
+
+    pub(super) fn start() {
+        let Some(cls) = observer_class() else {
+            tracing::warn!("focus-events: failed to declare NSWorkspace observer; polling");
+            return;
+        };
+        // NSWorkspace posts activation notifications on the main thread's run loop, which the
+        // tray keeps spinning for the whole run. The observer is intentionally leaked: it lives
+        // as long as the process and is never removed from the notification center.
+        unsafe {
+            let observer: *mut Object = msg_send![cls, new];
+            let workspace: *mut Object = msg_send![class!(NSWorkspace), sharedWorkspace];
+            let center: *mut Object = msg_send![workspace, notificationCenter];
+            let _: () = msg_send![center,
+                addObserver: observer
+                selector: sel!(appActivated:)
+                name: NSWorkspaceDidActivateApplicationNotification
+                object: std::ptr::null_mut::<Object>()];
+        }
+        super::set_push_active(true);
+        tracing::info!("focus-events: observing NSWorkspace app activation");
+    }
+}
+
+// ============================================================================
+// Windows Implementation
+// ============================================================================
+
+#[cfg(target_os = "windows")]
+mod windows_watch {
+    use std::ffi::c_void;
+
+    const EVENT_SYSTEM_FOREGROUND: u32 = 0x0003;
+    const WINEVENT_OUTOFCONTEXT: u32 = 0x0000;
+
+    type WinEventProc = unsafe extern "system" fn(
+        hook: *mut c_void,
+        event: u32,
+        hwnd: *mut c_void,
+        id_object: i32,
+        id_child: i32,
+        event_thread: u32,
+        event_time: u32,
+    );
+
+    #[repr(C)]
+    struct Msg {
+        hwnd: *mut c_void,
+        message: u32,
+        w_param: usize,
+        l_param: isize,
+        time: u32,
+        pt_x: i32,
+        pt_y: i32,
+    }
+
+    #[link(name = "user32")]
+    extern "system" {
+        fn SetWinEventHook(
+            event_min: u32,
+            event_max: u32,
+            hmod: *mut c_void,
+            callback: WinEventProc,
+            process_id: u32,
+            thread_id: u32,
+            flags: u32,
+        ) -> *mut c_void;
+        fn GetMessageW(msg: *mut Msg, hwnd: *mut c_void, filter_min: u32, filter_max: u32) -> i32;
+        fn TranslateMessage(msg: *const Msg) -> i32;
+        fn DispatchMessageW(msg: *const Msg) -> isize;
+    }
+
+    unsafe extern "system" fn on_foreground(
+        _hook: *mut c_void,
+        _event: u32,
+        _hwnd: *mut c_void,
+        _id_object: i32,
+        _id_child: i32,
+        _event_thread: u32,
+        _event_time: u32,
+    ) {
+        super::notify();
+    }
+
+    pub(super) fn start() {
+        // Out-of-context hooks are delivered through the installing thread's message queue, so
+        // the hook needs a dedicated thread pumping messages for the whole run. Our own windows
+        // are NOT skipped: the tray/Settings windows taking the foreground must invalidate the
+        // cached resolution too, so `filter_self` sees every transition it masks.
+        let spawned = std::thread::Builder::new()
+            .name("focus-events".into())
+            .spawn(|| unsafe {
+                let hook = SetWinEventHook(
+                    EVENT_SYSTEM_FOREGROUND,
+                    EVENT_SYSTEM_FOREGROUND,
+                    std::ptr::null_mut(),
+                    on_foreground,
+                    0,
+                    0,
+                    WINEVENT_OUTOFCONTEXT,
+                );
+                if hook.is_null() {
+                    tracing::warn!("focus-events: SetWinEventHook failed; polling");
+                    return;
+                }
+                super::set_push_active(true);
+                tracing::info!("focus-events: foreground hook installed");
+
+                let mut msg: Msg = std::mem::zeroed();
+                while GetMessageW(&mut msg, std::ptr::null_mut(), 0, 0) > 0 {
+                    TranslateMessage(&msg);
+                    DispatchMessageW(&msg);
+                }
+                super::set_push_active(false);
+            });
+        if let Err(e) = spawned {
+            tracing::warn!("focus-events: failed to spawn hook thread: {e}");
+        }
+    }
+}
+
+// ============================================================================
+// X11 Implementation
+// ============================================================================
+
+#[cfg(target_os = "linux")]
+mod x11_watch {
+    use std::time::Duration;
+    use x11rb::connection::Connection;
+    use x11rb::protocol::xproto::{ChangeWindowAttributesAux, ConnectionExt, EventMask};
+    use x11rb::protocol::Event;
+
+    pub(super) fn start() {
+        let spawned = std::thread::Builder::new()
+            .name("focus-events".into())
+            .spawn(|| loop {
+                if let Err(e) = watch() {
+                    tracing::debug!("focus-events(x11): {e}");
+                }
+                // Lost the X server (or never reached it): poll at full rate and retry.
+                super::set_push_active(false);
+                std::thread::sleep(Duration::from_secs(2));
+            });
+        if let Err(e) = spawned {
+            tracing::warn!("focus-events: failed to spawn X11 watcher: {e}");
+        }
+    }
+
+    /// Watch `_NET_ACTIVE_WINDOW` on the root window until the connection fails. Uses its own
+    /// connection so the blocking event wait never contends with the on-demand EWMH queries.
+    fn watch() -> Result<(), Box<dyn std::error::Error>> {
+        let (conn, screen_num) = x11rb::connect(None)?;
+        let root = conn.setup().roots[screen_num].root;
+        let net_active_window = conn
+            .intern_atom(false, b"_NET_ACTIVE_WINDOW")?
+            .reply()?
+            .atom;
+
+        conn.change_window_attributes(
+            root,
+            &ChangeWindowAttributesAux::new().event_mask(EventMask::PROPERTY_CHANGE),
+        )?
+        .check()?;
+        super::set_push_active(true);
+        tracing::info!("focus-events(x11): watching _NET_ACTIVE_WINDOW");
+
+        loop {
+            if let Event::PropertyNotify(ev) = conn.wait_for_event()? {
+                if ev.window == root && ev.atom == net_active_window {
+                    super::notify();
+                }
+            }
+        }
+    }
+}
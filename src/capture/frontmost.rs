@@ -249,13 +249,8 @@ fn get_frontmost_app_x11() -> Option<AppInfo> {
     // the wizard persists in `target_apps`, so `should_capture_app` matching agrees on X11.
     // (Both sides are kernel-truncated to 15 chars identically; the XComposite window
     // resolver additionally matches on the exe basename and WM_CLASS, see x11_windows.)
-    let comm = std::fs::read_to_string(format!("/proc/{}/comm", pid))
-        .ok()?
-        .trim()
-        .to_string();
-    if comm.is_empty() {
-        return None;
-    }
+    // Cached per (window, pid), so a steady focus skips the /proc read.
+    let comm = crate::capture::process_identity::x11_window_comm(active_window, pid)?;
 
     Some(AppInfo {
         bundle_id: comm.clone(),
@@ -389,37 +384,35 @@ fn filter_self(
     }
 }
 
+/// Per-window parts of a foreground resolution that never change for a given (window, owning
+/// process) pair: the executable stem and whether the window is a tray-shell surface. Cached
+/// in [`WINDOW_IDENTITIES`] so a steady foreground costs no process open per poll.
+#[cfg(target_os = "windows")]
+#[derive(Clone, Debug)]
+struct WindowIdentity {
+    name: String,
+    tray_shell: bool,
+}
+
+#[cfg(target_os = "windows")]
+static WINDOW_IDENTITIES: super::process_identity::IdentityCache<(usize, u32), WindowIdentity> =
+    super::process_identity::IdentityCache::new();
+
 /// Resolve the foreground window's owning application (this process included)
 /// plus the traits `filter_self` masks on: visibility (our hidden tray/menu
 /// window vs. our real windows) and whether the window is one of the shell's
-/// tray surfaces.
+/// tray surfaces. Visibility is read live; the owning exe and the window class
+/// are cached per `(hwnd, pid)` (see `capture::process_identity`).
 #[cfg(target_os = "windows")]
 fn resolve_foreground_app() -> Option<(AppInfo, ForegroundTraits)> {
-    use std::ffi::OsString;
-    use std::os::windows::ffi::OsStringExt;
-
     #[link(name = "user32")]
     extern "system" {
         fn GetForegroundWindow() -> *mut std::ffi::c_void;
         fn GetWindowThreadProcessId(hwnd: *mut std::ffi::c_void, process_id: *mut u32) -> u32;
         fn IsWindowVisible(hwnd: *mut std::ffi::c_void) -> i32;
-        fn GetClassNameW(hwnd: *mut std::ffi::c_void, buffer: *mut u16, max_count: i32) -> i32;
+        fn IsWindow(hwnd: *mut std::ffi::c_void) -> i32;
     }
 
-    #[link(name = "kernel32")]
-    extern "system" {
-        fn OpenProcess(access: u32, inherit: i32, pid: u32) -> *mut std::ffi::c_void;
-        fn CloseHandle(handle: *mut std::ffi::c_void) -> i32;
-        fn QueryFullProcessImageNameW(
-            process: *mut std::ffi::c_void,
-            flags: u32,
-            name: *mut u16,
-            size: *mut u32,
-        ) -> i32;
-    }
-
-    const PROCESS_QUERY_LIMITED_INFORMATION: u32 = 0x1000;
-
     unsafe {
         let hwnd = GetForegroundWindow();
         if hwnd.is_null() {
@@ -428,42 +421,25 @@ fn resolve_foreground_app() -> Option<(AppInfo, ForegroundTraits)> {
 
         let visible = IsWindowVisible(hwnd) != 0;
 
-        let mut class_buf = [0u16; 128];
-        let class_len = GetClassNameW(hwnd, class_buf.as_mut_ptr(), class_buf.len() as i32);
-        let tray_shell = class_len > 0 && {
-            let class = String::from_utf16_lossy(&class_buf[..class_len as usize]);
-            TRAY_SHELL_CLASSES.iter().any(|c| class == *c)
-        };
-
         let mut pid: u32 = 0;
         GetWindowThreadProcessId(hwnd, &mut pid);
         if pid == 0 {
             return None;
         }
 
-        let process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, 0, pid);
-        if process.is_null() {
-            return None;
-        }
-
-        let mut buffer = [0u16; 1024];
-        let mut size = buffer.len() as u32;
-
-        let result = QueryFullProcessImageNameW(process, 0, buffer.as_mut_ptr(), &mut size);
-        CloseHandle(process);
-
-        if result == 0 {
-            return None;
-        }
-
-        let path = OsString::from_wide(&buffer[..size as usize]);
-        let path_str = path.to_string_lossy();
-
-        let name = std::path::Path::new(path_str.as_ref())
-            .file_stem()
-            .and_then(|s| s.to_str())
-            .unwrap_or("Unknown")
-            .to_string();
+        // An entry stays valid while its window still exists and is still owned by the same
+        // PID: a window dies with its process, so that also catches exit and PID reuse.
+        let identity = WINDOW_IDENTITIES.get_or_resolve(
+            (hwnd as usize, pid),
+            || resolve_window_identity(hwnd, pid),
+            |&(cached_hwnd, cached_pid), _| {
+                let cached_hwnd = cached_hwnd as *mut std::ffi::c_void;
+                let mut owner: u32 = 0;
+                IsWindow(cached_hwnd) != 0
+                    && GetWindowThreadProcessId(cached_hwnd, &mut owner) != 0
+                    && owner == cached_pid
+            },
+        )?;
 
         // Use a lowercase executable stem as the bundle_id so app matching is
         // case-insensitive: Windows reports the on-disk case (e.g. "Notepad")
@@ -471,18 +447,78 @@ fn resolve_foreground_app() -> Option<(AppInfo, ForegroundTraits)> {
         // `name` keeps the original case for display.
         Some((
             AppInfo {
-                bundle_id: name.to_ascii_lowercase(),
-                name,
+                bundle_id: identity.name.to_ascii_lowercase(),
+                name: identity.name,
                 pid,
             },
             ForegroundTraits {
                 visible,
-                tray_shell,
+                tray_shell: identity.tray_shell,
             },
         ))
     }
 }
 
+/// Uncached half of [`resolve_foreground_app`]: the window class and the owning process's
+/// executable stem.
+#[cfg(target_os = "windows")]
+unsafe fn resolve_window_identity(hwnd: *mut std::ffi::c_void, pid: u32) -> Option<WindowIdentity> {
+    use std::ffi::OsString;
+    use std::os::windows::ffi::OsStringExt;
+
+    #[link(name = "user32")]
+    extern "system" {
+        fn GetClassNameW(hwnd: *mut std::ffi::c_void, buffer: *mut u16, max_count: i32) -> i32;
+    }
+
+    #[link(name = "kernel32")]
+    extern "system" {
+        fn OpenProcess(access: u32, inherit: i32, pid: u32) -> *mut std::ffi::c_void;
+        fn CloseHandle(handle: *mut std::ffi::c_void) -> i32;
+        fn QueryFullProcessImageNameW(
+            process: *mut std::ffi::c_void,
+            flags: u32,
+            name: *mut u16,
+            size: *mut u32,
+        ) -> i32;
+    }
+
+    const PROCESS_QUERY_LIMITED_INFORMATION: u32 = 0x1000;
+
+    let mut class_buf = [0u16; 128];
+    let class_len = GetClassNameW(hwnd, class_buf.as_mut_ptr(), class_buf.len() as i32);
+    let tray_shell = class_len > 0 && {
+        let class = String::from_utf16_lossy(&class_buf[..class_len as usize]);
+        TRAY_SHELL_CLASSES.iter().any(|c| class == *c)
+    };
+
+    let process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, 0, pid);
+    if process.is_null() {
+        return None;
+    }
+
+    let mut buffer = [0u16; 1024];
+    let mut size = buffer.len() as u32;
+
+    let result = QueryFullProcessImageNameW(process, 0, buffer.as_mut_ptr(), &mut size);
+    CloseHandle(process);
+
+    if result == 0 {
+        return None;
+    }
+
+    let path = OsString::from_wide(&buffer[..size as usize]);
+    let path_str = path.to_string_lossy();
+
+    let name = std::path::Path::new(path_str.as_ref())
+        .file_stem()
+        .and_then(|s| s.to_str())
+        .unwrap_or("Unknown")
+        .to_string();
+
+    Some(WindowIdentity { name, tray_shell })
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -0,0 +1,481 @@
+//! Push notifications for window geometry changes, and the geometry cache they
+//! keep fresh
+//!
+//! The per-app monitor fit (`apply_monitor_fit_to_active`) runs on every engine
+//! poll tick, and each run used to re-read the active window's geometry: a
+//! D-Bus round trip to the GNOME focus extension, three fresh X11 connections
+//! (focus, window rect, RandR monitors), or on macOS a `CGWindowListCopyWindowInfo`
+//! snapshot of every window on screen. Geometry only changes when a window is
+//! moved or resized or the monitor layout changes, and each platform can say so:
+//! - **X11**: `ConfigureNotify` for top-level windows (`SubstructureNotify` on
+//!   the root) and RandR `ScreenChangeNotify`
+//! - **GNOME Wayland**: the focus extension's `GeometryChanged` signal (see
+//!   `focus::gnome`), sent when the focused window moves or resizes or the
+//!   monitors change
+//! - **macOS**: Accessibility `AXWindowMoved`/`AXWindowResized` notifications
+//!   from the frontmost application
+//!
+//! As with [`super::focus_events`], a watcher only bumps [`generation`].
+//! [`GeometryCache`] holds the last resolved geometry per tracked window and
+//! serves it until the geometry or focus generation moves, re-reading only on a
+//! slow safety-net interval. Without a live watcher every lookup reads the OS,
+//! as before.
+
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::OnceLock;
+use std::time::{Duration, Instant};
+
+/// Re-read cached geometry at least this often, in case a change went unsignalled
+const GEOMETRY_SAFETY_POLL_INTERVAL: Duration = Duration::from_secs(2);
+
+static PUSH_ACTIVE: AtomicBool = AtomicBool::new(false);
+static GENERATION: AtomicU64 = AtomicU64::new(0);
+
+/// Signal that some window's geometry (or the monitor layout) may have changed.
+/// Cheap and callable from any thread.
+pub fn notify() {
+    GENERATION.fetch_add(1, Ordering::SeqCst);
+}
+
+/// Count of geometry-change signals so far.
+pub fn generation() -> u64 {
+    GENERATION.load(Ordering::SeqCst)
+}
+
+/// Whether a push watcher is currently delivering geometry changes.
+pub fn is_push_active() -> bool {
+    PUSH_ACTIVE.load(Ordering::SeqCst)
+}
+
+/// Mark whether a push watcher is live (set by the watcher itself, so a watcher
+/// that dies falls back to reading geometry on every lookup).
+pub(crate) fn set_push_active(active: bool) {
+    PUSH_ACTIVE.store(active, Ordering::SeqCst);
+}
+
+/// Start the platform geometry watcher exactly once (idempotent). GNOME Wayland
+/// needs no start here: its signal arrives on the focus provider's connection.
+pub fn ensure_started() {
+    static ONCE: OnceLock<()> = OnceLock::new();
+    ONCE.get_or_init(|| {
+        #[cfg(target_os = "macos")]
+        macos_watch::start();
+        #[cfg(target_os = "linux")]
+        {
+            if super::x11_windows::is_pure_x11_session() {
+                x11_watch::start();
+            }
+        }
+    });
+}
+
+/// Geometry and focus generations together. A cached resolution of "the app's
+/// focused window and where it is" is stale once either moves.
+fn stamp() -> (u64, u64) {
+    (generation(), super::focus_events::generation())
+}
+
+struct Cached<V> {
+    stamp: (u64, u64),
+    fetched_at: Instant,
+    value: V,
+}
+
+/// Last resolved geometry per tracked window (keyed by app)
+pub(super) struct GeometryCache<V> {
+    entries: HashMap<String, Cached<V>>,
+}
+
+impl<V: Clone> GeometryCache<V> {
+    pub(super) fn new() -> Self {
+        Self {
+            entries: HashMap::new(),
+        }
+    }
+
+    /// `key`'s geometry: cached while nothing has signalled a change, otherwise
+    /// read through `fetch`. A failed read isn't cached, so the caller's retry
+    /// on the next poll reads again.
+    pub(super) fn get_or_fetch(
+        &mut self,
+        key: &str,
+        fetch: impl FnOnce() -> Option<V>,
+    ) -> Option<V> {
+        let pushed = is_push_active() && super::focus_events::is_push_active();
+        self.get_or_fetch_at(key, stamp(), pushed, Instant::now(), fetch)
+    }
+
+    fn get_or_fetch_at(
+        &mut self,
+        key: &str,
+        stamp: (u64, u64),
+        pushed: bool,
+        now: Instant,
+        fetch: impl FnOnce() -> Option<V>,
+    ) -> Option<V> {
+        if pushed {
+            if let Some(cached) = self.entries.get(key) {
+                if cached.stamp == stamp
+                    && now.duration_since(cached.fetched_at) < GEOMETRY_SAFETY_POLL_INTERVAL
+                {
+                    return Some(cached.value.clone());
+                }
+            }
+        }
+        // The stamp is taken BEFORE the read: a change signalled mid-read leaves the
+        // entry stale, so the next lookup reads again.
+        let value = fetch();
+        match &value {
+            Some(v) => {
+                self.entries.insert(
+                    key.to_string(),
+                    Cached {
+                        stamp,
+                        fetched_at: now,
+                        value: v.clone(),
+                    },
+                );
+            }
+            None => {
+                self.entries.remove(key);
+            }
+        }
+        value
+    }
+
+    /// Forget `key`'s geometry (its window binding changed)
+    #[allow(dead_code)] // only the GNOME re-point path rebinds a tracked app's window
+    pub(super) fn invalidate(&mut self, key: &str) {
+        self.entries.remove(key);
+    }
+
+    /// Forget everything (sources were rebuilt)
+    pub(super) fn clear(&mut self) {
+        self.entries.clear();
+    }
+}
+
+// ============================================================================
+// X11 Implementation
+// ============================================================================
+
+#[cfg(target_os = "linux")]
+mod x11_watch {
+    use std::time::Duration;
+    use x11rb::connection::Connection;
+    use x11rb::protocol::randr::{ConnectionExt as _, NotifyMask};
+    use x11rb::protocol::xproto::{ChangeWindowAttributesAux, ConnectionExt, EventMask};
+    use x11rb::protocol::Event;
+
+    pub(super) fn start() {
+        let spawned = std::thread::Builder::new()
+            .name("geometry-events".into())
+            .spawn(|| loop {
+                if let Err(e) = watch() {
+                    tracing::debug!("geometry-events(x11): {e}");
+                }
+                super::set_push_active(false);
+                std::thread::sleep(Duration::from_secs(2));
+            });
+        if let Err(e) = spawned {
+            tracing::warn!("geometry-events: failed to spawn X11 watcher: {e}");
+        }
+    }
+
+    /// Watch top-level configure/map changes on the root until the connection fails. Under a
+    /// reparenting WM the top levels are the frames, which move and resize with their clients.
+    fn watch() -> Result<(), Box<dyn std::error::Error>> {
+        let (conn, screen_num) = x11rb::connect(None)?;
+        let root = conn.setup().roots[screen_num].root;
+
+        conn.change_window_attributes(
+            root,
+            &ChangeWindowAttributesAux::new().event_mask(EventMask::SUBSTRUCTURE_NOTIFY),
+        )?
+        .check()?;
+        // Monitor hotplug/rotation moves windows' monitors without moving the windows. Without
+        // RandR events those changes surface on the cache's safety-net interval instead.
+        let randr = match conn.randr_select_input(root, NotifyMask::SCREEN_CHANGE) {
+            Ok(cookie) => cookie.check().map_err(|e| e.to_string()),
+            Err(e) => Err(e.to_string()),
+        };
+        if let Err(e) = randr {
+            tracing::debug!("geometry-events(x11): no RandR screen-change events: {e}");
+        }
+        super::set_push_active(true);
+        super::notify();
+        tracing::info!("geometry-events(x11): watching top-level window geometry");
+
+        loop {
+            match conn.wait_for_event()? {
+                Event::ConfigureNotify(_)
+                | Event::MapNotify(_)
+                | Event::UnmapNotify(_)
+                | Event::DestroyNotify(_)
+                | Event::RandrScreenChangeNotify(_) => super::notify(),
+                _ => {}
+            }
+        }
+    }
+}
+
+// ============================================================================
+// macOS Implementation
+// ============================================================================
+
+#[cfg(target_os = "macos")]
+mod macos_watch {
+    use std::ffi::{c_char, c_void, CString};
+    use std::time::Duration;
+
+    type CFStringRef = *const c_void;
+    type AXObserverCallback = unsafe extern "C" fn(
+        observer: *mut c_void,
+        element: *mut c_void,
+        notification: CFStringRef,
+        refcon: *mut c_void,
+    );
+
+    #[link(name = "ApplicationServices", kind = "framework")]
+    extern "C" {
+        fn AXIsProcessTrusted() -> bool;
+        fn AXUIElementCreateApplication(pid: i32) -> *mut c_void;
+        fn AXObserverCreate(pid: i32, callback: AXObserverCallback, out: *mut *mut c_void) -> i32;
+        fn AXObserverAddNotification(
+            observer: *mut c_void,
+            element: *mut c_void,
+            notification: CFStringRef,
+            refcon: *mut c_void,
+        ) -> i32;
+        fn AXObserverGetRunLoopSource(observer: *mut c_void) -> *mut c_void;
+    }
+
+    #[link(name = "CoreFoundation", kind = "framework")]
+    extern "C" {
+        static kCFRunLoopDefaultMode: CFStringRef;
+        fn CFRunLoopGetCurrent() -> *mut c_void;
+        fn CFRunLoopAddSource(rl: *mut c_void, source: *mut c_void, mode: CFStringRef);
+        fn CFRunLoopRemoveSource(rl: *mut c_void, source: *mut c_void, mode: CFStringRef);
+        fn CFRunLoopRunInMode(mode: CFStringRef, seconds: f64, return_after_handled: u8) -> i32;
+        fn CFStringCreateWithCString(
+            alloc: *const c_void,
+            s: *const c_char,
+            encoding: u32,
+        ) -> CFStringRef;
+        fn CFRelease(cf: *const c_void);
+    }
+
+    const K_CF_STRING_ENCODING_UTF8: u32 = 0x0800_0100;
+    const K_AX_ERROR_SUCCESS: i32 = 0;
+
+    /// Application-level notifications: registered on the app element, they fire for any of
+    /// its windows.
+    const NOTIFICATIONS: &[&str] = &[
+        "AXWindowMoved",
+        "AXWindowResized",
+        "AXFocusedWindowChanged",
+        "AXWindowMiniaturized",
+        "AXWindowDeminiaturized",
+    ];
+
+    /// How long one run-loop turn waits before re-checking which app to observe
+    const TURN: Duration = Duration::from_millis(250);
+
+    unsafe extern "C" fn on_geometry(
+        _observer: *mut c_void,
+        _element: *mut c_void,
+        _notification: CFStringRef,
+        _refcon: *mut c_void,
+    ) {
+        super::notify();
+    }
+
+    /// An AX observer on one application, attached to this thread's run loop
+    struct Observed {
+        pid: u32,
+        observer: *mut c_void,
+        element: *mut c_void,
+    }
+
+    impl Observed {
+        unsafe fn attach(pid: u32, names: &[CFStringRef]) -> Option<Self> {
+            let mut observer: *mut c_void = std::ptr::null_mut();
+            if AXObserverCreate(pid as i32, on_geometry, &mut observer) != K_AX_ERROR_SUCCESS
+                || observer.is_null()
+            {
+                return None;
+            }
+            let element = AXUIElementCreateApplication(pid as i32);
+            if element.is_null() {
+                CFRelease(observer);
+                return None;
+            }
+            // An app may not support every notification; any one registered is useful.
+            let registered = names
+                .iter()
+                .filter(|&&name| {
+                    AXObserverAddNotification(observer, element, name, std::ptr::null_mut())
+                        == K_AX_ERROR_SUCCESS
+                })
+                .count();
+            if registered == 0 {
+                CFRelease(element);
+                CFRelease(observer);
+                return None;
+            }
+            CFRunLoopAddSource(
+                CFRunLoopGetCurrent(),
+                AXObserverGetRunLoopSource(observer),
+                kCFRunLoopDefaultMode,
+            );
+            Some(Self {
+                pid,
+                observer,
+                element,
+            })
+        }
+    }
+
+    impl Drop for Observed {
+        fn drop(&mut self) {
+            unsafe {
+                CFRunLoopRemoveSource(
+                    CFRunLoopGetCurrent(),
+                    AXObserverGetRunLoopSource(self.observer),
+                    kCFRunLoopDefaultMode,
+                );
+                CFRelease(self.element);
+                CFRelease(self.observer);
+            }
+        }
+    }
+
+    pub(super) fn start() {
+        if !unsafe { AXIsProcessTrusted() } {
+            tracing::debug!(
+                "geometry-events: Accessibility not granted; reading geometry per poll"
+            );
+            return;
+        }
+        let spawned = std::thread::Builder::new()
+            .name("geometry-events".into())
+            .spawn(watch);
+        if let Err(e) = spawned {
+            tracing::warn!("geometry-events: failed to spawn AX watcher: {e}");
+        }
+    }
+
+    /// Keep an AX observer on the frontmost application, moving it as focus moves, and spin
+    /// this thread's run loop to deliver its notifications.
+    fn watch() {
+        // Created once and kept for the life of the thread.
+        let names: Vec<CFStringRef> = NOTIFICATIONS
+            .iter()
+            .filter_map(|n| CString::new(*n).ok())
+            .map(|n| unsafe {
+                CFStringCreateWithCString(std::ptr::null(), n.as_ptr(), K_CF_STRING_ENCODING_UTF8)
+            })
+            .filter(|s| !s.is_null())
+            .collect();
+
+        let mut observed: Option<Observed> = None;
+        let mut seen_focus = None;
+        super::set_push_active(true);
+        tracing::info!("geometry-events: observing frontmost app window geometry");
+        loop {
+            // Without focus push the frontmost app is re-checked every turn.
+            let focus = crate::capture::focus_events::generation();
+            if seen_focus != Some(focus) || !crate::capture::focus_events::is_push_active() {
+                seen_focus = Some(focus);
+                let pid = crate::capture::get_frontmost_app().map(|app| app.pid);
+                if observed.as_ref().map(|o| o.pid) != pid {
+                    // Detach first: the new app's windows aren't the old one's.
+                    drop(observed.take());
+                    observed = pid.and_then(|pid| unsafe { Observed::attach(pid, &names) });
+                    super::notify();
+                }
+            }
+            if observed.is_some() {
+                unsafe {
+                    CFRunLoopRunInMode(kCFRunLoopDefaultMode, TURN.as_secs_f64(), 0);
+                }
+            } else {
+                // An empty run loop returns at once; don't spin.
+                std::thread::sleep(TURN);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const PUSHED: bool = true;
+
+    #[test]
+    fn unchanged_stamp_serves_cached_geometry() {
+        let mut cache = GeometryCache::new();
+        let now = Instant::now();
+        assert_eq!(
+            cache.get_or_fetch_at("app", (1, 1), PUSHED, now, || Some(10)),
+            Some(10)
+        );
+        assert_eq!(
+            cache.get_or_fetch_at("app", (1, 1), PUSHED, now, || panic!("re-read")),
+            Some(10)
+        );
+        // Another window has its own entry
+        assert_eq!(
+            cache.get_or_fetch_at("other", (1, 1), PUSHED, now, || Some(20)),
+            Some(20)
+        );
+    }
+
+    #[test]
+    fn geometry_or_focus_change_forces_a_read() {
+        let mut cache = GeometryCache::new();
+        let now = Instant::now();
+        cache.get_or_fetch_at("app", (1, 1), PUSHED, now, || Some(10));
+        assert_eq!(
+            cache.get_or_fetch_at("app", (2, 1), PUSHED, now, || Some(11)),
+            Some(11)
+        );
+        assert_eq!(
+            cache.get_or_fetch_at("app", (2, 2), PUSHED, now, || Some(12)),
+            Some(12)
+        );
+    }
+
+    #[test]
+    fn reads_through_without_push_or_after_safety_interval() {
+        let mut cache = GeometryCache::new();
+        let now = Instant::now();
+        cache.get_or_fetch_at("app", (1, 1), false, now, || Some(10));
+        assert_eq!(
+            cache.get_or_fetch_at("app", (1, 1), false, now, || Some(11)),
+            Some(11)
+        );
+        let later = now + GEOMETRY_SAFETY_POLL_INTERVAL;
+        assert_eq!(
+            cache.get_or_fetch_at("app", (1, 1), PUSHED, later, || Some(12)),
+            Some(12)
+        );
+    }
+
+    #[test]
+    fn failed_read_is_not_cached() {
+        let mut cache = GeometryCache::new();
+        let now = Instant::now();
+        cache.get_or_fetch_at("app", (1, 1), PUSHED, now, || Some(10));
+        assert_eq!(
+            cache.get_or_fetch_at("app", (2, 1), PUSHED, now, || None),
+            None
+        );
+        assert_eq!(
+            cache.get_or_fetch_at("app", (2, 1), PUSHED, now, || Some(11)),
+            Some(11)
+        );
+    }
+}
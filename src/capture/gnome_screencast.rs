@@ -13,13 +13,21 @@
 //! single dedicated thread owns the zbus connection and every session for the capture's
 //! lifetime. Dropping [`GnomeScreenCast`] tears the thread down, which closes the sessions.
 //!
+//! Requests are pipelined on that connection rather than served one at a time: window
+//! listings and geometry queries each run as their own task, so a geometry read never waits
+//! behind a multi-round-trip `RecordWindow`, and a batch of geometry queries goes out
+//! together. Only the session commands (record/stop) stay in arrival order, on one task that
+//! owns the sessions, so a window's stop can never overtake its record.
+//!
 //! Validated on GNOME 50 / Mutter ScreenCast v4: external `RecordWindow(window-id)` produces
 //! a live, consumable PipeWire node with no picker.
 #![cfg(target_os = "linux")]
 
 use std::collections::HashMap;
 use std::sync::mpsc;
-use std::time::Duration;
+use std::time::{Duration, Instant};
+
+use tokio::sync::mpsc::{unbounded_channel, UnboundedReceiver, UnboundedSender};
 
 use atspi::zbus; // zbus is re-exported by atspi (no direct dependency)
 use zbus::zvariant::{OwnedObjectPath, Value};
@@ -37,6 +45,10 @@ const FP_IFACE: &str = "org.crowdcast.FocusProvider";
 /// How long a sync caller waits for the worker thread to answer a command.
 const CMD_TIMEOUT: Duration = Duration::from_secs(12);
 
+/// First and longest wait before rebuilding a FocusProvider proxy that failed to build.
+const FOCUS_RETRY_MIN: Duration = Duration::from_secs(1);
+const FOCUS_RETRY_MAX: Duration = Duration::from_secs(60);
+
 /// One open toplevel, as reported by the extension's `ListWindows`.
 #[derive(Debug, Clone)]
 pub struct WindowInfo {
@@ -73,14 +85,14 @@ enum Cmd {
     /// node). Fire-and-forget: used after a focus re-point has bound the new window
     /// (make-before-break), and when an app's window goes away.
     StopWindow(u64),
-    /// Query the extension for `window_id`'s frame rect + its monitor's geometry (for the
-    /// multi-monitor per-app fit). Reply is `None` on any D-Bus error.
-    WindowGeometry(u64, mpsc::Sender<Option<WinGeom>>),
+    /// Query the extension for each window's frame rect + its monitor's geometry (for the
+    /// multi-monitor per-app fit), in order. An entry is `None` on any D-Bus error.
+    WindowGeometries(Vec<u64>, mpsc::Sender<Vec<Option<WinGeom>>>),
 }
 
 /// Owns the Mutter ScreenCast D-Bus connection + sessions on a dedicated thread.
 pub struct GnomeScreenCast {
-    tx: mpsc::Sender<Cmd>,
+    tx: UnboundedSender<Cmd>,
     _thread: std::thread::JoinHandle<()>,
 }
 
@@ -88,7 +100,7 @@ impl GnomeScreenCast {
     /// Spawn the worker (connects to the session bus + Mutter ScreenCast lazily). Returns an
     /// error only if the OS thread can't be spawned; D-Bus failures surface per-command.
     pub fn new() -> std::io::Result<Self> {
-        let (tx, rx) = mpsc::channel::<Cmd>();
+        let (tx, rx) = unbounded_channel::<Cmd>();
         let thread = std::thread::Builder::new()
             .name("gnome-screencast".into())
             .spawn(move || worker(rx))?;
@@ -141,14 +153,27 @@ impl GnomeScreenCast {
     /// The frame rect + monitor geometry of `window_id` (via the focus extension), or `None` on
     /// any error / if the window is gone. Used to compute the multi-monitor per-app fit.
     pub fn window_geometry(&self, window_id: u64) -> Option<WinGeom> {
+        self.window_geometries(&[window_id]).pop().flatten()
+    }
+
+    /// [`window_geometry`](Self::window_geometry) for several windows at once, in order. The
+    /// queries go out together on the one connection, so the batch costs about one round trip.
+    pub fn window_geometries(&self, window_ids: &[u64]) -> Vec<Option<WinGeom>> {
         let (rtx, rrx) = mpsc::channel();
-        self.tx.send(Cmd::WindowGeometry(window_id, rtx)).ok()?;
-        rrx.recv_timeout(CMD_TIMEOUT).ok().flatten()
+        if self
+            .tx
+            .send(Cmd::WindowGeometries(window_ids.to_vec(), rtx))
+            .is_err()
+        {
+            return vec![None; window_ids.len()];
+        }
+        rrx.recv_timeout(CMD_TIMEOUT)
+            .unwrap_or_else(|_| vec![None; window_ids.len()])
     }
 }
 
 /// Worker thread: owns a current-thread runtime + the zbus connection + every session.
-fn worker(rx: mpsc::Receiver<Cmd>) {
+fn worker(mut rx: UnboundedReceiver<Cmd>) {
     let rt = match tokio::runtime::Builder::new_current_thread()
         .enable_all()
         .build()
@@ -157,7 +182,7 @@ fn worker(rx: mpsc::Receiver<Cmd>) {
         Err(e) => {
             tracing::error!("gnome-screencast: runtime init failed: {e}");
             // Drain commands with errors so callers don't block to timeout.
-            for cmd in rx.iter() {
+            while let Some(cmd) = rx.blocking_recv() {
                 reply_err(cmd, "runtime init failed");
             }
             return;
@@ -170,82 +195,142 @@ fn worker(rx: mpsc::Receiver<Cmd>) {
             Err(e) => {
                 let msg = format!("session bus connect failed: {e}");
                 tracing::error!("gnome-screencast: {msg}");
-                for cmd in rx.iter() {
+                while let Some(cmd) = rx.recv().await {
                     reply_err(cmd, &msg);
                 }
                 return;
             }
         };
+        // One FocusProvider proxy for every query: building one per call cost a round trip
+        // for its signal match rules before the actual call could go out. Built on first
+        // use, and rebuilt with backoff while that fails (the extension may still be
+        // loading when capture starts).
+        let mut focus = FocusProxy::default();
+
+        let (session_tx, session_rx) = unbounded_channel();
+        let sessions = tokio::spawn(run_sessions(conn.clone(), session_rx));
 
-        // Retain session paths (keyed by window-id) so Mutter keeps each stream alive (a
-        // session lives as long as this connection stays open and is never Close'd). Closed
-        // explicitly on StopWindow (focus re-point) and on shutdown.
-        let mut sessions: HashMap<u64, OwnedObjectPath> = HashMap::new();
-
-        // `mpsc::Receiver` is blocking; poll it without starving the zbus executor by handing
-        // each blocking recv to a blocking task. (Commands are infrequent: focus switches.)
-        loop {
-            let cmd = match recv_async(&rx).await {
-                Some(c) => c,
-                None => break, // all senders dropped → shut down
-            };
+        while let Some(cmd) = rx.recv().await {
             match cmd {
                 Cmd::ListWindows(reply) => {
-                    let _ = reply.send(list_windows(&conn).await);
+                    let focus = focus.get(&conn).await;
+                    tokio::spawn(async move {
+                        let result = match focus {
+                            Some(proxy) => list_windows(&proxy).await,
+                            None => Err("FocusProvider proxy unavailable".to_string()),
+                        };
+                        let _ = reply.send(result);
+                    });
                 }
-                Cmd::RecordWindow(id, reply) => {
-                    // Re-recording a still-live window-id would leak the old session; stop it
-                    // first so each window-id maps to at most one session.
-                    if let Some(old) = sessions.remove(&id) {
-                        stop_session(&conn, &old).await;
-                    }
-                    match record_window(&conn, id).await {
-                        Ok((node, path)) => {
-                            sessions.insert(id, path);
-                            let _ = reply.send(Ok(node));
-                        }
-                        Err(e) => {
-                            let _ = reply.send(Err(e));
-                        }
+                Cmd::WindowGeometries(ids, reply) => {
+                    let focus = focus.get(&conn).await;
+                    tokio::spawn(async move {
+                        let _ = reply.send(window_geometries(focus.as_ref(), &ids).await);
+                    });
+                }
+                cmd @ (Cmd::RecordWindow(..) | Cmd::StopWindow(_)) => {
+                    if let Err(e) = session_tx.send(cmd) {
+                        reply_err(e.0, "gnome-screencast session task is gone");
                     }
                 }
-                Cmd::StopWindow(id) => {
-                    if let Some(path) = sessions.remove(&id) {
-                        stop_session(&conn, &path).await;
+            }
+        }
+
+        // All senders dropped → shut down: close the session queue and let it stop every
+        // session before the connection goes away.
+        drop(session_tx);
+        let _ = sessions.await;
+    });
+}
+
+/// Record/stop commands, in arrival order, against the sessions this task owns.
+async fn run_sessions(conn: zbus::Connection, mut rx: UnboundedReceiver<Cmd>) {
+    // Retain session paths (keyed by window-id) so Mutter keeps each stream alive (a
+    // session lives as long as this connection stays open and is never Close'd). Closed
+    // explicitly on StopWindow (focus re-point) and on shutdown.
+    let mut sessions: HashMap<u64, OwnedObjectPath> = HashMap::new();
+    while let Some(cmd) = rx.recv().await {
+        match cmd {
+            Cmd::RecordWindow(id, reply) => {
+                // Re-recording a still-live window-id would leak the old session; stop it
+                // first so each window-id maps to at most one session.
+                if let Some(old) = sessions.remove(&id) {
+                    stop_session(&conn, &old).await;
+                }
+                match record_window(&conn, id).await {
+                    Ok((node, path)) => {
+                        sessions.insert(id, path);
+                        let _ = reply.send(Ok(node));
+                    }
+                    Err(e) => {
+                        let _ = reply.send(Err(e));
                     }
                 }
-                Cmd::WindowGeometry(id, reply) => {
-                    let _ = reply.send(window_geometry(&conn, id).await);
+            }
+            Cmd::StopWindow(id) => {
+                if let Some(path) = sessions.remove(&id) {
+                    stop_session(&conn, &path).await;
                 }
             }
+            other => reply_err(other, "not a session command"),
         }
+    }
 
-        for path in sessions.values() {
-            stop_session(&conn, path).await;
-        }
-        tracing::debug!(
-            "gnome-screencast: worker shut down ({} sessions closed)",
-            sessions.len()
-        );
-    });
+    for path in sessions.values() {
+        stop_session(&conn, path).await;
+    }
+    tracing::debug!(
+        "gnome-screencast: worker shut down ({} sessions closed)",
+        sessions.len()
+    );
+}
+
+/// The worker's FocusProvider proxy, built lazily
+#[derive(Default)]
+struct FocusProxy {
+    proxy: Option<zbus::Proxy<'static>>,
+    /// Earliest next build attempt, and the wait after that one if it fails too
+    retry: Option<(Instant, Duration)>,
 }
 
-/// Await the next blocking-channel command without blocking the async executor.
-async fn recv_async(rx: &mpsc::Receiver<Cmd>) -> Option<Cmd> {
-    // The receiver isn't Send-safe to move; poll with a short async sleep between tries so the
-    // zbus connection's background tasks keep running. Commands are rare, so the latency is
-    // irrelevant and CPU cost negligible.
-    loop {
-        match rx.try_recv() {
-            Ok(cmd) => return Some(cmd),
-            Err(mpsc::TryRecvError::Empty) => {
-                tokio::time::sleep(Duration::from_millis(20)).await;
+impl FocusProxy {
+    /// The proxy, building it if it doesn't exist yet and no backoff is pending
+    async fn get(&mut self, conn: &zbus::Connection) -> Option<zbus::Proxy<'static>> {
+        if let Some(proxy) = &self.proxy {
+            return Some(proxy.clone());
+        }
+        if self.retry.is_some_and(|(at, _)| Instant::now() < at) {
+            return None;
+        }
+        match focus_provider(conn).await {
+            Ok(proxy) => {
+                if self.retry.is_some() {
+                    tracing::info!("gnome-screencast: FocusProvider proxy ready");
+                }
+                self.retry = None;
+                self.proxy = Some(proxy.clone());
+                Some(proxy)
+            }
+            Err(e) => {
+                let wait = self.retry.map_or(FOCUS_RETRY_MIN, |(_, wait)| wait);
+                tracing::warn!("gnome-screencast: FocusProvider proxy: {e} (retrying in {wait:?})");
+                self.retry = Some((Instant::now() + wait, (wait * 2).min(FOCUS_RETRY_MAX)));
+                None
             }
-            Err(mpsc::TryRecvError::Disconnected) => return None,
         }
     }
 }
 
+async fn focus_provider(conn: &zbus::Connection) -> zbus::Result<zbus::Proxy<'static>> {
+    zbus::proxy::Builder::new(conn)
+        .destination(FP_DEST)?
+        .path(FP_PATH)?
+        .interface(FP_IFACE)?
+        .cache_properties(zbus::proxy::CacheProperties::No)
+        .build()
+        .await
+}
+
 fn reply_err(cmd: Cmd, msg: &str) {
     match cmd {
         Cmd::ListWindows(r) => {
@@ -255,17 +340,26 @@ fn reply_err(cmd: Cmd, msg: &str) {
             let _ = r.send(Err(msg.to_string()));
         }
         Cmd::StopWindow(_) => {}
-        Cmd::WindowGeometry(_, r) => {
-            let _ = r.send(None);
+        Cmd::WindowGeometries(ids, r) => {
+            let _ = r.send(vec![None; ids.len()]);
         }
     }
 }
 
+/// Geometry of each of `window_ids`, in order. The calls are issued together, so zbus
+/// pipelines them on the connection instead of waiting out each round trip in turn.
+async fn window_geometries(
+    proxy: Option<&zbus::Proxy<'static>>,
+    window_ids: &[u64],
+) -> Vec<Option<WinGeom>> {
+    let Some(proxy) = proxy else {
+        return vec![None; window_ids.len()];
+    };
+    futures::future::join_all(window_ids.iter().map(|&id| window_geometry(proxy, id))).await
+}
+
 /// Query the focus extension for a window's frame rect + its monitor's geometry (logical px).
-async fn window_geometry(conn: &zbus::Connection, window_id: u64) -> Option<WinGeom> {
-    let proxy = zbus::Proxy::new(conn, FP_DEST, FP_PATH, FP_IFACE)
-        .await
-        .ok()?;
+async fn window_geometry(proxy: &zbus::Proxy<'_>, window_id: u64) -> Option<WinGeom> {
     let (found, wx, wy, ww, wh, mx, my, mw, mh, scale): (
         bool,
         i32,
@@ -293,10 +387,7 @@ async fn stop_session(conn: &zbus::Connection, path: &OwnedObjectPath) {
     }
 }
 
-async fn list_windows(conn: &zbus::Connection) -> Result<Vec<WindowInfo>, String> {
-    let proxy = zbus::Proxy::new(conn, FP_DEST, FP_PATH, FP_IFACE)
-        .await
-        .map_err(|e| format!("FocusProvider proxy: {e}"))?;
+async fn list_windows(proxy: &zbus::Proxy<'_>) -> Result<Vec<WindowInfo>, String> {
     let raw: Vec<(u64, i32, String, String)> =
         proxy.call("ListWindows", &()).await.map_err(|e| {
             format!("ListWindows call: {e} (is the crowd-cast-focus extension loaded?)")
@@ -177,6 +177,7 @@ const K_CF_NUMBER_SINT32: i32 = 3;
 
 /// A display to retarget an SCK source to: its CGDirectDisplayID, UUID (for `set_display_uuid`),
 /// and normalization factor (1080 / PIXEL short edge).
+#[derive(Clone)]
 pub struct DisplayTarget {
     pub id: u32,
     pub uuid: String,
@@ -11,15 +11,23 @@
 
 mod apps;
 mod context;
+mod encoder_probe;
 #[cfg(target_os = "linux")]
 pub(crate) mod focus;
+pub(crate) mod focus_events;
 mod frontmost;
+#[cfg(any(target_os = "macos", target_os = "linux"))]
+pub(crate) mod geometry_events;
 #[cfg(target_os = "macos")]
 mod mac_geometry;
 #[cfg(target_os = "linux")]
 pub(crate) mod gnome_screencast;
 #[cfg(target_os = "linux")]
 pub(crate) mod monitor_layout;
+#[cfg(any(target_os = "macos", target_os = "linux"))]
+mod plugin_manifest;
+#[cfg(any(target_os = "windows", target_os = "linux"))]
+mod process_identity;
 mod recording;
 mod recovery;
 mod sources;
@@ -0,0 +1,295 @@
+//! Cached OBS plugin selection for warm starts
+//!
+//! libobs loads every module it finds in the plugin directory, and the agent
+//! restarts its process many times a day (settings changes, wake/unlock
+//! recovery). The macOS runtime is a full OBS build, so each start loads
+//! obs-browser (CEF), obs-websocket, DeckLink/AJA and other modules a headless
+//! recorder never touches.
+//!
+//! Instead, libobs is pointed at a sibling directory of symlinks to just the
+//! modules the capture mode needs. That directory sits at the same depth as the
+//! real one, so `$ORIGIN`/`@loader_path`-relative library lookups resolve the
+//! same. A manifest in the data dir records what the directory was built from
+//! (agent version, the plugin directory's mtime, the excluded set): on a warm
+//! start with nothing changed the directory is reused as is, with no directory
+//! scan. Manifest or directory trouble degrades to loading every plugin.
+//!
+//! Once libobs' paths are resolved from a validated runtime, they are recorded
+//! in the manifest too ([`record_startup_paths`]). A warm start whose plugin
+//! directory is unchanged takes them from [`cached_startup_paths`] and skips the
+//! runtime checks; installing or replacing a runtime rewrites its plugin
+//! directory, which changes the mtime and invalidates the record.
+//!
+//! `CROWD_CAST_OBS_LOAD_ALL_PLUGINS=1` disables the selection.
+
+use serde::{Deserialize, Serialize};
+use std::path::{Path, PathBuf};
+use std::time::UNIX_EPOCH;
+use tracing::{debug, info, warn};
+
+/// Modules no capture mode uses: UI/frontend integrations, streaming and
+/// capture-card I/O, and source types the agent never creates
+const UNUSED_PLUGINS: &[&str] = &[
+    "aja",
+    "aja-output-ui",
+    "decklink",
+    "decklink-captions",
+    "decklink-output-ui",
+    "frontend-tools",
+    "image-source",
+    "mac-avcapture",
+    "mac-syphon",
+    "mac-virtualcam",
+    "obs-browser",
+    "obs-text",
+    "obs-vst",
+    "obs-webrtc",
+    "obs-websocket",
+    "text-freetype2",
+    "vlc-video",
+];
+
+/// Directory of selected plugins, beside the plugin directory it links into
+const SELECTED_DIR_NAME: &str = "obs-plugins-selected";
+
+#[derive(Debug, PartialEq, Serialize, Deserialize)]
+struct PluginManifest {
+    /// A different build may select differently
+    agent_version: String,
+    /// Plugin directory the selection was built from
+    plugin_dir: PathBuf,
+    /// Its mtime, which changes whenever a plugin is added, removed or replaced
+    plugin_dir_mtime_ns: u128,
+    excluded: Vec<String>,
+    /// Modules linked into the selected directory
+    selected: Vec<String>,
+    /// libobs paths resolved from the runtime on the start that validated it
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    startup_paths: Option<RuntimePaths>,
+}
+
+/// The three paths libobs starts from, as handed to `StartupPaths::new`
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+pub(super) struct RuntimePaths {
+    pub data: PathBuf,
+    pub plugin_bin: PathBuf,
+    pub plugin_data: PathBuf,
+}
+
+/// Modules that aren't needed beyond [`UNUSED_PLUGINS`], from the capture mode
+pub(super) fn unused_plugins(enable_audio: bool) -> Vec<&'static str> {
+    let mut unused = UNUSED_PLUGINS.to_vec();
+    #[cfg(target_os = "linux")]
+    {
+        // Wayland captures through PipeWire, X11 through xshm/xcomposite
+        if super::sources::is_wayland_session() {
+            unused.push("linux-capture");
+        } else {
+            unused.push("linux-pipewire");
+        }
+        if !enable_audio {
+            unused.push("linux-pulseaudio");
+        }
+        unused.push("linux-v4l2");
+        unused.push("linux-alsa");
+        unused.push("linux-jack");
+    }
+    #[cfg(not(target_os = "linux"))]
+    let _ = enable_audio;
+    unused
+}
+
+fn selection_disabled() -> bool {
+    std::env::var_os("CROWD_CAST_OBS_LOAD_ALL_PLUGINS").is_some_and(|v| v != "0")
+}
+
+fn manifest_path() -> Option<PathBuf> {
+    Some(
+        directories::ProjectDirs::from("dev", "crowd-cast", "agent")?
+            .data_dir()
+            .join("obs_plugin_manifest.json"),
+    )
+}
+
+fn mtime_ns(path: &Path) -> Option<u128> {
+    Some(
+        std::fs::metadata(path)
+            .and_then(|m| m.modified())
+            .ok()?
+            .duration_since(UNIX_EPOCH)
+            .ok()?
+            .as_nanos(),
+    )
+}
+
+fn sorted(excluded: &[&str]) -> Vec<String> {
+    let mut excluded: Vec<String> = excluded.iter().map(|m| m.to_string()).collect();
+    excluded.sort();
+    excluded
+}
+
+/// The manifest at `manifest_path`, if it still describes `plugin_dir` at
+/// `mtime_ns` with `excluded` left out and its selected directory in place
+fn current_manifest(
+    manifest_path: &Path,
+    plugin_dir: &Path,
+    mtime_ns: u128,
+    excluded: &[String],
+) -> Option<PluginManifest> {
+    let manifest = read_manifest(manifest_path)?;
+    let selected_dir = plugin_dir.parent()?.join(SELECTED_DIR_NAME);
+    (manifest.agent_version == env!("CARGO_PKG_VERSION")
+        && manifest.plugin_dir == plugin_dir
+        && manifest.plugin_dir_mtime_ns == mtime_ns
+        && manifest.excluded == excluded
+        && selected_dir.is_dir())
+    .then_some(manifest)
+}
+
+/// libobs paths recorded by an earlier start from the runtime whose plugin
+/// directory is `plugin_dir`, if that directory hasn't changed since. The
+/// runtime was validated when they were recorded, so the caller can skip its
+/// own checks.
+pub(super) fn cached_startup_paths(plugin_dir: &Path, excluded: &[&str]) -> Option<RuntimePaths> {
+    if selection_disabled() {
+        return None;
+    }
+    let paths = current_manifest(
+        &manifest_path()?,
+        plugin_dir,
+        mtime_ns(plugin_dir)?,
+        &sorted(excluded),
+    )?
+    .startup_paths?;
+    debug!("Reusing OBS runtime paths from manifest");
+    Some(paths)
+}
+
+/// Record the libobs paths resolved from the runtime at `plugin_dir`, for
+/// [`cached_startup_paths`]. Only kept alongside a current plugin selection.
+pub(super) fn record_startup_paths(plugin_dir: &Path, excluded: &[&str], paths: &RuntimePaths) {
+    if selection_disabled() {
+        return;
+    }
+    let Some(manifest_path) = manifest_path() else {
+        return;
+    };
+    let Some(mtime_ns) = mtime_ns(plugin_dir) else {
+        return;
+    };
+    let Some(mut manifest) =
+        current_manifest(&manifest_path, plugin_dir, mtime_ns, &sorted(excluded))
+    else {
+        return;
+    };
+    if manifest.startup_paths.as_ref() != Some(paths) {
+        manifest.startup_paths = Some(paths.clone());
+        write_manifest(&manifest_path, &manifest);
+    }
+}
+
+/// Directory holding only the plugins in `plugin_dir` (named `<module><ext>`)
+/// that aren't `excluded`, or `None` to load from `plugin_dir` itself.
+pub(super) fn selected_plugin_dir(
+    plugin_dir: &Path,
+    ext: &str,
+    excluded: &[&str],
+) -> Option<PathBuf> {
+    if selection_disabled() {
+        return None;
+    }
+    let selected_dir = plugin_dir.parent()?.join(SELECTED_DIR_NAME);
+    let manifest_path = manifest_path()?;
+    let mtime_ns = mtime_ns(plugin_dir)?;
+    let excluded = sorted(excluded);
+
+    if let Some(manifest) = current_manifest(&manifest_path, plugin_dir, mtime_ns, &excluded) {
+        debug!(
+            "Reusing OBS plugin selection ({} modules) from manifest",
+            manifest.selected.len()
+        );
+        return Some(selected_dir);
+    }
+
+    let selected = match build_selected_dir(plugin_dir, &selected_dir, ext, &excluded) {
+        Ok(selected) => selected,
+        Err(e) => {
+            warn!(
+                "Failed to build OBS plugin selection in {:?} ({}); loading all plugins",
+                selected_dir, e
+            );
+            return None;
+        }
+    };
+    info!(
+        "Selected {} OBS plugin(s) for this capture mode: {:?}",
+        selected.len(),
+        selected
+    );
+    write_manifest(
+        &manifest_path,
+        &PluginManifest {
+            agent_version: env!("CARGO_PKG_VERSION").to_string(),
+            plugin_dir: plugin_dir.to_path_buf(),
+            plugin_dir_mtime_ns: mtime_ns,
+            excluded,
+            selected,
+            startup_paths: None,
+        },
+    );
+    Some(selected_dir)
+}
+
+/// Rebuild `selected_dir` with a symlink per selected plugin, returning the
+/// selected module names. Built beside the target and renamed into place, so a
+/// crash never leaves libobs a half-populated directory.
+fn build_selected_dir(
+    plugin_dir: &Path,
+    selected_dir: &Path,
+    ext: &str,
+    excluded: &[String],
+) -> std::io::Result<Vec<String>> {
+    let mut selected = Vec::new();
+    let staging = selected_dir.with_extension("tmp");
+    let _ = std::fs::remove_dir_all(&staging);
+    std::fs::create_dir_all(&staging)?;
+    for entry in std::fs::read_dir(plugin_dir)? {
+        let entry = entry?;
+        let file_name = entry.file_name();
+        let Some(module) = file_name.to_str().and_then(|n| n.strip_suffix(ext)) else {
+            continue;
+        };
+        if excluded.iter().any(|e| e == module) {
+            continue;
+        }
+        std::os::unix::fs::symlink(entry.path(), staging.join(&file_name))?;
+        selected.push(module.to_string());
+    }
+    selected.sort();
+    // remove_dir_all unlinks the symlinks, never the plugins they point at
+    match std::fs::remove_dir_all(selected_dir) {
+        Ok(()) => {}
+        Err(e) if e.kind() == std::io::ErrorKind::NotFound => {}
+        Err(e) => return Err(e),
+    }
+    std::fs::rename(&staging, selected_dir)?;
+    Ok(selected)
+}
+
+fn read_manifest(path: &Path) -> Option<PluginManifest> {
+    let json = std::fs::read_to_string(path).ok()?;
+    serde_json::from_str(&json).ok()
+}
+
+fn write_manifest(path: &Path, manifest: &PluginManifest) {
+    if let Some(parent) = path.parent() {
+        let _ = std::fs::create_dir_all(parent);
+    }
+    let result = serde_json::to_string_pretty(manifest)
+        .map_err(std::io::Error::from)
+        .and_then(|json| std::fs::write(path, json));
+    if let Err(e) = result {
+        // Only costs the next start a rebuild
+        warn!("Failed to write OBS plugin manifest {:?}: {}", path, e);
+    }
+}
@@ -0,0 +1,188 @@
+//! Process-identity cache for foreground-window resolution (Windows and X11)
+//!
+//! Resolving the frontmost app's identity is the expensive half of a foreground
+//! query: `OpenProcess` + `QueryFullProcessImageNameW` on Windows, a
+//! `/proc/<pid>/comm` read on X11. The foreground window almost never changes
+//! between polls, so identities are cached per window/process key — `(hwnd,
+//! pid)` on Windows, `(window, pid)` on X11 — and only the cheap window → key
+//! lookup runs on a hit.
+//!
+//! Entries are revalidated on every miss (i.e. when focus actually lands on an
+//! uncached window): an entry whose process has exited — or whose PID now
+//! belongs to a different process, detected by process start time on Linux and
+//! by the window no longer belonging to that PID on Windows — is evicted, so a
+//! recycled PID can never inherit a stale identity.
+#![cfg(any(target_os = "windows", target_os = "linux"))]
+
+use std::collections::HashMap;
+use std::hash::Hash;
+use std::sync::{Mutex, OnceLock};
+
+/// Upper bound on cached identities; a full cache that survives revalidation is
+/// simply cleared (a user never has this many distinct foreground windows live).
+const MAX_ENTRIES: usize = 64;
+
+/// Identity cache keyed by a platform window/process key. Usable as a `static`.
+pub(crate) struct IdentityCache<K, V> {
+    entries: OnceLock<Mutex<HashMap<K, V>>>,
+}
+
+impl<K: Eq + Hash + Copy, V: Clone> IdentityCache<K, V> {
+    pub(crate) const fn new() -> Self {
+        Self {
+            entries: OnceLock::new(),
+        }
+    }
+
+    fn map(&self) -> std::sync::MutexGuard<'_, HashMap<K, V>> {
+        self.entries
+            .get_or_init(|| Mutex::new(HashMap::new()))
+            .lock()
+            .unwrap_or_else(std::sync::PoisonError::into_inner)
+    }
+
+    /// Return the cached identity for `key`, or `resolve` it. On a miss, entries failing
+    /// `still_valid` (exited / recycled processes) are evicted before the new one is stored.
+    /// A failed resolution is not cached, so transient failures are retried next call.
+    pub(crate) fn get_or_resolve(
+        &self,
+        key: K,
+        resolve: impl FnOnce() -> Option<V>,
+        still_valid: impl Fn(&K, &V) -> bool,
+    ) -> Option<V> {
+        if let Some(hit) = self.map().get(&key) {
+            return Some(hit.clone());
+        }
+        // Resolve without holding the lock: the engine and the capture context query from
+        // different threads, and resolution makes syscalls.
+        let value = resolve()?;
+        let mut map = self.map();
+        map.retain(|k, v| still_valid(k, v));
+        if map.len() >= MAX_ENTRIES {
+            map.clear();
+        }
+        map.insert(key, value.clone());
+        Some(value)
+    }
+
+    #[cfg(test)]
+    fn len(&self) -> usize {
+        self.map().len()
+    }
+}
+
+// ============================================================================
+// Linux (X11)
+// ============================================================================
+
+/// A process identity pinned to the process instance it was read from.
+#[cfg(target_os = "linux")]
+#[derive(Clone, Debug)]
+struct ProcIdentity {
+    comm: String,
+    /// `/proc/<pid>/stat` start time (clock ticks since boot); differs for a recycled PID
+    start_time: u64,
+}
+
+#[cfg(target_os = "linux")]
+static X11_IDENTITIES: IdentityCache<(u32, u32), ProcIdentity> = IdentityCache::new();
+
+/// `/proc/<pid>/comm` of the process owning X11 `window`, cached per `(window, pid)`. Shared
+/// by `frontmost::get_frontmost_app` and `x11_windows::resolve_capture_window`, so the
+/// identity the gate matches on and the one capture binds to come from the same read.
+#[cfg(target_os = "linux")]
+pub(crate) fn x11_window_comm(window: u32, pid: u32) -> Option<String> {
+    X11_IDENTITIES
+        .get_or_resolve(
+            (window, pid),
+            || read_proc_identity(pid),
+            |&(_, pid), id| proc_start_time(pid) == Some(id.start_time),
+        )
+        .map(|id| id.comm)
+}
+
+#[cfg(target_os = "linux")]
+fn read_proc_identity(pid: u32) -> Option<ProcIdentity> {
+    // Read the start time first: if the process is replaced between the two reads the start
+    // time no longer matches on revalidation and the entry is evicted, never trusted.
+    let start_time = proc_start_time(pid)?;
+    let comm = std::fs::read_to_string(format!("/proc/{pid}/comm"))
+        .ok()?
+        .trim()
+        .to_string();
+    if comm.is_empty() {
+        return None;
+    }
+    Some(ProcIdentity { comm, start_time })
+}
+
+#[cfg(target_os = "linux")]
+fn proc_start_time(pid: u32) -> Option<u64> {
+    parse_start_time(&std::fs::read_to_string(format!("/proc/{pid}/stat")).ok()?)
+}
+
+/// Field 22 (`starttime`) of a `/proc/<pid>/stat` line. The comm field (2) may itself
+/// contain spaces and parentheses, so fields are counted from the LAST `)`.
+#[cfg(target_os = "linux")]
+fn parse_start_time(stat: &str) -> Option<u64> {
+    let rest = &stat[stat.rfind(')')? + 1..];
+    // After ")": field 3 (state) is index 0, so field 22 is index 19.
+    rest.split_whitespace().nth(19)?.parse().ok()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::cell::Cell;
+
+    #[test]
+    fn hit_skips_resolution_and_miss_evicts_invalid() {
+        let cache: IdentityCache<u32, &str> = IdentityCache::new();
+        let resolves = Cell::new(0);
+        let resolve = |v| {
+            resolves.set(resolves.get() + 1);
+            Some(v)
+        };
+
+        assert_eq!(
+            cache.get_or_resolve(1, || resolve("a"), |_, _| true),
+            Some("a")
+        );
+        assert_eq!(
+            cache.get_or_resolve(1, || resolve("x"), |_, _| true),
+            Some("a")
+        );
+        assert_eq!(resolves.get(), 1);
+
+        // A miss revalidates: key 1's process "exited"
+        assert_eq!(
+            cache.get_or_resolve(2, || resolve("b"), |&k, _| k != 1),
+            Some("b")
+        );
+        assert_eq!(cache.len(), 1);
+        assert_eq!(
+            cache.get_or_resolve(1, || resolve("c"), |_, _| true),
+            Some("c")
+        );
+        assert_eq!(resolves.get(), 3);
+    }
+
+    #[test]
+    fn failed_resolution_is_not_cached() {
+        let cache: IdentityCache<u32, &str> = IdentityCache::new();
+        assert_eq!(cache.get_or_resolve(1, || None, |_, _| true), None);
+        assert_eq!(
+            cache.get_or_resolve(1, || Some("a"), |_, _| true),
+            Some("a")
+        );
+    }
+
+    #[cfg(target_os = "linux")]
+    #[test]
+    fn start_time_parses_past_tricky_comm() {
+        let stat = "1234 (we ird) (n) S 1 1234 1234 0 -1 4194560 100 0 0 0 5 3 0 0 20 0 1 0 \
+                    987654 12345678 100";
+        assert_eq!(parse_start_time(stat), Some(987654));
+        assert!(proc_start_time(std::process::id()).is_some());
+    }
+}
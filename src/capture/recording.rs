@@ -3,6 +3,17 @@
 //! Handles creating and managing recording outputs with proper encoder configuration.
 //! Uses HEVC hardware encoding (VideoToolbox on macOS) when available, falling back
 //! to H.264 hardware encoding, then software encoding.
+//!
+//! With `split_file` enabled the output can also switch to a new file at its next
+//! keyframe while the encoder keeps running (libobs' `split_file` procedure on the
+//! file outputs), which is how segments rotate without a stop/start gap.
+//!
+//! A bitrate-controlled encoder's target can likewise be changed while it runs
+//! ([`RecordingOutput::set_video_bitrate`]), which the engine uses to record idle
+//! screens at a lower bitrate.
+//!
+//! With `auto_hardware_encoder` set, a software encoder chosen by the builder is
+//! replaced by a registered hardware one on trial (see `encoder_probe`).
 
 use anyhow::Result;
 use libobs_simple::output::simple::{
@@ -11,8 +22,14 @@ use libobs_simple::output::simple::{
 use libobs_wrapper::context::ObsContext;
 use libobs_wrapper::data::output::ObsOutputRef;
 use libobs_wrapper::utils::ObsPath;
-use std::path::PathBuf;
-use tracing::{debug, info};
+use std::collections::VecDeque;
+use std::ffi::{c_char, c_void, CStr, CString};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use tracing::{debug, info, warn};
+
+use super::encoder_probe::EncoderTrial;
 
 /// Calculate output dimensions with aspect-preserving downscale
 ///
@@ -101,6 +118,11 @@ pub struct RecordingConfig {
     /// When set, supported encoders use CRF instead of fixed bitrate.
     /// Recommended: 75-85 for screen recording.
     pub crf: Option<u32>,
+    /// Enable keyframe-aligned file splitting (`RecordingOutput::request_split`)
+    pub split_file: bool,
+    /// Swap in a hardware encoder when the builder settles for software
+    /// (see `encoder_probe`)
+    pub auto_hardware_encoder: bool,
 }
 
 impl Default for RecordingConfig {
@@ -124,6 +146,8 @@ impl Default for RecordingConfig {
             fps: 30,
             // CRF quality 80 - sharp text at any resolution
             crf: Some(80),
+            split_file: false,
+            auto_hardware_encoder: false,
         }
     }
 }
@@ -142,6 +166,8 @@ impl RecordingConfig {
             max_output_height: 0,
             fps: 30,
             crf: Some(90),
+            split_file: false,
+            auto_hardware_encoder: false,
         }
     }
 
@@ -158,6 +184,8 @@ impl RecordingConfig {
             max_output_height: 720,
             fps: 30,
             crf: Some(65),
+            split_file: false,
+            auto_hardware_encoder: false,
         }
     }
 
@@ -174,6 +202,8 @@ impl RecordingConfig {
             max_output_height: 720,
             fps: 30,
             crf: Some(80),
+            split_file: false,
+            auto_hardware_encoder: false,
         }
     }
 
@@ -190,9 +220,235 @@ impl RecordingConfig {
     }
 }
 
+/// Name of the libobs output created for recordings
+const RECORDING_OUTPUT_NAME: &str = "recording";
+
+/// Run `f` on the raw recording output (the wrapper exposes neither encoder
+/// updates nor output stats), holding a reference for the duration of the call.
+fn with_recording_output<T>(f: impl FnOnce(*mut libobs::obs_output_t) -> T) -> Result<T> {
+    let name = CString::new(RECORDING_OUTPUT_NAME)?;
+    let output = unsafe { libobs::obs_get_output_by_name(name.as_ptr()) };
+    if output.is_null() {
+        anyhow::bail!("Recording output {:?} not found", RECORDING_OUTPUT_NAME);
+    }
+    let result = f(output);
+    unsafe { libobs::obs_output_release(output) };
+    Ok(result)
+}
+
+/// A file switch reported by the output's `file_changed` signal
+#[derive(Debug, Clone)]
+pub struct FileSplit {
+    /// File the output writes from the split keyframe on
+    pub next_path: PathBuf,
+    /// OBS video frame time of the keyframe that opens `next_path`
+    /// (nanoseconds), on the same clock as a session's `start_time_ns`. Falls
+    /// back to the frame time when the switch was reported, which trails the
+    /// keyframe by the encoder's pipeline delay, if libobs gave the packet no
+    /// timing.
+    pub frame_time_ns: u64,
+}
+
+/// State shared with the libobs callbacks of a [`SplitFileHook`]
+#[derive(Default)]
+struct SplitState {
+    splits: Mutex<VecDeque<FileSplit>>,
+    /// Render time of the last video keyframe handed to the muxer (0 = none yet)
+    keyframe_time_ns: AtomicU64,
+}
+
+/// Direct libobs hook for file splitting, which the wrapper doesn't expose:
+/// the `split_file` settings, the `split_file` procedure and the
+/// `file_changed` signal of the file output.
+struct SplitFileHook {
+    /// Strong reference from `obs_get_output_by_name`, released on drop
+    output: *mut libobs::obs_output_t,
+    /// `Arc<SplitState>` leaked as the callbacks' data pointer
+    state: *const SplitState,
+}
+
+// libobs output, proc and signal calls are thread-safe; the state is a Mutex
+// and an atomic.
+unsafe impl Send for SplitFileHook {}
+
+const FILE_CHANGED_SIGNAL: &CStr = c"file_changed";
+
+/// Called by the output for each packet just before the muxer gets it. The file
+/// outputs switch files on a video keyframe, signalling `file_changed` while
+/// muxing it, so the last keyframe seen here is the first packet of the new file.
+unsafe extern "C" fn on_packet(
+    _output: *mut libobs::obs_output_t,
+    pkt: *mut libobs::encoder_packet,
+    pkt_time: *mut libobs::encoder_packet_time,
+    data: *mut c_void,
+) {
+    if pkt.is_null() || pkt_time.is_null() {
+        return;
+    }
+    let pkt = &*pkt;
+    if pkt.type_ != libobs::obs_encoder_type_OBS_ENCODER_VIDEO || !pkt.keyframe {
+        return;
+    }
+    // `cts` is the frame's render time, the clock `obs_get_video_frame_time` reads
+    let state = &*(data as *const SplitState);
+    state
+        .keyframe_time_ns
+        .store((*pkt_time).cts, Ordering::Relaxed);
+}
+
+unsafe extern "C" fn on_file_changed(data: *mut c_void, cd: *mut libobs::calldata_t) {
+    let state = &*(data as *const SplitState);
+    let mut next_file: *const c_char = std::ptr::null();
+    if !libobs::calldata_get_string(cd, c"next_file".as_ptr(), &mut next_file)
+        || next_file.is_null()
+    {
+        return;
+    }
+    let frame_time_ns = match state.keyframe_time_ns.load(Ordering::Relaxed) {
+        0 => {
+            warn!("No keyframe timing for the file split, using the current frame time");
+            libobs::obs_get_video_frame_time()
+        }
+        keyframe => keyframe,
+    };
+    let split = FileSplit {
+        next_path: PathBuf::from(CStr::from_ptr(next_file).to_string_lossy().into_owned()),
+        frame_time_ns,
+    };
+    state
+        .splits
+        .lock()
+        .unwrap_or_else(std::sync::PoisonError::into_inner)
+        .push_back(split);
+}
+
+impl SplitFileHook {
+    /// Turn on manual file splitting for the recording output (before it starts:
+    /// the file outputs read `split_file` at start) and subscribe to file switches.
+    fn install(output_path: &Path) -> Result<Self> {
+        let name = CString::new(RECORDING_OUTPUT_NAME)?;
+        let output = unsafe { libobs::obs_get_output_by_name(name.as_ptr()) };
+        if output.is_null() {
+            anyhow::bail!("Recording output {:?} not found", RECORDING_OUTPUT_NAME);
+        }
+        let directory = output_path
+            .parent()
+            .and_then(Path::to_str)
+            .ok_or_else(|| anyhow::anyhow!("Invalid output directory: {:?}", output_path))?;
+        let extension = output_path
+            .extension()
+            .and_then(|e| e.to_str())
+            .unwrap_or("mp4");
+
+        let hook = Self {
+            output,
+            state: Arc::into_raw(Arc::new(SplitState::default())),
+        };
+        unsafe {
+            let settings = libobs::obs_data_create();
+            libobs::obs_data_set_bool(settings, c"split_file".as_ptr(), true);
+            // Split only on request, never by time or size
+            libobs::obs_data_set_int(settings, c"max_time_sec".as_ptr(), 0);
+            libobs::obs_data_set_int(settings, c"max_size_mb".as_ptr(), 0);
+            libobs::obs_data_set_bool(settings, c"allow_overwrite".as_ptr(), true);
+            libobs::obs_data_set_string(
+                settings,
+                c"directory".as_ptr(),
+                CString::new(directory)?.as_ptr(),
+            );
+            libobs::obs_data_set_string(
+                settings,
+                c"extension".as_ptr(),
+                CString::new(extension)?.as_ptr(),
+            );
+            libobs::obs_output_update(output, settings);
+            libobs::obs_data_release(settings);
+
+            libobs::signal_handler_connect(
+                libobs::obs_output_get_signal_handler(output),
+                FILE_CHANGED_SIGNAL.as_ptr(),
+                Some(on_file_changed),
+                hook.state as *mut c_void,
+            );
+            libobs::obs_output_add_packet_callback(
+                output,
+                Some(on_packet),
+                hook.state as *mut c_void,
+            );
+        }
+        Ok(hook)
+    }
+
+    /// Ask the output to switch to `next_path` at its next keyframe. Returns
+    /// whether the output accepted (it has splitting enabled).
+    fn request(&self, next_path: &Path) -> Result<bool> {
+        // The file outputs name split files `<directory>/<format>.<extension>`;
+        // a format without `%` specifiers is used verbatim.
+        let stem = next_path
+            .file_stem()
+            .and_then(|s| s.to_str())
+            .ok_or_else(|| anyhow::anyhow!("Invalid split path: {:?}", next_path))?;
+        let stem = CString::new(stem)?;
+        unsafe {
+            let settings = libobs::obs_data_create();
+            libobs::obs_data_set_string(settings, c"format".as_ptr(), stem.as_ptr());
+            libobs::obs_output_update(self.output, settings);
+            libobs::obs_data_release(settings);
+
+            let mut cd: libobs::calldata_t = std::mem::zeroed();
+            let called = libobs::proc_handler_call(
+                libobs::obs_output_get_proc_handler(self.output),
+                c"split_file".as_ptr(),
+                &mut cd,
+            );
+            let mut enabled = false;
+            libobs::calldata_get_data(
+                &cd,
+                c"split_file_enabled".as_ptr(),
+                &mut enabled as *mut bool as *mut c_void,
+                std::mem::size_of::<bool>(),
+            );
+            libobs::bfree(cd.stack as *mut c_void);
+            Ok(called && enabled)
+        }
+    }
+
+    fn take(&self) -> Option<FileSplit> {
+        unsafe { &*self.state }
+            .splits
+            .lock()
+            .unwrap_or_else(std::sync::PoisonError::into_inner)
+            .pop_front()
+    }
+}
+
+impl Drop for SplitFileHook {
+    fn drop(&mut self) {
+        unsafe {
+            libobs::signal_handler_disconnect(
+                libobs::obs_output_get_signal_handler(self.output),
+                FILE_CHANGED_SIGNAL.as_ptr(),
+                Some(on_file_changed),
+                self.state as *mut c_void,
+            );
+            libobs::obs_output_remove_packet_callback(
+                self.output,
+                Some(on_packet),
+                self.state as *mut c_void,
+            );
+            drop(Arc::from_raw(self.state));
+            libobs::obs_output_release(self.output);
+        }
+    }
+}
+
 /// Manages a recording output
 pub struct RecordingOutput {
+    // Declared before `output` so the signal is disconnected first
+    split_hook: Option<SplitFileHook>,
     output: ObsOutputRef,
+    // Declared after `output`: the swapped-in encoder outlives its use
+    encoder_trial: Option<EncoderTrial>,
     state: RecordingState,
     output_path: PathBuf,
 }
@@ -232,7 +488,7 @@ impl RecordingOutput {
         // audio capture is controlled at the source level via ScreenCaptureSource.
         // When config.enable_audio is false, no audio sources are added, so the
         // audio track will be silent.
-        let mut builder = SimpleOutputBuilder::new(context, "recording", obs_path)
+        let mut builder = SimpleOutputBuilder::new(context, RECORDING_OUTPUT_NAME, obs_path)
             .video_bitrate(config.video_bitrate)
             .audio_bitrate(config.audio_bitrate)
             .hardware_encoder(codec, config.quality_preset)
@@ -259,8 +515,37 @@ impl RecordingOutput {
             config.format, config.quality_preset
         );
 
+        let encoder_trial = if config.auto_hardware_encoder {
+            let preferred_codec = match config.codec_preference {
+                VideoCodecPreference::HevcPreferred => "hevc",
+                VideoCodecPreference::H264Preferred => "h264",
+                VideoCodecPreference::Av1Preferred => "av1",
+            };
+            with_recording_output(|output| {
+                EncoderTrial::begin(output, preferred_codec, config.video_bitrate, config.fps)
+            })
+            .unwrap_or_else(|e| {
+                warn!("Encoder probe skipped: {}", e);
+                None
+            })
+        } else {
+            None
+        };
+
+        // Splitting is an optimization over stop/start rotation, so failing to
+        // set it up only costs the optimization.
+        let mut split_hook = None;
+        if config.split_file {
+            match SplitFileHook::install(&output_path) {
+                Ok(hook) => split_hook = Some(hook),
+                Err(e) => warn!("File splitting unavailable, using stop/start: {}", e),
+            }
+        }
+
         Ok(Self {
+            split_hook,
             output,
+            encoder_trial,
             state: RecordingState::Stopped,
             output_path,
         })
@@ -279,9 +564,19 @@ impl RecordingOutput {
         }
 
         info!("Starting recording to {:?}", self.output_path);
-        self.output
-            .start()
-            .map_err(|e| anyhow::anyhow!("Failed to start recording: {}", e))?;
+        if let Err(e) = self.output.start() {
+            // A swapped-in encoder that won't start gets one retry on the builder's
+            let trial = self
+                .encoder_trial
+                .take()
+                .ok_or_else(|| anyhow::anyhow!("Failed to start recording: {}", e))?;
+            warn!("Failed to start recording: {}", e);
+            with_recording_output(|output| trial.fail(output))?;
+            drop(trial);
+            self.output
+                .start()
+                .map_err(|e| anyhow::anyhow!("Failed to start recording: {}", e))?;
+        }
 
         self.state = RecordingState::Recording;
         Ok(())
@@ -361,6 +656,69 @@ impl RecordingOutput {
     pub fn is_paused(&self) -> bool {
         self.state == RecordingState::Paused
     }
+
+    /// Ask the output to continue into `next_path` from its next keyframe,
+    /// without stopping the encoder. Returns `false` when splitting isn't
+    /// available, in which case the caller rotates with stop/start. The
+    /// switch itself is reported later through [`Self::take_file_split`].
+    pub fn request_split(&mut self, next_path: &Path) -> Result<bool> {
+        if self.state != RecordingState::Recording {
+            return Ok(false);
+        }
+        match &self.split_hook {
+            Some(hook) => hook.request(next_path),
+            None => Ok(false),
+        }
+    }
+
+    /// Retarget the running video encoder to `kbps`. Returns `false` (leaving the
+    /// encoder untouched) when it isn't bitrate-controlled: under constant-quality
+    /// rate control (CRF/CQP/ICQ) the bitrate setting is ignored.
+    pub fn set_video_bitrate(&mut self, kbps: u32) -> Result<bool> {
+        with_recording_output(|output| unsafe {
+            let encoder = libobs::obs_output_get_video_encoder(output);
+            if encoder.is_null() {
+                return false;
+            }
+            let settings = libobs::obs_encoder_get_settings(encoder);
+            let rate_control = libobs::obs_data_get_string(settings, c"rate_control".as_ptr());
+            let constant_quality = !rate_control.is_null()
+                && matches!(
+                    CStr::from_ptr(rate_control).to_bytes(),
+                    b"CRF" | b"CQP" | b"ICQ" | b"CQVBR"
+                );
+            if !constant_quality {
+                libobs::obs_data_set_int(settings, c"bitrate".as_ptr(), i64::from(kbps));
+                libobs::obs_encoder_update(encoder, settings);
+            }
+            libobs::obs_data_release(settings);
+            !constant_quality
+        })
+    }
+
+    /// Advance the trial of a swapped-in hardware encoder (call periodically
+    /// while recording)
+    pub fn poll_encoder_trial(&mut self) {
+        if self.state != RecordingState::Recording {
+            return;
+        }
+        if let Some(trial) = self.encoder_trial.as_mut() {
+            trial.poll();
+        }
+    }
+
+    /// Encoded bytes the output has written so far (0 if unavailable)
+    pub fn total_bytes(&self) -> u64 {
+        with_recording_output(|output| unsafe { libobs::obs_output_get_total_bytes(output) })
+            .unwrap_or(0)
+    }
+
+    /// The next file switch the output has completed, if any
+    pub fn take_file_split(&mut self) -> Option<FileSplit> {
+        let split = self.split_hook.as_ref()?.take()?;
+        self.output_path = split.next_path.clone();
+        Some(split)
+    }
 }
 
 /// Builder for RecordingOutput with fluent API
@@ -153,7 +153,8 @@ pub fn resolve_capture_window(app_identity: &str) -> Option<String> {
     let root = conn.setup().roots.get(screen_num)?.root;
 
     let active = net_active_window(&conn, root)?;
-    let focused_comm = net_wm_pid(&conn, active).and_then(proc_comm);
+    let focused_comm = net_wm_pid(&conn, active)
+        .and_then(|pid| crate::capture::process_identity::x11_window_comm(active, pid));
 
     // Single canonical key: comm-vs-comm is exact (both are kernel-truncated identically),
     // so no tolerance and no alternate keys are needed.
@@ -211,13 +212,6 @@ fn net_wm_pid(conn: &RustConnection, win: u32) -> Option<u32> {
         .filter(|&pid| pid != 0)
 }
 
-fn proc_comm(pid: u32) -> Option<String> {
-    std::fs::read_to_string(format!("/proc/{pid}/comm"))
-        .ok()
-        .map(|s| s.trim().to_string())
-        .filter(|s| !s.is_empty())
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
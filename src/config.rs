@@ -5,6 +5,8 @@ use serde::{Deserialize, Serialize};
 use std::collections::HashMap;
 use std::path::PathBuf;
 
+use crate::data::KeylogFormat;
+
 /// Main configuration structure
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct Config {
@@ -90,6 +92,13 @@ pub struct CaptureConfig {
     #[serde(default = "default_capture_watchdog_max_retries")]
     pub capture_watchdog_max_retries: u32,
 
+    /// Single-active per-app capture (Windows/Linux): how many per-app scenes to keep
+    /// warm. Scenes are created on first focus and the least recently focused one is torn
+    /// down beyond this. macOS keeps every running app's source (SCK sources can only be
+    /// created in a fresh OBS context).
+    #[serde(default = "default_warm_app_scenes")]
+    pub warm_app_scenes: usize,
+
     /// xdg-desktop-portal ScreenCast restore tokens for supported Wayland display capture,
     /// keyed by reserved identifiers such as `__display__`.
     #[serde(default)]
@@ -113,6 +122,12 @@ pub struct InputConfig {
     /// Whether to capture mouse scroll
     #[serde(default = "default_true")]
     pub capture_mouse_scroll: bool,
+
+    /// Window (ms) over which the rdev backend (macOS/Windows) merges consecutive mouse
+    /// motion into one event. 0 emits every OS callback. evdev already merges per
+    /// `SYN_REPORT` and ignores this.
+    #[serde(default = "default_motion_coalesce_ms")]
+    pub motion_coalesce_ms: u64,
 }
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -124,9 +139,31 @@ pub struct UploadConfig {
     #[serde(default = "default_true")]
     pub delete_after_upload: bool,
 
-    /// Maximum concurrent uploads
+    /// Ceiling for concurrent segment uploads; the scheduler adapts between
+    /// 1 and this from measured throughput and latency
     #[serde(default = "default_max_uploads")]
     pub max_concurrent_uploads: usize,
+
+    /// Upload bandwidth cap in megabits per second (0 = unlimited)
+    #[serde(default)]
+    pub bandwidth_limit_mbps: f64,
+
+    /// Local-time windows in which uploads may start, as "HH:MM-HH:MM"
+    /// (may wrap midnight). Empty = any time.
+    #[serde(default)]
+    pub upload_windows: Vec<String>,
+
+    /// Upload segment video as resumable S3 multipart uploads
+    #[serde(default = "default_true")]
+    pub multipart_uploads: bool,
+
+    /// Multipart part size in MiB (S3 minimum is 5)
+    #[serde(default = "default_multipart_part_size_mib")]
+    pub multipart_part_size_mib: u64,
+
+    /// Keylog format, both on disk and uploaded: "msgpack" or "columnar"
+    #[serde(default)]
+    pub keylog_format: KeylogFormat,
 }
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -150,12 +187,90 @@ pub struct RecordingConfig {
     /// Recordings will be split into segments of this duration for progressive upload
     #[serde(default = "default_segment_duration_secs")]
     pub segment_duration_secs: u64,
+
+    /// How segments rotate: "restart" or "split"
+    #[serde(default)]
+    pub segment_rotation: SegmentRotation,
+
+    /// Record fragmented MP4 and start uploading a segment's video while it is
+    /// still being written, in multipart parts held back until their bytes are
+    /// older than the 10-minute panic window. Needs `upload.multipart_uploads`.
+    #[serde(default)]
+    pub progressive_upload: bool,
+
+    /// Lower the video bitrate while input is idle and the screen is static, and
+    /// restore it on activity. Encodes with bitrate rate control instead of
+    /// constant quality so the bitrate can change while recording.
+    #[serde(default)]
+    pub adaptive_bitrate: bool,
+
+    /// Adaptive bitrate: video bitrate (Kbps) while the user is active
+    #[serde(default = "default_active_bitrate_kbps")]
+    pub active_bitrate_kbps: u32,
+
+    /// Adaptive bitrate: video bitrate (Kbps) while idle
+    #[serde(default = "default_idle_bitrate_kbps")]
+    pub idle_bitrate_kbps: u32,
+
+    /// Adaptive bitrate: seconds without input before dropping to the idle bitrate
+    #[serde(default = "default_bitrate_idle_after_secs")]
+    pub bitrate_idle_after_secs: u64,
+
+    /// Disk budget (GiB) for local segments, including the live recording.
+    /// Near it, uploaded segments are evicted, then new video is compressed,
+    /// then recording pauses until uploads make room (0 = bounded only by the
+    /// free-space reserve)
+    #[serde(default = "default_disk_budget_gb")]
+    pub disk_budget_gb: f64,
+
+    /// Video bitrate (Kbps) while the disk budget is under pressure
+    #[serde(default = "default_disk_pressure_bitrate_kbps")]
+    pub disk_pressure_bitrate_kbps: u32,
+
+    /// When the encoder would fall back to software (x264), record on a
+    /// registered hardware encoder instead, if one proves it keeps up. Opt-in:
+    /// the swapped encoder runs CBR at the video bitrate, not the configured
+    /// constant quality.
+    #[serde(default)]
+    pub auto_hardware_encoder: bool,
+}
+
+/// How the recording moves from one segment file to the next
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum SegmentRotation {
+    /// Stop the output and start a new one (encoder re-initialized each segment)
+    #[default]
+    Restart,
+    /// Switch files at the next keyframe while the encoder keeps running;
+    /// falls back to `Restart` where the output can't split
+    Split,
 }
 
 fn default_segment_duration_secs() -> u64 {
     300 // 5 minutes
 }
 
+fn default_active_bitrate_kbps() -> u32 {
+    6000
+}
+
+fn default_idle_bitrate_kbps() -> u32 {
+    1000
+}
+
+fn default_bitrate_idle_after_secs() -> u64 {
+    10
+}
+
+fn default_disk_budget_gb() -> f64 {
+    20.0
+}
+
+fn default_disk_pressure_bitrate_kbps() -> u32 {
+    1500
+}
+
 fn default_idle_timeout_secs() -> u64 {
     120 // 2 minutes of inactivity before pausing capture
 }
@@ -180,6 +295,10 @@ fn default_capture_watchdog_max_retries() -> u32 {
     1
 }
 
+fn default_warm_app_scenes() -> usize {
+    4
+}
+
 // Default value functions
 fn default_poll_interval() -> u64 {
     100 // 100ms for responsive frontmost app detection
@@ -189,8 +308,16 @@ fn default_true() -> bool {
     true
 }
 
+fn default_motion_coalesce_ms() -> u64 {
+    2 // 500 Hz: well above display rates, an 8 kHz mouse sends 16x that
+}
+
 fn default_max_uploads() -> usize {
-    2
+    6
+}
+
+fn default_multipart_part_size_mib() -> u64 {
+    16
 }
 
 fn default_recording_output_directory() -> PathBuf {
@@ -220,6 +347,7 @@ impl Default for CaptureConfig {
             blank_video_on_untracked_app: true,
             capture_watchdog_timeout_ms: default_capture_watchdog_timeout_ms(),
             capture_watchdog_max_retries: default_capture_watchdog_max_retries(),
+            warm_app_scenes: default_warm_app_scenes(),
             restore_tokens: HashMap::new(),
         }
     }
@@ -232,16 +360,34 @@ impl Default for InputConfig {
             capture_mouse_move: true,
             capture_mouse_click: true,
             capture_mouse_scroll: true,
+            motion_coalesce_ms: default_motion_coalesce_ms(),
         }
     }
 }
 
+impl InputConfig {
+    /// The capture flags as the policy word the input backends filter on
+    pub fn capture_policy(&self) -> crate::input::policy::PolicySnapshot {
+        crate::input::policy::PolicySnapshot::new(
+            self.capture_keyboard,
+            self.capture_mouse_move,
+            self.capture_mouse_click,
+            self.capture_mouse_scroll,
+        )
+    }
+}
+
 impl Default for UploadConfig {
     fn default() -> Self {
         Self {
             lambda_endpoint: None,
             delete_after_upload: true,
             max_concurrent_uploads: default_max_uploads(),
+            bandwidth_limit_mbps: 0.0,
+            upload_windows: Vec::new(),
+            multipart_uploads: true,
+            multipart_part_size_mib: default_multipart_part_size_mib(),
+            keylog_format: KeylogFormat::default(),
         }
     }
 }
@@ -254,6 +400,15 @@ impl Default for RecordingConfig {
             session_id: None,
             notify_on_start_stop: true,
             segment_duration_secs: default_segment_duration_secs(),
+            segment_rotation: SegmentRotation::default(),
+            progressive_upload: false,
+            adaptive_bitrate: false,
+            active_bitrate_kbps: default_active_bitrate_kbps(),
+            idle_bitrate_kbps: default_idle_bitrate_kbps(),
+            bitrate_idle_after_secs: default_bitrate_idle_after_secs(),
+            disk_budget_gb: default_disk_budget_gb(),
+            disk_pressure_bitrate_kbps: default_disk_pressure_bitrate_kbps(),
+            auto_hardware_encoder: false,
         }
     }
 }
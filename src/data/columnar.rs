@@ -0,0 +1,515 @@
+//! Columnar, zstd-compressed keylog format
+//!
+//! The msgpack keylog (`rmp_serde::to_vec(&Vec<InputEvent>)`) repeats the
+//! variant name of every event, which for a 1 kHz mouse is most of the file.
+//! This format instead stores one column per field:
+//!
+//! ```text
+//! "CCKL" | version: u8 | zstd frame {
+//!     event count                     varint
+//!     key-name count                  varint
+//!     column × 15                     varint byte length + bytes
+//! }
+//! ```
+//!
+//! Columns, in order (see [`Columns`]): event type tags (one byte each),
+//! timestamp deltas (zigzag varints), the key-name string table, key codes,
+//! key-name indices, mouse button ids, button x/y, move dx/dy, scroll dx/dy
+//! (zigzag varints), scroll x/y, and an "other" column holding the rare
+//! context/metadata/redaction events as length-prefixed msgpack `EventType`s.
+//! Floats are raw little-endian f64. Each event type's values appear in
+//! event order, so decoding is a single pass over the tag column.
+//!
+//! `scripts/overlay_keylogs.py` reads both formats.
+
+use anyhow::{bail, Context, Result};
+use std::collections::HashMap;
+
+use super::{
+    EventType, InputEvent, KeyEvent, MouseButton, MouseButtonEvent, MouseMoveEvent,
+    MouseScrollEvent,
+};
+
+/// File magic for columnar keylogs
+pub const COLUMNAR_MAGIC: &[u8; 4] = b"CCKL";
+
+/// Current columnar format version
+pub const COLUMNAR_VERSION: u8 = 1;
+
+/// zstd level: 3 is the library default and already captures nearly all the
+/// gain on these highly regular columns.
+const ZSTD_LEVEL: i32 = 3;
+
+const TAG_CONTEXT_CHANGED: u8 = 0;
+const TAG_KEY_PRESS: u8 = 1;
+const TAG_KEY_RELEASE: u8 = 2;
+const TAG_MOUSE_PRESS: u8 = 3;
+const TAG_MOUSE_RELEASE: u8 = 4;
+const TAG_MOUSE_MOVE: u8 = 5;
+const TAG_MOUSE_SCROLL: u8 = 6;
+const TAG_METADATA: u8 = 7;
+const TAG_REDACTED: u8 = 8;
+
+/// Number of columns after the header counts
+const COLUMN_COUNT: usize = 15;
+
+#[derive(Default)]
+struct Columns {
+    tags: Vec<u8>,
+    timestamps: Vec<u8>,
+    key_names: Vec<u8>,
+    key_codes: Vec<u8>,
+    key_name_idx: Vec<u8>,
+    button_ids: Vec<u8>,
+    button_x: Vec<u8>,
+    button_y: Vec<u8>,
+    move_dx: Vec<u8>,
+    move_dy: Vec<u8>,
+    scroll_dx: Vec<u8>,
+    scroll_dy: Vec<u8>,
+    scroll_x: Vec<u8>,
+    scroll_y: Vec<u8>,
+    other: Vec<u8>,
+}
+
+impl Columns {
+    fn in_order(&self) -> [&Vec<u8>; COLUMN_COUNT] {
+        [
+            &self.tags,
+            &self.timestamps,
+            &self.key_names,
+            &self.key_codes,
+            &self.key_name_idx,
+            &self.button_ids,
+            &self.button_x,
+            &self.button_y,
+            &self.move_dx,
+            &self.move_dy,
+            &self.scroll_dx,
+            &self.scroll_dy,
+            &self.scroll_x,
+            &self.scroll_y,
+            &self.other,
+        ]
+    }
+}
+
+fn put_varint(out: &mut Vec<u8>, mut value: u64) {
+    while value >= 0x80 {
+        out.push((value as u8) | 0x80);
+        value >>= 7;
+    }
+    out.push(value as u8);
+}
+
+fn put_zigzag(out: &mut Vec<u8>, value: i64) {
+    put_varint(out, ((value << 1) ^ (value >> 63)) as u64);
+}
+
+fn put_f64(out: &mut Vec<u8>, value: f64) {
+    out.extend_from_slice(&value.to_le_bytes());
+}
+
+fn button_id(button: MouseButton) -> u64 {
+    match button {
+        MouseButton::Left => 0,
+        MouseButton::Right => 1,
+        MouseButton::Middle => 2,
+        MouseButton::Other(n) => 3 + n as u64,
+    }
+}
+
+fn button_from_id(id: u64) -> Result<MouseButton> {
+    Ok(match id {
+        0 => MouseButton::Left,
+        1 => MouseButton::Right,
+        2 => MouseButton::Middle,
+        n => MouseButton::Other(u8::try_from(n - 3).context("Mouse button id out of range")?),
+    })
+}
+
+/// Encode events into the columnar format.
+pub fn encode_columnar(events: &[InputEvent]) -> Result<Vec<u8>> {
+    let mut cols = Columns::default();
+    let mut names: HashMap<&str, u64> = HashMap::new();
+    let mut name_count = 0u64;
+    let mut prev_ts = 0u64;
+
+    for event in events {
+        // Timestamps are nearly always non-decreasing; zigzag keeps the rare
+        // out-of-order event (e.g. a transition replay) cheap too.
+        put_zigzag(
+            &mut cols.timestamps,
+            event.timestamp_us.wrapping_sub(prev_ts) as i64,
+        );
+        prev_ts = event.timestamp_us;
+
+        match &event.event {
+            EventType::KeyPress(key) | EventType::KeyRelease(key) => {
+                cols.tags
+                    .push(if matches!(event.event, EventType::KeyPress(_)) {
+                        TAG_KEY_PRESS
+                    } else {
+                        TAG_KEY_RELEASE
+                    });
+                let idx = *names.entry(key.name.as_str()).or_insert_with(|| {
+                    put_varint(&mut cols.key_names, key.name.len() as u64);
+                    cols.key_names.extend_from_slice(key.name.as_bytes());
+                    name_count += 1;
+                    name_count - 1
+                });
+                put_varint(&mut cols.key_codes, key.code as u64);
+                put_varint(&mut cols.key_name_idx, idx);
+            }
+            EventType::MousePress(btn) | EventType::MouseRelease(btn) => {
+                cols.tags
+                    .push(if matches!(event.event, EventType::MousePress(_)) {
+                        TAG_MOUSE_PRESS
+                    } else {
+                        TAG_MOUSE_RELEASE
+                    });
+                put_varint(&mut cols.button_ids, button_id(btn.button));
+                put_f64(&mut cols.button_x, btn.x);
+                put_f64(&mut cols.button_y, btn.y);
+            }
+            EventType::MouseMove(mv) => {
+                cols.tags.push(TAG_MOUSE_MOVE);
+                put_f64(&mut cols.move_dx, mv.delta_x);
+                put_f64(&mut cols.move_dy, mv.delta_y);
+            }
+            EventType::MouseScroll(sc) => {
+                cols.tags.push(TAG_MOUSE_SCROLL);
+                put_zigzag(&mut cols.scroll_dx, sc.delta_x);
+                put_zigzag(&mut cols.scroll_dy, sc.delta_y);
+                put_f64(&mut cols.scroll_x, sc.x);
+                put_f64(&mut cols.scroll_y, sc.y);
+            }
+            other => {
+                cols.tags.push(match other {
+                    EventType::ContextChanged(_) => TAG_CONTEXT_CHANGED,
+                    EventType::Metadata(_) => TAG_METADATA,
+                    _ => TAG_REDACTED,
+                });
+                let bytes = rmp_serde::to_vec(other).context("Failed to serialize event")?;
+                put_varint(&mut cols.other, bytes.len() as u64);
+                cols.other.extend_from_slice(&bytes);
+            }
+        }
+    }
+
+    let mut body = Vec::new();
+    put_varint(&mut body, events.len() as u64);
+    put_varint(&mut body, name_count);
+    for col in cols.in_order() {
+        put_varint(&mut body, col.len() as u64);
+        body.extend_from_slice(col);
+    }
+
+    let mut out = Vec::with_capacity(body.len() / 4 + 5);
+    out.extend_from_slice(COLUMNAR_MAGIC);
+    out.push(COLUMNAR_VERSION);
+    zstd::stream::copy_encode(body.as_slice(), &mut out, ZSTD_LEVEL)
+        .context("Failed to compress keylog")?;
+    Ok(out)
+}
+
+/// Cursor over one column
+struct Reader<'a> {
+    buf: &'a [u8],
+    pos: usize,
+}
+
+impl<'a> Reader<'a> {
+    fn new(buf: &'a [u8]) -> Self {
+        Self { buf, pos: 0 }
+    }
+
+    fn bytes(&mut self, len: usize) -> Result<&'a [u8]> {
+        let end = self
+            .pos
+            .checked_add(len)
+            .context("Column length overflow")?;
+        let slice = self
+            .buf
+            .get(self.pos..end)
+            .context("Truncated columnar keylog")?;
+        self.pos = end;
+        Ok(slice)
+    }
+
+    fn varint(&mut self) -> Result<u64> {
+        let mut value = 0u64;
+        for shift in (0..64).step_by(7) {
+            let byte = self.bytes(1)?[0];
+            value |= ((byte & 0x7f) as u64) << shift;
+            if byte & 0x80 == 0 {
+                return Ok(value);
+            }
+        }
+        bail!("Varint too long")
+    }
+
+    /// Split off the next length-prefixed column
+    fn column(&mut self) -> Result<Reader<'a>> {
+        let len = self.varint()? as usize;
+        Ok(Reader::new(self.bytes(len)?))
+    }
+
+    fn zigzag(&mut self) -> Result<i64> {
+        let raw = self.varint()?;
+        Ok(((raw >> 1) as i64) ^ -((raw & 1) as i64))
+    }
+
+    fn f64(&mut self) -> Result<f64> {
+        let bytes: [u8; 8] = self.bytes(8)?.try_into().expect("8-byte slice");
+        Ok(f64::from_le_bytes(bytes))
+    }
+}
+
+/// Check whether `bytes` starts with the columnar magic (as opposed to a
+/// msgpack keylog, which starts with an array marker).
+pub fn is_columnar(bytes: &[u8]) -> bool {
+    bytes.starts_with(COLUMNAR_MAGIC)
+}
+
+/// Decode a columnar keylog produced by [`encode_columnar`].
+pub fn decode_columnar(bytes: &[u8]) -> Result<Vec<InputEvent>> {
+    let mut events = Vec::new();
+    visit_columnar(bytes, |event| {
+        events.push(event);
+        Ok(())
+    })?;
+    Ok(events)
+}
+
+/// Decode a columnar keylog one event at a time, handing each to `visit` in
+/// file order instead of collecting them. Only the decompressed columns are
+/// held. Returns the number of events.
+pub fn visit_columnar(
+    bytes: &[u8],
+    mut visit: impl FnMut(InputEvent) -> Result<()>,
+) -> Result<usize> {
+    if !is_columnar(bytes) {
+        bail!("Not a columnar keylog (bad magic)");
+    }
+    let version = *bytes.get(4).context("Truncated columnar keylog header")?;
+    if version != COLUMNAR_VERSION {
+        bail!("Unsupported columnar keylog version {}", version);
+    }
+    let body = zstd::stream::decode_all(&bytes[5..]).context("Failed to decompress keylog")?;
+
+    let mut header = Reader::new(&body);
+    let count = header.varint()? as usize;
+    let name_count = header.varint()? as usize;
+    // Same order as `Columns::in_order`
+    let mut tags = header.column()?;
+    let mut timestamps = header.column()?;
+    let mut key_names = header.column()?;
+    let mut key_codes = header.column()?;
+    let mut key_name_idx = header.column()?;
+    let mut button_ids = header.column()?;
+    let mut button_x = header.column()?;
+    let mut button_y = header.column()?;
+    let mut move_dx = header.column()?;
+    let mut move_dy = header.column()?;
+    let mut scroll_dx = header.column()?;
+    let mut scroll_dy = header.column()?;
+    let mut scroll_x = header.column()?;
+    let mut scroll_y = header.column()?;
+    let mut other = header.column()?;
+
+    let mut names = Vec::with_capacity(name_count);
+    for _ in 0..name_count {
+        let len = key_names.varint()? as usize;
+        let name = std::str::from_utf8(key_names.bytes(len)?).context("Key name not UTF-8")?;
+        names.push(name.to_string());
+    }
+
+    let mut ts = 0u64;
+    for _ in 0..count {
+        ts = ts.wrapping_add(timestamps.zigzag()? as u64);
+        let event = match tags.bytes(1)?[0] {
+            tag @ (TAG_KEY_PRESS | TAG_KEY_RELEASE) => {
+                let code = u32::try_from(key_codes.varint()?).context("Key code out of range")?;
+                let name = names
+                    .get(key_name_idx.varint()? as usize)
+                    .context("Key name index out of range")?
+                    .clone();
+                let key = KeyEvent { code, name };
+                if tag == TAG_KEY_PRESS {
+                    EventType::KeyPress(key)
+                } else {
+                    EventType::KeyRelease(key)
+                }
+            }
+            tag @ (TAG_MOUSE_PRESS | TAG_MOUSE_RELEASE) => {
+                let btn = MouseButtonEvent {
+                    button: button_from_id(button_ids.varint()?)?,
+                    x: button_x.f64()?,
+                    y: button_y.f64()?,
+                };
+                if tag == TAG_MOUSE_PRESS {
+                    EventType::MousePress(btn)
+                } else {
+                    EventType::MouseRelease(btn)
+                }
+            }
+            TAG_MOUSE_MOVE => EventType::MouseMove(MouseMoveEvent {
+                delta_x: move_dx.f64()?,
+                delta_y: move_dy.f64()?,
+            }),
+            TAG_MOUSE_SCROLL => EventType::MouseScroll(MouseScrollEvent {
+                delta_x: scroll_dx.zigzag()?,
+                delta_y: scroll_dy.zigzag()?,
+                x: scroll_x.f64()?,
+                y: scroll_y.f64()?,
+            }),
+            TAG_CONTEXT_CHANGED | TAG_METADATA | TAG_REDACTED => {
+                let len = other.varint()? as usize;
+                rmp_serde::from_slice(other.bytes(len)?).context("Failed to decode event")?
+            }
+            tag => bail!("Unknown event tag {}", tag),
+        };
+        visit(InputEvent {
+            timestamp_us: ts,
+            event,
+        })?;
+    }
+
+    Ok(count)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::data::{ContextEvent, KeylogFormat, RedactedEvent};
+
+    fn sample_events() -> Vec<InputEvent> {
+        let mut events = vec![InputEvent {
+            timestamp_us: 10,
+            event: EventType::ContextChanged(ContextEvent {
+                app_id: "com.example.editor".to_string(),
+            }),
+        }];
+        for i in 0..2000u64 {
+            events.push(InputEvent {
+                timestamp_us: 1_000 + i * 1_000,
+                event: EventType::MouseMove(MouseMoveEvent {
+                    delta_x: (i % 7) as f64 - 3.0,
+                    delta_y: 1.5,
+                }),
+            });
+        }
+        events.push(InputEvent {
+            timestamp_us: 2_500_000,
+            event: EventType::KeyPress(KeyEvent {
+                code: 30,
+                name: "KeyA".to_string(),
+            }),
+        });
+        // Out-of-order timestamp round-trips via the zigzag delta
+        events.push(InputEvent {
+            timestamp_us: 2_400_000,
+            event: EventType::KeyRelease(KeyEvent {
+                code: 30,
+                name: "KeyA".to_string(),
+            }),
+        });
+        events.push(InputEvent {
+            timestamp_us: 2_600_000,
+            event: EventType::MousePress(MouseButtonEvent {
+                button: MouseButton::Other(4),
+                x: 12.5,
+                y: -3.0,
+            }),
+        });
+        events.push(InputEvent {
+            timestamp_us: 2_700_000,
+            event: EventType::MouseScroll(MouseScrollEvent {
+                delta_x: 0,
+                delta_y: -120,
+                x: 400.0,
+                y: 300.0,
+            }),
+        });
+        events.push(InputEvent {
+            timestamp_us: 2_800_000,
+            event: EventType::Redacted(RedactedEvent {
+                reason: "secure_input".to_string(),
+            }),
+        });
+        events
+    }
+
+    #[test]
+    fn columnar_roundtrip_matches_msgpack() {
+        let events = sample_events();
+        let encoded = encode_columnar(&events).unwrap();
+        assert!(is_columnar(&encoded));
+        let decoded = decode_columnar(&encoded).unwrap();
+
+        // Compare through the msgpack encoding, which covers every field
+        assert_eq!(
+            rmp_serde::to_vec(&decoded).unwrap(),
+            rmp_serde::to_vec(&events).unwrap()
+        );
+    }
+
+    #[test]
+    fn columnar_smaller_than_msgpack_for_mouse_streams() {
+        let events = sample_events();
+        let columnar = encode_columnar(&events).unwrap();
+        let msgpack = rmp_serde::to_vec(&events).unwrap();
+        assert!(
+            columnar.len() * 5 < msgpack.len(),
+            "columnar {} vs msgpack {}",
+            columnar.len(),
+            msgpack.len()
+        );
+    }
+
+    #[test]
+    fn rejects_msgpack_input() {
+        let msgpack = rmp_serde::to_vec(&sample_events()).unwrap();
+        assert!(!is_columnar(&msgpack));
+        assert!(decode_columnar(&msgpack).is_err());
+    }
+
+    #[test]
+    fn persisted_keylog_format_roundtrips_by_extension() {
+        let events = sample_events();
+        for format in [KeylogFormat::Msgpack, KeylogFormat::Columnar] {
+            let path = std::path::PathBuf::from(format!("input_x.{}", format.extension()));
+            assert_eq!(KeylogFormat::from_path(&path), Some(format));
+            let decoded = format.decode(&format.encode(&events).unwrap()).unwrap();
+            assert_eq!(
+                rmp_serde::to_vec(&decoded).unwrap(),
+                rmp_serde::to_vec(&events).unwrap()
+            );
+        }
+        assert_eq!(
+            KeylogFormat::from_path(std::path::Path::new("input_x.journal")),
+            None
+        );
+    }
+
+    #[test]
+    fn streamed_keylog_matches_decoded() {
+        let events = sample_events();
+        for format in [KeylogFormat::Msgpack, KeylogFormat::Columnar] {
+            let encoded = format.encode(&events).unwrap();
+            let mut streamed = Vec::new();
+            let count = format
+                .for_each_event(encoded.as_slice(), |event| {
+                    streamed.push(event);
+                    Ok(())
+                })
+                .unwrap();
+            assert_eq!(count, events.len());
+            assert_eq!(
+                rmp_serde::to_vec(&streamed).unwrap(),
+                rmp_serde::to_vec(&events).unwrap()
+            );
+        }
+    }
+}
@@ -211,6 +211,14 @@ pub struct MetadataEvent {
     /// NOTE: positional index 13 in the msgpack wire format — must stay after `platform`.
     #[serde(default)]
     pub capture_mode: String,
+
+    /// Target video bitrate (Kbps) from this point on. Set when adaptive bitrate is on,
+    /// where a fresh metadata event marks every bitrate change; 0 under constant-quality
+    /// encoding and for recordings made before this field existed.
+    ///
+    /// NOTE: positional index 14 in the msgpack wire format — must stay after `capture_mode`.
+    #[serde(default)]
+    pub video_bitrate_kbps: u32,
 }
 
 /// Marker emitted when secure-input gating begins withholding key events.
@@ -612,6 +620,7 @@ mod tests {
                 displays: vec![dell.clone(), builtin],
                 platform: "macos".to_string(),
                 capture_mode: "single_active_app".to_string(),
+                video_bitrate_kbps: 6000,
             }),
         };
         let bytes = rmp_serde::to_vec(&event).unwrap();
@@ -624,13 +633,15 @@ mod tests {
                 assert_eq!(m.displays[1].px_width, 2940);
                 assert_eq!(m.platform, "macos");
                 assert_eq!(m.capture_mode, "single_active_app");
+                assert_eq!(m.video_bitrate_kbps, 6000);
             }
             other => panic!("unexpected event after roundtrip: {:?}", other),
         }
     }
 
-    /// Keylogs are msgpack POSITIONAL arrays (no field names), so `platform` and
-    /// `capture_mode` are defined by their trailing indices: 12 and 13. This test
+    /// Keylogs are msgpack POSITIONAL arrays (no field names), so `platform`,
+    /// `capture_mode` and `video_bitrate_kbps` are defined by their trailing
+    /// indices: 12, 13 and 14. This test
     /// pins that wire contract and the backward-compat decode of old (12-element)
     /// metadata arrays.
     #[test]
@@ -650,6 +661,7 @@ mod tests {
             displays: Vec::new(),
             platform: "linux".to_string(),
             capture_mode: "display".to_string(),
+            video_bitrate_kbps: 1000,
         };
 
         // Typed roundtrip: the new fields survive encode/decode.
@@ -658,8 +670,8 @@ mod tests {
         assert_eq!(decoded.platform, "linux");
         assert_eq!(decoded.capture_mode, "display");
 
-        // Positional contract: decode the same bytes as a bare 14-tuple and assert
-        // platform sits at index 12 and capture_mode at index 13.
+        // Positional contract: decode the same bytes as a bare 15-tuple and assert
+        // platform sits at index 12, capture_mode at 13 and video_bitrate_kbps at 14.
         type MetadataTuple = (
             u32,
             u32,
@@ -675,6 +687,7 @@ mod tests {
             Vec<MonitorInfo>,
             String,
             String,
+            u32,
         );
         let tuple: MetadataTuple = rmp_serde::from_slice(&bytes).unwrap();
         assert_eq!(tuple.12, "linux", "platform must be positional index 12");
@@ -682,6 +695,10 @@ mod tests {
             tuple.13, "display",
             "capture_mode must be positional index 13"
         );
+        assert_eq!(
+            tuple.14, 1000,
+            "video_bitrate_kbps must be positional index 14"
+        );
 
         // Backward compat: a pre-fix 12-element array (no platform/capture_mode)
         // still decodes, with both new fields defaulting to "".
@@ -704,6 +721,7 @@ mod tests {
         assert_eq!(old.display_width, 1920);
         assert_eq!(old.platform, "");
         assert_eq!(old.capture_mode, "");
+        assert_eq!(old.video_bitrate_kbps, 0);
     }
 }
 
@@ -1,7 +1,8 @@
 //! Data format and serialization utilities
 
-use anyhow::Result;
+use anyhow::{bail, Context, Result};
 use serde::{Deserialize, Serialize};
+use std::io::Read;
 
 use super::InputEvent;
 
@@ -91,6 +92,118 @@ impl InputChunk {
     }
 }
 
+/// On-the-wire format of uploaded keylogs
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum KeylogFormat {
+    /// `rmp_serde` array of [`InputEvent`]s (`.msgpack`)
+    #[default]
+    Msgpack,
+    /// Versioned columnar, zstd-compressed format (`.cckl`), see `columnar.rs`
+    Columnar,
+}
+
+impl KeylogFormat {
+    /// File extension for the uploaded object
+    pub fn extension(self) -> &'static str {
+        match self {
+            Self::Msgpack => "msgpack",
+            Self::Columnar => "cckl",
+        }
+    }
+
+    /// Content type sent when the presign response doesn't specify one
+    pub fn content_type(self) -> &'static str {
+        match self {
+            Self::Msgpack => "application/msgpack",
+            Self::Columnar => "application/octet-stream",
+        }
+    }
+
+    /// Format of a persisted keylog, from its file extension
+    pub fn from_path(path: &std::path::Path) -> Option<Self> {
+        match path.extension()?.to_str()? {
+            "msgpack" => Some(Self::Msgpack),
+            "cckl" => Some(Self::Columnar),
+            _ => None,
+        }
+    }
+
+    /// Serialize `events` in this format
+    pub fn encode(self, events: &[InputEvent]) -> Result<Vec<u8>> {
+        match self {
+            Self::Msgpack => Ok(rmp_serde::to_vec(events)?),
+            Self::Columnar => super::encode_columnar(events),
+        }
+    }
+
+    /// Deserialize events previously written by [`Self::encode`]
+    pub fn decode(self, bytes: &[u8]) -> Result<Vec<InputEvent>> {
+        match self {
+            Self::Msgpack => Ok(rmp_serde::from_slice(bytes)?),
+            Self::Columnar => super::decode_columnar(bytes),
+        }
+    }
+
+    /// Stream the events of a keylog read from `reader` to `visit`, in file
+    /// order, without collecting them: msgpack is decoded one event at a time,
+    /// and a columnar keylog holds only its decompressed columns. Returns the
+    /// number of events.
+    pub fn for_each_event(
+        self,
+        reader: impl Read,
+        mut visit: impl FnMut(InputEvent) -> Result<()>,
+    ) -> Result<usize> {
+        match self {
+            Self::Msgpack => {
+                let mut reader = std::io::BufReader::new(reader);
+                let count = read_msgpack_array_len(&mut reader)?;
+                let mut de = rmp_serde::Deserializer::new(reader);
+                for _ in 0..count {
+                    let event =
+                        InputEvent::deserialize(&mut de).context("Failed to decode event")?;
+                    visit(event)?;
+                }
+                Ok(count)
+            }
+            Self::Columnar => {
+                let mut bytes = Vec::new();
+                let mut reader = reader;
+                reader
+                    .read_to_end(&mut bytes)
+                    .context("Failed to read keylog")?;
+                super::visit_columnar(&bytes, visit)
+            }
+        }
+    }
+}
+
+/// Length of the top-level msgpack array a msgpack keylog consists of
+fn read_msgpack_array_len(reader: &mut impl Read) -> Result<usize> {
+    let mut marker = [0u8; 1];
+    reader
+        .read_exact(&mut marker)
+        .context("Truncated msgpack keylog")?;
+    Ok(match marker[0] {
+        m @ 0x90..=0x9f => (m & 0x0f) as usize,
+        0xdc => {
+            let mut len = [0u8; 2];
+            reader
+                .read_exact(&mut len)
+                .context("Truncated msgpack keylog")?;
+            u16::from_be_bytes(len) as usize
+        }
+        0xdd => {
+            let mut len = [0u8; 4];
+            reader
+                .read_exact(&mut len)
+                .context("Truncated msgpack keylog")?;
+            u32::from_be_bytes(len) as usize
+        }
+        m => bail!("Not a msgpack keylog (marker {:#04x})", m),
+    })
+}
+
 /// Information about a completed recording chunk ready for upload
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CompletedChunk {
@@ -104,8 +217,16 @@ pub struct CompletedChunk {
     #[serde(skip_serializing_if = "Option::is_none")]
     pub video_path: Option<std::path::PathBuf>,
 
-    /// Input events in this chunk
-    pub events: Vec<InputEvent>,
+    /// Persisted keylog for this chunk, already encoded in `keylog_format`.
+    /// Uploads stream it from disk, so a chunk waiting out its upload hold
+    /// and retries doesn't keep its events in memory.
+    pub keylog_path: std::path::PathBuf,
+
+    /// Encoding of the file at `keylog_path`
+    pub keylog_format: KeylogFormat,
+
+    /// Number of input events in the keylog
+    pub event_count: usize,
 
     /// Start timestamp (microseconds)
     pub start_time_us: u64,
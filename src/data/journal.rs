@@ -0,0 +1,172 @@
+//! Append-only per-segment input event journal
+//!
+//! Events drained from the in-memory buffer during a segment are appended to
+//! `input_<segment>.journal` as length-prefixed records (`u32` little-endian
+//! byte length, then a msgpack `Vec<InputEvent>` batch). At rotation the file
+//! is read back front to back in one pass — records are already in append
+//! order. A crash can at worst leave a torn final record, which the reader
+//! drops: everything before the last sync is recoverable.
+
+use anyhow::{Context, Result};
+use std::path::{Path, PathBuf};
+use tokio::io::AsyncWriteExt;
+use tracing::warn;
+
+use super::InputEvent;
+
+/// Writer for one segment's journal
+pub struct EventJournal {
+    path: PathBuf,
+    file: tokio::fs::File,
+    /// Whether records were appended since the last `sync`
+    dirty: bool,
+}
+
+impl EventJournal {
+    /// Create (or truncate) the journal at `path`
+    pub async fn create(path: PathBuf) -> Result<Self> {
+        let file = tokio::fs::File::create(&path)
+            .await
+            .with_context(|| format!("Failed to create event journal {:?}", path))?;
+        Ok(Self {
+            path,
+            file,
+            dirty: false,
+        })
+    }
+
+    /// Path of the journal file
+    pub fn path(&self) -> &Path {
+        &self.path
+    }
+
+    /// Append a batch of events as one record. Not durable until [`Self::sync`].
+    pub async fn append(&mut self, events: &[InputEvent]) -> Result<()> {
+        if events.is_empty() {
+            return Ok(());
+        }
+        let payload = rmp_serde::to_vec(events).context("Failed to serialize journal record")?;
+        let len = u32::try_from(payload.len()).context("Journal record too large")?;
+        let mut record = Vec::with_capacity(4 + payload.len());
+        record.extend_from_slice(&len.to_le_bytes());
+        record.extend_from_slice(&payload);
+        self.file
+            .write_all(&record)
+            .await
+            .with_context(|| format!("Failed to append to event journal {:?}", self.path))?;
+        self.dirty = true;
+        Ok(())
+    }
+
+    /// fsync appended records to disk (no-op if nothing changed)
+    pub async fn sync(&mut self) -> Result<()> {
+        if !self.dirty {
+            return Ok(());
+        }
+        self.file
+            .flush()
+            .await
+            .with_context(|| format!("Failed to flush event journal {:?}", self.path))?;
+        self.file
+            .sync_data()
+            .await
+            .with_context(|| format!("Failed to sync event journal {:?}", self.path))?;
+        self.dirty = false;
+        Ok(())
+    }
+
+    /// Flush and fsync the journal, then close it. `tokio::fs::File` writes
+    /// in the background, so dropping it without this can lose the final
+    /// batches.
+    pub async fn close(mut self) -> Result<PathBuf> {
+        self.file
+            .flush()
+            .await
+            .with_context(|| format!("Failed to flush event journal {:?}", self.path))?;
+        self.file
+            .sync_data()
+            .await
+            .with_context(|| format!("Failed to sync event journal {:?}", self.path))?;
+        Ok(self.path)
+    }
+
+    /// Read every complete record of the journal at `path`, in append order.
+    /// A torn or corrupt trailing record (crash mid-append) is dropped with a
+    /// warning.
+    pub async fn read_all(path: &Path) -> Result<Vec<InputEvent>> {
+        let bytes = tokio::fs::read(path)
+            .await
+            .with_context(|| format!("Failed to read event journal {:?}", path))?;
+        Ok(decode_records(&bytes, path))
+    }
+}
+
+fn decode_records(bytes: &[u8], path: &Path) -> Vec<InputEvent> {
+    let mut events = Vec::new();
+    let mut pos = 0usize;
+    while pos < bytes.len() {
+        let Some(header) = bytes.get(pos..pos + 4) else {
+            warn!("Dropping torn record header at end of journal {:?}", path);
+            break;
+        };
+        let len = u32::from_le_bytes(header.try_into().expect("4-byte slice")) as usize;
+        let Some(payload) = bytes.get(pos + 4..pos + 4 + len) else {
+            warn!("Dropping torn record at end of journal {:?}", path);
+            break;
+        };
+        match rmp_serde::from_slice::<Vec<InputEvent>>(payload) {
+            Ok(batch) => events.extend(batch),
+            Err(e) => {
+                warn!("Dropping corrupt record in journal {:?}: {}", path, e);
+                break;
+            }
+        }
+        pos += 4 + len;
+    }
+    events
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::data::{EventType, MouseMoveEvent};
+
+    fn moves(range: std::ops::Range<u64>) -> Vec<InputEvent> {
+        range
+            .map(|ts| InputEvent {
+                timestamp_us: ts,
+                event: EventType::MouseMove(MouseMoveEvent {
+                    delta_x: 1.0,
+                    delta_y: -1.0,
+                }),
+            })
+            .collect()
+    }
+
+    #[tokio::test]
+    async fn journal_roundtrip_drops_torn_tail() {
+        let dir = std::env::temp_dir().join(format!("cc-journal-{}", uuid::Uuid::new_v4()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let path = dir.join("input_test.journal");
+
+        let mut journal = EventJournal::create(path.clone()).await.unwrap();
+        journal.append(&moves(0..100)).await.unwrap();
+        journal.append(&moves(100..150)).await.unwrap();
+        journal.sync().await.unwrap();
+        journal.append(&moves(150..160)).await.unwrap();
+        journal.close().await.unwrap();
+
+        let events = EventJournal::read_all(&path).await.unwrap();
+        let timestamps: Vec<u64> = events.iter().map(|e| e.timestamp_us).collect();
+        assert_eq!(timestamps, (0..160).collect::<Vec<_>>());
+
+        // Simulate a crash mid-append: a header promising more bytes than written
+        let mut bytes = std::fs::read(&path).unwrap();
+        bytes.extend_from_slice(&1000u32.to_le_bytes());
+        bytes.extend_from_slice(&[0x90, 0x00]);
+        std::fs::write(&path, bytes).unwrap();
+        assert_eq!(EventJournal::read_all(&path).await.unwrap().len(), 160);
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -1,7 +1,11 @@
 //! Data structures and serialization for input logs
 
+mod columnar;
 mod events;
 mod format;
+mod journal;
 
+pub use columnar::*;
 pub use events::*;
 pub use format::*;
+pub use journal::*;
@@ -1,16 +1,17 @@
 //! Input capture backend trait
 
-use crate::data::InputEvent;
+use crate::input::policy::CapturePolicy;
 use crate::input::secure::SecureInputState;
+use crate::input::InputSink;
 use anyhow::{Context, Result};
 use std::sync::Arc;
-use tokio::sync::mpsc;
+use std::time::Duration;
 
 /// Trait for input capture backends
 pub trait InputBackend: Send + Sync {
     /// Start capturing input events
-    /// Events are sent to the provided channel
-    fn start(&mut self, tx: mpsc::UnboundedSender<InputEvent>) -> Result<()>;
+    /// Each capture thread registers its own ring with the provided sink
+    fn start(&mut self, sink: InputSink) -> Result<()>;
 
     /// Stop capturing input events.
     /// Should be called before process exit to allow the event tap to drain cleanly.
@@ -26,8 +27,14 @@ pub trait InputBackend: Send + Sync {
 ///
 /// Linux uses evdev for both X11 and Wayland: raw pre-acceleration deltas, reaches the
 /// same input layer raw-input consumers read, and works regardless of display server.
-/// rdev is not linked on Linux (see Cargo.toml). macOS/Windows use rdev.
-pub fn create_input_backend(secure: Arc<SecureInputState>) -> Result<Box<dyn InputBackend>> {
+/// rdev is not linked on Linux (see Cargo.toml). macOS/Windows use rdev. Both apply `policy`
+/// at the source, before an event is built. `motion_window` only applies to rdev: evdev
+/// merges motion per device report.
+pub fn create_input_backend(
+    policy: Arc<CapturePolicy>,
+    secure: Arc<SecureInputState>,
+    motion_window: Duration,
+) -> Result<Box<dyn InputBackend>> {
     #[cfg(target_os = "linux")]
     {
         // No fallback by design: crowd-cast exists to record input, so a backend that can't
@@ -35,9 +42,10 @@ pub fn create_input_backend(secure: Arc<SecureInputState>) -> Result<Box<dyn Inp
         // silently dropping every keystroke. Startup gates on 'input' group membership (see
         // installer::requirements), so evdev should succeed by the time we get here; if it
         // still fails, fail closed and loud rather than degrade to recording no input.
-        let backend = super::evdev_backend::EvdevBackend::new(secure).context(
+        let backend = super::evdev_backend::EvdevBackend::new(policy, secure).context(
             "evdev input backend init failed -- ensure the user is in the 'input' group",
         )?;
+        let _ = motion_window;
         tracing::info!("Using evdev backend for input capture");
         Ok(Box::new(backend))
     }
@@ -48,6 +56,9 @@ pub fn create_input_backend(secure: Arc<SecureInputState>) -> Result<Box<dyn Inp
         // (e.g. macOS Secure Event Input), so the shared gate is inert here.
         let _ = secure;
         tracing::info!("Using rdev backend for input capture");
-        Ok(Box::new(super::rdev_backend::RdevBackend::new()))
+        Ok(Box::new(super::rdev_backend::RdevBackend::new(
+            policy,
+            motion_window,
+        )))
     }
 }
@@ -0,0 +1,104 @@
+//! evdev → unified event-schema translation (Linux)
+//!
+//! Kept apart from the capture loop in `evdev_reactor` so the per-event
+//! translation can be exercised (and benchmarked, see `benches/`) without
+//! opening devices.
+#![cfg(target_os = "linux")]
+
+use super::policy::PolicySnapshot;
+use crate::data::{
+    EventType, KeyEvent, MouseButton, MouseButtonEvent, MouseMoveEvent, MouseScrollEvent,
+};
+use evdev::InputEventKind;
+
+/// Translates a stream of evdev events into the unified `EventType` schema shared with the
+/// macOS backend. Relative motion/scroll are accumulated and flushed as a single combined
+/// event per `SYN_REPORT` (matching macOS' one-MouseMove-per-motion); keys and pointer
+/// buttons are emitted immediately. Event classes `policy` disables are dropped here, before
+/// anything is built; secure-input gating arrives as a cleared keyboard bit, which withholds
+/// keystrokes but never pointer buttons.
+#[derive(Default)]
+pub struct EventCoalescer {
+    dx: f64,
+    dy: f64,
+    scroll_x: i64,
+    scroll_y: i64,
+}
+
+impl EventCoalescer {
+    pub fn feed(
+        &mut self,
+        kind: InputEventKind,
+        value: i32,
+        policy: PolicySnapshot,
+        out: &mut Vec<EventType>,
+    ) {
+        use evdev::RelativeAxisType;
+        match kind {
+            InputEventKind::Key(key) => {
+                // Pointer buttons (BTN_*) arrive as Key events; route them to mouse events.
+                // Buttons are never gated by secure-input (matches macOS, where clicks aren't
+                // withheld for a focused password field).
+                if let Some(button) = MouseButton::from_evdev_key(key) {
+                    if !policy.mouse_click() {
+                        return;
+                    }
+                    let be = MouseButtonEvent {
+                        button,
+                        x: 0.0,
+                        y: 0.0,
+                    };
+                    match value {
+                        1 => out.push(EventType::MousePress(be)),
+                        0 => out.push(EventType::MouseRelease(be)),
+                        _ => {}
+                    }
+                } else if !policy.keyboard() {
+                    // Keyboard capture is off, or a secure context is active.
+                } else {
+                    let ke = KeyEvent::from(key);
+                    match value {
+                        1 => out.push(EventType::KeyPress(ke)),
+                        0 => out.push(EventType::KeyRelease(ke)),
+                        _ => {} // key repeat (value == 2)
+                    }
+                }
+            }
+            // Disabled axes are never accumulated, so their SYN_REPORT flushes nothing.
+            InputEventKind::RelAxis(axis) => match axis {
+                RelativeAxisType::REL_X if policy.mouse_move() => self.dx += value as f64,
+                RelativeAxisType::REL_Y if policy.mouse_move() => self.dy += value as f64,
+                RelativeAxisType::REL_WHEEL if policy.mouse_scroll() => {
+                    self.scroll_y += value as i64
+                }
+                RelativeAxisType::REL_HWHEEL if policy.mouse_scroll() => {
+                    self.scroll_x += value as i64
+                }
+                _ => {}
+            },
+            // SYN_REPORT delimits one device packet: flush accumulated motion/scroll as
+            // single combined events, then reset.
+            InputEventKind::Synchronization(_) => {
+                if self.dx != 0.0 || self.dy != 0.0 {
+                    out.push(EventType::MouseMove(MouseMoveEvent {
+                        delta_x: self.dx,
+                        delta_y: self.dy,
+                    }));
+                    self.dx = 0.0;
+                    self.dy = 0.0;
+                }
+                if self.scroll_x != 0 || self.scroll_y != 0 {
+                    out.push(EventType::MouseScroll(MouseScrollEvent {
+                        delta_x: self.scroll_x,
+                        delta_y: self.scroll_y,
+                        x: 0.0,
+                        y: 0.0,
+                    }));
+                    self.scroll_x = 0;
+                    self.scroll_y = 0;
+                }
+            }
+            _ => {}
+        }
+    }
+}
@@ -0,0 +1,561 @@
+//! Single-thread epoll reactor for the evdev backend (Linux)
+//!
+//! Every adopted device fd shares one epoll set with an inotify watch on
+//! `/dev/input`, serviced by one thread that only wakes when a device has data
+//! or a node appears or disappears. Device fds are non-blocking and drained
+//! until `EAGAIN` on each wakeup; all devices push into one ring.
+//!
+//! udev creates a node before it fixes the node's permissions, so an open
+//! that fails on `IN_CREATE` is retried on the `IN_ATTRIB` that follows. If
+//! inotify is unavailable (or its queue overflows) the reactor falls back to
+//! rescanning the directory.
+#![cfg(target_os = "linux")]
+
+use crate::data::{EventType, InputEvent};
+use crate::input::coalescer::EventCoalescer;
+use crate::input::policy::CapturePolicy;
+use crate::input::secure::SecureInputState;
+use crate::input::{InputSink, RingProducer};
+use evdev::Device;
+use std::collections::HashMap;
+use std::ffi::{CString, OsString};
+use std::io;
+use std::os::fd::{AsRawFd, FromRawFd, OwnedFd, RawFd};
+use std::os::unix::ffi::{OsStrExt, OsStringExt};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
+use std::thread;
+use std::time::{Duration, Instant};
+use tracing::{debug, info, warn};
+
+use super::evdev_backend::{is_device_disconnected, is_event_node, open_input_device};
+
+/// Upper bound on a single `epoll_wait`, so a cleared `capturing` flag is
+/// noticed while no device is producing input
+const STOP_CHECK_INTERVAL: Duration = Duration::from_millis(250);
+
+/// How long a device that returned a non-fatal read error sits out of the epoll
+/// set before it is read again. Level-triggered epoll would otherwise spin on it.
+const READ_ERROR_BACKOFF: Duration = Duration::from_millis(100);
+
+/// Directory rescans when inotify can't be used; see `HOTPLUG_POLL_INTERVAL`
+const RESCAN_INTERVAL: Duration = super::evdev_backend::HOTPLUG_POLL_INTERVAL;
+
+const DEVICE_EVENTS: u32 = (libc::EPOLLIN | libc::EPOLLERR | libc::EPOLLHUP) as u32;
+
+/// Owned epoll instance
+struct Epoll(OwnedFd);
+
+impl Epoll {
+    fn new() -> io::Result<Self> {
+        // SAFETY: plain syscall; a non-negative return is a fresh fd we own
+        let fd = unsafe { libc::epoll_create1(libc::EPOLL_CLOEXEC) };
+        if fd < 0 {
+            return Err(io::Error::last_os_error());
+        }
+        Ok(Self(unsafe { OwnedFd::from_raw_fd(fd) }))
+    }
+
+    fn ctl(&self, op: libc::c_int, fd: RawFd, events: u32) -> io::Result<()> {
+        let mut event = libc::epoll_event {
+            events,
+            u64: fd as u64,
+        };
+        // SAFETY: `event` outlives the call; the kernel copies it
+        if unsafe { libc::epoll_ctl(self.0.as_raw_fd(), op, fd, &mut event) } < 0 {
+            return Err(io::Error::last_os_error());
+        }
+        Ok(())
+    }
+
+    fn add(&self, fd: RawFd, events: u32) -> io::Result<()> {
+        self.ctl(libc::EPOLL_CTL_ADD, fd, events)
+    }
+
+    fn modify(&self, fd: RawFd, events: u32) -> io::Result<()> {
+        self.ctl(libc::EPOLL_CTL_MOD, fd, events)
+    }
+
+    fn delete(&self, fd: RawFd) -> io::Result<()> {
+        self.ctl(libc::EPOLL_CTL_DEL, fd, 0)
+    }
+
+    /// Wait for readiness, returning the fds that are ready. An interrupted wait
+    /// returns nothing rather than an error.
+    fn wait(&self, ready: &mut Vec<libc::epoll_event>, timeout: Duration) -> io::Result<()> {
+        ready.clear();
+        // Round up so a sub-millisecond deadline doesn't become a busy poll
+        let timeout_ms = timeout.as_micros().div_ceil(1000).min(i32::MAX as u128) as i32;
+        // SAFETY: the kernel writes at most `capacity` entries into the buffer
+        let n = unsafe {
+            libc::epoll_wait(
+                self.0.as_raw_fd(),
+                ready.as_mut_ptr(),
+                ready.capacity() as libc::c_int,
+                timeout_ms,
+            )
+        };
+        if n < 0 {
+            let err = io::Error::last_os_error();
+            if err.raw_os_error() == Some(libc::EINTR) {
+                return Ok(());
+            }
+            return Err(err);
+        }
+        // SAFETY: the first `n` entries were initialized by epoll_wait
+        unsafe { ready.set_len(n as usize) };
+        Ok(())
+    }
+}
+
+/// A change to the device directory reported by inotify
+#[derive(Debug, PartialEq)]
+enum DirChange {
+    /// A node was created, renamed in, or had its attributes (permissions) changed
+    Appeared(OsString),
+    /// A node was deleted or renamed away
+    Removed(OsString),
+    /// Events were lost; the directory has to be rescanned
+    Overflow,
+}
+
+/// Non-blocking inotify watch on one directory
+struct DirWatch(OwnedFd);
+
+impl DirWatch {
+    fn new(dir: &Path) -> io::Result<Self> {
+        // SAFETY: plain syscall; a non-negative return is a fresh fd we own
+        let fd = unsafe { libc::inotify_init1(libc::IN_NONBLOCK | libc::IN_CLOEXEC) };
+        if fd < 0 {
+            return Err(io::Error::last_os_error());
+        }
+        let fd = unsafe { OwnedFd::from_raw_fd(fd) };
+        let dir = CString::new(dir.as_os_str().as_bytes())
+            .map_err(|e| io::Error::new(io::ErrorKind::InvalidInput, e))?;
+        let mask = libc::IN_CREATE
+            | libc::IN_ATTRIB
+            | libc::IN_DELETE
+            | libc::IN_MOVED_TO
+            | libc::IN_MOVED_FROM;
+        // SAFETY: `dir` is NUL-terminated and outlives the call
+        if unsafe { libc::inotify_add_watch(fd.as_raw_fd(), dir.as_ptr(), mask) } < 0 {
+            return Err(io::Error::last_os_error());
+        }
+        Ok(Self(fd))
+    }
+
+    /// Read every queued change into `out`
+    fn read_changes(&self, out: &mut Vec<DirChange>) -> io::Result<()> {
+        let mut buf = [0u8; 4096];
+        loop {
+            // SAFETY: the kernel writes at most `buf.len()` bytes into `buf`
+            let n = unsafe {
+                libc::read(
+                    self.0.as_raw_fd(),
+                    buf.as_mut_ptr() as *mut libc::c_void,
+                    buf.len(),
+                )
+            };
+            if n < 0 {
+                let err = io::Error::last_os_error();
+                return match err.raw_os_error() {
+                    Some(libc::EAGAIN) => Ok(()),
+                    Some(libc::EINTR) => continue,
+                    _ => Err(err),
+                };
+            }
+            if n == 0 {
+                return Ok(());
+            }
+            parse_dir_changes(&buf[..n as usize], out);
+        }
+    }
+}
+
+/// Decode a buffer of `struct inotify_event` records, each followed by its
+/// NUL-padded name
+fn parse_dir_changes(mut buf: &[u8], out: &mut Vec<DirChange>) {
+    let header = std::mem::size_of::<libc::inotify_event>();
+    while buf.len() >= header {
+        // SAFETY: `buf` holds at least a header; read_unaligned has no alignment needs
+        let event = unsafe { std::ptr::read_unaligned(buf.as_ptr() as *const libc::inotify_event) };
+        let end = (header + event.len as usize).min(buf.len());
+        let name = &buf[header..end];
+        let name = &name[..name.iter().position(|&b| b == 0).unwrap_or(name.len())];
+        buf = &buf[end..];
+
+        if event.mask & libc::IN_Q_OVERFLOW != 0 {
+            out.push(DirChange::Overflow);
+        } else if name.is_empty() {
+            continue;
+        } else if event.mask & (libc::IN_DELETE | libc::IN_MOVED_FROM) != 0 {
+            out.push(DirChange::Removed(OsString::from_vec(name.to_vec())));
+        } else if event.mask & (libc::IN_CREATE | libc::IN_ATTRIB | libc::IN_MOVED_TO) != 0 {
+            out.push(DirChange::Appeared(OsString::from_vec(name.to_vec())));
+        }
+    }
+}
+
+/// An adopted device and its translation state
+struct Tracked {
+    path: PathBuf,
+    name: String,
+    device: Device,
+    coalescer: EventCoalescer,
+    /// Set while the device is out of the epoll set after a read error
+    retry_at: Option<Instant>,
+}
+
+struct Reactor {
+    dir: PathBuf,
+    epoll: Epoll,
+    watch: Option<DirWatch>,
+    /// Adopted devices, keyed by their fd (also their epoll token)
+    devices: HashMap<RawFd, Tracked>,
+    producer: RingProducer,
+    policy: Arc<CapturePolicy>,
+    secure: Arc<SecureInputState>,
+    start_time: Instant,
+    out: Vec<EventType>,
+}
+
+impl Reactor {
+    fn is_tracked(&self, path: &Path) -> bool {
+        self.devices.values().any(|d| d.path == path)
+    }
+
+    fn adopt(&mut self, path: PathBuf, name: String, device: Device) {
+        let fd = device.as_raw_fd();
+        if let Err(e) = set_nonblocking(fd).and_then(|()| self.epoll.add(fd, DEVICE_EVENTS)) {
+            warn!("Cannot poll input device {} ({:?}): {}", name, path, e);
+            return;
+        }
+        info!("Started evdev capture for: {} ({:?})", name, path);
+        self.devices.insert(
+            fd,
+            Tracked {
+                path,
+                name,
+                device,
+                coalescer: EventCoalescer::default(),
+                retry_at: None,
+            },
+        );
+    }
+
+    fn release(&mut self, fd: RawFd) {
+        if let Some(tracked) = self.devices.remove(&fd) {
+            // Deregister before the fd is closed (and possibly reused)
+            let _ = self.epoll.delete(fd);
+            info!(
+                "Stopped evdev capture for: {} ({:?})",
+                tracked.name, tracked.path
+            );
+        }
+    }
+
+    /// Adopt `path` if it is an untracked keyboard or mouse node
+    fn try_adopt(&mut self, path: PathBuf) {
+        if !is_event_node(&path) || self.is_tracked(&path) {
+            return;
+        }
+        if let Some((name, device)) = open_input_device(&path) {
+            info!("Hotplugged input device: {} ({:?})", name, path);
+            self.adopt(path, name, device);
+        }
+    }
+
+    /// Adopt any untracked node in the directory
+    fn rescan(&mut self) {
+        let entries = match std::fs::read_dir(&self.dir) {
+            Ok(entries) => entries,
+            Err(e) => {
+                warn!("hotplug: cannot read {:?}: {}", self.dir, e);
+                return;
+            }
+        };
+        for entry in entries.flatten() {
+            self.try_adopt(entry.path());
+        }
+    }
+
+    fn handle_dir_changes(&mut self, changes: &mut Vec<DirChange>) {
+        let Some(watch) = &self.watch else {
+            return;
+        };
+        if let Err(e) = watch.read_changes(changes) {
+            warn!(
+                "hotplug: inotify read failed ({}); falling back to rescans",
+                e
+            );
+            if let Some(watch) = self.watch.take() {
+                let _ = self.epoll.delete(watch.0.as_raw_fd());
+            }
+        }
+        for change in changes.drain(..) {
+            match change {
+                DirChange::Appeared(name) => self.try_adopt(self.dir.join(name)),
+                DirChange::Removed(name) => {
+                    // The fd would report ENODEV on its next read anyway; dropping
+                    // it now frees the path for a node created under the same name
+                    let path = self.dir.join(&name);
+                    let gone: Vec<RawFd> = self
+                        .devices
+                        .iter()
+                        .filter(|(_, d)| d.path == path)
+                        .map(|(&fd, _)| fd)
+                        .collect();
+                    for fd in gone {
+                        info!("Input device removed: {:?}", path);
+                        self.release(fd);
+                    }
+                }
+                DirChange::Overflow => {
+                    debug!("hotplug: inotify queue overflowed; rescanning");
+                    self.rescan();
+                }
+            }
+        }
+    }
+
+    /// Drain a readable device until `EAGAIN`
+    fn read_device(&mut self, fd: RawFd) {
+        let Some(tracked) = self.devices.get_mut(&fd) else {
+            return;
+        };
+        let err = loop {
+            let events = match tracked.device.fetch_events() {
+                Ok(events) => events,
+                Err(e) if e.kind() == io::ErrorKind::Interrupted => continue,
+                Err(e) => break e,
+            };
+            for ev in events {
+                let timestamp_us = self.start_time.elapsed().as_micros() as u64;
+                self.out.clear();
+                let policy = self
+                    .policy
+                    .load()
+                    .suppressing_keys(self.secure.should_suppress_keys());
+                tracked
+                    .coalescer
+                    .feed(ev.kind(), ev.value(), policy, &mut self.out);
+                for event in self.out.drain(..) {
+                    if !self.producer.push(InputEvent {
+                        timestamp_us,
+                        event,
+                    }) {
+                        debug!("Input ring full for {}, dropped event", tracked.name);
+                    }
+                }
+            }
+        };
+        if err.kind() == io::ErrorKind::WouldBlock {
+            return;
+        }
+        // A removed node (unplug, or suspend/resume re-enumeration) is terminal
+        // for this fd; the node is re-adopted if it returns. Other errors are
+        // treated as transient and retried after a backoff.
+        if is_device_disconnected(&err) {
+            info!(
+                "Input device disconnected: {} ({:?})",
+                tracked.name, tracked.path
+            );
+            self.release(fd);
+            return;
+        }
+        warn!("evdev fetch error for {}: {}", tracked.name, err);
+        if self.epoll.modify(fd, 0).is_ok() {
+            tracked.retry_at = Some(Instant::now() + READ_ERROR_BACKOFF);
+        }
+    }
+
+    /// Put devices whose error backoff has elapsed back into the epoll set, and
+    /// return the time until the next one is due
+    fn resume_backed_off(&mut self, now: Instant) -> Option<Duration> {
+        let mut next: Option<Duration> = None;
+        for (&fd, tracked) in &mut self.devices {
+            let Some(retry_at) = tracked.retry_at else {
+                continue;
+            };
+            if retry_at <= now {
+                tracked.retry_at = None;
+                if let Err(e) = self.epoll.modify(fd, DEVICE_EVENTS) {
+                    warn!("Cannot re-poll input device {}: {}", tracked.name, e);
+                }
+            } else {
+                let wait = retry_at - now;
+                next = Some(next.map_or(wait, |n| n.min(wait)));
+            }
+        }
+        next
+    }
+
+    fn run(mut self, capturing: &AtomicBool) {
+        let watch_fd = self.watch.as_ref().map(|w| w.0.as_raw_fd());
+        let mut ready = Vec::with_capacity(32);
+        let mut changes = Vec::new();
+        let mut next_rescan = Instant::now() + RESCAN_INTERVAL;
+
+        while capturing.load(Ordering::SeqCst) {
+            let now = Instant::now();
+            let mut timeout = STOP_CHECK_INTERVAL;
+            if let Some(retry) = self.resume_backed_off(now) {
+                timeout = timeout.min(retry);
+            }
+            if self.watch.is_none() {
+                if now >= next_rescan {
+                    self.rescan();
+                    next_rescan = now + RESCAN_INTERVAL;
+                }
+                timeout = timeout.min(next_rescan.saturating_duration_since(now));
+            }
+
+            if let Err(e) = self.epoll.wait(&mut ready, timeout) {
+                warn!("evdev epoll_wait failed: {}", e);
+                thread::sleep(READ_ERROR_BACKOFF);
+                continue;
+            }
+            if !capturing.load(Ordering::SeqCst) {
+                break;
+            }
+            for event in &ready {
+                let fd = event.u64 as RawFd;
+                if Some(fd) == watch_fd {
+                    self.handle_dir_changes(&mut changes);
+                } else {
+                    // EPOLLHUP/EPOLLERR surface as the read error (ENODEV) here
+                    self.read_device(fd);
+                }
+            }
+        }
+
+        for fd in self.devices.keys().copied().collect::<Vec<_>>() {
+            self.release(fd);
+        }
+        info!("Stopped evdev reactor");
+    }
+}
+
+fn set_nonblocking(fd: RawFd) -> io::Result<()> {
+    // SAFETY: fcntl on an fd we own, with no pointer arguments
+    let flags = unsafe { libc::fcntl(fd, libc::F_GETFL) };
+    if flags < 0 || unsafe { libc::fcntl(fd, libc::F_SETFL, flags | libc::O_NONBLOCK) } < 0 {
+        return Err(io::Error::last_os_error());
+    }
+    Ok(())
+}
+
+/// Start the reactor thread with the devices enumerated at startup. Nodes in
+/// `dir` that appear later, or that weren't passed in (a restart after
+/// `stop()`), are adopted by the reactor itself. Runs until `capturing` clears.
+pub(super) fn spawn(
+    dir: &Path,
+    devices: Vec<(PathBuf, Device)>,
+    sink: InputSink,
+    capturing: Arc<AtomicBool>,
+    policy: Arc<CapturePolicy>,
+    secure: Arc<SecureInputState>,
+    start_time: Instant,
+) -> io::Result<()> {
+    let epoll = Epoll::new()?;
+    let watch = match DirWatch::new(dir) {
+        Ok(watch) => match epoll.add(watch.0.as_raw_fd(), libc::EPOLLIN as u32) {
+            Ok(()) => Some(watch),
+            Err(e) => {
+                warn!("hotplug: cannot poll inotify ({}); rescanning {:?}", e, dir);
+                None
+            }
+        },
+        Err(e) => {
+            warn!("hotplug: inotify unavailable ({}); rescanning {:?}", e, dir);
+            None
+        }
+    };
+    let dir = dir.to_path_buf();
+
+    thread::Builder::new()
+        .name("evdev-reactor".into())
+        .spawn(move || {
+            let mut reactor = Reactor {
+                dir,
+                epoll,
+                watch,
+                devices: HashMap::new(),
+                producer: sink.register(),
+                policy,
+                secure,
+                start_time,
+                out: Vec::with_capacity(4),
+            };
+            for (path, device) in devices {
+                let name = device.name().unwrap_or("Unknown").to_string();
+                reactor.adopt(path, name, device);
+            }
+            // The watch was armed before this scan, so a node created since
+            // enumeration is either picked up here or reported by inotify
+            reactor.rescan();
+            info!(
+                "Started evdev reactor ({} device(s))",
+                reactor.devices.len()
+            );
+            reactor.run(&capturing);
+        })?;
+    Ok(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn record(mask: u32, name: &str) -> Vec<u8> {
+        // Names are NUL-padded to the record alignment, as the kernel does
+        let padded = (name.len() + 1).div_ceil(16) * 16;
+        let event = libc::inotify_event {
+            wd: 1,
+            mask,
+            cookie: 0,
+            len: if name.is_empty() { 0 } else { padded as u32 },
+        };
+        let mut bytes = unsafe {
+            std::slice::from_raw_parts(
+                &event as *const libc::inotify_event as *const u8,
+                std::mem::size_of::<libc::inotify_event>(),
+            )
+        }
+        .to_vec();
+        if !name.is_empty() {
+            let mut name = name.as_bytes().to_vec();
+            name.resize(padded, 0);
+            bytes.extend(name);
+        }
+        bytes
+    }
+
+    #[test]
+    fn dir_changes_decode_names_and_kinds() {
+        let mut buf = record(libc::IN_CREATE, "event7");
+        buf.extend(record(libc::IN_ATTRIB, "event7"));
+        buf.extend(record(libc::IN_DELETE, "event3"));
+        buf.extend(record(libc::IN_Q_OVERFLOW, ""));
+        let mut out = Vec::new();
+        parse_dir_changes(&buf, &mut out);
+        assert_eq!(
+            out,
+            vec![
+                DirChange::Appeared("event7".into()),
+                DirChange::Appeared("event7".into()),
+                DirChange::Removed("event3".into()),
+                DirChange::Overflow,
+            ]
+        );
+    }
+
+    #[test]
+    fn truncated_dir_change_buffer_is_ignored() {
+        let buf = record(libc::IN_CREATE, "event1");
+        let mut out = Vec::new();
+        parse_dir_changes(&buf[..8], &mut out);
+        assert!(out.is_empty());
+    }
+}
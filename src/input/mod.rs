@@ -1,11 +1,18 @@
 //! Input capture backends
 
 mod backend;
+pub(crate) mod policy;
 #[cfg(not(target_os = "linux"))]
 pub(crate) mod rdev_backend;
+mod ring;
 pub(crate) mod secure;
 
+#[cfg(target_os = "linux")]
+pub(crate) mod coalescer;
 #[cfg(target_os = "linux")]
 pub(crate) mod evdev_backend;
+#[cfg(target_os = "linux")]
+mod evdev_reactor;
 
 pub use backend::*;
+pub use ring::*;
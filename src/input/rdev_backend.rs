@@ -5,27 +5,280 @@ use crate::data::{
     EventType, InputEvent, KeyEvent, MouseButton, MouseButtonEvent, MouseMoveEvent,
     MouseScrollEvent,
 };
-use crate::input::InputBackend;
+use crate::input::policy::CapturePolicy;
+use crate::input::{InputBackend, InputSink, RingProducer};
 use anyhow::Result;
-use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicU8, Ordering};
 use std::sync::Arc;
 use std::thread;
-use std::time::Instant;
-use tokio::sync::mpsc;
+use std::time::{Duration, Instant};
 use tracing::{debug, error, info};
 
+/// Longest the motion flusher sleeps with nothing pending, so it notices `stop()`
+const FLUSHER_IDLE_WAIT: Duration = Duration::from_millis(250);
+
+/// Time-windowed mouse-motion merging, the rdev counterpart of evdev's per-`SYN_REPORT`
+/// batching in `EventCoalescer`. The OS delivers one callback per mouse report (8 kHz on
+/// gaming mice); consecutive motion inside `window` is summed into one `MouseMove`.
+///
+/// The first motion after a quiet window is emitted as is, so a movement starts at its
+/// exact timestamp; merged motion is stamped with its last callback, so it ends at one.
+/// Any other event flushes pending motion first, keeping the stream in order.
+struct MotionCoalescer {
+    window_us: u64,
+    pending: Option<PendingMotion>,
+    last_emit_us: Option<u64>,
+}
+
+struct PendingMotion {
+    dx: f64,
+    dy: f64,
+    first_us: u64,
+    last_us: u64,
+}
+
+impl MotionCoalescer {
+    fn new(window: Duration) -> Self {
+        Self {
+            window_us: window.as_micros() as u64,
+            pending: None,
+            last_emit_us: None,
+        }
+    }
+
+    fn push(&mut self, timestamp_us: u64, dx: f64, dy: f64, mut emit: impl FnMut(InputEvent)) {
+        if let Some(p) = &mut self.pending {
+            if timestamp_us.saturating_sub(p.first_us) < self.window_us {
+                p.dx += dx;
+                p.dy += dy;
+                p.last_us = timestamp_us;
+                return;
+            }
+            self.flush(&mut emit);
+        }
+        let quiet = self
+            .last_emit_us
+            .is_none_or(|last| timestamp_us.saturating_sub(last) >= self.window_us);
+        if quiet {
+            emit(motion_event(timestamp_us, dx, dy));
+            self.last_emit_us = Some(timestamp_us);
+        } else {
+            self.pending = Some(PendingMotion {
+                dx,
+                dy,
+                first_us: timestamp_us,
+                last_us: timestamp_us,
+            });
+        }
+    }
+
+    fn flush(&mut self, mut emit: impl FnMut(InputEvent)) {
+        if let Some(p) = self.pending.take() {
+            emit(motion_event(p.last_us, p.dx, p.dy));
+            self.last_emit_us = Some(p.last_us);
+        }
+    }
+
+    /// Drop pending motion that was emitted elsewhere (by the flusher)
+    fn forget_pending(&mut self) {
+        if let Some(p) = self.pending.take() {
+            self.last_emit_us = Some(p.last_us);
+        }
+    }
+
+    /// When pending motion is due, in backend microseconds
+    fn deadline_us(&self) -> Option<u64> {
+        self.pending.as_ref().map(|p| p.first_us + self.window_us)
+    }
+}
+
+fn motion_event(timestamp_us: u64, delta_x: f64, delta_y: f64) -> InputEvent {
+    InputEvent {
+        timestamp_us,
+        event: EventType::MouseMove(MouseMoveEvent { delta_x, delta_y }),
+    }
+}
+
+const SLOT_EMPTY: u8 = 0;
+/// The callback is updating the fields
+const SLOT_WRITING: u8 = 1;
+const SLOT_PENDING: u8 = 2;
+/// The flusher is emitting the fields
+const SLOT_TAKEN: u8 = 3;
+
+/// The callback's pending motion, mirrored for the flusher thread. Ownership of
+/// the fields passes by compare-and-swap on `state`, so the OS input hook never
+/// waits on the flusher (the lock-free callback contract of the input rings).
+#[derive(Default)]
+struct MotionSlot {
+    state: AtomicU8,
+    dx_bits: AtomicU64,
+    dy_bits: AtomicU64,
+    last_us: AtomicU64,
+    due_us: AtomicU64,
+}
+
+impl MotionSlot {
+    /// The pending motion, if the flusher got it before the callback reclaimed it
+    fn take(&self) -> Option<InputEvent> {
+        self.state
+            .compare_exchange(
+                SLOT_PENDING,
+                SLOT_TAKEN,
+                Ordering::Acquire,
+                Ordering::Relaxed,
+            )
+            .ok()?;
+        let event = motion_event(
+            self.last_us.load(Ordering::Relaxed),
+            f64::from_bits(self.dx_bits.load(Ordering::Relaxed)),
+            f64::from_bits(self.dy_bits.load(Ordering::Relaxed)),
+        );
+        self.state.store(SLOT_EMPTY, Ordering::Release);
+        Some(event)
+    }
+}
+
+/// State owned by the rdev callback. With a motion window the pending motion is
+/// mirrored into `slot`, from which the flusher emits it into its own ring if no
+/// event arrives before the window closes.
+struct Emitter {
+    producer: RingProducer,
+    motion: MotionCoalescer,
+    slot: Option<Arc<MotionSlot>>,
+    flusher: Option<thread::Thread>,
+}
+
+impl Emitter {
+    /// Take the slot back before touching pending motion. `false` when the
+    /// flusher has claimed it: the motion is emitted from there, and the slot
+    /// stays the flusher's until it is done.
+    fn reclaim(&mut self) -> bool {
+        let Some(slot) = &self.slot else {
+            return true;
+        };
+        let expected = if self.motion.deadline_us().is_some() {
+            SLOT_PENDING
+        } else {
+            SLOT_EMPTY
+        };
+        let owned = slot
+            .state
+            .compare_exchange(expected, SLOT_WRITING, Ordering::Acquire, Ordering::Relaxed)
+            .is_ok();
+        if !owned {
+            self.motion.forget_pending();
+        }
+        owned
+    }
+
+    /// Mirror the pending motion into the reclaimed slot and hand it back
+    fn publish(&self, was_pending: bool) {
+        let Some(slot) = &self.slot else {
+            return;
+        };
+        let state = match &self.motion.pending {
+            Some(p) => {
+                slot.dx_bits.store(p.dx.to_bits(), Ordering::Relaxed);
+                slot.dy_bits.store(p.dy.to_bits(), Ordering::Relaxed);
+                slot.last_us.store(p.last_us, Ordering::Relaxed);
+                slot.due_us
+                    .store(p.first_us + self.motion.window_us, Ordering::Relaxed);
+                SLOT_PENDING
+            }
+            None => SLOT_EMPTY,
+        };
+        slot.state.store(state, Ordering::Release);
+        if state == SLOT_PENDING && !was_pending {
+            if let Some(flusher) = &self.flusher {
+                flusher.unpark();
+            }
+        }
+    }
+
+    fn push_motion(&mut self, timestamp_us: u64, dx: f64, dy: f64) {
+        if !self.reclaim() {
+            // The flusher holds the slot for a moment: emit unmerged, don't wait
+            push_event(&mut self.producer, motion_event(timestamp_us, dx, dy));
+            return;
+        }
+        let was_pending = self.motion.deadline_us().is_some();
+        let Emitter {
+            producer, motion, ..
+        } = self;
+        motion.push(timestamp_us, dx, dy, |event| push_event(producer, event));
+        self.publish(was_pending);
+    }
+
+    /// Emit `event`, flushing pending motion first to keep the stream in order
+    fn push(&mut self, event: InputEvent) {
+        if self.reclaim() {
+            let Emitter {
+                producer, motion, ..
+            } = self;
+            motion.flush(|event| push_event(producer, event));
+            self.publish(false);
+        }
+        push_event(&mut self.producer, event);
+    }
+}
+
+fn push_event(producer: &mut RingProducer, event: InputEvent) {
+    if !producer.push(event) {
+        debug!("Input ring full, dropped event");
+    }
+}
+
+/// Emit motion left pending at the end of a burst once its window closes, into
+/// its own ring (the drain merges rings by timestamp). Parked while nothing is
+/// pending; the callback unparks it when motion starts pending.
+fn spawn_motion_flusher(
+    slot: Arc<MotionSlot>,
+    mut producer: RingProducer,
+    capturing: Arc<AtomicBool>,
+    start_time: Instant,
+) -> thread::Thread {
+    let handle = thread::spawn(move || loop {
+        let running = capturing.load(Ordering::SeqCst);
+        let now_us = start_time.elapsed().as_micros() as u64;
+        let due = (slot.state.load(Ordering::Acquire) == SLOT_PENDING)
+            .then(|| slot.due_us.load(Ordering::Relaxed));
+        let wait = match due {
+            Some(due) if running && due > now_us => Duration::from_micros(due - now_us),
+            Some(_) => {
+                if let Some(event) = slot.take() {
+                    push_event(&mut producer, event);
+                }
+                FLUSHER_IDLE_WAIT
+            }
+            None => FLUSHER_IDLE_WAIT,
+        };
+        if !running {
+            break;
+        }
+        thread::park_timeout(wait);
+    });
+    handle.thread().clone()
+}
+
 /// rdev-based input capture backend
 pub struct RdevBackend {
     capturing: Arc<AtomicBool>,
+    /// `[input]` capture flags, checked in the callback before an event is built
+    policy: Arc<CapturePolicy>,
+    /// Motion merging window; zero emits every motion callback
+    motion_window: Duration,
     /// The instant when the backend was started, used for timestamp calculation
     start_time: Option<Instant>,
 }
 
 impl RdevBackend {
     /// Create a new rdev backend
-    pub fn new() -> Self {
+    pub fn new(policy: Arc<CapturePolicy>, motion_window: Duration) -> Self {
         Self {
             capturing: Arc::new(AtomicBool::new(false)),
+            policy,
+            motion_window,
             start_time: None,
         }
     }
@@ -33,19 +286,22 @@ impl RdevBackend {
 
 impl Default for RdevBackend {
     fn default() -> Self {
-        Self::new()
+        Self::new(Arc::default(), Duration::ZERO)
     }
 }
 
 impl InputBackend for RdevBackend {
-    fn start(&mut self, tx: mpsc::UnboundedSender<InputEvent>) -> Result<()> {
+    fn start(&mut self, sink: InputSink) -> Result<()> {
         if self.capturing.load(Ordering::SeqCst) {
             return Ok(()); // Already capturing
         }
 
         self.capturing.store(true, Ordering::SeqCst);
         let capturing = self.capturing.clone();
-        let start_time = Instant::now();
+        let policy = self.policy.clone();
+        let motion_window = self.motion_window;
+        // The sink's clock, shared with every other producer
+        let start_time = sink.epoch();
         self.start_time = Some(start_time);
 
         let handle = thread::spawn(move || {
@@ -59,6 +315,17 @@ impl InputBackend for RdevBackend {
 
             info!("rdev input capture started");
 
+            // Without a window nothing is ever left pending, so no flusher is needed
+            let slot = (!motion_window.is_zero()).then(|| Arc::new(MotionSlot::default()));
+            let flusher = slot.as_ref().map(|slot| {
+                spawn_motion_flusher(slot.clone(), sink.register(), capturing.clone(), start_time)
+            });
+            let mut emitter = Emitter {
+                producer: sink.register(),
+                motion: MotionCoalescer::new(motion_window),
+                slot,
+                flusher,
+            };
             let callback = move |event: rdev::Event| {
                 if !capturing.load(Ordering::SeqCst) {
                     return;
@@ -66,7 +333,21 @@ impl InputBackend for RdevBackend {
 
                 let timestamp_us = start_time.elapsed().as_micros() as u64;
 
+                // Disabled classes are dropped before anything (e.g. a key name) is built
+                let policy = policy.load();
                 let event_type = match event.event_type {
+                    rdev::EventType::KeyPress(_) | rdev::EventType::KeyRelease(_)
+                        if !policy.keyboard() =>
+                    {
+                        None
+                    }
+                    rdev::EventType::ButtonPress(_) | rdev::EventType::ButtonRelease(_)
+                        if !policy.mouse_click() =>
+                    {
+                        None
+                    }
+                    rdev::EventType::MouseMove { .. } if !policy.mouse_move() => None,
+                    rdev::EventType::Wheel { .. } if !policy.mouse_scroll() => None,
                     rdev::EventType::KeyPress(key) => {
                         Some(EventType::KeyPress(KeyEvent::from(key)))
                     }
@@ -90,7 +371,10 @@ impl InputBackend for RdevBackend {
                     }
                     rdev::EventType::MouseMove {
                         delta_x, delta_y, ..
-                    } => Some(EventType::MouseMove(MouseMoveEvent { delta_x, delta_y })),
+                    } => {
+                        emitter.push_motion(timestamp_us, delta_x, delta_y);
+                        None
+                    }
                     rdev::EventType::Wheel { delta_x, delta_y } => {
                         Some(EventType::MouseScroll(MouseScrollEvent {
                             delta_x,
@@ -102,14 +386,10 @@ impl InputBackend for RdevBackend {
                 };
 
                 if let Some(event_type) = event_type {
-                    let input_event = InputEvent {
+                    emitter.push(InputEvent {
                         timestamp_us,
                         event: event_type,
-                    };
-
-                    if let Err(e) = tx.send(input_event) {
-                        debug!("Failed to send input event: {}", e);
-                    }
+                    });
                 }
             };
 
@@ -139,3 +419,95 @@ impl InputBackend for RdevBackend {
         self.start_time.map(|t| t.elapsed().as_micros() as u64)
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn feed(c: &mut MotionCoalescer, trace: &[(u64, f64)], out: &mut Vec<InputEvent>) {
+        for &(ts, dx) in trace {
+            c.push(ts, dx, 0.0, |e| out.push(e));
+        }
+    }
+
+    fn moves(out: &[InputEvent]) -> Vec<(u64, f64)> {
+        out.iter()
+            .map(|e| match &e.event {
+                EventType::MouseMove(m) => (e.timestamp_us, m.delta_x),
+                other => panic!("expected MouseMove, got {:?}", other),
+            })
+            .collect()
+    }
+
+    // An 8 kHz burst collapses into one event per window; the first report keeps its
+    // timestamp and each merged event carries its last report's, with no delta lost.
+    #[test]
+    fn burst_merges_per_window_with_exact_edges() {
+        let mut c = MotionCoalescer::new(Duration::from_millis(2));
+        let mut out = Vec::new();
+        let trace: Vec<(u64, f64)> = (0..40).map(|i| (i * 125, 1.0)).collect();
+        feed(&mut c, &trace, &mut out);
+        c.flush(|e| out.push(e));
+
+        let moves = moves(&out);
+        assert_eq!(moves.first(), Some(&(0, 1.0)));
+        assert_eq!(moves.last().map(|m| m.0), Some(39 * 125));
+        assert_eq!(moves.iter().map(|m| m.1).sum::<f64>(), 40.0);
+        assert!(moves.len() <= 4, "{} events for a 5 ms burst", moves.len());
+    }
+
+    #[test]
+    fn pending_motion_has_a_deadline_until_flushed() {
+        let mut c = MotionCoalescer::new(Duration::from_millis(2));
+        let mut out = Vec::new();
+        feed(&mut c, &[(0, 1.0), (500, 2.0)], &mut out);
+        assert_eq!(c.deadline_us(), Some(2_500));
+        c.flush(|e| out.push(e));
+        assert_eq!(c.deadline_us(), None);
+        assert_eq!(moves(&out), vec![(0, 1.0), (500, 2.0)]);
+    }
+
+    // Pending motion is emitted exactly once, by whichever side gets the slot
+    #[test]
+    fn slot_hands_pending_motion_to_one_side() {
+        let (sink, rings) = crate::input::input_rings();
+        let slot = Arc::new(MotionSlot::default());
+        let mut flusher_ring = sink.register();
+        let mut emitter = Emitter {
+            producer: sink.register(),
+            motion: MotionCoalescer::new(Duration::from_millis(2)),
+            slot: Some(slot.clone()),
+            flusher: None,
+        };
+        emitter.push_motion(0, 1.0, 0.0);
+        emitter.push_motion(500, 2.0, 0.0);
+        assert_eq!(slot.state.load(Ordering::Relaxed), SLOT_PENDING);
+
+        // The flusher wins the window's motion; the callback must not repeat it
+        push_event(&mut flusher_ring, slot.take().unwrap());
+        assert!(slot.take().is_none());
+        emitter.push(motion_event(3_000, 0.0, 4.0));
+
+        // Otherwise the next event reclaims and flushes it itself
+        emitter.push_motion(3_100, 8.0, 0.0);
+        emitter.push_motion(3_200, 16.0, 0.0);
+        emitter.push(motion_event(9_000, 0.0, 0.0));
+        assert!(slot.take().is_none());
+
+        let mut out = Vec::new();
+        rings.drain_into(&mut out, usize::MAX);
+        let total: f64 = moves(&out).iter().map(|m| m.1).sum();
+        assert_eq!(total, 27.0);
+        let stamps: Vec<u64> = out.iter().map(|e| e.timestamp_us).collect();
+        assert_eq!(stamps, [0, 500, 3_000, 3_100, 3_200, 9_000]);
+    }
+
+    #[test]
+    fn zero_window_emits_every_report() {
+        let mut c = MotionCoalescer::new(Duration::ZERO);
+        let mut out = Vec::new();
+        feed(&mut c, &[(0, 1.0), (1, 1.0), (2, 1.0)], &mut out);
+        assert_eq!(out.len(), 3);
+        assert_eq!(c.deadline_us(), None);
+    }
+}
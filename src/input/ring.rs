@@ -0,0 +1,358 @@
+//! Bounded SPSC rings carrying input events from capture threads to the engine
+//!
+//! Every capture thread registers its own preallocated ring through an
+//! [`InputSink`]; the engine owns the single [`InputRings`] consumer and
+//! drains all rings in batches, merged by timestamp. Producers stamp events
+//! from the sink's shared clock ([`InputSink::epoch`]) so that merge is
+//! meaningful across threads. Pushing never allocates or locks: a full ring
+//! drops the event and bumps a shared overflow counter (surfaced in
+//! `EngineStatus::Capturing`) instead of growing without bound. Producers only
+//! wake the engine when no wakeup is already pending, so a burst of events
+//! costs one wakeup per drain rather than one per event.
+
+use std::cell::UnsafeCell;
+use std::mem::MaybeUninit;
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::Instant;
+use tokio::sync::Notify;
+
+use crate::data::InputEvent;
+
+/// Slots per ring. A power of two; at 8 kHz polling this is ~1 s of input,
+/// far more than the engine ever lags behind.
+pub const RING_CAPACITY: usize = 8192;
+
+/// Slots for a ring carrying only occasional events (e.g. `Redacted` markers)
+pub const MARKER_RING_CAPACITY: usize = 64;
+
+struct Ring {
+    slots: Box<[UnsafeCell<MaybeUninit<InputEvent>>]>,
+    /// Next slot to read; written only by the consumer
+    head: AtomicUsize,
+    /// Next slot to write; written only by the producer
+    tail: AtomicUsize,
+    /// Set when the producer is dropped; the consumer prunes the ring once empty
+    closed: AtomicBool,
+}
+
+// SAFETY: a slot is only written by the single producer while it lies outside
+// `head..tail`, and only read by the single consumer once it lies inside; the
+// SeqCst index stores publish slot contents between the two threads.
+unsafe impl Send for Ring {}
+unsafe impl Sync for Ring {}
+
+impl Ring {
+    fn new(capacity: usize) -> Self {
+        debug_assert!(capacity.is_power_of_two());
+        Self {
+            slots: (0..capacity)
+                .map(|_| UnsafeCell::new(MaybeUninit::uninit()))
+                .collect(),
+            head: AtomicUsize::new(0),
+            tail: AtomicUsize::new(0),
+            closed: AtomicBool::new(false),
+        }
+    }
+
+    fn mask(&self) -> usize {
+        self.slots.len() - 1
+    }
+
+    fn is_empty(&self) -> bool {
+        self.head.load(Ordering::SeqCst) == self.tail.load(Ordering::SeqCst)
+    }
+
+    /// Timestamp of the event at `index`
+    ///
+    /// # Safety
+    /// `index` must lie in `head..tail` as seen by the consumer.
+    unsafe fn timestamp_at(&self, index: usize) -> u64 {
+        (*self.slots[index & self.mask()].get())
+            .assume_init_ref()
+            .timestamp_us
+    }
+}
+
+impl Drop for Ring {
+    fn drop(&mut self) {
+        let head = *self.head.get_mut();
+        let tail = *self.tail.get_mut();
+        let mask = self.mask();
+        let mut i = head;
+        while i != tail {
+            // SAFETY: slots in head..tail were written and never read
+            unsafe { self.slots[i & mask].get_mut().assume_init_drop() };
+            i = i.wrapping_add(1);
+        }
+    }
+}
+
+struct Shared {
+    rings: Mutex<Vec<Arc<Ring>>>,
+    notify: Notify,
+    /// Set by the first producer to push after a drain began; the engine is
+    /// already awake (or about to be) while it is set.
+    wakeup_pending: AtomicBool,
+    dropped: Arc<AtomicU64>,
+    /// Zero of every producer's `timestamp_us`
+    epoch: Instant,
+}
+
+/// Handle given to an input backend for registering capture threads
+#[derive(Clone)]
+pub struct InputSink {
+    shared: Arc<Shared>,
+}
+
+impl InputSink {
+    /// Register a new ring for one capture thread
+    pub fn register(&self) -> RingProducer {
+        self.register_with_capacity(RING_CAPACITY)
+    }
+
+    /// Register a ring with `capacity` slots (a power of two)
+    pub fn register_with_capacity(&self, capacity: usize) -> RingProducer {
+        let ring = Arc::new(Ring::new(capacity));
+        self.shared
+            .rings
+            .lock()
+            .unwrap_or_else(|p| p.into_inner())
+            .push(ring.clone());
+        RingProducer {
+            ring,
+            shared: self.shared.clone(),
+        }
+    }
+
+    /// Instant that event timestamps count from. Producers must stamp with
+    /// `epoch().elapsed()` for the drain to merge rings correctly.
+    pub fn epoch(&self) -> Instant {
+        self.shared.epoch
+    }
+}
+
+/// Producer end of one ring, owned by a single capture thread
+pub struct RingProducer {
+    ring: Arc<Ring>,
+    shared: Arc<Shared>,
+}
+
+impl RingProducer {
+    /// Microseconds since [`InputSink::epoch`]
+    pub fn now_us(&self) -> u64 {
+        self.shared.epoch.elapsed().as_micros() as u64
+    }
+
+    /// Push an event, returning `false` (and counting an overflow) if the
+    /// ring is full.
+    pub fn push(&mut self, event: InputEvent) -> bool {
+        let tail = self.ring.tail.load(Ordering::Relaxed);
+        let head = self.ring.head.load(Ordering::SeqCst);
+        if tail.wrapping_sub(head) == self.ring.slots.len() {
+            self.shared.dropped.fetch_add(1, Ordering::Relaxed);
+            return false;
+        }
+        // SAFETY: the slot is outside head..tail, so the consumer won't touch it
+        unsafe { (*self.ring.slots[tail & self.ring.mask()].get()).write(event) };
+        self.ring.tail.store(tail.wrapping_add(1), Ordering::SeqCst);
+
+        if !self.shared.wakeup_pending.swap(true, Ordering::SeqCst) {
+            self.shared.notify.notify_one();
+        }
+        true
+    }
+}
+
+impl Drop for RingProducer {
+    fn drop(&mut self) {
+        self.ring.closed.store(true, Ordering::SeqCst);
+        // Wake the engine so it drains the tail and prunes the ring
+        self.shared.notify.notify_one();
+    }
+}
+
+/// Consumer side of every registered ring, owned by the engine
+pub struct InputRings {
+    shared: Arc<Shared>,
+}
+
+/// Create a sink for input backends and the matching consumer
+pub fn input_rings() -> (InputSink, InputRings) {
+    let shared = Arc::new(Shared {
+        rings: Mutex::new(Vec::new()),
+        notify: Notify::new(),
+        wakeup_pending: AtomicBool::new(false),
+        dropped: Arc::new(AtomicU64::new(0)),
+        epoch: Instant::now(),
+    });
+    (
+        InputSink {
+            shared: shared.clone(),
+        },
+        InputRings { shared },
+    )
+}
+
+impl InputRings {
+    /// Wait until some producer has pushed since the last drain
+    pub async fn notified(&self) {
+        self.shared.notify.notified().await;
+    }
+
+    /// Move up to `max` events from all rings into `out`, merged by
+    /// `timestamp_us`: every step takes the earliest head across the rings
+    /// (each ring is already in order), so a busy ring such as mouse motion
+    /// can't push older events of another ring out of the batch. Events
+    /// pushed after the drain starts wait for the next one. Returns `true` if
+    /// events were left behind, in which case the next `notified` call
+    /// returns immediately.
+    pub fn drain_into(&self, out: &mut Vec<InputEvent>, max: usize) -> bool {
+        // Clear before reading so any push from here on triggers a new wakeup
+        self.shared.wakeup_pending.store(false, Ordering::SeqCst);
+
+        let mut rings = self.shared.rings.lock().unwrap_or_else(|p| p.into_inner());
+        {
+            // (ring, next head, tail when the drain started) of each non-empty ring
+            let mut cursors: Vec<(&Ring, usize, usize)> = rings
+                .iter()
+                .map(|ring| {
+                    let head = ring.head.load(Ordering::Relaxed);
+                    (&**ring, head, ring.tail.load(Ordering::SeqCst))
+                })
+                .filter(|(_, head, tail)| head != tail)
+                .collect();
+            let mut budget = max;
+            while budget > 0 {
+                let earliest = cursors
+                    .iter_mut()
+                    .filter(|(_, head, tail)| head != tail)
+                    // SAFETY: slots in head..tail were published by the producer
+                    .min_by_key(|(ring, head, _)| unsafe { ring.timestamp_at(*head) });
+                let Some((ring, head, _)) = earliest else {
+                    break;
+                };
+                // SAFETY: as above; the slot is released when `head` is stored
+                out.push(unsafe { (*ring.slots[*head & ring.mask()].get()).assume_init_read() });
+                *head = head.wrapping_add(1);
+                budget -= 1;
+            }
+            for (ring, head, _) in cursors {
+                ring.head.store(head, Ordering::SeqCst);
+            }
+        }
+        rings.retain(|ring| !(ring.closed.load(Ordering::SeqCst) && ring.is_empty()));
+
+        let more = rings.iter().any(|ring| !ring.is_empty());
+        if more {
+            self.shared.notify.notify_one();
+        }
+        more
+    }
+
+    /// Events dropped so far because a ring was full
+    pub fn dropped_counter(&self) -> Arc<AtomicU64> {
+        self.shared.dropped.clone()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::data::{EventType, MouseMoveEvent};
+
+    fn mv(ts: u64) -> InputEvent {
+        InputEvent {
+            timestamp_us: ts,
+            event: EventType::MouseMove(MouseMoveEvent {
+                delta_x: 1.0,
+                delta_y: 0.0,
+            }),
+        }
+    }
+
+    #[test]
+    fn drains_in_order_and_counts_overflow() {
+        let (sink, rings) = input_rings();
+        let mut producer = sink.register();
+        for ts in 0..(RING_CAPACITY as u64 + 10) {
+            producer.push(mv(ts));
+        }
+        assert_eq!(rings.dropped_counter().load(Ordering::Relaxed), 10);
+
+        let mut out = Vec::new();
+        assert!(rings.drain_into(&mut out, 100));
+        assert!(!rings.drain_into(&mut out, usize::MAX));
+        let timestamps: Vec<u64> = out.iter().map(|e| e.timestamp_us).collect();
+        assert_eq!(timestamps, (0..RING_CAPACITY as u64).collect::<Vec<_>>());
+
+        // Space freed by the drain is reusable
+        assert!(producer.push(mv(1)));
+    }
+
+    #[test]
+    fn drain_merges_rings_by_timestamp() {
+        let (sink, rings) = input_rings();
+        let mut motion = sink.register();
+        let mut keys = sink.register_with_capacity(MARKER_RING_CAPACITY);
+        for ts in 0..1000 {
+            motion.push(mv(ts * 2));
+        }
+        keys.push(mv(1));
+        keys.push(mv(5));
+
+        // A batch smaller than the motion backlog still carries the key
+        // ring's early events, in timestamp order
+        let mut out = Vec::new();
+        assert!(rings.drain_into(&mut out, 6));
+        let timestamps: Vec<u64> = out.iter().map(|e| e.timestamp_us).collect();
+        assert_eq!(timestamps, [0, 1, 2, 4, 5, 6]);
+
+        rings.drain_into(&mut out, usize::MAX);
+        assert_eq!(out.len(), 1002);
+        assert!(out
+            .windows(2)
+            .all(|w| w[0].timestamp_us <= w[1].timestamp_us));
+    }
+
+    #[test]
+    fn closed_ring_is_drained_then_pruned() {
+        let (sink, rings) = input_rings();
+        let mut producer = sink.register();
+        producer.push(mv(7));
+        drop(producer);
+
+        let mut out = Vec::new();
+        rings.drain_into(&mut out, usize::MAX);
+        assert_eq!(out.len(), 1);
+        assert!(rings.shared.rings.lock().unwrap().is_empty());
+    }
+
+    #[test]
+    fn threaded_producers_deliver_everything() {
+        let (sink, rings) = input_rings();
+        let handles: Vec<_> = (0..4)
+            .map(|_| {
+                let mut producer = sink.register();
+                std::thread::spawn(move || {
+                    let mut sent = 0;
+                    while sent < 20_000 {
+                        if producer.push(mv(sent)) {
+                            sent += 1;
+                        } else {
+                            std::thread::yield_now();
+                        }
+                    }
+                })
+            })
+            .collect();
+        let mut out = Vec::new();
+        while out.len() < 80_000 {
+            rings.drain_into(&mut out, 4096);
+        }
+        for handle in handles {
+            handle.join().unwrap();
+        }
+        assert_eq!(out.len(), 80_000);
+    }
+}
@@ -5,6 +5,7 @@
 
 use super::{SecureInputState, Transition};
 use crate::data::{EventType, InputEvent, RedactedEvent};
+use crate::input::RingProducer;
 use anyhow::Result;
 use atspi::connection::AccessibilityConnection;
 use atspi::events::event_wrappers::ObjectEvents;
@@ -13,12 +14,11 @@ use atspi::proxy::accessible::ObjectRefExt;
 use atspi::{Event, Role, State};
 use futures::StreamExt;
 use std::sync::Arc;
-use tokio::sync::mpsc::UnboundedSender;
 use tracing::{debug, info, warn};
 
 pub async fn run(
     state: Arc<SecureInputState>,
-    marker_tx: UnboundedSender<InputEvent>,
+    mut markers: RingProducer,
     enable_accessibility: bool,
 ) -> Result<()> {
     if enable_accessibility {
@@ -64,10 +64,12 @@ pub async fn run(
         match state.set_atspi_secure(secure, reason) {
             Transition::Entered => {
                 debug!("secure-input: password field focused; suppressing key capture");
-                // Label the gap for post-processing. timestamp_us=0 is re-stamped to
-                // recording time by the sync engine before buffering.
-                let _ = marker_tx.send(InputEvent {
-                    timestamp_us: 0,
+                // Label the gap for post-processing. Stamped on the ring clock so it
+                // drains in order with the keys around it; the sync engine re-stamps it
+                // to recording time before buffering.
+                let timestamp_us = markers.now_us();
+                markers.push(InputEvent {
+                    timestamp_us,
                     event: EventType::Redacted(RedactedEvent {
                         reason: "secure-field".to_string(),
                     }),
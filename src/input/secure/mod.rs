@@ -108,15 +108,16 @@ impl Default for SecureInputState {
 }
 
 /// Launch secure-input gating. Linux: optionally enable system accessibility, then run
-/// the AT-SPI focus listener. Other platforms: no-op.
+/// the AT-SPI focus listener, which pushes `Redacted` markers into `markers` so they are
+/// merged with the captured input in timestamp order. Other platforms: no-op.
 #[cfg(target_os = "linux")]
 pub fn spawn(
     state: std::sync::Arc<SecureInputState>,
-    marker_tx: tokio::sync::mpsc::UnboundedSender<crate::data::InputEvent>,
+    markers: crate::input::RingProducer,
     enable_accessibility: bool,
 ) {
     tokio::spawn(async move {
-        if let Err(e) = atspi_gate::run(state, marker_tx, enable_accessibility).await {
+        if let Err(e) = atspi_gate::run(state, markers, enable_accessibility).await {
             tracing::warn!("secure-input gate exited: {e:#}");
         }
     });
@@ -125,7 +126,7 @@ pub fn spawn(
 #[cfg(not(target_os = "linux"))]
 pub fn spawn(
     _state: std::sync::Arc<SecureInputState>,
-    _marker_tx: tokio::sync::mpsc::UnboundedSender<crate::data::InputEvent>,
+    _markers: crate::input::RingProducer,
     _enable_accessibility: bool,
 ) {
 }
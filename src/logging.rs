@@ -118,7 +118,9 @@ fn prune_old_logs(log_dir: &PathBuf, max_age: Duration) {
             continue;
         };
 
-        if !file_name.starts_with(LOG_FILE_BASENAME) {
+        if !file_name.starts_with(LOG_FILE_BASENAME)
+            && !file_name.starts_with(crate::metrics::METRICS_FILE_PREFIX)
+        {
             continue;
         }
 
@@ -17,6 +17,7 @@ mod data;
 mod input;
 mod installer;
 mod logging;
+mod metrics;
 #[cfg(target_os = "linux")]
 mod resume_linux;
 mod sync;
@@ -158,6 +159,8 @@ fn main() -> Result<()> {
 
     // Initialize logging
     let _log_guard = logging::init_logging()?;
+    // Anchor the metrics snapshots' uptime at process start
+    metrics::init();
 
     // Initialize crash handler (must be after logging so we have the log directory)
     let log_dir = logging::get_log_dir()?;
@@ -297,14 +300,11 @@ fn main() -> Result<()> {
         }
 
         // Internal: render the manual "Check for Updates" status dialog in a clean process.
-        // The parent agent writes simple status snapshots to the supplied file while the
-        // dialog polls it. This must stay above libobs/tray/runtime init for the same GTK
+        // The parent agent pushes status snapshots over the dialog's stdin as they change.
+        // This must stay above libobs/tray/runtime init for the same GTK
         // default-GMainContext reason as `--settings-panel-out`.
-        if let Some(pos) = args.iter().position(|a| a == "--update-check-dialog") {
-            let status = args
-                .get(pos + 1)
-                .ok_or_else(|| anyhow::anyhow!("--update-check-dialog requires a file path"))?;
-            ui::update_dialog::run_update_check_dialog_subprocess(std::path::Path::new(status))?;
+        if args.iter().any(|a| a == "--update-check-dialog") {
+            ui::update_dialog::run_update_check_dialog_subprocess()?;
             return Ok(());
         }
 
@@ -447,16 +447,49 @@ fn main() -> Result<()> {
         warn!("Screen Recording permission not granted - capture may not work");
     }
 
-    // Bootstrap OBS binaries if needed
-    info!("Bootstrapping OBS binaries...");
-    let mut capture_ctx =
-        match runtime.block_on(capture::CaptureContext::new(get_output_directory(&config))) {
-            Ok(ctx) => ctx,
-            Err(e) => {
-                error!("Failed to bootstrap OBS binaries: {}", e);
-                std::process::exit(1);
+    // Initialize optional Google OAuth auth manager. A stale ID token is refreshed in
+    // the background now, over the network, so the first upload doesn't wait on it.
+    let auth_manager = option_env!("CROWD_CAST_GOOGLE_CLIENT_ID").map(|client_id| {
+        let client_secret = option_env!("CROWD_CAST_GOOGLE_CLIENT_SECRET").unwrap_or("");
+        let mgr = auth::AuthManager::new(client_id, client_secret);
+        if mgr.is_authenticated() {
+            info!("Authenticated as {}", mgr.email().unwrap_or("unknown"));
+        }
+        std::sync::Arc::new(tokio::sync::Mutex::new(mgr))
+    });
+    if let Some(auth) = auth_manager.clone() {
+        runtime.spawn(async move {
+            let mut mgr = auth.lock().await;
+            if mgr.is_authenticated() {
+                mgr.get_valid_token().await;
             }
-        };
+        });
+    }
+
+    // Bootstrap OBS binaries if needed. On macOS, shortly after boot/login or a wake,
+    // the display set is settled at the same time: it is still in flux then, and
+    // capture setup attempted mid-flux fails into the retry delays below. Any other
+    // start skips the wait.
+    info!("Bootstrapping OBS binaries...");
+    let bootstrap = capture::CaptureContext::new(get_output_directory(&config));
+    #[cfg(target_os = "macos")]
+    let bootstrap = async {
+        if !sync::booted_or_woke_within(sync::STARTUP_SETTLE_WINDOW) {
+            return bootstrap.await;
+        }
+        let (ctx, settled) = tokio::join!(bootstrap, sync::wait_for_displays_to_settle());
+        if !settled {
+            info!("Starting capture setup before the display set settled");
+        }
+        ctx
+    };
+    let mut capture_ctx = match runtime.block_on(bootstrap) {
+        Ok(ctx) => ctx,
+        Err(e) => {
+            error!("Failed to bootstrap OBS binaries: {}", e);
+            std::process::exit(1);
+        }
+    };
     info!("OBS binaries ready");
 
     // Heal pre-1096 LaunchAgent plists so launchd also relaunches after a clean
@@ -469,6 +502,7 @@ fn main() -> Result<()> {
     // multi-monitor per-app envelope vs the display-capture canvas (setup_capture re-sets these).
     capture_ctx.set_single_active_app_capture(config.capture.single_active_app_capture);
     capture_ctx.set_mac_multi_monitor_capture(config.capture.mac_multi_monitor_capture);
+    capture_ctx.set_warm_app_scene_limit(config.capture.warm_app_scenes);
     let target_apps = config.capture.target_apps.clone();
     capture_ctx.set_target_apps(&target_apps);
 
@@ -569,16 +603,6 @@ fn main() -> Result<()> {
     // Create engine channels
     let (cmd_tx, cmd_rx, status_tx, _status_rx) = create_engine_channels();
 
-    // Initialize optional Google OAuth auth manager
-    let auth_manager = option_env!("CROWD_CAST_GOOGLE_CLIENT_ID").map(|client_id| {
-        let client_secret = option_env!("CROWD_CAST_GOOGLE_CLIENT_SECRET").unwrap_or("");
-        let mgr = auth::AuthManager::new(client_id, client_secret);
-        if mgr.is_authenticated() {
-            info!("Authenticated as {}", mgr.email().unwrap_or("unknown"));
-        }
-        std::sync::Arc::new(tokio::sync::Mutex::new(mgr))
-    });
-
     // Create sync engine
     let engine = SyncEngine::new(
         config.clone(),
@@ -0,0 +1,418 @@
+//! In-process latency and throughput metrics for the engine's hot paths
+//!
+//! A fixed set of lock-free histograms (engine spans, uploads) and counters
+//! (input events, upload bytes, retries), plus per-description histograms for
+//! `obs_call_with_watchdog`. Counts are cumulative since process start.
+//!
+//! The engine appends a compact one-line JSON snapshot to a daily
+//! `metrics-YYYY-MM-DD.log` in the log directory every few minutes (skipped
+//! when nothing was recorded since the last one, so an idle machine's file
+//! stops growing), and `LogShipper` ships it alongside the text logs. A hung
+//! OBS call writes a final snapshot naming the call before the watchdog
+//! restarts the process, so the file shows which machines hit the watchdog and
+//! what they were doing.
+
+use std::collections::{BTreeMap, HashMap};
+use std::io::Write;
+use std::path::PathBuf;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Mutex, OnceLock};
+use std::time::{Duration, Instant};
+
+use serde::Serialize;
+use tracing::warn;
+
+/// Histogram buckets: bucket `i` counts durations in `[2^i, 2^(i+1))` µs, the
+/// last one everything from ~8.4 s up (past the 5 s OBS watchdog).
+const BUCKETS: usize = 24;
+
+/// Local (and remote) file name prefix of the daily snapshot files.
+pub const METRICS_FILE_PREFIX: &str = "metrics-";
+
+/// Log-bucketed latency histogram. Recording is a handful of relaxed atomics.
+pub struct Histogram {
+    buckets: [AtomicU64; BUCKETS],
+    count: AtomicU64,
+    sum_us: AtomicU64,
+    max_us: AtomicU64,
+}
+
+impl Histogram {
+    pub const fn new() -> Self {
+        #[allow(clippy::declare_interior_mutable_const)]
+        const ZERO: AtomicU64 = AtomicU64::new(0);
+        Self {
+            buckets: [ZERO; BUCKETS],
+            count: AtomicU64::new(0),
+            sum_us: AtomicU64::new(0),
+            max_us: AtomicU64::new(0),
+        }
+    }
+
+    pub fn record(&self, elapsed: Duration) {
+        let us = u64::try_from(elapsed.as_micros()).unwrap_or(u64::MAX);
+        self.buckets[bucket_index(us)].fetch_add(1, Ordering::Relaxed);
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.sum_us.fetch_add(us, Ordering::Relaxed);
+        self.max_us.fetch_max(us, Ordering::Relaxed);
+    }
+
+    /// Start timing a span; the elapsed time is recorded when the guard drops,
+    /// so early returns and `?` are covered.
+    pub fn start(&self) -> SpanTimer<'_> {
+        SpanTimer {
+            histogram: self,
+            started: Instant::now(),
+        }
+    }
+
+    fn snapshot(&self) -> HistogramSnapshot {
+        let buckets: Vec<u64> = self
+            .buckets
+            .iter()
+            .map(|b| b.load(Ordering::Relaxed))
+            .collect();
+        let count = self.count.load(Ordering::Relaxed);
+        HistogramSnapshot {
+            n: count,
+            sum_us: self.sum_us.load(Ordering::Relaxed),
+            max_us: self.max_us.load(Ordering::Relaxed),
+            p50_us: quantile_upper_bound(&buckets, count, 0.50),
+            p99_us: quantile_upper_bound(&buckets, count, 0.99),
+            buckets: trim_trailing_zeros(buckets),
+        }
+    }
+}
+
+/// Guard returned by [`Histogram::start`]
+pub struct SpanTimer<'a> {
+    histogram: &'a Histogram,
+    started: Instant,
+}
+
+impl Drop for SpanTimer<'_> {
+    fn drop(&mut self) {
+        self.histogram.record(self.started.elapsed());
+    }
+}
+
+/// Monotonic counter
+pub struct Counter(AtomicU64);
+
+impl Counter {
+    pub const fn new() -> Self {
+        Self(AtomicU64::new(0))
+    }
+
+    pub fn add(&self, n: u64) {
+        self.0.fetch_add(n, Ordering::Relaxed);
+    }
+
+    pub fn inc(&self) {
+        self.add(1);
+    }
+
+    pub fn set(&self, n: u64) {
+        self.0.store(n, Ordering::Relaxed);
+    }
+
+    fn get(&self) -> u64 {
+        self.0.load(Ordering::Relaxed)
+    }
+}
+
+/// Every metric the agent records
+pub struct Metrics {
+    pub poll_frontmost_app: Histogram,
+    pub apply_pending_app_switch: Histogram,
+    pub rotate_segment: Histogram,
+    pub collect_segment_events: Histogram,
+    pub upload_segment: Histogram,
+    pub upload_log_file: Histogram,
+
+    pub events_buffered: Counter,
+    /// Mirrors the input rings' overflow counter (set by the engine)
+    pub events_dropped: Counter,
+    /// Events drained from the buffer into the segment journal
+    pub events_flushed: Counter,
+    pub upload_bytes: Counter,
+    pub upload_retries: Counter,
+    pub upload_failures: Counter,
+    /// Current adaptive upload concurrency limit (set by the scheduler)
+    pub upload_concurrency: Counter,
+    pub obs_watchdog_fired: Counter,
+
+    obs_calls: Mutex<Option<HashMap<String, Histogram>>>,
+}
+
+pub fn metrics() -> &'static Metrics {
+    static METRICS: Metrics = Metrics::new();
+    &METRICS
+}
+
+impl Metrics {
+    const fn new() -> Self {
+        Self {
+            poll_frontmost_app: Histogram::new(),
+            apply_pending_app_switch: Histogram::new(),
+            rotate_segment: Histogram::new(),
+            collect_segment_events: Histogram::new(),
+            upload_segment: Histogram::new(),
+            upload_log_file: Histogram::new(),
+            events_buffered: Counter::new(),
+            events_dropped: Counter::new(),
+            events_flushed: Counter::new(),
+            upload_bytes: Counter::new(),
+            upload_retries: Counter::new(),
+            upload_failures: Counter::new(),
+            upload_concurrency: Counter::new(),
+            obs_watchdog_fired: Counter::new(),
+            obs_calls: Mutex::new(None),
+        }
+    }
+
+    /// Record one `obs_call_with_watchdog` call under its description
+    pub fn record_obs_call(&self, description: &str, elapsed: Duration) {
+        let mut calls = self.obs_calls.lock().unwrap_or_else(|p| p.into_inner());
+        let calls = calls.get_or_insert_with(HashMap::new);
+        match calls.get(description) {
+            Some(h) => h.record(elapsed),
+            None => {
+                let h = Histogram::new();
+                h.record(elapsed);
+                calls.insert(description.to_string(), h);
+            }
+        }
+    }
+
+    fn snapshot(&self, hung_obs_call: Option<&str>) -> Snapshot {
+        let spans = [
+            ("poll_frontmost_app", &self.poll_frontmost_app),
+            ("apply_pending_app_switch", &self.apply_pending_app_switch),
+            ("rotate_segment", &self.rotate_segment),
+            ("collect_segment_events", &self.collect_segment_events),
+            ("upload_segment", &self.upload_segment),
+            ("upload_log_file", &self.upload_log_file),
+        ]
+        .into_iter()
+        .filter(|(_, h)| h.count.load(Ordering::Relaxed) > 0)
+        .map(|(name, h)| (name.to_string(), h.snapshot()))
+        .collect();
+
+        let obs_calls = self
+            .obs_calls
+            .lock()
+            .unwrap_or_else(|p| p.into_inner())
+            .iter()
+            .flatten()
+            .map(|(desc, h)| (desc.clone(), h.snapshot()))
+            .collect();
+
+        let counters = [
+            ("events_buffered", &self.events_buffered),
+            ("events_dropped", &self.events_dropped),
+            ("events_flushed", &self.events_flushed),
+            ("upload_bytes", &self.upload_bytes),
+            ("upload_retries", &self.upload_retries),
+            ("upload_failures", &self.upload_failures),
+            ("upload_concurrency", &self.upload_concurrency),
+            ("obs_watchdog_fired", &self.obs_watchdog_fired),
+        ]
+        .into_iter()
+        .map(|(name, c)| (name.to_string(), c.get()))
+        .collect();
+
+        Snapshot {
+            ts: chrono::Utc::now().to_rfc3339_opts(chrono::SecondsFormat::Secs, true),
+            pid: std::process::id(),
+            uptime_s: process_start().elapsed().as_secs(),
+            version: env!("CARGO_PKG_VERSION"),
+            hung_obs_call: hung_obs_call.map(str::to_string),
+            spans,
+            obs_calls,
+            counters,
+        }
+    }
+
+    /// Total recorded samples and counts; unchanged means nothing happened.
+    /// `poll_frontmost_app` is left out: it records a span every poll tick, so
+    /// counting it would make every snapshot look changed. Its histogram still
+    /// goes out with the next snapshot something else triggers.
+    fn activity(&self) -> u64 {
+        let spans = [
+            &self.apply_pending_app_switch,
+            &self.rotate_segment,
+            &self.collect_segment_events,
+            &self.upload_segment,
+            &self.upload_log_file,
+        ]
+        .iter()
+        .map(|h| h.count.load(Ordering::Relaxed))
+        .sum::<u64>();
+        let obs = self
+            .obs_calls
+            .lock()
+            .unwrap_or_else(|p| p.into_inner())
+            .iter()
+            .flatten()
+            .map(|(_, h)| h.count.load(Ordering::Relaxed))
+            .sum::<u64>();
+        spans
+            .wrapping_add(obs)
+            .wrapping_add(self.events_buffered.get())
+            .wrapping_add(self.events_dropped.get())
+            .wrapping_add(self.upload_retries.get())
+            .wrapping_add(self.upload_failures.get())
+    }
+}
+
+#[derive(Serialize)]
+struct HistogramSnapshot {
+    n: u64,
+    sum_us: u64,
+    max_us: u64,
+    p50_us: u64,
+    p99_us: u64,
+    /// Counts per power-of-two µs bucket, trailing empty buckets omitted
+    buckets: Vec<u64>,
+}
+
+#[derive(Serialize)]
+struct Snapshot {
+    ts: String,
+    pid: u32,
+    uptime_s: u64,
+    version: &'static str,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    hung_obs_call: Option<String>,
+    spans: BTreeMap<String, HistogramSnapshot>,
+    obs_calls: BTreeMap<String, HistogramSnapshot>,
+    counters: BTreeMap<String, u64>,
+}
+
+/// Record the process start time (snapshot `uptime_s` counts from here)
+pub fn init() {
+    process_start();
+}
+
+fn process_start() -> &'static Instant {
+    static START: OnceLock<Instant> = OnceLock::new();
+    START.get_or_init(Instant::now)
+}
+
+fn bucket_index(us: u64) -> usize {
+    if us == 0 {
+        0
+    } else {
+        (63 - us.leading_zeros() as usize).min(BUCKETS - 1)
+    }
+}
+
+/// Upper bound (µs) of the bucket holding quantile `q`
+fn quantile_upper_bound(buckets: &[u64], count: u64, q: f64) -> u64 {
+    if count == 0 {
+        return 0;
+    }
+    let target = ((count as f64) * q).ceil().max(1.0) as u64;
+    let mut seen = 0;
+    for (i, &n) in buckets.iter().enumerate() {
+        seen += n;
+        if seen >= target {
+            return (1u64 << (i + 1)) - 1;
+        }
+    }
+    u64::MAX
+}
+
+fn trim_trailing_zeros(mut buckets: Vec<u64>) -> Vec<u64> {
+    while buckets.last() == Some(&0) {
+        buckets.pop();
+    }
+    buckets
+}
+
+/// Today's snapshot file in the log directory
+fn snapshot_path() -> Option<PathBuf> {
+    let dir = crate::logging::get_log_dir().ok()?;
+    Some(dir.join(format!(
+        "{}{}.log",
+        METRICS_FILE_PREFIX,
+        chrono::Local::now().format("%Y-%m-%d")
+    )))
+}
+
+fn append_snapshot(snapshot: &Snapshot) {
+    let Some(path) = snapshot_path() else {
+        return;
+    };
+    let line = match serde_json::to_string(snapshot) {
+        Ok(line) => line,
+        Err(e) => {
+            warn!("Failed to serialize metrics snapshot: {}", e);
+            return;
+        }
+    };
+    let result = std::fs::OpenOptions::new()
+        .create(true)
+        .append(true)
+        .open(&path)
+        .and_then(|mut f| writeln!(f, "{}", line));
+    if let Err(e) = result {
+        warn!("Failed to write metrics snapshot {:?}: {}", path, e);
+    }
+}
+
+/// Append a snapshot if anything was recorded since the last call. Blocking
+/// file I/O; small enough that callers needn't offload it.
+pub fn write_snapshot_if_changed() {
+    static LAST_ACTIVITY: AtomicU64 = AtomicU64::new(0);
+    let activity = metrics().activity();
+    if LAST_ACTIVITY.swap(activity, Ordering::Relaxed) == activity {
+        return;
+    }
+    append_snapshot(&metrics().snapshot(None));
+}
+
+/// Append a final snapshot naming the OBS call the watchdog is about to
+/// restart the process for.
+pub fn write_hung_obs_call_snapshot(description: &str) {
+    metrics().obs_watchdog_fired.inc();
+    append_snapshot(&metrics().snapshot(Some(description)));
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn buckets_and_quantiles() {
+        assert_eq!(bucket_index(0), 0);
+        assert_eq!(bucket_index(1), 0);
+        assert_eq!(bucket_index(1023), 9);
+        assert_eq!(bucket_index(1024), 10);
+        assert_eq!(bucket_index(u64::MAX), BUCKETS - 1);
+
+        let h = Histogram::new();
+        for _ in 0..99 {
+            h.record(Duration::from_micros(100));
+        }
+        h.record(Duration::from_secs(6));
+        let snap = h.snapshot();
+        assert_eq!(snap.n, 100);
+        assert_eq!(snap.max_us, 6_000_000);
+        assert_eq!(snap.p50_us, 127);
+        assert_eq!(snap.p99_us, 127);
+        assert_eq!(snap.buckets.len(), 23);
+        assert_eq!(quantile_upper_bound(&[1, 0, 1], 2, 1.0), 7);
+    }
+
+    #[test]
+    fn poll_ticks_alone_are_not_activity() {
+        let metrics = Metrics::new();
+        let idle = metrics.activity();
+        metrics.poll_frontmost_app.record(Duration::from_micros(50));
+        assert_eq!(metrics.activity(), idle);
+        metrics.rotate_segment.record(Duration::from_millis(5));
+        assert_ne!(metrics.activity(), idle);
+    }
+}
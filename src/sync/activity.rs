@@ -0,0 +1,251 @@
+//! Activity-driven video bitrate profile
+//!
+//! Most of a workday is a static screen, which a fixed bitrate records as
+//! generously as a burst of scrolling. With `adaptive_bitrate` on, the engine
+//! drops the encoder to `idle_bitrate_kbps` once input has been idle for
+//! `bitrate_idle_after_secs` and restores `active_bitrate_kbps` on the next
+//! input event. Every switch is logged as a `Metadata` event carrying the new
+//! bitrate, so training data can tell which stretches were encoded lean.
+//!
+//! Input alone misses content that moves on its own (a video playing while
+//! the user watches), so the encoder's output rate vetoes the idle profile
+//! when it runs at the idle budget. The veto only engages once the encoder has
+//! shown it is variable-rate (output well under target while active): a CBR
+//! encoder fills any budget, so its output says nothing about the screen.
+
+use std::time::Duration;
+use tokio::time::Instant;
+
+/// Window over which the encoder's output rate is measured
+const SAMPLE_WINDOW: Duration = Duration::from_secs(5);
+
+/// Output below this fraction of the active target marks the encoder as
+/// variable-rate (and the screen as quiet enough to go idle)
+const QUIET_FRACTION: f64 = 0.5;
+
+/// While idle, output at this fraction of the idle budget means the screen is
+/// changing faster than the idle bitrate can carry
+const BUSY_FRACTION: f64 = 0.9;
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum VideoProfile {
+    Active,
+    Idle,
+}
+
+/// Chooses the video bitrate from input activity and encoder output
+#[derive(Debug)]
+pub struct ActivityProfile {
+    active_kbps: u32,
+    idle_kbps: u32,
+    idle_after: Duration,
+    profile: VideoProfile,
+    last_input: Instant,
+    /// Encoder byte count at the start of the current measurement window
+    window_start: Option<(Instant, u64)>,
+    /// Output rate (Kbps) over the last complete window at the current bitrate
+    output_kbps: Option<u32>,
+    /// The encoder has undershot its active target, so its output tracks content
+    variable_rate: bool,
+}
+
+impl ActivityProfile {
+    pub fn new(active_kbps: u32, idle_kbps: u32, idle_after: Duration, now: Instant) -> Self {
+        Self {
+            active_kbps,
+            idle_kbps,
+            idle_after,
+            profile: VideoProfile::Active,
+            last_input: now,
+            window_start: None,
+            output_kbps: None,
+            variable_rate: false,
+        }
+    }
+
+    /// Bitrate for the current profile
+    pub fn kbps(&self) -> u32 {
+        match self.profile {
+            VideoProfile::Active => self.active_kbps,
+            VideoProfile::Idle => self.idle_kbps,
+        }
+    }
+
+    pub fn note_input(&mut self, now: Instant) {
+        self.last_input = now;
+    }
+
+    /// Re-evaluate the profile, returning the new one when it changes.
+    /// `total_bytes` reads the encoder's output counter and is only called
+    /// when a measurement window completes.
+    pub fn evaluate(
+        &mut self,
+        now: Instant,
+        total_bytes: impl FnOnce() -> Option<u64>,
+    ) -> Option<VideoProfile> {
+        let window_due = self.window_start.map_or(true, |(start, _)| {
+            now.duration_since(start) >= SAMPLE_WINDOW
+        });
+        if window_due {
+            self.sample_output(now, total_bytes());
+        }
+
+        let input_idle = now.duration_since(self.last_input) >= self.idle_after;
+        let next = match self.profile {
+            VideoProfile::Active => {
+                let screen_busy = self.variable_rate
+                    && self.output_kbps.map_or(true, |kbps| {
+                        f64::from(kbps) > f64::from(self.active_kbps) * QUIET_FRACTION
+                    });
+                if input_idle && !screen_busy {
+                    VideoProfile::Idle
+                } else {
+                    VideoProfile::Active
+                }
+            }
+            VideoProfile::Idle => {
+                let screen_busy = self.variable_rate
+                    && self.output_kbps.is_some_and(|kbps| {
+                        f64::from(kbps) >= f64::from(self.idle_kbps) * BUSY_FRACTION
+                    });
+                if input_idle && !screen_busy {
+                    VideoProfile::Idle
+                } else {
+                    VideoProfile::Active
+                }
+            }
+        };
+        if next == self.profile {
+            return None;
+        }
+        self.profile = next;
+        // Output measured at the old bitrate says nothing about the new one
+        self.output_kbps = None;
+        self.window_start = None;
+        Some(next)
+    }
+
+    fn sample_output(&mut self, now: Instant, total_bytes: Option<u64>) {
+        let Some(bytes) = total_bytes else {
+            self.window_start = None;
+            self.output_kbps = None;
+            return;
+        };
+        if let Some((start, start_bytes)) = self.window_start {
+            // A new output restarts its counter: drop the window rather than
+            // report a negative rate
+            self.output_kbps = bytes.checked_sub(start_bytes).map(|delta| {
+                let secs = now.duration_since(start).as_secs_f64().max(f64::EPSILON);
+                (delta as f64 * 8.0 / 1000.0 / secs) as u32
+            });
+            if self.profile == VideoProfile::Active
+                && self.output_kbps.is_some_and(|kbps| {
+                    f64::from(kbps) <= f64::from(self.active_kbps) * QUIET_FRACTION
+                })
+            {
+                self.variable_rate = true;
+            }
+        }
+        self.window_start = Some((now, bytes));
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const IDLE_AFTER: Duration = Duration::from_secs(10);
+
+    /// Bytes a `kbps` stream writes over `secs`
+    fn bytes(kbps: u64, secs: u64) -> u64 {
+        kbps * 1000 / 8 * secs
+    }
+
+    #[test]
+    fn drops_to_idle_after_quiet_input_and_recovers_on_input() {
+        let t0 = Instant::now();
+        let mut profile = ActivityProfile::new(6000, 1000, IDLE_AFTER, t0);
+
+        assert_eq!(profile.evaluate(t0 + Duration::from_secs(5), || None), None);
+        assert_eq!(
+            profile.evaluate(t0 + Duration::from_secs(10), || None),
+            Some(VideoProfile::Idle)
+        );
+        assert_eq!(profile.kbps(), 1000);
+
+        profile.note_input(t0 + Duration::from_secs(12));
+        assert_eq!(
+            profile.evaluate(t0 + Duration::from_secs(12), || None),
+            Some(VideoProfile::Active)
+        );
+        assert_eq!(profile.kbps(), 6000);
+    }
+
+    #[test]
+    fn cbr_output_does_not_veto_idle() {
+        // A CBR encoder writes its full target regardless of content
+        let t0 = Instant::now();
+        let mut profile = ActivityProfile::new(6000, 1000, IDLE_AFTER, t0);
+        let mut now = t0;
+        let mut total = 0;
+        let mut changed = None;
+        for _ in 0..3 {
+            now += SAMPLE_WINDOW;
+            total += bytes(6000, 5);
+            changed = changed.or(profile.evaluate(now, || Some(total)));
+        }
+        assert_eq!(changed, Some(VideoProfile::Idle));
+
+        now += SAMPLE_WINDOW;
+        total += bytes(1000, 5);
+        assert_eq!(profile.evaluate(now, || Some(total)), None);
+        now += SAMPLE_WINDOW;
+        total += bytes(1000, 5);
+        assert_eq!(profile.evaluate(now, || Some(total)), None);
+    }
+
+    #[test]
+    fn moving_content_holds_active_on_variable_rate_encoder() {
+        let t0 = Instant::now();
+        let mut profile = ActivityProfile::new(6000, 1000, IDLE_AFTER, t0);
+        let mut now = t0;
+        let mut total = 0;
+
+        // Static screen proves the encoder variable-rate, then a video starts
+        assert_eq!(profile.evaluate(now, || Some(total)), None);
+        now += SAMPLE_WINDOW;
+        total += bytes(500, 5);
+        assert_eq!(profile.evaluate(now, || Some(total)), None);
+        now += SAMPLE_WINDOW;
+        total += bytes(5000, 5);
+        assert_eq!(profile.evaluate(now, || Some(total)), None);
+        assert_eq!(profile.profile, VideoProfile::Active);
+
+        // The video stops: output falls and the idle profile applies
+        now += SAMPLE_WINDOW;
+        total += bytes(400, 5);
+        assert_eq!(
+            profile.evaluate(now, || Some(total)),
+            Some(VideoProfile::Idle)
+        );
+
+        // It resumes and saturates the idle budget: back to active
+        profile.evaluate(now, || Some(total));
+        now += SAMPLE_WINDOW;
+        total += bytes(1000, 5);
+        assert_eq!(
+            profile.evaluate(now, || Some(total)),
+            Some(VideoProfile::Active)
+        );
+    }
+
+    #[test]
+    fn restarted_output_counter_is_not_a_rate() {
+        let t0 = Instant::now();
+        let mut profile = ActivityProfile::new(6000, 1000, IDLE_AFTER, t0);
+        profile.evaluate(t0, || Some(bytes(6000, 60)));
+        profile.evaluate(t0 + SAMPLE_WINDOW, || Some(1000));
+        assert_eq!(profile.output_kbps, None);
+        assert!(!profile.variable_rate);
+    }
+}
@@ -8,39 +8,46 @@
 //! split into fixed-duration segments that are uploaded and deleted
 //! immediately to minimize storage overhead.
 
-use anyhow::Result;
-use serde::{Deserialize, Serialize};
+use anyhow::{Context, Result};
 use std::cmp::Ordering;
 use std::collections::BinaryHeap;
 use std::hash::{Hash, Hasher};
-use std::path::PathBuf;
-use std::sync::atomic::{AtomicBool, Ordering as AtomicOrdering};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering as AtomicOrdering};
 use std::sync::Arc;
+#[cfg(all(target_os = "macos", not(no_tray)))]
+use std::sync::{Mutex, MutexGuard, OnceLock, PoisonError};
 use std::time::Duration;
 use tokio::sync::{broadcast, mpsc};
 use tokio::time::Instant;
 use tracing::{debug, error, info, warn};
 
 use crate::capture::{
-    get_display_uuid, get_frontmost_app, get_main_display_resolution, CaptureContext,
+    get_display_uuid, get_frontmost_app, get_main_display_resolution, AppInfo, CaptureContext,
     DisplayChangeEvent, DisplayMonitor, RecordingSession,
 };
-use crate::config::Config;
+use crate::config::{Config, SegmentRotation};
 use crate::data::{
-    CompletedChunk, ContextEvent, EventType, InputEvent, InputEventBuffer, MetadataEvent,
-    UNCAPTURED_APP_ID, UNKNOWN_APP_ID,
+    CompletedChunk, ContextEvent, EventJournal, EventType, InputEvent, InputEventBuffer,
+    KeylogFormat, MetadataEvent, UNCAPTURED_APP_ID, UNKNOWN_APP_ID,
 };
+use crate::input::policy::CapturePolicy;
 use crate::input::{create_input_backend, InputBackend};
 use crate::installer::permissions::describe_missing_permissions;
 use crate::ui::notifications::{
-    is_authorized as notifications_authorized, show_idle_paused_notification,
-    show_idle_resumed_notification, show_low_disk_notification,
+    is_authorized as notifications_authorized, show_disk_budget_paused_notification,
+    show_idle_paused_notification, show_idle_resumed_notification, show_low_disk_notification,
     show_permissions_missing_notification, show_recording_paused_notification,
     show_recording_resumed_notification, show_recording_started_notification,
     show_recording_stopped_notification, NotificationAction,
 };
 use crate::upload::Uploader;
 
+use super::activity::ActivityProfile;
+#[cfg(all(target_os = "macos", not(no_tray)))]
+use super::ledger::Ledger;
+use super::progressive::ProgressiveUploads;
+use super::store::{DiskPressure, SegmentState, SegmentStore, StoredSegment};
 use super::{EngineCommand, EngineStatus};
 
 /// Warn when free space on the recording volume drops below this. crowd-cast's
@@ -50,10 +57,20 @@ const LOW_DISK_THRESHOLD_BYTES: u64 = 2 * 1024 * 1024 * 1024; // 2 GiB
 /// How often to check free space (it's a syscall, so don't run it every poll).
 const DISK_CHECK_INTERVAL: Duration = Duration::from_secs(30);
 
+/// How long a completed segment is held before upload, so the panic button can
+/// delete recent recordings without a backend call. Progressive uploads hold
+/// back growing bytes for the same window.
+const UPLOAD_BUFFER_DELAY: Duration = Duration::from_secs(600);
+
 /// How often to re-check the captured source resolution for changes. Resolution
 /// changes are rare (app switch / window resize), so this need not run every poll.
 const SOURCE_RES_CHECK_INTERVAL: Duration = Duration::from_secs(1);
 
+/// Maximum age of a cached frontmost-app resolution while a push focus watcher
+/// is live (see `capture::focus_events`). Pushes invalidate the cache on every
+/// focus change; this only bounds how long a missed notification can go unseen.
+const FOCUS_SAFETY_POLL_INTERVAL: Duration = Duration::from_secs(2);
+
 /// Wall-clock gap between consecutive poll ticks above which we treat the process as having been
 /// frozen by a system suspend (Windows/Linux) — far longer than any real poll interval or hitch,
 /// so only a genuine sleep/resume trips it. On trip, an in-progress recording is restarted fresh.
@@ -181,9 +198,11 @@ const RESTART_HISTORY_WINDOW: Duration = Duration::from_secs(3600);
 /// open is no worse than recreating straight into the flux). Callers that RESTART
 /// must gate on `true`: restarting mid-flux is what crashed SCK init and
 /// crash-looped historically (#56), so during sustained flux they fall back to
-/// the non-crashing in-place path instead.
+/// the non-crashing in-place path instead. Startup also runs it alongside the
+/// OBS bootstrap when the system just booted or woke ([`booted_or_woke_within`]),
+/// so capture setup doesn't begin mid-flux after login or a wake.
 #[cfg(target_os = "macos")]
-async fn wait_for_displays_to_settle() -> bool {
+pub async fn wait_for_displays_to_settle() -> bool {
     use core_graphics::display::CGDisplay;
 
     let read_displays = || CGDisplay::active_displays().unwrap_or_default();
@@ -209,6 +228,42 @@ async fn wait_for_displays_to_settle() -> bool {
     false
 }
 
+/// How soon after boot or a wake startup still treats the display set as
+/// possibly in flux
+#[cfg(target_os = "macos")]
+pub const STARTUP_SETTLE_WINDOW: Duration = Duration::from_secs(120);
+
+/// Whether the system booted or woke within `window` (kernel `kern.boottime` /
+/// `kern.waketime`). An unreadable boot time counts as recent; a missing wake
+/// time means the system hasn't slept since boot.
+#[cfg(target_os = "macos")]
+pub fn booted_or_woke_within(window: Duration) -> bool {
+    use std::time::{SystemTime, UNIX_EPOCH};
+
+    fn sysctl_time(name: &std::ffi::CStr) -> Option<SystemTime> {
+        let mut tv: libc::timeval = unsafe { std::mem::zeroed() };
+        let mut len = std::mem::size_of::<libc::timeval>();
+        let rc = unsafe {
+            libc::sysctlbyname(
+                name.as_ptr(),
+                (&mut tv as *mut libc::timeval).cast(),
+                &mut len,
+                std::ptr::null_mut(),
+                0,
+            )
+        };
+        if rc != 0 || tv.tv_sec <= 0 {
+            return None;
+        }
+        Some(UNIX_EPOCH + Duration::new(tv.tv_sec as u64, tv.tv_usec as u32 * 1000))
+    }
+
+    let now = SystemTime::now();
+    let recent = |at: SystemTime| now.duration_since(at).map_or(true, |age| age < window);
+    sysctl_time(c"kern.boottime").map_or(true, recent)
+        || sysctl_time(c"kern.waketime").is_some_and(recent)
+}
+
 /// What the capture watchdog should do about a not-ready active source. Pure (no OBS, no
 /// I/O) so the decision is unit-tested directly — the caller supplies the facts.
 ///
@@ -248,21 +303,52 @@ fn dead_source_action(
     }
 }
 
+/// Open a marker ledger in the data dir, dropping the plain-text file it replaced
 #[cfg(all(target_os = "macos", not(no_tray)))]
-fn restart_history_path() -> Option<PathBuf> {
-    directories::ProjectDirs::from("dev", "crowd-cast", "agent")
-        .map(|p| p.data_dir().join("restart_history"))
+fn open_marker_ledger(name: &str, legacy: &str) -> Ledger<u64> {
+    let data_dir = directories::ProjectDirs::from("dev", "crowd-cast", "agent")
+        .map(|p| p.data_dir().to_path_buf());
+    if let Some(dir) = data_dir.as_ref() {
+        let _ = std::fs::remove_file(dir.join(legacy));
+    }
+    Ledger::open(data_dir.map(|d| d.join(name)))
+}
+
+/// Timestamps of recent restarts, keyed by the timestamp itself
+#[cfg(all(target_os = "macos", not(no_tray)))]
+fn restart_history() -> MutexGuard<'static, Ledger<u64>> {
+    static HISTORY: OnceLock<Mutex<Ledger<u64>>> = OnceLock::new();
+    HISTORY
+        .get_or_init(|| {
+            Mutex::new(open_marker_ledger(
+                "restart_history.jsonl",
+                "restart_history",
+            ))
+        })
+        .lock()
+        .unwrap_or_else(PoisonError::into_inner)
 }
 
 /// Per-app marker recording which apps we've restarted for to recover a dead capture source.
 /// Survives the exec() so the fresh process can tell "already restarted for THIS app, still
 /// dead" (→ OS-level wedge, alert) from a first failure (→ try one restart). Keyed per app so
 /// a *different* app recovering never clears a still-broken app's "already tried" memory —
-/// the fix for the partial-wedge restart loop. Stored as `app<TAB>unix_secs` lines.
+/// the fix for the partial-wedge restart loop. Stored as a ledger of `app -> unix_secs`;
+/// stale (>1h) entries are dropped on open so a long-past wedge never suppresses a genuinely
+/// new one for the same app.
 #[cfg(all(target_os = "macos", not(no_tray)))]
-fn capture_dead_restart_marker_path() -> Option<PathBuf> {
-    directories::ProjectDirs::from("dev", "crowd-cast", "agent")
-        .map(|p| p.data_dir().join("capture_dead_restart"))
+fn capture_dead_restarts() -> MutexGuard<'static, Ledger<u64>> {
+    static MARKERS: OnceLock<Mutex<Ledger<u64>>> = OnceLock::new();
+    MARKERS
+        .get_or_init(|| {
+            let mut markers =
+                open_marker_ledger("capture_dead_restart.jsonl", "capture_dead_restart");
+            let now = unix_now_secs();
+            markers.retain(|_, &ts| now.saturating_sub(ts) <= 3600);
+            Mutex::new(markers)
+        })
+        .lock()
+        .unwrap_or_else(PoisonError::into_inner)
 }
 
 #[cfg(all(target_os = "macos", not(no_tray)))]
@@ -273,109 +359,48 @@ fn unix_now_secs() -> u64 {
         .unwrap_or(0)
 }
 
-/// Read the marker as `{app -> unix_secs}`, dropping unparseable and stale (>1h) entries so a
-/// long-past wedge never suppresses a genuinely new one for the same app.
-#[cfg(all(target_os = "macos", not(no_tray)))]
-fn read_capture_dead_restart_map() -> std::collections::HashMap<String, u64> {
-    let mut map = std::collections::HashMap::new();
-    let Some(path) = capture_dead_restart_marker_path() else {
-        return map;
-    };
-    let now = unix_now_secs();
-    if let Ok(contents) = std::fs::read_to_string(&path) {
-        for line in contents.lines() {
-            let mut parts = line.splitn(2, '\t');
-            if let (Some(app), Some(ts)) = (parts.next(), parts.next()) {
-                if let Ok(ts) = ts.trim().parse::<u64>() {
-                    if now.saturating_sub(ts) <= 3600 {
-                        map.insert(app.to_string(), ts);
-                    }
-                }
-            }
-        }
-    }
-    map
-}
-
-#[cfg(all(target_os = "macos", not(no_tray)))]
-fn write_capture_dead_restart_map(map: &std::collections::HashMap<String, u64>) {
-    let Some(path) = capture_dead_restart_marker_path() else {
-        return;
-    };
-    if map.is_empty() {
-        let _ = std::fs::remove_file(&path);
-        return;
-    }
-    if let Some(parent) = path.parent() {
-        let _ = std::fs::create_dir_all(parent);
-    }
-    let body: String = map.iter().map(|(app, ts)| format!("{app}\t{ts}\n")).collect();
-    let _ = std::fs::write(&path, body);
-}
-
 /// How long ago we restarted for `app`, or `None` if we haven't (recently).
 #[cfg(all(target_os = "macos", not(no_tray)))]
 fn capture_dead_restart_age(app: &str) -> Option<Duration> {
-    let ts = *read_capture_dead_restart_map().get(app)?;
+    let ts = *capture_dead_restarts().get(app)?;
     Some(Duration::from_secs(unix_now_secs().saturating_sub(ts)))
 }
 
 /// Record that we just restarted for `app` (called just before the restart; survives exec).
 #[cfg(all(target_os = "macos", not(no_tray)))]
 fn note_capture_dead_restart(app: &str) {
-    let mut map = read_capture_dead_restart_map();
-    map.insert(app.to_string(), unix_now_secs());
-    write_capture_dead_restart_map(&map);
+    capture_dead_restarts().insert(app.to_string(), unix_now_secs());
 }
 
 /// Forget the restart marker for `app` (called once ITS source is healthy again — never
 /// because some other app recovered).
 #[cfg(all(target_os = "macos", not(no_tray)))]
 fn clear_capture_dead_restart(app: &str) {
-    let mut map = read_capture_dead_restart_map();
-    if map.remove(app).is_some() {
-        write_capture_dead_restart_map(&map);
-    }
+    capture_dead_restarts().remove(app);
 }
 
 /// Whether a restart is allowed under the exponential backoff, recording `now`
-/// when it is. Reads the restart-history marker file, drops timestamps older
-/// than the window, and requires the gap since the most recent restart to be at
-/// least `RESTART_BACKOFF_BASE * 2^(n-1)` (capped at [`RESTART_BACKOFF_MAX`])
-/// where `n` is the number of restarts in the window. The first restart in a
-/// quiet window fires immediately. Never refuses forever — a denied restart is
+/// when it is. Drops restart-history timestamps older than the window, and
+/// requires the gap since the most recent restart to be at least
+/// `RESTART_BACKOFF_BASE * 2^(n-1)` (capped at [`RESTART_BACKOFF_MAX`]) where
+/// `n` is the number of restarts in the window. The first restart in a quiet
+/// window fires immediately. Never refuses forever — a denied restart is
 /// merely deferred until the gap elapses (the watchdog keeps polling and the
 /// detach threshold stays crossed, so it retries). Persists across exec()s.
 ///
-/// Fails OPEN: on any file-I/O or path error the restart is allowed (a missing
-/// tray icon from an occasional extra restart is fine; being unable to restart
-/// at all is worse). Never panics.
+/// Fails OPEN: the history ledger logs and carries on through file-I/O errors,
+/// so at worst a restart isn't counted (a missing tray icon from an occasional
+/// extra restart is fine; being unable to restart at all is worse). Never panics.
 #[cfg(all(target_os = "macos", not(no_tray)))]
 fn restart_allowed_with_backoff() -> bool {
-    let Some(path) = restart_history_path() else {
-        return true; // fail open
-    };
-
-    let now = std::time::SystemTime::now()
-        .duration_since(std::time::UNIX_EPOCH)
-        .map(|d| d.as_secs())
-        .unwrap_or(0);
+    let now = unix_now_secs();
     let cutoff = now.saturating_sub(RESTART_HISTORY_WINDOW.as_secs());
 
-    // Read existing timestamps (one per line), dropping anything unparseable or
-    // older than the window. A missing file simply yields an empty history.
-    let mut recent: Vec<u64> = std::fs::read_to_string(&path)
-        .ok()
-        .map(|s| {
-            s.lines()
-                .filter_map(|l| l.trim().parse::<u64>().ok())
-                .filter(|&ts| ts >= cutoff)
-                .collect()
-        })
-        .unwrap_or_default();
+    let mut history = restart_history();
+    history.retain(|_, &ts| ts >= cutoff);
 
-    if let Some(&last) = recent.iter().max() {
-        let n = recent.len() as u32;
+    if let Some(last) = history.values().copied().max() {
+        let n = history.len() as u32;
         let required_gap = RESTART_BACKOFF_BASE
             .saturating_mul(1u64 << (n - 1).min(63))
             .min(RESTART_BACKOFF_MAX);
@@ -390,20 +415,7 @@ fn restart_allowed_with_backoff() -> bool {
         }
     }
 
-    recent.push(now);
-    if let Some(parent) = path.parent() {
-        let _ = std::fs::create_dir_all(parent);
-    }
-    let serialized = recent
-        .iter()
-        .map(|ts| ts.to_string())
-        .collect::<Vec<_>>()
-        .join("\n");
-    if let Err(e) = std::fs::write(&path, serialized) {
-        // Fail open: we couldn't persist the new timestamp, but still allow the
-        // restart (the backoff just won't count this one).
-        warn!("Failed to persist restart history: {}", e);
-    }
+    history.insert(now.to_string(), now);
     true
 }
 
@@ -477,12 +489,16 @@ where
                 "OBS call '{}' hung for {:?} — restarting process",
                 desc, OBS_CALL_TIMEOUT
             );
+            // Leave a metrics record of which call hung before the restart wipes the registry.
+            crate::metrics::write_hung_obs_call_snapshot(&desc);
             restart_process();
         }
     });
 
+    let started = std::time::Instant::now();
     let result = f();
     completed.store(true, AtomicOrdering::SeqCst);
+    crate::metrics::metrics().record_obs_call(description, started.elapsed());
     result
 }
 
@@ -556,59 +572,13 @@ fn write_uploads_paused(paused: bool) {
     let _ = std::fs::write(&path, if paused { "true" } else { "false" });
 }
 
-// --- Pending uploads manifest (persists upload queue across restarts) ---
-
-#[derive(Debug, Clone, Serialize, Deserialize)]
-struct PendingUploadEntry {
-    chunk_id: String,
-    session_id: String,
-    video_path: Option<PathBuf>,
-    input_path: PathBuf,
-    buffered_at_epoch_s: u64,
-}
-
-fn pending_uploads_path() -> Option<PathBuf> {
-    directories::ProjectDirs::from("dev", "crowd-cast", "agent")
-        .map(|p| p.data_dir().join("pending_uploads.json"))
-}
-
-fn read_pending_uploads() -> Vec<PendingUploadEntry> {
-    pending_uploads_path()
-        .and_then(|p| std::fs::read_to_string(&p).ok())
-        .and_then(|s| serde_json::from_str(&s).ok())
-        .unwrap_or_default()
-}
-
-fn write_pending_uploads(entries: &[PendingUploadEntry]) {
-    let Some(path) = pending_uploads_path() else {
-        return;
-    };
-    if let Some(parent) = path.parent() {
-        let _ = std::fs::create_dir_all(parent);
-    }
-    match serde_json::to_string(entries) {
-        Ok(json) => {
-            if let Err(e) = std::fs::write(&path, json) {
-                warn!("Failed to write pending uploads manifest: {}", e);
-            }
-        }
-        Err(e) => warn!("Failed to serialize pending uploads: {}", e),
-    }
-}
-
-fn append_pending_upload(entry: PendingUploadEntry) {
-    let mut entries = read_pending_uploads();
-    entries.push(entry);
-    write_pending_uploads(&entries);
-}
-
-fn remove_pending_upload(chunk_id: &str) {
-    let mut entries = read_pending_uploads();
-    let before = entries.len();
-    entries.retain(|e| e.chunk_id != chunk_id);
-    if entries.len() != before {
-        write_pending_uploads(&entries);
-    }
+/// Decode a persisted segment keylog, detecting its format from the file extension
+/// (segments written before a `keylog_format` change keep their original format).
+fn read_persisted_keylog(path: &Path) -> Result<(KeylogFormat, Vec<InputEvent>)> {
+    let format = KeylogFormat::from_path(path)
+        .with_context(|| format!("Unrecognized keylog file extension: {:?}", path))?;
+    let bytes = std::fs::read(path)?;
+    Ok((format, format.decode(&bytes)?))
 }
 
 #[derive(Clone, Copy, Debug, PartialEq, Eq)]
@@ -638,10 +608,8 @@ impl StatusKind {
 /// A completed segment ready for upload
 #[derive(Debug)]
 struct CompletedSegment {
-    /// The completed chunk with video path and events
+    /// The completed chunk with video and keylog paths
     chunk: CompletedChunk,
-    /// Path to the input events file
-    input_path: PathBuf,
 }
 
 #[derive(Debug)]
@@ -711,6 +679,14 @@ struct PendingCaptureWatchdog {
     attempt: u32,
 }
 
+/// Last frontmost-app resolution, tagged with the focus-change generation it was taken at
+#[derive(Debug, Clone)]
+struct FrontmostCache {
+    generation: u64,
+    resolved_at: Instant,
+    app: Option<AppInfo>,
+}
+
 #[derive(Debug)]
 struct PendingInputTransition {
     target_app: String,
@@ -718,6 +694,14 @@ struct PendingInputTransition {
 }
 
 const CAPTURING_STATUS_INTERVAL: Duration = Duration::from_secs(1);
+/// Most input events handled per wakeup before the select loop services its
+/// other branches again.
+const INPUT_DRAIN_BATCH: usize = 1024;
+/// How often buffered input is appended to the segment journal and fsync'd,
+/// bounding how much keylog a crash can lose.
+const JOURNAL_SYNC_INTERVAL: Duration = Duration::from_secs(5);
+/// How often a metrics snapshot is appended to the shipped metrics file (see `crate::metrics`)
+const METRICS_SNAPSHOT_INTERVAL: Duration = Duration::from_secs(240);
 const MAX_TRANSITION_INPUT_EVENTS: usize = 512;
 
 /// The synchronization engine coordinates recording and input capture
@@ -731,18 +715,30 @@ pub struct SyncEngine {
     /// Shared secure-input gate consulted by the input backend; flips on while a
     /// password field is focused (Linux). See src/input/secure/.
     secure_state: Arc<crate::input::secure::SecureInputState>,
+    /// `[input]` capture flags shared with the input backend, which filters at the source
+    #[cfg_attr(not(target_os = "linux"), allow(dead_code))]
+    capture_policy: Arc<CapturePolicy>,
     /// Command receiver
     cmd_rx: mpsc::Receiver<EngineCommand>,
     /// Status broadcaster
     status_tx: broadcast::Sender<EngineStatus>,
     /// Input event buffer
     event_buffer: InputEventBuffer,
+    /// Append-only journal of events already drained from `event_buffer` in
+    /// the current segment, with the segment ID it belongs to
+    event_journal: Option<(String, EventJournal)>,
+    /// When the journal was last appended to and fsync'd
+    last_journal_sync: Instant,
+    /// Input events dropped because a capture thread's ring was full
+    dropped_input_events: Arc<AtomicU64>,
     /// Whether input capture is currently enabled
     capture_enabled: bool,
     /// Whether recording is currently paused (both video and keylog)
     is_paused: bool,
     /// Last known frontmost app
     last_frontmost_app: Option<String>,
+    /// Cached frontmost resolution reused while a push focus watcher is live
+    frontmost_cache: Option<FrontmostCache>,
     /// Current recording session
     current_session: Option<RecordingSession>,
     /// OBS timestamp at recording start (nanoseconds). Shifted forward on resume from a
@@ -767,6 +763,8 @@ pub struct SyncEngine {
     /// Buffer for completed segments — held for 10 minutes before uploading
     /// so the panic button can delete recent recordings without a backend call.
     upload_buffer: std::collections::VecDeque<(Instant, CompletedSegment)>,
+    /// Early uploads of the recording and buffered segments (`progressive_upload`)
+    progressive: Option<ProgressiveUploads>,
     /// Uploader instance
     uploader: Uploader,
     /// Segment duration in seconds (cached from config)
@@ -814,6 +812,17 @@ pub struct SyncEngine {
     /// every code path that starts/stops recording (including display recovery)
     /// automatically gets the timer in the right state.
     segment_timer: Option<tokio::time::Interval>,
+    /// Split-file rotation: when the pending file split was requested. The
+    /// segment closes once the output reports the switch (see
+    /// `finish_segment_split`).
+    segment_split_requested_at: Option<Instant>,
+    /// Adaptive bitrate controller (`recording.adaptive_bitrate`)
+    video_profile: Option<ActivityProfile>,
+    /// Video bitrate last applied to the encoder (Kbps), or 0 while it encodes at
+    /// constant quality
+    video_bitrate_kbps: u32,
+    /// The encoder turned out not to be bitrate-controlled; stop retargeting it
+    video_bitrate_fixed: bool,
     /// Input events buffered while waiting for a tracked app's video to become ready
     pending_input_transition: Option<PendingInputTransition>,
     /// Last application context emitted into the raw event stream
@@ -863,6 +872,12 @@ pub struct SyncEngine {
     display_resolution: (u32, u32),
     /// Whether we've already warned about low disk space (re-armed once it recovers)
     low_disk_warned: bool,
+    /// Index of local segments and their upload state, shared with the upload task
+    segment_store: Arc<SegmentStore>,
+    /// Disk budget pressure at the last check
+    disk_pressure: DiskPressure,
+    /// Recording is paused because the disk budget is exhausted
+    disk_paused: bool,
     /// Last time we checked free disk space (throttles the syscall)
     last_disk_check: Instant,
     /// Native resolution of the captured source at the last metadata emit, used to
@@ -879,7 +894,7 @@ impl SyncEngine {
     /// Create a new sync engine
     pub fn new(
         config: Config,
-        capture_ctx: CaptureContext,
+        mut capture_ctx: CaptureContext,
         cmd_rx: mpsc::Receiver<EngineCommand>,
         status_tx: broadcast::Sender<EngineStatus>,
         notification_rx: mpsc::UnboundedReceiver<NotificationAction>,
@@ -894,6 +909,28 @@ impl SyncEngine {
         let (upload_tx, upload_rx) = mpsc::unbounded_channel();
         let uploader = Uploader::new(&config, auth);
         let segment_duration_secs = config.recording.segment_duration_secs;
+        capture_ctx
+            .set_split_file_rotation(config.recording.segment_rotation == SegmentRotation::Split);
+        capture_ctx.set_auto_hardware_encoder(config.recording.auto_hardware_encoder);
+        let progressive = (config.recording.progressive_upload
+            && config.upload.multipart_uploads
+            && uploader.is_configured())
+        .then(|| {
+            capture_ctx.set_fragmented_mp4(true);
+            ProgressiveUploads::new(UPLOAD_BUFFER_DELAY)
+        });
+        let segment_store = Arc::new(SegmentStore::open(
+            (config.recording.disk_budget_gb * 1024.0 * 1024.0 * 1024.0) as u64,
+        ));
+        let video_profile = config.recording.adaptive_bitrate.then(|| {
+            capture_ctx.set_bitrate_rate_control(config.recording.active_bitrate_kbps);
+            ActivityProfile::new(
+                config.recording.active_bitrate_kbps,
+                config.recording.idle_bitrate_kbps,
+                Duration::from_secs(config.recording.bitrate_idle_after_secs),
+                Instant::now(),
+            )
+        });
         let delete_after_upload = config.upload.delete_after_upload;
 
         // Activity-gated capture settings
@@ -923,6 +960,8 @@ unintended app video."
         }
 
         let secure_state = Arc::new(crate::input::secure::SecureInputState::new());
+        let capture_policy = Arc::new(CapturePolicy::new(config.input.capture_policy()));
+        let motion_window = Duration::from_millis(config.input.motion_coalesce_ms);
 
         // Record the real display resolution into segment metadata (input coordinates are
         // normalized against it downstream). Linux fails closed rather than recording a guessed
@@ -937,13 +976,18 @@ unintended app video."
             config,
             capture_ctx,
             secure_state: secure_state.clone(),
-            input_backend: create_input_backend(secure_state)?,
+            capture_policy: capture_policy.clone(),
+            input_backend: create_input_backend(capture_policy, secure_state, motion_window)?,
             cmd_rx,
             status_tx,
             event_buffer: InputEventBuffer::new(),
+            event_journal: None,
+            last_journal_sync: Instant::now(),
+            dropped_input_events: Arc::default(),
             capture_enabled: false,
             is_paused: false,
             last_frontmost_app: None,
+            frontmost_cache: None,
             current_session: None,
             recording_start_ns: None,
             pause_start_ns: None,
@@ -957,6 +1001,7 @@ unintended app video."
             delete_after_upload,
             uploads_paused: Arc::new(AtomicBool::new(read_uploads_paused())),
             upload_buffer: std::collections::VecDeque::new(),
+            progressive,
             upload_rx: Some(upload_rx),
             notification_rx: Some(notification_rx),
             last_recorded_action_time: Instant::now(),
@@ -975,6 +1020,10 @@ unintended app video."
             #[cfg(target_os = "macos")]
             last_canvas_convergence_check: None,
             segment_timer: None,
+            segment_split_requested_at: None,
+            video_bitrate_kbps: video_profile.as_ref().map_or(0, ActivityProfile::kbps),
+            video_bitrate_fixed: false,
+            video_profile,
             pending_input_transition: None,
             last_emitted_context: None,
             buffered_non_context_event_count: 0,
@@ -994,6 +1043,9 @@ unintended app video."
             last_alive_target: None,
             display_resolution,
             low_disk_warned: false,
+            segment_store,
+            disk_pressure: DiskPressure::Normal,
+            disk_paused: false,
             last_disk_check: Instant::now(),
             last_logged_source_dims: None,
             last_logged_active_display: None,
@@ -1060,33 +1112,66 @@ unintended app video."
         }
     }
 
-    /// Buffer a completed segment for delayed upload (10-minute hold).
+    /// Index a completed segment in the disk-budgeted store and, when an
+    /// uploader is configured, buffer it for delayed upload (10-minute hold).
+    /// Local-only segments are indexed too, as evictable `Local` entries, so
+    /// the disk budget sees them without pinning them forever.
     fn buffer_segment_for_upload(&mut self, segment: CompletedSegment, segment_id: String) {
-        if self.uploader.is_configured() {
+        let configured = self.uploader.is_configured();
+        self.segment_store.insert(StoredSegment {
+            chunk_id: segment.chunk.chunk_id.clone(),
+            session_id: segment.chunk.session_id.clone(),
+            video_path: segment.chunk.video_path.clone(),
+            input_path: segment.chunk.keylog_path.clone(),
+            buffered_at_epoch_s: std::time::SystemTime::now()
+                .duration_since(std::time::UNIX_EPOCH)
+                .unwrap_or_default()
+                .as_secs(),
+            state: if configured {
+                SegmentState::Pending
+            } else {
+                SegmentState::Local
+            },
+            bytes: 0,
+        });
+        if configured {
             info!("Buffering segment {} for delayed upload", segment_id);
-            append_pending_upload(PendingUploadEntry {
-                chunk_id: segment.chunk.chunk_id.clone(),
-                session_id: segment.chunk.session_id.clone(),
-                video_path: segment.chunk.video_path.clone(),
-                input_path: segment.input_path.clone(),
-                buffered_at_epoch_s: std::time::SystemTime::now()
-                    .duration_since(std::time::UNIX_EPOCH)
-                    .unwrap_or_default()
-                    .as_secs(),
-            });
             self.upload_buffer.push_back((Instant::now(), segment));
+        } else {
+            debug!("Indexed segment {} (no uploader configured)", segment_id);
         }
     }
 
     /// Graduate buffered segments older than 10 minutes to the upload task.
     fn graduate_upload_buffer(&mut self) {
-        const UPLOAD_BUFFER_DELAY: Duration = Duration::from_secs(600);
         let now = Instant::now();
 
-        while let Some((created_at, _)) = self.upload_buffer.front() {
+        let current_id = self.current_segment_id();
+        if let Some(progressive) = self.progressive.as_mut() {
+            if !self.uploads_paused.load(AtomicOrdering::SeqCst) {
+                let recording = self
+                    .current_session
+                    .as_ref()
+                    .map(|s| (current_id.as_str(), s.output_path.as_path()));
+                let buffered = self.upload_buffer.iter().filter_map(|(_, segment)| {
+                    let chunk = &segment.chunk;
+                    Some((chunk.chunk_id.as_str(), chunk.video_path.as_deref()?))
+                });
+                progressive.poll(&self.uploader, recording.into_iter().chain(buffered), now);
+            }
+        }
+
+        while let Some((created_at, segment)) = self.upload_buffer.front() {
             if now.duration_since(*created_at) >= UPLOAD_BUFFER_DELAY {
-                let (_, segment) = self.upload_buffer.pop_front().unwrap();
                 let chunk_id = segment.chunk.chunk_id.clone();
+                if let Some(progressive) = self.progressive.as_mut() {
+                    // Let an early upload of this segment settle before the final one
+                    if progressive.is_busy(&chunk_id) {
+                        break;
+                    }
+                    progressive.finish(&chunk_id);
+                }
+                let (_, segment) = self.upload_buffer.pop_front().unwrap();
                 info!("Graduating segment {} from upload buffer", chunk_id);
                 if let Err(e) = self.upload_tx.send(UploadMessage::Segment(segment)) {
                     error!("Failed to send graduated segment: {}", e);
@@ -1103,6 +1188,9 @@ unintended app video."
         if count > 0 {
             info!("Flushing {} buffered segment(s) to upload queue", count);
         }
+        if let Some(progressive) = self.progressive.as_mut() {
+            progressive.stop_all();
+        }
         while let Some((_, segment)) = self.upload_buffer.pop_front() {
             let chunk_id = segment.chunk.chunk_id.clone();
             if let Err(e) = self.upload_tx.send(UploadMessage::Segment(segment)) {
@@ -1111,12 +1199,16 @@ unintended app video."
         }
     }
 
-    /// Panic: delete all buffered segments from disk and clear the manifest.
+    /// Panic: delete all buffered segments from disk and drop pending segments
+    /// from the store.
     fn purge_upload_buffer(&mut self) {
         let count = self.upload_buffer.len();
         if count > 0 {
             info!("Panic: deleting {} buffered segment(s)", count);
         }
+        if let Some(progressive) = self.progressive.as_mut() {
+            progressive.discard_all();
+        }
         while let Some((_, segment)) = self.upload_buffer.pop_front() {
             if let Some(ref video_path) = segment.chunk.video_path {
                 if let Err(e) = std::fs::remove_file(video_path) {
@@ -1125,13 +1217,14 @@ unintended app video."
                     debug!("Deleted video: {:?}", video_path);
                 }
             }
-            if let Err(e) = std::fs::remove_file(&segment.input_path) {
-                warn!("Failed to delete input {:?}: {}", segment.input_path, e);
+            let input_path = &segment.chunk.keylog_path;
+            if let Err(e) = std::fs::remove_file(input_path) {
+                warn!("Failed to delete input {:?}: {}", input_path, e);
             } else {
-                debug!("Deleted input: {:?}", segment.input_path);
+                debug!("Deleted input: {:?}", input_path);
             }
         }
-        write_pending_uploads(&[]);
+        self.segment_store.clear_pending();
     }
 
     fn active_video_target(&self) -> Option<&str> {
@@ -1555,8 +1648,34 @@ unintended app video."
         Ok(desired_target)
     }
 
+    /// The frontmost app, served from the last resolution while a push focus watcher is live
+    /// and no focus change has been signalled since. Without a watcher every call queries the
+    /// OS, as before; with one, per-tick polls and per-keystroke capture checks stop paying for
+    /// a foreground query each.
+    fn resolve_frontmost(&mut self) -> Option<AppInfo> {
+        // Read the generation BEFORE querying: a change signalled mid-query bumps it, so the
+        // next call re-resolves instead of trusting a result that may predate the switch.
+        let generation = crate::capture::focus_events::generation();
+        if crate::capture::focus_events::is_push_active() {
+            if let Some(cache) = &self.frontmost_cache {
+                if cache.generation == generation
+                    && cache.resolved_at.elapsed() < FOCUS_SAFETY_POLL_INTERVAL
+                {
+                    return cache.app.clone();
+                }
+            }
+        }
+        let app = get_frontmost_app();
+        self.frontmost_cache = Some(FrontmostCache {
+            generation,
+            resolved_at: Instant::now(),
+            app: app.clone(),
+        });
+        app
+    }
+
     fn frontmost_capture_state(&mut self) -> (Option<String>, bool) {
-        let frontmost = get_frontmost_app();
+        let frontmost = self.resolve_frontmost();
         let bundle_id = frontmost.as_ref().map(|a| a.bundle_id.clone());
         let should_capture = match bundle_id.as_deref() {
             Some(id) => self.config.should_capture_app(id),
@@ -1614,6 +1733,7 @@ unintended app video."
         let Some(pending) = self.pending_app_switch.take() else {
             return;
         };
+        let _timer = crate::metrics::metrics().apply_pending_app_switch.start();
 
         let (frontmost_app, should_capture) = self.frontmost_capture_state();
         let desired_target =
@@ -1889,9 +2009,17 @@ unintended app video."
         self.buffered_non_context_event_count
     }
 
+    fn capturing_status(&self) -> EngineStatus {
+        EngineStatus::Capturing {
+            event_count: self.buffered_input_event_count(),
+            dropped_events: self.dropped_input_events.load(AtomicOrdering::Relaxed),
+        }
+    }
+
     fn buffer_input_event(&mut self, event: InputEvent) {
         self.event_buffer.push(event);
         self.buffered_non_context_event_count += 1;
+        crate::metrics::metrics().events_buffered.inc();
     }
 
     fn clear_event_buffer(&mut self) {
@@ -1999,6 +2127,7 @@ unintended app video."
                 displays,
                 platform: std::env::consts::OS.to_string(),
                 capture_mode: self.capture_ctx.capture_mode().to_string(),
+                video_bitrate_kbps: self.video_bitrate_kbps,
             }),
         });
     }
@@ -2031,6 +2160,64 @@ unintended app video."
         }
     }
 
+    /// Adaptive bitrate: retarget the encoder when the activity profile changes,
+    /// logging the new bitrate in a metadata event at the switch.
+    fn update_video_profile(&mut self) {
+        if self.current_session.is_none() || self.is_paused {
+            return;
+        }
+        let Some(profile) = self.video_profile.as_mut() else {
+            return;
+        };
+        let capture_ctx = &self.capture_ctx;
+        let Some(next) = profile.evaluate(Instant::now(), || capture_ctx.recording_total_bytes())
+        else {
+            return;
+        };
+        debug!("Video profile: {:?}", next);
+        self.retarget_video_bitrate();
+    }
+
+    /// Apply the bitrate the activity profile and disk pressure call for: the
+    /// profile's, capped while the disk budget is under pressure. Logged in a
+    /// metadata event at the switch.
+    fn retarget_video_bitrate(&mut self) {
+        if self.video_bitrate_fixed {
+            return;
+        }
+        let profile_kbps = self.video_profile.as_ref().map(ActivityProfile::kbps);
+        let pressure_kbps = (self.disk_pressure >= DiskPressure::Compress)
+            .then_some(self.config.recording.disk_pressure_bitrate_kbps);
+        let kbps = match (profile_kbps, pressure_kbps) {
+            (Some(profile), Some(cap)) => profile.min(cap),
+            (profile, cap) => match profile.or(cap) {
+                Some(kbps) => kbps,
+                // Constant quality, and nothing asks for a bitrate
+                None => return,
+            },
+        };
+        if kbps == self.video_bitrate_kbps {
+            return;
+        }
+        let applied = obs_call_with_watchdog(
+            || tokio::task::block_in_place(|| self.capture_ctx.set_video_bitrate(kbps)),
+            "retarget_video_bitrate: set_video_bitrate",
+        );
+        match applied {
+            Ok(true) => {
+                info!("Video bitrate: {} Kbps", kbps);
+                self.video_bitrate_kbps = kbps;
+                self.emit_metadata_event(self.current_capture_timestamp_us());
+            }
+            Ok(false) => {
+                warn!("Encoder is not bitrate-controlled; leaving its bitrate alone");
+                self.video_bitrate_fixed = true;
+                self.video_profile = None;
+            }
+            Err(e) => warn!("Failed to set video bitrate to {} Kbps: {}", kbps, e),
+        }
+    }
+
     fn emit_context_snapshot(&mut self, should_capture: bool, timestamp_us: u64) {
         let app_id = self.current_context_app_id(should_capture).to_string();
         self.push_context_event(app_id, timestamp_us);
@@ -2052,19 +2239,20 @@ unintended app video."
 
     /// Spawn background task for uploading completed segments.
     ///
-    /// Uploads run concurrently (up to MAX_CONCURRENT_UPLOADS) so that one
-    /// slow or failing upload does not block the entire pipeline.
+    /// Uploads run concurrently so that one slow or failing upload does not
+    /// block the entire pipeline. How many run at once, when they may start,
+    /// and how fast they send is up to the uploader's `UploadScheduler`.
     fn spawn_upload_task(
         mut upload_rx: mpsc::UnboundedReceiver<UploadMessage>,
         uploader: Uploader,
         delete_after_upload: bool,
         uploads_paused: Arc<AtomicBool>,
+        segment_store: Arc<SegmentStore>,
     ) {
         const BASE_RETRY_BACKOFF: Duration = Duration::from_secs(30);
         const MAX_RETRY_BACKOFF: Duration = Duration::from_secs(2 * 60 * 60);
         const MAX_RETRY_WINDOW: Duration = Duration::from_secs(2 * 60 * 60);
         const UPLOAD_PAUSE_NOTIFY_THRESHOLD: usize = 50;
-        const MAX_CONCURRENT_UPLOADS: usize = 3;
 
         tokio::spawn(async move {
             let mut retry_queue: BinaryHeap<RetryEntry> = BinaryHeap::new();
@@ -2072,9 +2260,6 @@ unintended app video."
             let mut active_session_id: Option<String> = None;
             let mut upload_pause_notified = false;
 
-            // Semaphore limits concurrent uploads
-            let semaphore = Arc::new(tokio::sync::Semaphore::new(MAX_CONCURRENT_UPLOADS));
-
             // Channel for receiving upload results from spawned tasks
             let (result_tx, mut result_rx) = mpsc::unbounded_channel::<UploadResult>();
 
@@ -2097,7 +2282,7 @@ unintended app video."
                     .min(MAX_RETRY_BACKOFF)
             }
 
-            /// Spawn a concurrent upload task. Acquires a semaphore permit,
+            /// Spawn a concurrent upload task. Waits for a scheduler slot,
             /// performs the upload, cleans up files, and sends the result back.
             fn spawn_upload(
                 uploader: Uploader,
@@ -2106,15 +2291,32 @@ unintended app video."
                 attempts: u32,
                 first_failed_at: Option<Instant>,
                 delete_after_upload: bool,
-                semaphore: Arc<tokio::sync::Semaphore>,
                 result_tx: mpsc::UnboundedSender<UploadResult>,
             ) {
                 tokio::spawn(async move {
-                    // Acquire a permit — blocks if MAX_CONCURRENT_UPLOADS are in flight
-                    let _permit = semaphore.acquire().await.expect("semaphore closed");
+                    // Smallest segments first among those waiting for a slot
+                    let file_len = |path: PathBuf| async move {
+                        tokio::fs::metadata(path).await.map_or(0, |m| m.len())
+                    };
+                    let mut size = file_len(segment.chunk.keylog_path.clone()).await;
+                    if let Some(video_path) = segment.chunk.video_path.clone() {
+                        size += file_len(video_path).await;
+                    }
+                    let scheduler = uploader.scheduler().clone();
+                    let _slot = scheduler.acquire(size).await;
 
                     let result = async {
-                        uploader.upload(&segment.chunk).await?;
+                        let stats = {
+                            let _timer = crate::metrics::metrics().upload_segment.start();
+                            uploader.upload(&segment.chunk).await
+                        };
+                        match stats {
+                            Ok(stats) => scheduler.record_success(stats),
+                            Err(e) => {
+                                scheduler.record_failure();
+                                return Err(e);
+                            }
+                        }
 
                         if delete_after_upload {
                             if let Some(ref video_path) = segment.chunk.video_path {
@@ -2124,13 +2326,11 @@ unintended app video."
                                     debug!("Deleted video file: {:?}", video_path);
                                 }
                             }
-                            if let Err(e) = tokio::fs::remove_file(&segment.input_path).await {
-                                warn!(
-                                    "Failed to delete input file {:?}: {}",
-                                    segment.input_path, e
-                                );
+                            let input_path = &segment.chunk.keylog_path;
+                            if let Err(e) = tokio::fs::remove_file(input_path).await {
+                                warn!("Failed to delete input file {:?}: {}", input_path, e);
                             } else {
-                                debug!("Deleted input file: {:?}", segment.input_path);
+                                debug!("Deleted input file: {:?}", input_path);
                             }
                         }
 
@@ -2197,7 +2397,6 @@ unintended app video."
                                     0,
                                     None,
                                     delete_after_upload,
-                                    semaphore.clone(),
                                     result_tx.clone(),
                                 );
                             }
@@ -2210,9 +2409,10 @@ unintended app video."
                         match result {
                             Ok(()) => {
                                 info!("Successfully uploaded segment {}", chunk_id);
-                                remove_pending_upload(&chunk_id);
+                                segment_store.mark_uploaded(&chunk_id, delete_after_upload);
                             }
                             Err(e) => {
+                                crate::metrics::metrics().upload_failures.inc();
                                 let attempt = attempts + 1;
                                 error!(
                                     "Failed to upload segment {}: {:#} (attempt {}, retry queue: {})",
@@ -2256,6 +2456,7 @@ unintended app video."
                         if uploads_paused.load(AtomicOrdering::SeqCst) {
                             continue;
                         }
+                        let mut due: Vec<RetryItem> = Vec::new();
                         while retry_queue.peek().map(|entry| entry.next_attempt_at <= now).unwrap_or(false) {
                             let entry = retry_queue.pop().expect("retry queue peeked");
                             let item = entry.item;
@@ -2266,7 +2467,8 @@ unintended app video."
                                     "Giving up on segment {} after {} attempts (retry window exceeded)",
                                     chunk_id, item.attempts
                                 );
-                                remove_pending_upload(&chunk_id);
+                                segment_store.remove(&chunk_id);
+                                crate::upload::forget_multipart_upload(&chunk_id);
                                 continue;
                             }
 
@@ -2275,24 +2477,213 @@ unintended app video."
                                 chunk_id,
                                 item.attempts + 1
                             );
+                            crate::metrics::metrics().upload_retries.inc();
+                            due.push(item);
+                        }
 
-                            spawn_upload(
-                                uploader.clone(),
-                                item.segment,
-                                chunk_id,
-                                item.attempts,
-                                Some(item.first_failed_at),
-                                delete_after_upload,
-                                semaphore.clone(),
-                                result_tx.clone(),
-                            );
+                        // Several segments due at once (typically after uploads
+                        // resume or the network comes back): presign them all
+                        // in one batch before the uploads start.
+                        if due.is_empty() {
+                            continue;
                         }
+                        let uploader = uploader.clone();
+                        let result_tx = result_tx.clone();
+                        tokio::spawn(async move {
+                            if due.len() > 1 {
+                                let chunks: Vec<&CompletedChunk> =
+                                    due.iter().map(|item| &item.segment.chunk).collect();
+                                uploader.prefetch_chunk_presigns(&chunks).await;
+                            }
+                            for item in due {
+                                let chunk_id = item.segment.chunk.chunk_id.clone();
+                                spawn_upload(
+                                    uploader.clone(),
+                                    item.segment,
+                                    chunk_id,
+                                    item.attempts,
+                                    Some(item.first_failed_at),
+                                    delete_after_upload,
+                                    result_tx.clone(),
+                                );
+                            }
+                        });
                     }
                 }
             }
         });
     }
 
+    /// Rebuild keylogs from segment journals a crash left behind (a clean
+    /// rotation or stop always consumes its journal). Each one is written out
+    /// in the configured keylog format, paired with its recording if that
+    /// survived, and indexed as pending so it is queued with the rest of the
+    /// pending uploads; the journal is deleted afterwards.
+    async fn recover_orphaned_journals(&self) {
+        let Ok(mut entries) = tokio::fs::read_dir(&self.output_dir).await else {
+            return;
+        };
+        let mut recovered = 0;
+        while let Ok(Some(entry)) = entries.next_entry().await {
+            let path = entry.path();
+            let Some(segment_id) = path
+                .file_name()
+                .and_then(|name| name.to_str())
+                .and_then(|name| name.strip_prefix("input_")?.strip_suffix(".journal"))
+                .map(str::to_string)
+            else {
+                continue;
+            };
+            match self.recover_orphaned_journal(&path, &segment_id).await {
+                Ok(true) => recovered += 1,
+                Ok(false) => {}
+                Err(e) => {
+                    // Left in place so a later start can try again
+                    warn!("Failed to recover event journal {:?}: {:#}", path, e);
+                    continue;
+                }
+            }
+            if let Err(e) = tokio::fs::remove_file(&path).await {
+                warn!("Failed to delete event journal {:?}: {}", path, e);
+            }
+        }
+        if recovered > 0 {
+            info!(
+                "Rebuilt {} segment keylog(s) from interrupted journals",
+                recovered
+            );
+        }
+    }
+
+    /// Returns `false` when the journal held nothing worth keeping
+    async fn recover_orphaned_journal(&self, path: &Path, segment_id: &str) -> Result<bool> {
+        let events = EventJournal::read_all(path).await?;
+        if events.is_empty() {
+            return Ok(false);
+        }
+        let start_time_us = events.first().map(|e| e.timestamp_us).unwrap_or(0);
+        let end_time_us = events.last().map(|e| e.timestamp_us).unwrap_or(0);
+        let event_count = events.len();
+        let keylog_path = self.persist_segment_keylog(segment_id, events).await?;
+
+        // Recorder extensions, see CaptureContext::generate_output_path
+        let video_path = ["mp4", "mov", "mkv", "flv", "ts"]
+            .iter()
+            .map(|ext| {
+                self.output_dir
+                    .join(format!("recording_{}.{}", segment_id, ext))
+            })
+            .find(|p| p.exists());
+        let session_id = segment_id
+            .rsplit_once("_seg")
+            .map_or(segment_id, |(session, _)| session);
+
+        debug!(
+            "Recovered {} events ({}..{} us) for segment {} from its journal",
+            event_count, start_time_us, end_time_us, segment_id
+        );
+        self.segment_store.insert(StoredSegment {
+            chunk_id: segment_id.to_string(),
+            session_id: session_id.to_string(),
+            video_path,
+            input_path: keylog_path,
+            buffered_at_epoch_s: std::time::SystemTime::now()
+                .duration_since(std::time::UNIX_EPOCH)
+                .unwrap_or_default()
+                .as_secs(),
+            state: if self.uploader.is_configured() {
+                SegmentState::Pending
+            } else {
+                SegmentState::Local
+            },
+            bytes: 0,
+        });
+        Ok(true)
+    }
+
+    /// Re-queue segments left pending by a previous session, dropping any whose
+    /// keylog is missing or unreadable from the store
+    fn recover_pending_segments(
+        pending: Vec<StoredSegment>,
+        segment_store: &SegmentStore,
+        upload_tx: &mpsc::UnboundedSender<UploadMessage>,
+    ) {
+        let mut recovered = 0;
+        let mut unrecoverable = std::collections::HashSet::new();
+        for entry in &pending {
+            let input_exists = entry.input_path.exists();
+            if !input_exists {
+                debug!(
+                    "Skipping orphaned segment {} (keylog missing)",
+                    entry.chunk_id
+                );
+                unrecoverable.insert(entry.chunk_id.clone());
+                continue;
+            }
+
+            let video_exists = entry
+                .video_path
+                .as_ref()
+                .map(|p| p.exists())
+                .unwrap_or(true);
+
+            // Decoded only to validate the file and recover its time range; the
+            // events are dropped again and the upload streams the file itself.
+            let (keylog_format, events) = match read_persisted_keylog(&entry.input_path) {
+                Ok(keylog) => keylog,
+                Err(e) => {
+                    warn!(
+                        "Failed to read events for segment {}: {}",
+                        entry.chunk_id, e
+                    );
+                    unrecoverable.insert(entry.chunk_id.clone());
+                    continue;
+                }
+            };
+
+            let start_time_us = events.first().map(|e| e.timestamp_us).unwrap_or(0);
+            let end_time_us = events.last().map(|e| e.timestamp_us).unwrap_or(0);
+
+            let chunk = CompletedChunk {
+                chunk_id: entry.chunk_id.clone(),
+                session_id: entry.session_id.clone(),
+                video_path: entry.video_path.clone().filter(|_| video_exists),
+                keylog_path: entry.input_path.clone(),
+                keylog_format,
+                event_count: events.len(),
+                start_time_us,
+                end_time_us,
+            };
+            drop(events);
+
+            let segment = CompletedSegment { chunk };
+
+            if let Err(e) = upload_tx.send(UploadMessage::Segment(segment)) {
+                error!(
+                    "Failed to re-queue recovered segment {}: {}",
+                    entry.chunk_id, e
+                );
+            } else {
+                recovered += 1;
+            }
+        }
+
+        if recovered > 0 {
+            info!(
+                "Recovered {} pending upload(s) from previous session",
+                recovered
+            );
+        }
+        if !unrecoverable.is_empty() {
+            // Remove entries for segments we couldn't recover
+            segment_store.retain(|e| !unrecoverable.contains(&e.chunk_id));
+            info!(
+                "Cleaned {} unrecoverable segment(s) from manifest",
+                unrecoverable.len()
+            );
+        }
+    }
+
     /// Run the engine main loop
     pub async fn run(&mut self) -> Result<()> {
         let session_id = self.config.session_id();
@@ -2305,6 +2696,7 @@ unintended app video."
                 self.uploader.clone(),
                 self.delete_after_upload,
                 self.uploads_paused.clone(),
+                self.segment_store.clone(),
             );
         }
 
@@ -2333,23 +2725,59 @@ unintended app video."
             }
         }
 
+        self.recover_orphaned_journals().await;
+
+        // Recover pending uploads from previous session. Validating each keylog means
+        // decoding it, which after a long outage is hundreds of files: do it off the
+        // engine thread so recording and input draining start without waiting on it.
+        if self.uploader.is_configured() {
+            let pending = self.segment_store.pending();
+            if !pending.is_empty() {
+                let segment_store = self.segment_store.clone();
+                let upload_tx = self.upload_tx.clone();
+                tokio::task::spawn_blocking(move || {
+                    Self::recover_pending_segments(pending, &segment_store, &upload_tx)
+                });
+            }
+        }
+
         // Take notification receiver for the main loop
         let mut notification_rx = self.notification_rx.take();
 
         // Ensure output directory exists
         std::fs::create_dir_all(&self.output_dir)?;
 
-        // Start input capture (events go to a channel)
-        let (input_tx, mut input_rx) = mpsc::unbounded_channel();
-        self.input_backend.start(input_tx.clone())?;
+        // Start input capture (each capture thread pushes into its own ring)
+        let (input_sink, input_rings) = crate::input::input_rings();
+        self.dropped_input_events = input_rings.dropped_counter();
+        self.input_backend.start(input_sink.clone())?;
+        let mut input_batch: Vec<InputEvent> = Vec::with_capacity(INPUT_DRAIN_BATCH);
+
+        // Append a metrics snapshot next to the logs for the shipper to pick up. Blocking
+        // file I/O, but one small append every few minutes.
+        {
+            let dropped = self.dropped_input_events.clone();
+            tokio::spawn(async move {
+                let mut interval = tokio::time::interval(METRICS_SNAPSHOT_INTERVAL);
+                interval.tick().await;
+                loop {
+                    interval.tick().await;
+                    crate::metrics::metrics()
+                        .events_dropped
+                        .set(dropped.load(AtomicOrdering::Relaxed));
+                    crate::metrics::write_snapshot_if_changed();
+                }
+            });
+        }
 
         // Secure-input gating (Linux: AT-SPI password-field detection). Updates
         // `secure_state` (read by the input backend) and injects Redacted markers into
-        // the input stream. No-op on other platforms / when disabled.
+        // the input stream. No-op on other platforms / when disabled. Markers are rare,
+        // so they get a small ring of their own, drained in order with the rest.
         if self.config.security.gating_enabled {
             crate::input::secure::spawn(
                 self.secure_state.clone(),
-                input_tx,
+                input_sink.register_with_capacity(crate::input::MARKER_RING_CAPACITY),
                 self.config.security.enable_accessibility,
             );
         }
@@ -2360,6 +2788,14 @@ unintended app video."
         // records full-screen (capture-all), with no app gating.
         #[cfg(target_os = "linux")]
         crate::capture::focus::ensure_started();
+        // Push notifications for focus changes, so app switches are handled as they happen
+        // rather than on the next poll tick; the poll then reuses that resolution (re-querying
+        // the OS only on a slow safety-net interval).
+        crate::capture::focus_events::ensure_started();
+        // Push notifications for window moves/resizes, so the per-poll monitor fit reuses the
+        // active window's geometry instead of re-reading it while nothing moves.
+        #[cfg(any(target_os = "macos", target_os = "linux"))]
+        crate::capture::geometry_events::ensure_started();
 
         // Main polling interval
         let poll_interval = Duration::from_millis(self.config.capture.poll_interval_ms);
@@ -2396,100 +2832,6 @@ unintended app video."
             }
         }
 
-        // Recover pending uploads from previous session
-        if self.uploader.is_configured() {
-            let pending = read_pending_uploads();
-            if !pending.is_empty() {
-                let mut recovered = 0;
-                let mut cleaned = 0;
-                for entry in &pending {
-                    let input_exists = entry.input_path.exists();
-                    if !input_exists {
-                        debug!(
-                            "Skipping orphaned segment {} (msgpack missing)",
-                            entry.chunk_id
-                        );
-                        cleaned += 1;
-                        continue;
-                    }
-
-                    let video_exists = entry
-                        .video_path
-                        .as_ref()
-                        .map(|p| p.exists())
-                        .unwrap_or(true);
-
-                    let events: Vec<InputEvent> =
-                        match std::fs::read(&entry.input_path).and_then(|bytes| {
-                            rmp_serde::from_slice(&bytes).map_err(|e| {
-                                std::io::Error::new(std::io::ErrorKind::InvalidData, e)
-                            })
-                        }) {
-                            Ok(events) => events,
-                            Err(e) => {
-                                warn!(
-                                    "Failed to read events for segment {}: {}",
-                                    entry.chunk_id, e
-                                );
-                                cleaned += 1;
-                                continue;
-                            }
-                        };
-
-                    let start_time_us = events.first().map(|e| e.timestamp_us).unwrap_or(0);
-                    let end_time_us = events.last().map(|e| e.timestamp_us).unwrap_or(0);
-
-                    let chunk = CompletedChunk {
-                        chunk_id: entry.chunk_id.clone(),
-                        session_id: entry.session_id.clone(),
-                        video_path: entry.video_path.clone().filter(|_| video_exists),
-                        events,
-                        start_time_us,
-                        end_time_us,
-                    };
-
-                    let segment = CompletedSegment {
-                        chunk,
-                        input_path: entry.input_path.clone(),
-                    };
-
-                    if let Err(e) = self.upload_tx.send(UploadMessage::Segment(segment)) {
-                        error!(
-                            "Failed to re-queue recovered segment {}: {}",
-                            entry.chunk_id, e
-                        );
-                    } else {
-                        recovered += 1;
-                    }
-                }
-
-                if recovered > 0 {
-                    info!(
-                        "Recovered {} pending upload(s) from previous session",
-                        recovered
-                    );
-                }
-                if cleaned > 0 {
-                    // Remove entries for segments we couldn't recover
-                    let valid: Vec<_> = pending
-                        .into_iter()
-                        .filter(|e| {
-                            e.input_path.exists()
-                                && std::fs::read(&e.input_path)
-                                    .and_then(|b| {
-                                        rmp_serde::from_slice::<Vec<InputEvent>>(&b).map_err(|e| {
-                                            std::io::Error::new(std::io::ErrorKind::InvalidData, e)
-                                        })
-                                    })
-                                    .is_ok()
-                        })
-                        .collect();
-                    write_pending_uploads(&valid);
-                    info!("Cleaned {} unrecoverable segment(s) from manifest", cleaned);
-                }
-            }
-        }
-
         // Wall-clock anchor for resume-from-suspend detection (Windows/Linux). Initialized after
         // all startup work (OBS install/bootstrap can take minutes on first run) so the first
         // poll tick doesn't read that as a freeze. macOS uses its restart-on-unlock path instead.
@@ -2575,6 +2917,13 @@ unintended app video."
                             {
                                 self.config.capture.target_apps = target_apps;
                                 self.config.capture.capture_all = capture_all;
+                                // Pick up `[input]` edits saved alongside; the backend sees
+                                // the new policy from its next event.
+                                match crate::config::Config::load() {
+                                    Ok(saved) => self.config.input = saved.input,
+                                    Err(e) => warn!("Keeping input capture flags: {}", e),
+                                }
+                                self.capture_policy.store(self.config.input.capture_policy());
                                 self.capture_ctx.set_single_active_app_capture(
                                     self.config.capture.single_active_app_capture,
                                 );
@@ -2637,6 +2986,11 @@ unintended app video."
                         EngineCommand::Panic => {
                             warn!("PANIC: deleting recent recordings");
                             if self.current_session.is_some() {
+                                // Close out a completed file split so its segment is purged below
+                                if let Err(e) = self.finish_segment_split().await {
+                                    warn!("Failed to finish segment split: {}", e);
+                                }
+                                self.segment_split_requested_at = None;
                                 let session = obs_call_with_watchdog(
                                     || tokio::task::block_in_place(|| self.capture_ctx.stop_recording()),
                                     "panic: stop_recording",
@@ -2660,6 +3014,8 @@ unintended app video."
                                 self.recording_start_ns = None;
                                 self.segment_timer = None;
                                 self.clear_event_buffer();
+                                // Already deleted with the segment's files above
+                                self.event_journal = None;
                             }
                             self.purge_upload_buffer();
                             write_recording_state(PersistedRecordingState::Recording);
@@ -2748,15 +3104,23 @@ unintended app video."
                     }
                 }
 
-                // Handle input events
-                Some(event) = input_rx.recv() => {
+                // Handle input events, a batch per wakeup
+                _ = input_rings.notified() => {
+                    input_rings.drain_into(&mut input_batch, INPUT_DRAIN_BATCH);
                     let was_paused = self.is_paused;
-                    self.handle_input_event(event).await;
+                    for event in input_batch.drain(..) {
+                        self.handle_input_event(event).await;
+                    }
                     if was_paused && !self.is_paused {
                         self.reset_segment_timer();
                     }
                 }
 
+                // Focus moved (push watcher): re-resolve the frontmost app right away
+                _ = crate::capture::focus_events::wait() => {
+                    self.poll_frontmost_app().await;
+                }
+
                 // Poll frontmost app and check for display changes
                 _ = poll_timer.tick() => {
                     // Windows/Linux resume-from-suspend handling. The poll loop ticks every
@@ -2791,6 +3155,9 @@ unintended app video."
                     }
 
                     self.poll_frontmost_app().await;
+                    if let Err(e) = self.finish_segment_split().await {
+                        error!("Failed to finish segment split: {}", e);
+                    }
                     // Track the active window's real on-monitor position/scale
                     // (Windows monitor-level fit; no-op elsewhere).
                     self.capture_ctx.apply_monitor_fit_to_active();
@@ -2799,6 +3166,9 @@ unintended app video."
                     self.check_capture_health();
                     self.check_low_disk_space();
                     self.log_source_resolution_changes();
+                    self.update_video_profile();
+                    self.capture_ctx.poll_encoder_trial();
+                    self.sync_event_journal().await;
                     #[cfg(target_os = "linux")]
                     self.check_capture_alive().await;
                 }
@@ -2882,6 +3252,17 @@ unintended app video."
             debug!("Skipping segment rotation while paused");
             return Ok(());
         }
+        if self.segment_split_requested_at.is_some() {
+            // A split that landed since the last poll tick is this rotation
+            self.finish_segment_split().await?;
+            if self.segment_split_requested_at.is_none() {
+                return Ok(());
+            }
+        }
+        if self.request_segment_split() {
+            return Ok(());
+        }
+        let _timer = crate::metrics::metrics().rotate_segment.start();
 
         let main_session_id = self
             .main_session_id
@@ -2900,19 +3281,15 @@ unintended app video."
         let video_path = self.current_session.as_ref().map(|s| s.output_path.clone());
         let segment_id = self.current_segment_id();
 
-        // Collect all events: partial flush files + remaining buffer
+        // Collect all events: journal + remaining buffer
         let events = self.collect_segment_events(&segment_id).await?;
         let start_time_us = events.first().map(|e| e.timestamp_us).unwrap_or(0);
         let end_time_us = events.last().map(|e| e.timestamp_us).unwrap_or(0);
 
-        // Save combined input events to disk
-        let input_path = self
-            .output_dir
-            .join(format!("input_{}.msgpack", segment_id));
-        let bytes = rmp_serde::to_vec(&events)?;
-        tokio::fs::write(&input_path, bytes).await?;
-
-        info!("Saved {} events to {:?}", events.len(), input_path);
+        // Save combined input events to disk in upload format; only the path is kept
+        let event_count = events.len();
+        let keylog_format = self.config.upload.keylog_format;
+        let keylog_path = self.persist_segment_keylog(&segment_id, events).await?;
 
         // Stop the current recording
         let _session = obs_call_with_watchdog(
@@ -2924,14 +3301,16 @@ unintended app video."
         let chunk = CompletedChunk {
             chunk_id: segment_id.clone(),
             session_id: main_session_id.clone(),
-            events,
+            keylog_path,
+            keylog_format,
+            event_count,
             video_path: video_path.clone(),
             start_time_us,
             end_time_us,
         };
 
         // Buffer for delayed upload (10-minute hold for panic button)
-        let segment = CompletedSegment { chunk, input_path };
+        let segment = CompletedSegment { chunk };
         self.buffer_segment_for_upload(segment, segment_id);
 
         // Clear recording state before starting new segment
@@ -2982,7 +3361,7 @@ unintended app video."
         }
         self.update_capture_enabled(should_capture, desired_target.as_deref());
         if self.capture_enabled {
-            self.send_status_force(EngineStatus::Capturing { event_count: 0 });
+            self.send_status_force(self.capturing_status());
         } else {
             self.send_status_force(EngineStatus::RecordingBlocked);
         }
@@ -2998,51 +3377,182 @@ unintended app video."
         }
     }
 
-    /// Collect all events for a segment, including partial flush files and buffer
+    /// Split-file rotation: ask the output to switch files at its next keyframe.
+    /// Returns `true` while a split is in flight (the rotation completes in
+    /// `finish_segment_split`), `false` when the caller should rotate with
+    /// stop/start instead — split rotation is off, unsupported, or the output
+    /// never reported the switch.
+    fn request_segment_split(&mut self) -> bool {
+        const SEGMENT_SPLIT_TIMEOUT: Duration = Duration::from_secs(20);
+
+        if self.config.recording.segment_rotation != SegmentRotation::Split {
+            return false;
+        }
+        if let Some(requested_at) = self.segment_split_requested_at {
+            if requested_at.elapsed() < SEGMENT_SPLIT_TIMEOUT {
+                debug!("Segment split still pending");
+                return true;
+            }
+            warn!(
+                "Output did not split within {:?}; rotating with stop/start",
+                SEGMENT_SPLIT_TIMEOUT
+            );
+            self.segment_split_requested_at = None;
+            return false;
+        }
+
+        let next_segment_id = match &self.main_session_id {
+            Some(id) => format!("{}_seg{:04}", id, self.segment_index + 1),
+            None => return false,
+        };
+        let requested = obs_call_with_watchdog(
+            || {
+                tokio::task::block_in_place(|| {
+                    self.capture_ctx.request_segment_split(&next_segment_id)
+                })
+            },
+            "rotate_segment: request_segment_split",
+        );
+        match requested {
+            Ok(true) => {
+                info!(
+                    "Rotating segment {} at the next keyframe",
+                    self.segment_index
+                );
+                self.segment_split_requested_at = Some(Instant::now());
+                true
+            }
+            Ok(false) => false,
+            Err(e) => {
+                warn!("Segment split failed, rotating with stop/start: {}", e);
+                false
+            }
+        }
+    }
+
+    /// Complete a split-file rotation once the output reports the file switch.
     ///
-    /// This reads any partial flush files for the segment, combines them with
-    /// the remaining buffer events, and cleans up the partial files.
-    async fn collect_segment_events(&mut self, segment_id: &str) -> Result<Vec<InputEvent>> {
-        let mut all_events = Vec::new();
+    /// Events before the split frame close out the old segment; later ones
+    /// (captured while the output waited for a keyframe) are rebased onto the
+    /// new segment, whose clock starts at the split. Capture is never
+    /// disabled, so unlike stop/start rotation there is no gap.
+    async fn finish_segment_split(&mut self) -> Result<()> {
+        if self.segment_split_requested_at.is_none() {
+            return Ok(());
+        }
+        let Some((finished, session)) = self.capture_ctx.take_segment_split() else {
+            return Ok(());
+        };
+        self.segment_split_requested_at = None;
+        let _timer = crate::metrics::metrics().rotate_segment.start();
 
-        // Find and read all partial flush files for this segment
-        let partial_prefix = format!("input_{}_partial_", segment_id);
-        let mut partial_files = Vec::new();
+        let segment_id = self.current_segment_id();
+        let split_us = self.recording_start_ns.map_or(0, |start_ns| {
+            session.start_time_ns.saturating_sub(start_ns) / 1000
+        });
 
-        if let Ok(mut entries) = tokio::fs::read_dir(&self.output_dir).await {
-            while let Ok(Some(entry)) = entries.next_entry().await {
-                let file_name = entry.file_name();
-                let file_name_str = file_name.to_string_lossy();
-                if file_name_str.starts_with(&partial_prefix) && file_name_str.ends_with(".msgpack")
-                {
-                    partial_files.push(entry.path());
-                }
+        let mut events = self.collect_segment_events(&segment_id).await?;
+        let carried = events.split_off(events.partition_point(|e| e.timestamp_us < split_us));
+        let start_time_us = events.first().map(|e| e.timestamp_us).unwrap_or(0);
+        let end_time_us = events.last().map(|e| e.timestamp_us).unwrap_or(0);
+
+        let event_count = events.len();
+        let keylog_format = self.config.upload.keylog_format;
+        let keylog_path = self.persist_segment_keylog(&segment_id, events).await?;
+
+        let chunk = CompletedChunk {
+            chunk_id: segment_id.clone(),
+            session_id: self.main_session_id.clone().unwrap_or_default(),
+            keylog_path,
+            keylog_format,
+            event_count,
+            video_path: Some(finished.output_path),
+            start_time_us,
+            end_time_us,
+        };
+        self.buffer_segment_for_upload(CompletedSegment { chunk }, segment_id);
+
+        self.segment_index += 1;
+        info!(
+            "Started new segment {} by split: session={}, output={:?} ({} events carried over)",
+            self.segment_index,
+            session.session_id,
+            session.output_path,
+            carried.len()
+        );
+        self.recording_start_ns = Some(session.start_time_ns);
+        self.current_session = Some(session);
+
+        let should_capture = self.capture_enabled;
+        self.emit_metadata_event(0);
+        self.emit_context_snapshot(should_capture, 0);
+        for mut event in carried {
+            event.timestamp_us -= split_us;
+            if !matches!(
+                event.event,
+                EventType::ContextChanged(_) | EventType::Metadata(_)
+            ) {
+                self.buffered_non_context_event_count += 1;
             }
+            self.event_buffer.push(event);
         }
+        Ok(())
+    }
+
+    /// Encode a segment's events in the configured keylog format and write
+    /// them to `input_<segment>.<ext>`, consuming the events. The uploader
+    /// streams this file as-is.
+    async fn persist_segment_keylog(
+        &self,
+        segment_id: &str,
+        events: Vec<InputEvent>,
+    ) -> Result<PathBuf> {
+        let format = self.config.upload.keylog_format;
+        let path = self
+            .output_dir
+            .join(format!("input_{}.{}", segment_id, format.extension()));
+        let bytes = format.encode(&events)?;
+        tokio::fs::write(&path, bytes).await?;
+
+        info!("Saved {} events to {:?}", events.len(), path);
+        Ok(path)
+    }
 
-        // Sort partial files by name (which includes timestamp) to maintain order
-        partial_files.sort();
+    /// Collect all events for a segment: the journal plus the buffer
+    ///
+    /// Reads the segment's journal back in one sequential pass, appends the
+    /// remaining buffer and transition events, and removes the journal.
+    async fn collect_segment_events(&mut self, segment_id: &str) -> Result<Vec<InputEvent>> {
+        let _timer = crate::metrics::metrics().collect_segment_events.start();
+        let mut all_events = Vec::new();
 
-        // Read and combine events from partial files
-        for partial_path in &partial_files {
-            match tokio::fs::read(partial_path).await {
-                Ok(bytes) => match rmp_serde::from_slice::<Vec<InputEvent>>(&bytes) {
+        match self.event_journal.take() {
+            Some((journal_segment, journal)) if journal_segment == segment_id => {
+                let path = journal.path().to_path_buf();
+                if let Err(e) = journal.close().await {
+                    warn!("Failed to flush event journal {:?}: {}", path, e);
+                }
+                match EventJournal::read_all(&path).await {
                     Ok(events) => {
-                        debug!(
-                            "Loaded {} events from partial file {:?}",
-                            events.len(),
-                            partial_path
-                        );
-                        all_events.extend(events);
+                        debug!("Loaded {} events from journal {:?}", events.len(), path);
+                        all_events = events;
                     }
-                    Err(e) => {
-                        warn!("Failed to parse partial file {:?}: {}", partial_path, e);
-                    }
-                },
-                Err(e) => {
-                    warn!("Failed to read partial file {:?}: {}", partial_path, e);
+                    Err(e) => warn!("Failed to read event journal {:?}: {}", path, e),
                 }
+                if let Err(e) = tokio::fs::remove_file(&path).await {
+                    warn!("Failed to delete event journal {:?}: {}", path, e);
+                }
+            }
+            Some((journal_segment, journal)) => {
+                // Left over from a segment that was never collected; it's not
+                // ours to merge.
+                warn!(
+                    "Discarding event journal for segment {} while collecting {}",
+                    journal_segment, segment_id
+                );
+                let _ = tokio::fs::remove_file(journal.path()).await;
             }
+            None => {}
         }
 
         // Add remaining events from buffer
@@ -3057,16 +3567,15 @@ unintended app video."
         );
         all_events.extend(transition_events);
 
-        // Clean up partial files
-        for partial_path in partial_files {
-            if let Err(e) = tokio::fs::remove_file(&partial_path).await {
-                warn!("Failed to delete partial file {:?}: {}", partial_path, e);
-            }
+        // Journal and buffer are already in capture order; only replayed
+        // transition events can land out of order, so sort (stable) only then.
+        if all_events
+            .windows(2)
+            .any(|pair| pair[0].timestamp_us > pair[1].timestamp_us)
+        {
+            all_events.sort_by_key(|e| e.timestamp_us);
         }
 
-        // Sort all events by timestamp to ensure proper order
-        all_events.sort_by_key(|e| e.timestamp_us);
-
         Ok(all_events)
     }
 
@@ -3235,6 +3744,7 @@ unintended app video."
         self.clear_pending_input_transition();
         self.is_paused = false; // Ensure not paused when starting
         self.idle_paused = false; // Ensure not idle-paused when starting
+        self.disk_paused = false; // The next disk check re-pauses if the budget is still spent
         self.last_recorded_action_time = Instant::now(); // Reset recorded-action timer
 
         self.emit_metadata_event(0);
@@ -3244,7 +3754,7 @@ unintended app video."
         }
         self.update_capture_enabled(should_capture, desired_target.as_deref());
         if self.capture_enabled {
-            self.send_status_force(EngineStatus::Capturing { event_count: 0 });
+            self.send_status_force(self.capturing_status());
         } else {
             self.send_status_force(EngineStatus::RecordingBlocked);
         }
@@ -3267,25 +3777,25 @@ unintended app video."
 
         info!("Stopping recording...");
 
+        // A split the output already made must close out its segment first
+        self.finish_segment_split().await?;
+        self.segment_split_requested_at = None;
+
         // Save any buffered events with final video path
         let video_path = self.current_session.as_ref().map(|s| s.output_path.clone());
         let segment_id = self.current_segment_id();
 
-        // Collect all events: partial flush files + remaining buffer
+        // Collect all events: journal + remaining buffer
         let events = self.collect_segment_events(&segment_id).await?;
 
         if !events.is_empty() || video_path.is_some() {
             let start_time_us = events.first().map(|e| e.timestamp_us).unwrap_or(0);
             let end_time_us = events.last().map(|e| e.timestamp_us).unwrap_or(0);
 
-            // Save combined input events to disk
-            let input_path = self
-                .output_dir
-                .join(format!("input_{}.msgpack", segment_id));
-            let bytes = rmp_serde::to_vec(&events)?;
-            tokio::fs::write(&input_path, bytes).await?;
-
-            info!("Saved {} events to {:?}", events.len(), input_path);
+            // Save combined input events to disk in upload format; only the path is kept
+            let event_count = events.len();
+            let keylog_format = self.config.upload.keylog_format;
+            let keylog_path = self.persist_segment_keylog(&segment_id, events).await?;
 
             // Stop libobs recording — watchdog restarts the process if OBS hangs.
             let session = obs_call_with_watchdog(
@@ -3305,13 +3815,15 @@ unintended app video."
                 let chunk = CompletedChunk {
                     chunk_id: segment_id.clone(),
                     session_id: main_session_id,
-                    events,
+                    keylog_path,
+                    keylog_format,
+                    event_count,
                     video_path,
                     start_time_us,
                     end_time_us,
                 };
 
-                let segment = CompletedSegment { chunk, input_path };
+                let segment = CompletedSegment { chunk };
                 self.buffer_segment_for_upload(segment, segment_id);
             }
         } else {
@@ -3334,6 +3846,7 @@ unintended app video."
         self.segment_index = 0;
         self.is_paused = false;
         self.idle_paused = false;
+        self.disk_paused = false;
         self.pending_app_switch = None;
         self.segment_timer = None;
         self.clear_capture_watchdog();
@@ -3399,6 +3912,7 @@ unintended app video."
         if self.config.recording.notify_on_start_stop
             && notifications_authorized()
             && !self.idle_paused
+            && !self.disk_paused
         {
             show_recording_paused_notification();
         }
@@ -3417,6 +3931,10 @@ unintended app video."
             debug!("Recording not paused");
             return;
         }
+        if self.disk_paused {
+            debug!("Recording stays paused until the disk budget has room");
+            return;
+        }
 
         info!("Resuming recording (video and keylog)...");
 
@@ -3471,9 +3989,7 @@ unintended app video."
         self.update_capture_enabled(should_capture, desired_target.as_deref());
 
         if self.capture_enabled {
-            self.send_status_force(EngineStatus::Capturing {
-                event_count: self.buffered_input_event_count(),
-            });
+            self.send_status_force(self.capturing_status());
         } else {
             self.send_status_force(EngineStatus::RecordingBlocked);
         }
@@ -3929,7 +4445,8 @@ unintended app video."
     }
 
     /// Warn (once per low-disk episode) if free space on the recording volume is
-    /// running out. Recording into a full disk fails silently, so surface it.
+    /// running out, and hold local segments to the disk budget (see
+    /// `sync::store`). Recording into a full disk fails silently, so surface it.
     fn check_low_disk_space(&mut self) {
         if self.current_session.is_none() {
             return;
@@ -3945,10 +4462,23 @@ unintended app video."
             .output_directory
             .clone()
             .unwrap_or_else(|| std::env::temp_dir().join("crowd-cast-recordings"));
-        let Some(free) = free_space_bytes(&dir) else {
+        let free = free_space_bytes(&dir);
+        let active_bytes = self
+            .current_session
+            .as_ref()
+            .and_then(|s| std::fs::metadata(&s.output_path).ok())
+            .map_or(0, |m| m.len());
+        let pressure = self.segment_store.enforce(
+            active_bytes,
+            free,
+            LOW_DISK_THRESHOLD_BYTES,
+            self.disk_pressure,
+        );
+        self.apply_disk_pressure(pressure);
+
+        let Some(free) = free else {
             return;
         };
-
         if free < LOW_DISK_THRESHOLD_BYTES {
             if !self.low_disk_warned {
                 self.low_disk_warned = true;
@@ -3967,8 +4497,36 @@ unintended app video."
         }
     }
 
+    /// Step recording between the disk-budget levels: compress new video, pause
+    /// once the budget is spent, resume once uploads have made room.
+    fn apply_disk_pressure(&mut self, pressure: DiskPressure) {
+        if pressure != self.disk_pressure {
+            info!(
+                "Disk budget pressure: {:?} -> {:?}",
+                self.disk_pressure, pressure
+            );
+            self.disk_pressure = pressure;
+            self.retarget_video_bitrate();
+        }
+
+        // Checked every time, so a user resume under an exhausted budget is re-paused
+        if pressure == DiskPressure::Pause && !self.is_paused {
+            warn!("Disk budget exhausted; pausing recording until uploads free space");
+            self.disk_paused = true;
+            self.pause_recording();
+            if notifications_authorized() {
+                show_disk_budget_paused_notification();
+            }
+        } else if pressure != DiskPressure::Pause && self.disk_paused {
+            info!("Disk budget has room again; resuming recording");
+            self.disk_paused = false;
+            self.resume_recording();
+        }
+    }
+
     /// Poll the frontmost application and update capture state
     async fn poll_frontmost_app(&mut self) {
+        let _timer = crate::metrics::metrics().poll_frontmost_app.start();
         // Ignore the agent's own app being frontmost (our Settings/wizard window
         // has focus): that's the user in our UI, not leaving their tracked app,
         // so hold the poll's capture/status state. Windows tray and menu clicks
@@ -3976,7 +4534,8 @@ unintended app video."
         // reporting the previous app (filter_self in frontmost.rs), which also
         // protects the frontmost_capture_state callers that bypass this poll
         // guard (segment rotation, recording start/resume, app switches).
-        if get_frontmost_app()
+        if self
+            .resolve_frontmost()
             .map(|a| crate::config::is_agent_self(&a.bundle_id))
             .unwrap_or(false)
         {
@@ -4020,9 +4579,7 @@ unintended app video."
         // Update status
         if is_recording {
             if self.capture_enabled {
-                self.send_status(EngineStatus::Capturing {
-                    event_count: self.buffered_input_event_count(),
-                });
+                self.send_status(self.capturing_status());
             } else if !self.is_paused {
                 self.send_status(EngineStatus::RecordingBlocked);
             }
@@ -4082,6 +4639,10 @@ unintended app video."
             return;
         }
 
+        if let Some(profile) = self.video_profile.as_mut() {
+            profile.note_input(Instant::now());
+        }
+
         let adjusted_event = self.adjust_input_event_timestamp(event);
 
         self.buffer_input_event(adjusted_event);
@@ -4096,37 +4657,64 @@ unintended app video."
 
     /// Flush the event buffer to disk (for periodic flushing during long segments)
     ///
-    /// This drains the buffer to bound memory usage. Events are saved to numbered
-    /// partial files that will be combined with the main segment file at rotation.
+    /// This drains the buffer to bound memory usage. Events are appended to the
+    /// segment's journal, which is read back at rotation. Not durable until
+    /// the next `sync_event_journal`.
     async fn flush_event_buffer(&mut self) -> Result<()> {
         if self.event_buffer.is_empty() {
             return Ok(());
         }
 
-        // Generate a unique partial file name using timestamp to allow multiple flushes
         let segment_id = self.current_segment_id();
-        let timestamp = std::time::SystemTime::now()
-            .duration_since(std::time::UNIX_EPOCH)
-            .map(|d| d.as_millis())
-            .unwrap_or(0);
-        let flush_path = self.output_dir.join(format!(
-            "input_{}_partial_{}.msgpack",
-            segment_id, timestamp
-        ));
+        if self
+            .event_journal
+            .as_ref()
+            .map_or(true, |(journal_segment, _)| *journal_segment != segment_id)
+        {
+            let path = self
+                .output_dir
+                .join(format!("input_{}.journal", segment_id));
+            let journal = EventJournal::create(path).await?;
+            self.event_journal = Some((segment_id, journal));
+        }
+        let (_, journal) = self.event_journal.as_mut().expect("journal just opened");
 
-        // Drain the buffer to bound memory usage
-        let events = self.drain_event_buffer();
-        let event_count = events.len();
-        let bytes = rmp_serde::to_vec(&events)?;
-        tokio::fs::write(&flush_path, bytes).await?;
+        // Drain the buffer to bound memory usage. The status event count is
+        // per segment, so it is left alone here.
+        let events = self.event_buffer.drain();
+        journal.append(&events).await?;
+        crate::metrics::metrics()
+            .events_flushed
+            .add(events.len() as u64);
 
         debug!(
-            "Partial flush: {} events to {:?} (buffer cleared)",
-            event_count, flush_path
+            "Journal flush: {} events to {:?} (buffer cleared)",
+            events.len(),
+            journal.path()
         );
 
         Ok(())
     }
+
+    /// Every `JOURNAL_SYNC_INTERVAL` while recording, append the buffer to
+    /// the segment journal and fsync it.
+    async fn sync_event_journal(&mut self) {
+        if self.current_session.is_none()
+            || self.last_journal_sync.elapsed() < JOURNAL_SYNC_INTERVAL
+        {
+            return;
+        }
+        self.last_journal_sync = Instant::now();
+
+        if let Err(e) = self.flush_event_buffer().await {
+            error!("Failed to flush event buffer: {}", e);
+        }
+        if let Some((_, journal)) = self.event_journal.as_mut() {
+            if let Err(e) = journal.sync().await {
+                warn!("{:#}", e);
+            }
+        }
+    }
 }
 
 /// Create command and status channels for the engine
@@ -4223,11 +4811,12 @@ mod tests {
                 session_id: "test-session".to_string(),
                 chunk_id: name.to_string(),
                 video_path: Some(video_path),
-                events: vec![],
+                keylog_path: input_path,
+                keylog_format: crate::data::KeylogFormat::Msgpack,
+                event_count: 0,
                 start_time_us: 0,
                 end_time_us: 1000,
             },
-            input_path,
         }
     }
 
@@ -4238,9 +4827,9 @@ mod tests {
         let seg2 = make_test_segment(&dir, "seg2");
 
         let video1 = seg1.chunk.video_path.clone().unwrap();
-        let input1 = seg1.input_path.clone();
+        let input1 = seg1.chunk.keylog_path.clone();
         let video2 = seg2.chunk.video_path.clone().unwrap();
-        let input2 = seg2.input_path.clone();
+        let input2 = seg2.chunk.keylog_path.clone();
 
         assert!(video1.exists());
         assert!(input1.exists());
@@ -4257,7 +4846,7 @@ mod tests {
             if let Some(ref video_path) = segment.chunk.video_path {
                 let _ = std::fs::remove_file(video_path);
             }
-            let _ = std::fs::remove_file(&segment.input_path);
+            let _ = std::fs::remove_file(&segment.chunk.keylog_path);
         }
 
         assert!(!video1.exists());
@@ -0,0 +1,310 @@
+//! Append-only keyed ledger for small persisted maps
+//!
+//! The agent's persisted maps (the segment store index, the capture-dead
+//! restart markers, the restart history) used to be read, modified and
+//! rewritten whole on every change — quadratic I/O when hundreds of segments
+//! drain after an outage. A ledger keeps the map in memory and appends one
+//! JSON line per change instead:
+//!
+//! ```text
+//! {"put":["<key>",<value>]}
+//! {"del":"<key>"}
+//! ```
+//!
+//! On open the log is replayed front to back. A crash can at worst leave a
+//! torn final line, which replay skips. Once the log holds far more records
+//! than live entries it is compacted: a snapshot of one `put` per entry is
+//! written beside it and renamed over it, so the file is never half-written.
+
+use serde::de::DeserializeOwned;
+use serde::{Deserialize, Serialize};
+use std::collections::{BTreeMap, HashMap};
+use std::fs::{File, OpenOptions};
+use std::io::Write;
+use std::path::PathBuf;
+use tracing::warn;
+
+/// Compact once the log has this many records beyond twice the live entries
+const COMPACT_SLACK: usize = 64;
+
+#[derive(Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+enum Record<K, V> {
+    Put(K, V),
+    Del(K),
+}
+
+/// A string-keyed map persisted as an append-only log. Iteration follows the
+/// order keys were first inserted.
+pub struct Ledger<V> {
+    /// Log file, or `None` for a map that isn't persisted (no data dir, tests)
+    path: Option<PathBuf>,
+    /// Open for appending; reopened lazily after a failed write or compaction
+    file: Option<File>,
+    /// Records in the log, live or not
+    records: usize,
+    next_seq: u64,
+    /// Entries by insertion sequence, for ordered iteration
+    entries: BTreeMap<u64, (String, V)>,
+    seq_by_key: HashMap<String, u64>,
+}
+
+impl<V: Serialize + DeserializeOwned> Ledger<V> {
+    /// Open (and replay) the ledger at `path`. A missing or unreadable file
+    /// yields an empty map; failures are logged, never returned.
+    pub fn open(path: Option<PathBuf>) -> Self {
+        let mut ledger = Self {
+            path,
+            file: None,
+            records: 0,
+            next_seq: 0,
+            entries: BTreeMap::new(),
+            seq_by_key: HashMap::new(),
+        };
+        let Some(path) = ledger.path.clone() else {
+            return ledger;
+        };
+        let contents = match std::fs::read_to_string(&path) {
+            Ok(contents) => contents,
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => return ledger,
+            Err(e) => {
+                warn!("Failed to read ledger {:?}: {}", path, e);
+                return ledger;
+            }
+        };
+        let mut skipped = 0;
+        for line in contents.lines().filter(|l| !l.trim().is_empty()) {
+            match serde_json::from_str::<Record<String, V>>(line) {
+                Ok(Record::Put(key, value)) => ledger.apply_put(key, value),
+                Ok(Record::Del(key)) => {
+                    ledger.apply_del(&key);
+                }
+                Err(_) => skipped += 1,
+            }
+            ledger.records += 1;
+        }
+        if skipped > 0 {
+            warn!("Skipped {} unreadable record(s) in {:?}", skipped, path);
+            // Rewrite so the garbage doesn't outlive this replay
+            ledger.compact();
+        } else {
+            ledger.maybe_compact();
+        }
+        ledger
+    }
+
+    #[allow(dead_code)] // only the macOS restart history counts its entries
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    pub fn get(&self, key: &str) -> Option<&V> {
+        let seq = self.seq_by_key.get(key)?;
+        self.entries.get(seq).map(|(_, v)| v)
+    }
+
+    /// Values in insertion order
+    pub fn values(&self) -> impl Iterator<Item = &V> {
+        self.entries.values().map(|(_, v)| v)
+    }
+
+    /// Keys in insertion order
+    #[cfg(test)]
+    pub fn keys(&self) -> impl Iterator<Item = &str> {
+        self.entries.values().map(|(k, _)| k.as_str())
+    }
+
+    /// Insert or replace `key`. A replaced entry keeps its place in the order.
+    pub fn insert(&mut self, key: String, value: V) {
+        self.append(&Record::Put(key.as_str(), &value));
+        self.apply_put(key, value);
+        self.maybe_compact();
+    }
+
+    pub fn remove(&mut self, key: &str) -> Option<V> {
+        let value = self.apply_del(key)?;
+        self.append(&Record::<&str, &V>::Del(key));
+        self.maybe_compact();
+        Some(value)
+    }
+
+    /// Keep only the entries for which `keep` returns `true`
+    pub fn retain(&mut self, mut keep: impl FnMut(&str, &V) -> bool) {
+        let doomed: Vec<String> = self
+            .entries
+            .values()
+            .filter(|(k, v)| !keep(k, v))
+            .map(|(k, _)| k.clone())
+            .collect();
+        for key in doomed {
+            self.remove(&key);
+        }
+    }
+
+    fn apply_put(&mut self, key: String, value: V) {
+        match self.seq_by_key.get(&key) {
+            Some(seq) => {
+                self.entries.insert(*seq, (key, value));
+            }
+            None => {
+                let seq = self.next_seq;
+                self.next_seq += 1;
+                self.seq_by_key.insert(key.clone(), seq);
+                self.entries.insert(seq, (key, value));
+            }
+        }
+    }
+
+    fn apply_del(&mut self, key: &str) -> Option<V> {
+        let seq = self.seq_by_key.remove(key)?;
+        self.entries.remove(&seq).map(|(_, v)| v)
+    }
+
+    fn append(&mut self, record: &Record<&str, &V>) {
+        let Some(path) = self.path.as_ref() else {
+            return;
+        };
+        let mut line = match serde_json::to_string(record) {
+            Ok(line) => line,
+            Err(e) => {
+                warn!("Failed to serialize ledger record for {:?}: {}", path, e);
+                return;
+            }
+        };
+        line.push('\n');
+        if self.file.is_none() {
+            if let Some(parent) = path.parent() {
+                let _ = std::fs::create_dir_all(parent);
+            }
+            match OpenOptions::new().create(true).append(true).open(path) {
+                Ok(file) => self.file = Some(file),
+                Err(e) => {
+                    warn!("Failed to open ledger {:?}: {}", path, e);
+                    return;
+                }
+            }
+        }
+        let file = self.file.as_mut().expect("ledger file just opened");
+        // One write per record: a crash tears at most this line
+        if let Err(e) = file.write_all(line.as_bytes()) {
+            warn!("Failed to append to ledger {:?}: {}", path, e);
+            self.file = None;
+            return;
+        }
+        self.records += 1;
+    }
+
+    fn maybe_compact(&mut self) {
+        if self.records > 2 * self.entries.len() + COMPACT_SLACK {
+            self.compact();
+        }
+    }
+
+    /// Rewrite the log as one `put` per live entry
+    fn compact(&mut self) {
+        let Some(path) = self.path.as_ref() else {
+            return;
+        };
+        let mut snapshot = String::new();
+        for (key, value) in self.entries.values() {
+            match serde_json::to_string(&Record::Put(key.as_str(), value)) {
+                Ok(line) => {
+                    snapshot.push_str(&line);
+                    snapshot.push('\n');
+                }
+                Err(e) => {
+                    warn!("Failed to serialize ledger entry for {:?}: {}", path, e);
+                    return;
+                }
+            }
+        }
+        let tmp = path.with_extension("compact");
+        if let Err(e) = std::fs::write(&tmp, snapshot).and_then(|()| std::fs::rename(&tmp, path)) {
+            warn!("Failed to compact ledger {:?}: {}", path, e);
+            return;
+        }
+        // The old handle points at the replaced file
+        self.file = None;
+        self.records = self.entries.len();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn test_path(name: &str) -> PathBuf {
+        let dir =
+            std::env::temp_dir().join(format!("crowd-cast-ledger-{}-{}", name, std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        std::fs::create_dir_all(&dir).unwrap();
+        dir.join("map.jsonl")
+    }
+
+    #[test]
+    fn replays_puts_and_deletes_in_order() {
+        let path = test_path("replay");
+        {
+            let mut ledger = Ledger::<u64>::open(Some(path.clone()));
+            ledger.insert("a".to_string(), 1);
+            ledger.insert("b".to_string(), 2);
+            ledger.insert("c".to_string(), 3);
+            ledger.insert("a".to_string(), 10);
+            assert_eq!(ledger.remove("b"), Some(2));
+        }
+        let ledger = Ledger::<u64>::open(Some(path.clone()));
+        assert_eq!(ledger.keys().collect::<Vec<_>>(), ["a", "c"]);
+        assert_eq!(ledger.get("a"), Some(&10));
+        assert_eq!(ledger.get("b"), None);
+
+        let _ = std::fs::remove_dir_all(path.parent().unwrap());
+    }
+
+    #[test]
+    fn torn_final_record_is_dropped() {
+        let path = test_path("torn");
+        {
+            let mut ledger = Ledger::<u64>::open(Some(path.clone()));
+            ledger.insert("a".to_string(), 1);
+            ledger.insert("b".to_string(), 2);
+        }
+        let mut file = OpenOptions::new().append(true).open(&path).unwrap();
+        file.write_all(br#"{"put":["c","#).unwrap();
+        drop(file);
+
+        let ledger = Ledger::<u64>::open(Some(path.clone()));
+        assert_eq!(ledger.len(), 2);
+        // The torn line was compacted away, so appends start on a clean line
+        let contents = std::fs::read_to_string(&path).unwrap();
+        assert_eq!(contents.lines().count(), 2);
+
+        let _ = std::fs::remove_dir_all(path.parent().unwrap());
+    }
+
+    #[test]
+    fn compaction_bounds_the_log() {
+        let path = test_path("compact");
+        let mut ledger = Ledger::<u64>::open(Some(path.clone()));
+        for i in 0..1000u64 {
+            ledger.insert(format!("k{}", i), i);
+            if i >= 5 {
+                ledger.remove(&format!("k{}", i - 5));
+            }
+        }
+        assert_eq!(ledger.len(), 5);
+        let lines = std::fs::read_to_string(&path).unwrap().lines().count();
+        assert!(
+            lines <= 2 * 5 + COMPACT_SLACK + 1,
+            "log has {} lines",
+            lines
+        );
+
+        let reopened = Ledger::<u64>::open(Some(path.clone()));
+        assert_eq!(
+            reopened.keys().collect::<Vec<_>>(),
+            ["k995", "k996", "k997", "k998", "k999"]
+        );
+
+        let _ = std::fs::remove_dir_all(path.parent().unwrap());
+    }
+}
@@ -1,7 +1,13 @@
 //! Synchronization engine - coordinates input capture with recording state
 
+mod activity;
 mod engine;
+mod ledger;
+mod progressive;
+mod store;
 
+#[cfg(target_os = "macos")]
+pub use engine::{booted_or_woke_within, wait_for_displays_to_settle, STARTUP_SETTLE_WINDOW};
 pub use engine::{create_engine_channels, SyncEngine};
 
 /// Commands that can be sent to the sync engine
@@ -48,6 +54,8 @@ pub enum EngineStatus {
     Capturing {
         /// Number of events captured in current chunk
         event_count: usize,
+        /// Input events dropped since startup because a capture ring was full
+        dropped_events: u64,
     },
     /// Recording is paused (both video and keylog)
     Paused,
@@ -0,0 +1,228 @@
+//! Progressive upload of segment video while it is still recorded
+//!
+//! A segment normally goes up whole once it has finished and sat out the
+//! 10-minute panic window in the upload buffer, so uplink traffic arrives in
+//! segment-sized bursts. With `progressive_upload` the recording is fragmented
+//! MP4, which only ever grows, and every whole multipart part of it is sent as
+//! soon as its bytes are older than that window: the engine samples each
+//! tracked file's length as it grows, and a part is released once a sample
+//! taken at least `hold` ago already covered it. The panic button can still
+//! delete everything recorded in the last 10 minutes, because none of it has
+//! left the machine.
+//!
+//! The segment's final upload (after graduation) resumes the same multipart
+//! upload with the remaining parts and the keylog, which is only encoded once
+//! the segment ends.
+
+use std::collections::{HashMap, VecDeque};
+use std::path::{Path, PathBuf};
+use std::time::Duration;
+use tokio::task::JoinHandle;
+use tokio::time::Instant;
+use tracing::{debug, warn};
+
+use crate::upload::Uploader;
+
+/// How often a tracked file's length is sampled. A part is released at most
+/// this much later than `hold` strictly requires.
+const SAMPLE_INTERVAL: Duration = Duration::from_secs(5);
+
+/// When each length of a growing file was first seen
+#[derive(Debug, Default)]
+struct GrowthLog {
+    /// `(when, len)`, oldest first, lengths increasing
+    samples: VecDeque<(Instant, u64)>,
+}
+
+impl GrowthLog {
+    fn record(&mut self, now: Instant, len: u64) {
+        if self.samples.back().is_none_or(|&(_, last)| len > last) {
+            self.samples.push_back((now, len));
+        }
+    }
+
+    /// Length the file had already reached `hold` before `now`. Samples older
+    /// than the newest such one are no longer needed and are dropped.
+    fn settled_len(&mut self, now: Instant, hold: Duration) -> u64 {
+        let Some(cutoff) = now.checked_sub(hold) else {
+            return 0;
+        };
+        while self.samples.len() > 1 && self.samples[1].0 <= cutoff {
+            self.samples.pop_front();
+        }
+        match self.samples.front() {
+            Some(&(when, len)) if when <= cutoff => len,
+            _ => 0,
+        }
+    }
+}
+
+struct Track {
+    path: PathBuf,
+    growth: GrowthLog,
+    last_sample: Option<Instant>,
+    /// Settled length the latest early upload was started for
+    released_len: u64,
+    /// Uploads the parts released so far; at most one per segment at a time
+    task: Option<JoinHandle<()>>,
+}
+
+impl Track {
+    fn new(path: &Path) -> Self {
+        Self {
+            path: path.to_path_buf(),
+            growth: GrowthLog::default(),
+            last_sample: None,
+            released_len: 0,
+            task: None,
+        }
+    }
+
+    fn is_busy(&self) -> bool {
+        self.task.as_ref().is_some_and(|t| !t.is_finished())
+    }
+}
+
+/// Segments whose video is being uploaded as it grows, keyed by chunk ID
+pub(super) struct ProgressiveUploads {
+    hold: Duration,
+    tracks: HashMap<String, Track>,
+}
+
+impl ProgressiveUploads {
+    pub(super) fn new(hold: Duration) -> Self {
+        Self {
+            hold,
+            tracks: HashMap::new(),
+        }
+    }
+
+    /// Advance every segment not yet handed to the upload task: `live` lists
+    /// the recording segment and the buffered ones as `(chunk ID, video path)`.
+    /// Segments no longer listed stop being tracked.
+    pub(super) fn poll<'a>(
+        &mut self,
+        uploader: &Uploader,
+        live: impl IntoIterator<Item = (&'a str, &'a Path)>,
+        now: Instant,
+    ) {
+        let mut seen = Vec::new();
+        for (chunk_id, path) in live {
+            seen.push(chunk_id);
+            let track = self
+                .tracks
+                .entry(chunk_id.to_string())
+                .or_insert_with(|| Track::new(path));
+            if track.path != path {
+                // A different file under the same segment ID: start over
+                if let Some(task) = track.task.take() {
+                    task.abort();
+                }
+                *track = Track::new(path);
+            }
+            if track
+                .last_sample
+                .is_none_or(|at| now.duration_since(at) >= SAMPLE_INTERVAL)
+            {
+                track.last_sample = Some(now);
+                match std::fs::metadata(path) {
+                    Ok(m) => track.growth.record(now, m.len()),
+                    Err(e) => debug!("Cannot sample recording size {:?}: {}", path, e),
+                }
+            }
+            let ready_len = track.growth.settled_len(now, self.hold);
+            if ready_len <= track.released_len || track.is_busy() {
+                continue;
+            }
+            track.released_len = ready_len;
+            let uploader = uploader.clone();
+            let chunk_id = chunk_id.to_string();
+            let path = track.path.clone();
+            track.task = Some(tokio::spawn(async move {
+                if let Err(e) = uploader
+                    .upload_growing_parts(&chunk_id, &path, ready_len)
+                    .await
+                {
+                    // Retried once more bytes settle; the final upload resumes
+                    // or restarts the multipart upload regardless
+                    warn!("Early upload of chunk {} failed: {:#}", chunk_id, e);
+                }
+            }));
+        }
+        self.tracks.retain(|chunk_id, track| {
+            let keep = seen.contains(&chunk_id.as_str());
+            if !keep {
+                if let Some(task) = track.task.take() {
+                    task.abort();
+                }
+            }
+            keep
+        });
+    }
+
+    /// Whether an early upload for `chunk_id` is in flight. Its final upload
+    /// must wait, since both update the same multipart progress.
+    pub(super) fn is_busy(&self, chunk_id: &str) -> bool {
+        self.tracks.get(chunk_id).is_some_and(Track::is_busy)
+    }
+
+    /// Stop tracking a segment handed to the upload task
+    pub(super) fn finish(&mut self, chunk_id: &str) {
+        if let Some(task) = self.tracks.remove(chunk_id).and_then(|t| t.task) {
+            task.abort();
+        }
+    }
+
+    /// Stop every early upload, keeping the persisted progress for the final
+    /// uploads to resume (graceful shutdown)
+    pub(super) fn stop_all(&mut self) {
+        for (_, track) in self.tracks.drain() {
+            if let Some(task) = track.task {
+                task.abort();
+            }
+        }
+    }
+
+    /// Stop every early upload and drop its progress (panic)
+    pub(super) fn discard_all(&mut self) {
+        for (chunk_id, track) in self.tracks.drain() {
+            if let Some(task) = track.task {
+                task.abort();
+            }
+            crate::upload::forget_multipart_upload(&chunk_id);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const HOLD: Duration = Duration::from_secs(600);
+
+    #[test]
+    fn bytes_are_released_only_after_the_hold() {
+        let t0 = Instant::now();
+        let mut log = GrowthLog::default();
+        log.record(t0, 10);
+        log.record(t0 + Duration::from_secs(60), 50);
+        log.record(t0 + Duration::from_secs(120), 90);
+
+        assert_eq!(log.settled_len(t0 + Duration::from_secs(599), HOLD), 0);
+        assert_eq!(log.settled_len(t0 + HOLD, HOLD), 10);
+        assert_eq!(log.settled_len(t0 + Duration::from_secs(690), HOLD), 50);
+        assert_eq!(log.settled_len(t0 + Duration::from_secs(900), HOLD), 90);
+        // Superseded samples were dropped along the way
+        assert_eq!(log.samples.len(), 1);
+    }
+
+    #[test]
+    fn unchanged_or_shrunk_lengths_are_not_recorded() {
+        let t0 = Instant::now();
+        let mut log = GrowthLog::default();
+        log.record(t0, 10);
+        log.record(t0 + Duration::from_secs(5), 10);
+        log.record(t0 + Duration::from_secs(10), 4);
+        assert_eq!(log.samples.len(), 1);
+    }
+}
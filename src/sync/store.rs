@@ -0,0 +1,464 @@
+//! Disk-budgeted store of local segments
+//!
+//! Every segment written for upload is indexed here with its upload state and
+//! on-disk size, so the agent's footprint can be held under
+//! `recording.disk_budget_gb` and a reserve of free space on the volume. A
+//! participant offline for days would otherwise fill the disk until recording
+//! failed. Pressure on the budget is relieved in order:
+//! 1. evict segments that are already uploaded (kept on disk when
+//!    `delete_after_upload` is off) or were recorded with no uploader
+//!    configured, oldest first
+//! 2. compress: record at `disk_pressure_bitrate_kbps` (`DiskPressure::Compress`)
+//! 3. pause recording until uploads free space again (`DiskPressure::Pause`)
+//!
+//! Pending segments are never evicted: they are the only copy of that data.
+//! Entries whose files were deleted out from under the store are dropped when
+//! the budget is next applied.
+//!
+//! The index persists as an append-only ledger, `segment_store.jsonl` in the
+//! data dir, so an upload completing costs one appended line rather than a
+//! rewrite of every queued segment. The older whole-file indexes
+//! (`segment_store.json`, `pending_uploads.json`) are migrated on first open.
+
+use super::ledger::Ledger;
+use serde::{Deserialize, Serialize};
+use std::path::{Path, PathBuf};
+use std::sync::{Mutex, MutexGuard, PoisonError};
+use tracing::{debug, info, warn};
+
+/// Usage at which new video is compressed
+const COMPRESS_FRACTION: f64 = 0.8;
+/// Compression stays on until usage falls below this
+const COMPRESS_RELEASE_FRACTION: f64 = 0.7;
+/// Recording resumes from a budget pause once usage falls below this
+const PAUSE_RELEASE_FRACTION: f64 = 0.9;
+
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum SegmentState {
+    /// Waiting for (or in) upload
+    #[default]
+    Pending,
+    /// Uploaded but still on disk; first to go under pressure
+    Uploaded,
+    /// Recorded with no uploader configured; evicted like `Uploaded`
+    Local,
+}
+
+impl SegmentState {
+    fn is_evictable(self) -> bool {
+        matches!(self, Self::Uploaded | Self::Local)
+    }
+}
+
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct StoredSegment {
+    pub chunk_id: String,
+    pub session_id: String,
+    pub video_path: Option<PathBuf>,
+    pub input_path: PathBuf,
+    pub buffered_at_epoch_s: u64,
+    /// Absent in manifests written before the store existed (all pending)
+    #[serde(default)]
+    pub state: SegmentState,
+    /// Bytes on disk (video + keylog), measured when indexed
+    #[serde(default)]
+    pub bytes: u64,
+}
+
+impl StoredSegment {
+    fn measure(&mut self) {
+        let size = |p: &Path| std::fs::metadata(p).map_or(0, |m| m.len());
+        self.bytes = size(&self.input_path) + self.video_path.as_deref().map_or(0, size);
+    }
+
+    fn files_exist(&self) -> bool {
+        self.input_path.exists() || self.video_path.as_deref().is_some_and(Path::exists)
+    }
+
+    fn delete_files(&self) {
+        for path in self
+            .video_path
+            .iter()
+            .chain(std::iter::once(&self.input_path))
+        {
+            match std::fs::remove_file(path) {
+                Ok(()) => debug!("Deleted {:?}", path),
+                Err(e) if e.kind() == std::io::ErrorKind::NotFound => {}
+                Err(e) => warn!("Failed to delete {:?}: {}", path, e),
+            }
+        }
+    }
+}
+
+/// How hard the disk budget is pressed, in escalating order
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq, PartialOrd, Ord)]
+pub enum DiskPressure {
+    #[default]
+    Normal,
+    Compress,
+    Pause,
+}
+
+impl DiskPressure {
+    /// Pressure at `used` of `limit` bytes. Each level is left at a lower usage
+    /// than it is entered at, so the engine doesn't flap around a threshold.
+    fn at(used: u64, limit: u64, previous: Self) -> Self {
+        let ratio = used as f64 / limit.max(1) as f64;
+        if ratio >= 1.0 || (previous == Self::Pause && ratio >= PAUSE_RELEASE_FRACTION) {
+            Self::Pause
+        } else if ratio >= COMPRESS_FRACTION
+            || (previous != Self::Normal && ratio >= COMPRESS_RELEASE_FRACTION)
+        {
+            Self::Compress
+        } else {
+            Self::Normal
+        }
+    }
+}
+
+/// Index of local segments, shared by the engine and the upload task
+pub struct SegmentStore {
+    /// Byte budget for stored segments plus the live recording (0 = none)
+    budget_bytes: u64,
+    /// Segments by chunk id, in the order they were indexed (oldest first)
+    segments: Mutex<Ledger<StoredSegment>>,
+}
+
+impl SegmentStore {
+    /// Open the store persisted in the agent's data dir
+    pub fn open(budget_bytes: u64) -> Self {
+        let dirs = directories::ProjectDirs::from("dev", "crowd-cast", "agent");
+        let data_dir = dirs.as_ref().map(|d| d.data_dir());
+        let path = data_dir.map(|d| d.join("segment_store.jsonl"));
+        let fresh = path.as_deref().is_some_and(|p| !p.exists());
+        let mut ledger = Ledger::open(path);
+        if fresh {
+            // First run with the ledger: adopt the older whole-file indexes
+            for legacy in ["segment_store.json", "pending_uploads.json"] {
+                let Some(legacy) = data_dir.map(|d| d.join(legacy)) else {
+                    continue;
+                };
+                let Some(entries) = read_index(&legacy) else {
+                    continue;
+                };
+                info!(
+                    "Migrated {} segment(s) from {:?} to the segment store",
+                    entries.len(),
+                    legacy
+                );
+                for mut segment in entries {
+                    if segment.bytes == 0 {
+                        segment.measure();
+                    }
+                    ledger.insert(segment.chunk_id.clone(), segment);
+                }
+                let _ = std::fs::remove_file(&legacy);
+            }
+        }
+        Self::with_ledger(budget_bytes, ledger)
+    }
+
+    fn with_ledger(budget_bytes: u64, ledger: Ledger<StoredSegment>) -> Self {
+        Self {
+            budget_bytes,
+            segments: Mutex::new(ledger),
+        }
+    }
+
+    fn lock(&self) -> MutexGuard<'_, Ledger<StoredSegment>> {
+        self.segments.lock().unwrap_or_else(PoisonError::into_inner)
+    }
+
+    /// Index a segment that was just written to disk
+    pub fn insert(&self, mut segment: StoredSegment) {
+        segment.measure();
+        let mut segments = self.lock();
+        // Re-indexing a chunk moves it to the back, like a new segment
+        segments.remove(&segment.chunk_id);
+        segments.insert(segment.chunk_id.clone(), segment);
+    }
+
+    /// Record a finished upload. Segments whose files were deleted with the
+    /// upload leave the index; the rest stay as evictable `Uploaded` entries.
+    pub fn mark_uploaded(&self, chunk_id: &str, files_deleted: bool) {
+        let mut segments = self.lock();
+        if files_deleted {
+            segments.remove(chunk_id);
+        } else if let Some(segment) = segments.get(chunk_id) {
+            let segment = StoredSegment {
+                state: SegmentState::Uploaded,
+                ..segment.clone()
+            };
+            segments.insert(chunk_id.to_string(), segment);
+        }
+    }
+
+    /// Forget a segment (its files are left alone)
+    pub fn remove(&self, chunk_id: &str) {
+        self.lock().remove(chunk_id);
+    }
+
+    /// Forget every pending segment (panic: their files are deleted by the caller)
+    pub fn clear_pending(&self) {
+        self.lock().retain(|_, s| s.state != SegmentState::Pending);
+    }
+
+    /// Snapshot of the segments still waiting for upload, oldest first
+    pub fn pending(&self) -> Vec<StoredSegment> {
+        self.lock()
+            .values()
+            .filter(|s| s.state == SegmentState::Pending)
+            .cloned()
+            .collect()
+    }
+
+    /// Keep only the segments for which `keep` returns `true`
+    pub fn retain(&self, mut keep: impl FnMut(&StoredSegment) -> bool) {
+        self.lock().retain(|_, s| keep(s));
+    }
+
+    /// Apply the budget: re-measure the index, evict uploaded and local-only
+    /// segments if usage is high, then report the remaining pressure. `active_bytes` is the live recording's size and
+    /// `free_bytes` the volume's free space, of which `reserve_bytes` must stay
+    /// free whatever the budget says.
+    pub fn enforce(
+        &self,
+        active_bytes: u64,
+        free_bytes: Option<u64>,
+        reserve_bytes: u64,
+        previous: DiskPressure,
+    ) -> DiskPressure {
+        let mut segments = self.lock();
+        Self::refresh(&mut segments);
+        let mut used = active_bytes + segments.values().map(|s| s.bytes).sum::<u64>();
+        // Evicting frees disk as fast as it lowers usage, so the limit holds throughout
+        let disk_limit = free_bytes.map(|free| (used + free).saturating_sub(reserve_bytes));
+        let limit = match (self.budget_bytes, disk_limit) {
+            (0, None) => return DiskPressure::Normal,
+            (0, Some(disk)) => disk,
+            (budget, None) => budget,
+            (budget, Some(disk)) => budget.min(disk),
+        };
+
+        let evict_above = (limit as f64 * COMPRESS_RELEASE_FRACTION) as u64;
+        let mut evicted = 0;
+        while used > evict_above {
+            let Some(chunk_id) = segments
+                .values()
+                .find(|s| s.state.is_evictable())
+                .map(|s| s.chunk_id.clone())
+            else {
+                break;
+            };
+            let Some(segment) = segments.remove(&chunk_id) else {
+                break;
+            };
+            segment.delete_files();
+            used = used.saturating_sub(segment.bytes);
+            evicted += 1;
+        }
+        if evicted > 0 {
+            info!(
+                "Evicted {} uploaded or local segment(s) to stay within the disk budget",
+                evicted
+            );
+        }
+
+        DiskPressure::at(used, limit, previous)
+    }
+
+    /// Drop entries whose files are gone and update sizes that changed on disk,
+    /// so segments deleted by hand stop counting against the budget
+    fn refresh(segments: &mut Ledger<StoredSegment>) {
+        let mut missing = Vec::new();
+        let mut resized = Vec::new();
+        for segment in segments.values() {
+            if !segment.files_exist() {
+                missing.push(segment.chunk_id.clone());
+                continue;
+            }
+            let mut measured = segment.clone();
+            measured.measure();
+            if measured.bytes != segment.bytes {
+                resized.push(measured);
+            }
+        }
+        if !missing.is_empty() {
+            info!(
+                "Dropping {} segment(s) whose files no longer exist from the store",
+                missing.len()
+            );
+            segments.retain(|chunk_id, _| !missing.iter().any(|m| m == chunk_id));
+        }
+        for segment in resized {
+            segments.insert(segment.chunk_id.clone(), segment);
+        }
+    }
+}
+
+/// Read a whole-file index written before the store moved to a ledger
+fn read_index(path: &Path) -> Option<Vec<StoredSegment>> {
+    let json = std::fs::read_to_string(path).ok()?;
+    match serde_json::from_str(&json) {
+        Ok(segments) => Some(segments),
+        Err(e) => {
+            warn!("Ignoring unreadable segment index {:?}: {}", path, e);
+            None
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const MB: u64 = 1024 * 1024;
+
+    fn test_dir(name: &str) -> PathBuf {
+        let dir =
+            std::env::temp_dir().join(format!("crowd-cast-store-{}-{}", name, std::process::id()));
+        let _ = std::fs::create_dir_all(&dir);
+        dir
+    }
+
+    fn segment(dir: &Path, name: &str, video_bytes: u64) -> StoredSegment {
+        let video_path = dir.join(format!("{}.mp4", name));
+        let input_path = dir.join(format!("input_{}.msgpack", name));
+        std::fs::write(&video_path, vec![0u8; video_bytes as usize]).unwrap();
+        std::fs::write(&input_path, b"keylog").unwrap();
+        StoredSegment {
+            chunk_id: name.to_string(),
+            session_id: "session".to_string(),
+            video_path: Some(video_path),
+            input_path,
+            buffered_at_epoch_s: 0,
+            state: SegmentState::Pending,
+            bytes: 0,
+        }
+    }
+
+    #[test]
+    fn evicts_oldest_uploaded_and_never_pending() {
+        let dir = test_dir("evict");
+        let store = SegmentStore::with_ledger(10 * MB, Ledger::open(Some(dir.join("index.jsonl"))));
+        for name in ["a", "b", "c", "d"] {
+            store.insert(segment(&dir, name, 2 * MB));
+        }
+        store.mark_uploaded("a", false);
+        store.mark_uploaded("b", false);
+
+        // 8 MB of 10: above the compress level, so uploaded segments go, oldest
+        // first, until usage is back under the compress release level
+        let pressure = store.enforce(0, None, 0, DiskPressure::Normal);
+        assert!(!dir.join("a.mp4").exists());
+        assert!(dir.join("b.mp4").exists());
+        assert_eq!(pressure, DiskPressure::Normal);
+
+        // With only pending segments left to evict, usage stays put
+        store.mark_uploaded("c", true);
+        store.insert(segment(&dir, "e", 4 * MB));
+        store.enforce(0, None, 0, DiskPressure::Normal);
+        assert!(!dir.join("b.mp4").exists());
+        assert!(dir.join("d.mp4").exists());
+        assert!(dir.join("e.mp4").exists());
+        let pending: Vec<_> = store.pending().into_iter().map(|s| s.chunk_id).collect();
+        assert_eq!(pending, ["d", "e"]);
+
+        // The persisted index reflects the evictions
+        let reopened = Ledger::<StoredSegment>::open(Some(dir.join("index.jsonl")));
+        assert_eq!(reopened.keys().collect::<Vec<_>>(), ["d", "e"]);
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn local_segments_are_evictable_and_deleted_files_leave_the_index() {
+        let dir = test_dir("local");
+        let store = SegmentStore::with_ledger(10 * MB, Ledger::open(None));
+        for name in ["a", "b", "c", "d", "e"] {
+            let mut local = segment(&dir, name, 2 * MB);
+            local.state = SegmentState::Local;
+            store.insert(local);
+        }
+        // 10 MB of 10 would pause; local segments go oldest first instead
+        assert_eq!(
+            store.enforce(0, None, 0, DiskPressure::Normal),
+            DiskPressure::Normal
+        );
+        assert!(!dir.join("b.mp4").exists());
+        assert!(dir.join("c.mp4").exists());
+
+        // Files removed by hand stop counting against the budget
+        store.insert(segment(&dir, "f", 4 * MB));
+        for name in ["c", "d"] {
+            let _ = std::fs::remove_file(dir.join(format!("{}.mp4", name)));
+            let _ = std::fs::remove_file(dir.join(format!("input_{}.msgpack", name)));
+        }
+        assert_eq!(
+            store.enforce(0, None, 0, DiskPressure::Normal),
+            DiskPressure::Normal
+        );
+        assert!(dir.join("e.mp4").exists());
+        assert_eq!(store.lock().len(), 2);
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn escalates_to_pause_with_only_pending_segments() {
+        let dir = test_dir("pause");
+        let store = SegmentStore::with_ledger(10 * MB, Ledger::open(None));
+        for name in ["a", "b", "c", "d"] {
+            store.insert(segment(&dir, name, 2 * MB));
+        }
+        assert_eq!(
+            store.enforce(MB, None, 0, DiskPressure::Normal),
+            DiskPressure::Compress
+        );
+        assert_eq!(
+            store.enforce(3 * MB, None, 0, DiskPressure::Compress),
+            DiskPressure::Pause
+        );
+        // Uploads drain one segment: still within the pause hysteresis band
+        store.mark_uploaded("a", true);
+        assert_eq!(
+            store.enforce(3 * MB, None, 0, DiskPressure::Pause),
+            DiskPressure::Pause
+        );
+        store.mark_uploaded("b", true);
+        assert_eq!(
+            store.enforce(3 * MB, None, 0, DiskPressure::Pause),
+            DiskPressure::Compress
+        );
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn free_space_reserve_bounds_an_unlimited_budget() {
+        let dir = test_dir("reserve");
+        let store = SegmentStore::with_ledger(0, Ledger::open(None));
+        store.insert(segment(&dir, "a", 4 * MB));
+        assert_eq!(
+            store.enforce(0, None, 0, DiskPressure::Normal),
+            DiskPressure::Normal
+        );
+        // 4 MB stored and 1 MB free under a 2 MB reserve: the limit is 3 MB
+        assert_eq!(
+            store.enforce(0, Some(MB), 2 * MB, DiskPressure::Normal),
+            DiskPressure::Pause
+        );
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+
+    #[test]
+    fn legacy_manifest_entries_decode_as_pending() {
+        let json = r#"[{"chunk_id":"c1","session_id":"s","video_path":null,
+            "input_path":"/tmp/input_c1.msgpack","buffered_at_epoch_s":1}]"#;
+        let entries: Vec<StoredSegment> = serde_json::from_str(json).unwrap();
+        assert_eq!(entries[0].state, SegmentState::Pending);
+        assert_eq!(entries[0].bytes, 0);
+    }
+}
@@ -460,6 +460,20 @@ pub fn show_low_disk_notification(free_mb: u64) {
     );
 }
 
+/// Recording paused because local segments filled the disk budget. No macOS
+/// toast yet, as for the low-disk warning.
+#[cfg(target_os = "macos")]
+pub fn show_disk_budget_paused_notification() {}
+
+/// Recording paused because local segments filled the disk budget (non-macOS).
+#[cfg(not(target_os = "macos"))]
+pub fn show_disk_budget_paused_notification() {
+    emit(
+        "Recording paused",
+        "Storage limit reached. Recording resumes once pending uploads finish.",
+    );
+}
+
 /// Feedback toast for a manual "Check for Updates" (macOS uses Sparkle's own UI).
 #[cfg(target_os = "macos")]
 pub fn show_update_check_notification(_message: &str) {}
@@ -39,7 +39,9 @@ pub struct TrayIconPaths {
 /// Full display state for the tray menu.
 ///
 /// `TrayApp` maintains this state and passes it to the platform tray
-/// whenever a refresh is needed.
+/// whenever a refresh is needed. Backends compare it against the state they last
+/// applied so unchanged items aren't touched.
+#[derive(Clone, Debug, PartialEq, Eq)]
 pub struct TrayDisplayState {
     /// Which icon variant to show.
     pub icon_state: TrayIconState,
@@ -41,6 +41,12 @@ int tray_loop(int blocking);
 /* Update the tray icon, tooltip, and menu */
 void tray_update(struct tray *tray);
 
+/* Update the tray icon, tooltip, and the title / disabled / checked state of
+ * the menu items already shown, matched by position. The native menu is only
+ * rebuilt when the menu's shape (item count, separators, submenus) differs
+ * from the one last built. */
+void tray_update_items(struct tray *tray);
+
 /* Tear down AppKit tray state before replacing the process */
 void tray_prepare_for_restart(void);
 
@@ -251,12 +251,27 @@ impl TrayApp {
             Some(EngineStatus::Idle) => {
                 ("Status: Idle".to_string(), TrayIconState::Idle, true, false)
             }
-            Some(EngineStatus::Capturing { event_count }) => (
+            Some(EngineStatus::Capturing {
+                event_count,
+                dropped_events: 0,
+            }) => (
                 format!("Status: Capturing ({} events)", event_count),
                 TrayIconState::Recording,
                 false,
                 true,
             ),
+            Some(EngineStatus::Capturing {
+                event_count,
+                dropped_events,
+            }) => (
+                format!(
+                    "Status: Capturing ({} events, {} dropped)",
+                    event_count, dropped_events
+                ),
+                TrayIconState::Recording,
+                false,
+                true,
+            ),
             Some(EngineStatus::Paused) => (
                 "Status: Idle (paused)".to_string(),
                 TrayIconState::Idle,
@@ -518,8 +533,13 @@ impl TrayApp {
             "Tray status updated: {}",
             match status {
                 EngineStatus::Idle => "Idle".to_string(),
-                EngineStatus::Capturing { event_count } =>
-                    format!("Capturing ({} events)", event_count),
+                EngineStatus::Capturing {
+                    event_count,
+                    dropped_events,
+                } => format!(
+                    "Capturing ({} events, {} dropped)",
+                    event_count, dropped_events
+                ),
                 EngineStatus::Paused => "Paused".to_string(),
                 EngineStatus::RecordingBlocked => "RecordingBlocked".to_string(),
                 EngineStatus::WaitingForOBS => "WaitingForOBS".to_string(),
@@ -700,7 +720,8 @@ mod tests {
     #[test]
     fn update_blocking_statuses_match_policy() {
         assert!(status_blocks_immediate_update(&EngineStatus::Capturing {
-            event_count: 1
+            event_count: 1,
+            dropped_events: 0,
         }));
         assert!(status_blocks_immediate_update(
             &EngineStatus::RecordingBlocked
@@ -721,7 +742,8 @@ mod tests {
     #[test]
     fn prepare_for_update_only_targets_active_recording_states() {
         assert!(status_needs_prepare_for_update(&EngineStatus::Capturing {
-            event_count: 1
+            event_count: 1,
+            dropped_events: 0,
         }));
         assert!(status_needs_prepare_for_update(&EngineStatus::Paused));
         assert!(status_needs_prepare_for_update(
@@ -740,7 +762,10 @@ mod tests {
     #[test]
     fn prepare_for_update_action_is_one_shot_and_status_driven() {
         assert_eq!(
-            next_prepare_for_update_action(true, Some(&EngineStatus::Capturing { event_count: 1 })),
+            next_prepare_for_update_action(true, Some(&EngineStatus::Capturing {
+                    event_count: 1,
+                    dropped_events: 0,
+                })),
             PrepareForUpdateAction::SendCommand
         );
         assert_eq!(
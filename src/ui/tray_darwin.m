@@ -10,6 +10,7 @@
 
 static NSStatusItem *statusItem = nil;
 static NSMenu *menu = nil;
+static NSString *lastIconPath = nil;
 static struct tray *currentTray = nil;
 static BOOL shouldExit = NO;
 static BOOL screenUnlocked = NO;
@@ -133,6 +134,64 @@ static NSMenu *_tray_menu(struct tray_menu *m) {
     return menu;
 }
 
+// YES if `nsmenu` was built from a menu of the same shape as `m`: as many
+// items, with separators and submenus in the same places.
+static BOOL _tray_menu_same_shape(NSMenu *nsmenu, struct tray_menu *m) {
+    NSInteger i = 0;
+    for (; m != NULL && m->text != NULL; m++, i++) {
+        if (i >= nsmenu.numberOfItems) {
+            return NO;
+        }
+        NSMenuItem *item = [nsmenu itemAtIndex:i];
+        BOOL separator = strcmp(m->text, "-") == 0;
+        if (separator != item.isSeparatorItem) {
+            return NO;
+        }
+        if ((m->submenu != NULL) != (item.submenu != nil)) {
+            return NO;
+        }
+        if (m->submenu != NULL && !_tray_menu_same_shape(item.submenu, m->submenu)) {
+            return NO;
+        }
+    }
+    return i == nsmenu.numberOfItems;
+}
+
+// Copy titles and enabled/checked state onto a menu of the same shape. Only
+// properties that actually changed are set: every setter re-lays out the menu
+// if it is open, which is what made per-second rebuilds flicker.
+static void _tray_menu_apply(NSMenu *nsmenu, struct tray_menu *m) {
+    NSInteger i = 0;
+    for (; m != NULL && m->text != NULL; m++, i++) {
+        NSMenuItem *item = [nsmenu itemAtIndex:i];
+        if (item.isSeparatorItem) {
+            continue;
+        }
+
+        NSString *title = [NSString stringWithUTF8String:m->text];
+        if (![item.title isEqualToString:title]) {
+            [item setTitle:title];
+        }
+        BOOL enabled = m->disabled ? NO : YES;
+        if (item.enabled != enabled) {
+            [item setEnabled:enabled];
+        }
+        NSControlStateValue state = m->checked ? NSControlStateValueOn : NSControlStateValueOff;
+        if (item.state != state) {
+            [item setState:state];
+        }
+        // The caller may have moved its item array since the menu was built
+        NSValue *ptrValue = item.representedObject;
+        if (ptrValue == nil || [ptrValue pointerValue] != m) {
+            [item setRepresentedObject:[NSValue valueWithPointer:m]];
+        }
+
+        if (m->submenu != NULL) {
+            _tray_menu_apply(item.submenu, m->submenu);
+        }
+    }
+}
+
 static NSStatusItem *create_status_item(void) {
     NSStatusItem *item = [[NSStatusBar systemStatusBar]
         statusItemWithLength:NSVariableStatusItemLength];
@@ -354,7 +413,9 @@ int tray_loop(int blocking) {
     }
 }
 
-void tray_update(struct tray *tray) {
+// Shared body of tray_update / tray_update_items. With `diffMenu`, a menu of
+// unchanged shape is patched in place instead of rebuilt.
+static void tray_apply(struct tray *tray, BOOL diffMenu) {
     void (^updateBlock)(void) = ^{
         @autoreleasepool {
             @try {
@@ -375,26 +436,37 @@ void tray_update(struct tray *tray) {
                 // Always ensure visible (macOS can hide items after display changes)
                 statusItem.visible = YES;
 
-                // Update icon
+                // Update icon (reloaded from disk only when the path changes)
                 if (tray->icon_filepath != NULL) {
                     NSString *path = [NSString stringWithUTF8String:tray->icon_filepath];
-                    NSImage *image = [[NSImage alloc] initWithContentsOfFile:path];
-                    if (image != nil) {
-                        [image setSize:NSMakeSize(18, 18)];
-                        [image setTemplate:NO];
-                        statusItem.button.image = image;
+                    if (!diffMenu || ![path isEqualToString:lastIconPath]) {
+                        NSImage *image = [[NSImage alloc] initWithContentsOfFile:path];
+                        if (image != nil) {
+                            [image setSize:NSMakeSize(18, 18)];
+                            [image setTemplate:NO];
+                            statusItem.button.image = image;
+                            lastIconPath = path;
+                        }
                     }
                 }
 
                 // Update tooltip
                 if (tray->tooltip != NULL) {
-                    statusItem.button.toolTip = [NSString stringWithUTF8String:tray->tooltip];
+                    NSString *tooltip = [NSString stringWithUTF8String:tray->tooltip];
+                    if (![statusItem.button.toolTip isEqualToString:tooltip]) {
+                        statusItem.button.toolTip = tooltip;
+                    }
                 }
 
                 // Update menu
                 if (tray->menu != NULL) {
-                    menu = _tray_menu(tray->menu);
-                    statusItem.menu = menu;
+                    if (diffMenu && menu != nil && statusItem.menu == menu
+                        && _tray_menu_same_shape(menu, tray->menu)) {
+                        _tray_menu_apply(menu, tray->menu);
+                    } else {
+                        menu = _tray_menu(tray->menu);
+                        statusItem.menu = menu;
+                    }
                 }
                 check_status_item_health();
             } @catch (NSException *exception) {
@@ -411,6 +483,14 @@ void tray_update(struct tray *tray) {
     }
 }
 
+void tray_update(struct tray *tray) {
+    tray_apply(tray, NO);
+}
+
+void tray_update_items(struct tray *tray) {
+    tray_apply(tray, YES);
+}
+
 static void tray_teardown_on_main(void) {
     if (unlockObserver != nil) {
         [[NSDistributedNotificationCenter defaultCenter] removeObserver:unlockObserver];
@@ -428,6 +508,7 @@ static void tray_teardown_on_main(void) {
     }
 
     menu = nil;
+    lastIconPath = nil;
     currentTray = nil;
     statusItemDetachedSince = 0;
     statusItemWasAttached = NO;
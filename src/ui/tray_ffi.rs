@@ -49,6 +49,11 @@ extern "C" {
     /// Update the tray icon, tooltip, and menu
     pub fn tray_update(tray: *mut Tray);
 
+    /// Update the icon, tooltip, and existing menu items' text and
+    /// disabled/checked state in place (items matched by position). Rebuilds
+    /// the native menu only when its shape changed.
+    pub fn tray_update_items(tray: *mut Tray);
+
     /// Remove the AppKit status item before replacing the process
     pub fn tray_prepare_for_restart();
 
@@ -82,6 +87,9 @@ pub unsafe fn tray_loop(_blocking: c_int) -> c_int {
 #[cfg(any(no_tray, target_os = "linux"))]
 pub unsafe fn tray_update(_tray: *mut Tray) {}
 
+#[cfg(any(no_tray, target_os = "linux"))]
+pub unsafe fn tray_update_items(_tray: *mut Tray) {}
+
 #[cfg(any(no_tray, target_os = "linux"))]
 pub unsafe fn tray_prepare_for_restart() {}
 
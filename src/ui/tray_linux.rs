@@ -314,6 +314,8 @@ pub struct LinuxTray {
     action_rx: Receiver<TrayAction>,
     host_present: Arc<AtomicBool>,
     last_host_logged: Option<bool>,
+    /// State last pushed to the SNI model
+    last_state: Option<TrayDisplayState>,
 }
 
 impl LinuxTray {
@@ -328,6 +330,7 @@ impl LinuxTray {
             action_rx,
             host_present: Arc::new(AtomicBool::new(false)),
             last_host_logged: None,
+            last_state: None,
         })
     }
 }
@@ -399,6 +402,12 @@ impl PlatformTray for LinuxTray {
         let Some(handle) = self.handle.as_ref() else {
             return;
         };
+        // Every `Handle::update` makes ksni re-render the menu and icon and signal
+        // the host, and statuses stream in every second: skip unchanged states.
+        if self.last_state.as_ref() == Some(state) {
+            return;
+        }
+        self.last_state = Some(state.clone());
 
         let icon_state = state.icon_state;
         let status_text = state.status_text.clone();
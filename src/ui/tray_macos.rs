@@ -147,6 +147,8 @@ pub struct MacOSTray {
     _tooltip: CString,
     menu_items: Vec<TrayMenuItem>,
     menu_strings: Vec<CString>,
+    /// State last pushed to the native menu
+    last_state: Option<TrayDisplayState>,
 }
 
 impl MacOSTray {
@@ -308,6 +310,7 @@ impl MacOSTray {
             _tooltip: tooltip,
             menu_items,
             menu_strings,
+            last_state: None,
         })
     }
 }
@@ -404,6 +407,11 @@ impl PlatformTray for MacOSTray {
     }
 
     fn update(&mut self, state: &TrayDisplayState) {
+        // Statuses stream in every second; most carry nothing new for the menu
+        if self.last_state.as_ref() == Some(state) {
+            return;
+        }
+
         // Status text
         if let Ok(text) = CString::new(state.status_text.as_bytes()) {
             self.menu_strings[MENU_STATUS] = text;
@@ -439,11 +447,13 @@ impl PlatformTray for MacOSTray {
         // Icon
         self.tray.icon_filepath = self.icons.path_for(state.icon_state);
 
-        // Apply
+        // Apply: the menu's shape never changes, so the native side only patches
+        // the items that differ instead of rebuilding the NSMenu
         self.tray.menu = self.menu_items.as_mut_ptr();
         unsafe {
-            tray_ffi::tray_update(&mut self.tray);
+            tray_ffi::tray_update_items(&mut self.tray);
         }
+        self.last_state = Some(state.clone());
     }
 
     fn prepare_for_restart(&mut self) {
@@ -44,6 +44,8 @@ pub struct WindowsTray {
     sign_item: MenuItem,
     updates_item: MenuItem,
     last_icon_state: Option<TrayIconState>,
+    /// State last applied to the menu items
+    last_state: Option<TrayDisplayState>,
 }
 
 impl WindowsTray {
@@ -101,6 +103,7 @@ impl WindowsTray {
             sign_item,
             updates_item,
             last_icon_state: None,
+            last_state: None,
         })
     }
 
@@ -176,14 +179,34 @@ impl PlatformTray for WindowsTray {
     }
 
     fn update(&mut self, state: &TrayDisplayState) {
-        self.status_item.set_text(&state.status_text);
-        self.account_item.set_text(&state.account_text);
-        self.start_item.set_enabled(state.can_start);
-        self.stop_item.set_enabled(state.can_stop);
-        self.uploads_item.set_text(&state.uploads_text);
-        self.sign_item.set_text(&state.sign_action_text);
-        self.sign_item.set_enabled(state.auth_action_enabled);
-        self.updates_item.set_enabled(state.can_check_updates);
+        // Each muda setter rewrites the native item (and redraws an open menu), so
+        // only touch what changed since the last update.
+        let last = self.last_state.as_ref();
+        if last.map(|l| &l.status_text) != Some(&state.status_text) {
+            self.status_item.set_text(&state.status_text);
+        }
+        if last.map(|l| &l.account_text) != Some(&state.account_text) {
+            self.account_item.set_text(&state.account_text);
+        }
+        if last.map(|l| l.can_start) != Some(state.can_start) {
+            self.start_item.set_enabled(state.can_start);
+        }
+        if last.map(|l| l.can_stop) != Some(state.can_stop) {
+            self.stop_item.set_enabled(state.can_stop);
+        }
+        if last.map(|l| &l.uploads_text) != Some(&state.uploads_text) {
+            self.uploads_item.set_text(&state.uploads_text);
+        }
+        if last.map(|l| &l.sign_action_text) != Some(&state.sign_action_text) {
+            self.sign_item.set_text(&state.sign_action_text);
+        }
+        if last.map(|l| l.auth_action_enabled) != Some(state.auth_action_enabled) {
+            self.sign_item.set_enabled(state.auth_action_enabled);
+        }
+        if last.map(|l| l.can_check_updates) != Some(state.can_check_updates) {
+            self.updates_item.set_enabled(state.can_check_updates);
+        }
+        self.last_state = Some(state.clone());
 
         if self.last_icon_state != Some(state.icon_state) {
             if let Some(tray) = self.tray.as_ref() {
@@ -3,11 +3,12 @@
 //! The agent process owns libobs, whose Wayland path runs a GLib loop on the
 //! default context. Like the Settings panel, this dialog must render in a clean
 //! child process so GTK is never initialized inside the libobs-owning process.
+//! Status snapshots are pushed to it over its stdin as they change, so the
+//! dialog only wakes when there is something new to show.
 
 use anyhow::{Context as _, Result};
-use std::ffi::CString;
-use std::path::{Path, PathBuf};
-use std::process::{Child, Command};
+use std::io::Write;
+use std::process::{Child, ChildStdin, Command, Stdio};
 use tracing::warn;
 
 #[derive(Debug, Clone, PartialEq, Eq)]
@@ -91,45 +92,65 @@ fn version_build_sentence(prefix: &str, version: &str, build: u64) -> String {
     }
 }
 
-pub fn status_path() -> PathBuf {
-    std::env::temp_dir().join(format!(
-        "crowd-cast-update-check-{}.status",
-        std::process::id()
-    ))
-}
-
-pub fn write_status(path: &Path, status: &UpdateDialogStatus) -> Result<()> {
-    let body = format!(
+/// Wire form of one snapshot, as read by `show_update_check_dialog`: four
+/// newline-separated fields terminated by a NUL (which is why the text fields
+/// must not contain one).
+fn encode_status(status: &UpdateDialogStatus) -> Vec<u8> {
+    let mut record = format!(
         "{}\n{}\n{}\n{}",
         if status.done { "1" } else { "0" },
         if status.error { "1" } else { "0" },
-        status.title,
-        status.message
-    );
-
-    let tmp = path.with_extension("tmp");
-    std::fs::write(&tmp, body)
-        .with_context(|| format!("writing update dialog status to {}", tmp.display()))?;
-    std::fs::rename(&tmp, path)
-        .with_context(|| format!("publishing update dialog status to {}", path.display()))?;
-    Ok(())
+        status.title.replace(['\n', '\0'], " "),
+        status.message.replace('\0', "")
+    )
+    .into_bytes();
+    record.push(0);
+    record
 }
 
-pub fn spawn_status_dialog(path: &Path) -> Result<()> {
-    let exe = std::env::current_exe().context("locating current executable")?;
-    let mut child = Command::new(&exe)
-        .arg("--update-check-dialog")
-        .arg(path)
-        .spawn()
-        .with_context(|| {
-            format!(
-                "spawning update-check dialog subprocess from {}",
-                exe.display()
-            )
-        })?;
-
-    std::thread::spawn(move || wait_for_dialog(&mut child));
-    Ok(())
+/// A running update-check dialog subprocess. Dropping it closes the channel;
+/// the dialog keeps showing the last snapshot until the user closes it.
+pub struct StatusDialog {
+    stdin: Option<ChildStdin>,
+}
+
+impl StatusDialog {
+    pub fn spawn(initial: &UpdateDialogStatus) -> Result<Self> {
+        let exe = std::env::current_exe().context("locating current executable")?;
+        let mut child = Command::new(&exe)
+            .arg("--update-check-dialog")
+            .stdin(Stdio::piped())
+            .spawn()
+            .with_context(|| {
+                format!(
+                    "spawning update-check dialog subprocess from {}",
+                    exe.display()
+                )
+            })?;
+
+        let mut dialog = Self {
+            stdin: child.stdin.take(),
+        };
+        std::thread::spawn(move || wait_for_dialog(&mut child));
+        dialog.send(initial)?;
+        Ok(dialog)
+    }
+
+    /// Show `status`. A dialog the user already closed is not an error: the
+    /// check carries on without it.
+    pub fn send(&mut self, status: &UpdateDialogStatus) -> Result<()> {
+        let Some(stdin) = self.stdin.as_mut() else {
+            return Ok(());
+        };
+        match stdin.write_all(&encode_status(status)) {
+            Ok(()) => Ok(()),
+            Err(e) if e.kind() == std::io::ErrorKind::BrokenPipe => {
+                self.stdin = None;
+                Ok(())
+            }
+            Err(e) => Err(e).context("sending update dialog status"),
+        }
+    }
 }
 
 fn wait_for_dialog(child: &mut Child) {
@@ -139,13 +160,12 @@ fn wait_for_dialog(child: &mut Child) {
 }
 
 extern "C" {
-    fn show_update_check_dialog(status_path: *const std::os::raw::c_char) -> i32;
+    fn show_update_check_dialog() -> i32;
 }
 
-pub fn run_update_check_dialog_subprocess(path: &Path) -> Result<()> {
-    let path_c = CString::new(path.to_string_lossy().as_bytes())
-        .context("update dialog status path contains NUL")?;
-    let rc = unsafe { show_update_check_dialog(path_c.as_ptr()) };
+/// Child side: render the dialog, reading status snapshots from stdin
+pub fn run_update_check_dialog_subprocess() -> Result<()> {
+    let rc = unsafe { show_update_check_dialog() };
     if rc == 0 {
         Ok(())
     } else {
@@ -155,7 +175,7 @@ pub fn run_update_check_dialog_subprocess(path: &Path) -> Result<()> {
 
 #[cfg(test)]
 mod tests {
-    use super::UpdateDialogStatus;
+    use super::{encode_status, UpdateDialogStatus};
 
     #[test]
     fn formats_build_when_present() {
@@ -174,4 +194,17 @@ mod tests {
             .contains("Updated components: app, OBS runtime."));
         assert!(status.message.contains("Release notes:\nfixes"));
     }
+
+    #[test]
+    fn encoded_status_is_one_nul_terminated_record() {
+        let mut status = UpdateDialogStatus::failed("line one\nline\0 two");
+        status.title = "Update\nCheck Failed".to_string();
+        let record = encode_status(&status);
+        assert_eq!(record.last(), Some(&0));
+        assert_eq!(record.iter().filter(|&&b| b == 0).count(), 1);
+        assert_eq!(
+            std::str::from_utf8(&record[..record.len() - 1]).unwrap(),
+            "1\n1\nUpdate Check Failed\nline one\nline two"
+        );
+    }
 }
@@ -14,6 +14,11 @@
 //!   macOS `SUPublicEDKey` / Sparkle `sign_update`. The 32-byte public key is baked in at build
 //!   time (`CROWD_CAST_UPDATE_PUBKEY`); the per-artifact SHA-256 inside the signed manifest then
 //!   authenticates each download (verify-before-swap).
+//! * **Deltas**: the binary entry may list zstd `--patch-from` patches from recent releases,
+//!   keyed by the SHA-256 of the binary they apply to. When one matches the running binary, only
+//!   the patch is downloaded; the rebuilt binary must still hash to the manifest's `sha256`, so a
+//!   delta is trusted exactly as far as the full download. Any mismatch or failure falls back to
+//!   the full binary.
 //! * **Apply**: replace the running binary in place (rename-over is legal on Linux) and re-exec —
 //!   reusing the same clean-stop handshake as macOS (`EngineCommand::PrepareForUpdate`) so we
 //!   never yank the floor out from under an in-progress capture.
@@ -96,6 +101,19 @@ pub struct BinaryArtifact {
     pub url: String,
     /// Lowercase hex SHA-256 of the artifact.
     pub sha256: String,
+    /// Patches from earlier release binaries to this one. Empty for feeds that predate deltas.
+    #[serde(default)]
+    pub deltas: Vec<DeltaArtifact>,
+}
+
+/// A zstd `--patch-from` patch that turns one earlier release binary into this release's.
+#[derive(Debug, Clone, Deserialize)]
+pub struct DeltaArtifact {
+    /// SHA-256 of the binary the patch applies to.
+    pub from_sha256: String,
+    pub url: String,
+    /// SHA-256 of the patch file itself.
+    pub sha256: String,
 }
 
 #[derive(Debug, Clone, Deserialize)]
@@ -348,17 +366,83 @@ fn http_get(url: &str) -> Result<Vec<u8>> {
     })
 }
 
-fn download_verify(url: &str, expected_sha256: &str, dest: &Path) -> Result<()> {
-    let bytes = http_get(url)?;
-    let got = sha256_hex(&bytes);
+fn verify_sha256(bytes: &[u8], expected_sha256: &str, what: &str) -> Result<()> {
+    let got = sha256_hex(bytes);
     if !got.eq_ignore_ascii_case(expected_sha256.trim()) {
-        bail!("SHA-256 mismatch for {url}: manifest {expected_sha256}, got {got}");
+        bail!("SHA-256 mismatch for {what}: manifest {expected_sha256}, got {got}");
     }
+    Ok(())
+}
+
+fn write_staged(dest: &Path, bytes: &[u8]) -> Result<()> {
     if let Some(parent) = dest.parent() {
         std::fs::create_dir_all(parent).ok();
     }
-    std::fs::write(dest, &bytes).with_context(|| format!("failed to write {}", dest.display()))?;
-    Ok(())
+    std::fs::write(dest, bytes).with_context(|| format!("failed to write {}", dest.display()))
+}
+
+fn download_verify(url: &str, expected_sha256: &str, dest: &Path) -> Result<()> {
+    let bytes = http_get(url)?;
+    verify_sha256(&bytes, expected_sha256, url)?;
+    write_staged(dest, &bytes)
+}
+
+// ---------------------------------------------------------------------------
+// Delta updates
+// ---------------------------------------------------------------------------
+
+/// The manifest's patch from the binary hashing to `current_sha256`, if it lists one.
+fn select_delta<'a>(binary: &'a BinaryArtifact, current_sha256: &str) -> Option<&'a DeltaArtifact> {
+    binary
+        .deltas
+        .iter()
+        .find(|d| d.from_sha256.trim().eq_ignore_ascii_case(current_sha256))
+}
+
+/// Rebuild a binary from the one it was diffed against (`zstd --patch-from=<old> <new>`).
+fn apply_patch(old: &[u8], patch: &[u8]) -> Result<Vec<u8>> {
+    use std::io::Read;
+
+    let mut decoder = zstd::stream::read::Decoder::with_ref_prefix(patch, old)
+        .context("failed to set up the delta decoder")?;
+    // The CLI sizes the patch window to cover the old binary, beyond the decoder's default limit.
+    decoder
+        .window_log_max(31)
+        .context("failed to raise the delta window limit")?;
+    let mut out = Vec::new();
+    decoder
+        .read_to_end(&mut out)
+        .context("failed to apply the delta patch")?;
+    Ok(out)
+}
+
+/// Stage the new binary at `dest` from a delta against the running one. `Ok(false)` when the
+/// manifest has no patch for it; the caller then downloads the full binary, as it does on `Err`.
+fn stage_binary_from_delta(
+    binary: &BinaryArtifact,
+    current_exe: &Path,
+    dest: &Path,
+) -> Result<bool> {
+    if binary.deltas.is_empty() {
+        return Ok(false);
+    }
+    let old = std::fs::read(current_exe)
+        .with_context(|| format!("failed to read {}", current_exe.display()))?;
+    let Some(delta) = select_delta(binary, &sha256_hex(&old)) else {
+        return Ok(false);
+    };
+
+    let patch = http_get(&delta.url)?;
+    verify_sha256(&patch, &delta.sha256, &delta.url)?;
+    let new = apply_patch(&old, &patch)?;
+    verify_sha256(&new, &binary.sha256, "the patched binary")?;
+    write_staged(dest, &new)?;
+    info!(
+        "Auto-update: rebuilt binary from a {} KiB delta instead of the {} KiB download",
+        patch.len() / 1024,
+        new.len() / 1024
+    );
+    Ok(true)
 }
 
 fn extract_bundle(archive: &Path, dest: &Path) -> Result<()> {
@@ -512,18 +596,15 @@ impl LinuxUpdater {
             bail!("An update check is already running.");
         }
 
-        let status_path = super::update_dialog::status_path();
-        if let Err(e) = super::update_dialog::write_status(
-            &status_path,
+        let mut dialog = match super::update_dialog::StatusDialog::spawn(
             &super::update_dialog::UpdateDialogStatus::checking(),
         ) {
-            self.shared.check_in_flight.store(false, Ordering::SeqCst);
-            return Err(e);
-        }
-        if let Err(e) = super::update_dialog::spawn_status_dialog(&status_path) {
-            self.shared.check_in_flight.store(false, Ordering::SeqCst);
-            return Err(e);
-        }
+            Ok(dialog) => dialog,
+            Err(e) => {
+                self.shared.check_in_flight.store(false, Ordering::SeqCst);
+                return Err(e);
+            }
+        };
 
         let me = Arc::clone(self);
         std::thread::spawn(move || {
@@ -537,7 +618,7 @@ impl LinuxUpdater {
                     super::update_dialog::UpdateDialogStatus::failed(&format!("{e:#}"))
                 }
             };
-            if let Err(e) = super::update_dialog::write_status(&status_path, &status) {
+            if let Err(e) = dialog.send(&status) {
                 warn!("Failed to update manual update-check dialog status: {e:#}");
             }
             me.shared.check_in_flight.store(false, Ordering::SeqCst);
@@ -669,7 +750,16 @@ impl LinuxUpdater {
 
         if plan.binary_changed {
             let dest = work.join("crowd-cast-agent.new");
-            download_verify(&manifest.binary.url, &manifest.binary.sha256, &dest)?;
+            let from_delta = std::env::current_exe()
+                .context("current_exe() failed")
+                .and_then(|exe| stage_binary_from_delta(&manifest.binary, &exe, &dest))
+                .unwrap_or_else(|e| {
+                    warn!("Auto-update: delta update failed, downloading the full binary: {e:#}");
+                    false
+                });
+            if !from_delta {
+                download_verify(&manifest.binary.url, &manifest.binary.sha256, &dest)?;
+            }
             std::fs::set_permissions(&dest, std::fs::Permissions::from_mode(0o755)).ok();
             staged.new_binary = Some(dest);
         }
@@ -877,6 +967,39 @@ mod tests {
         assert_eq!(m.build, 0);
         assert!(!m.critical);
         assert_eq!(m.minimum_version, "");
+        assert!(m.binary.deltas.is_empty());
+    }
+
+    #[test]
+    fn delta_matches_running_binary_and_rebuilds_it() {
+        let old = b"crowd-cast-agent 1.0.3 \x7fELF".repeat(500);
+        let mut new = old.clone();
+        new[1234] ^= 0x55;
+        new.extend_from_slice(b"1.0.4 tail");
+
+        let mut patch = Vec::new();
+        {
+            let mut enc =
+                zstd::stream::write::Encoder::with_ref_prefix(&mut patch, 19, &old).unwrap();
+            std::io::Write::write_all(&mut enc, &new).unwrap();
+            enc.finish().unwrap();
+        }
+        assert!(patch.len() < new.len() / 10);
+        assert_eq!(apply_patch(&old, &patch).unwrap(), new);
+        // Against a different base the output is garbage or an error, never the new binary.
+        assert!(apply_patch(b"another binary", &patch).map_or(true, |out| out != new));
+
+        let binary = BinaryArtifact {
+            url: "https://example/crowd-cast-agent".into(),
+            sha256: sha256_hex(&new),
+            deltas: vec![DeltaArtifact {
+                from_sha256: sha256_hex(&old).to_uppercase(),
+                url: "https://example/crowd-cast-agent.from-old.zst".into(),
+                sha256: sha256_hex(&patch),
+            }],
+        };
+        assert!(select_delta(&binary, &sha256_hex(&old)).is_some());
+        assert!(select_delta(&binary, &sha256_hex(b"unknown")).is_none());
     }
 
     #[test]
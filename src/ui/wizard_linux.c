@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 // Must match #[repr(C)] WizardAppInfo in wizard_ffi.rs
 typedef struct {
@@ -536,21 +537,24 @@ void app_selection_free_result(AppSelectionResult *out) {
 }
 
 // ---- Manual "Check for Updates" dialog -------------------------------------
-// Rendered only from a clean subprocess. The agent writes a tiny status file:
+// Rendered only from a clean subprocess. The agent pushes status snapshots over the
+// subprocess's stdin, each terminated by a NUL byte:
 //   line 1: done flag ("0" or "1")
 //   line 2: error flag ("0" or "1")
 //   line 3: title
 //   line 4+: message body
-// The dialog polls that file and updates in place. If the user closes it early, the
-// agent-side update check continues; this is only a user-facing foreground status view.
+// A GIOChannel watch wakes the dialog only when a snapshot arrives; the newest complete
+// one is shown. EOF (the agent finished or exited) leaves the last snapshot on screen.
+// If the user closes the dialog early, the agent-side update check continues; this is
+// only a user-facing foreground status view.
 
 typedef struct {
-    char *path;
     GtkWidget *dialog;
     GtkWidget *spinner;
     GtkWidget *title;
     GtkWidget *body;
-    guint poll_id;
+    GString *pending;
+    guint watch_id;
 } UpdateCheckDialogCtx;
 
 static void update_check_set_title(GtkWidget *label, const char *title, gboolean error) {
@@ -564,15 +568,8 @@ static void update_check_set_title(GtkWidget *label, const char *title, gboolean
     g_free(esc);
 }
 
-static gboolean update_check_dialog_poll(gpointer data) {
-    UpdateCheckDialogCtx *ctx = (UpdateCheckDialogCtx *)data;
-    char *contents = NULL;
-    gsize len = 0;
-    if (!g_file_get_contents(ctx->path, &contents, &len, NULL)) {
-        return TRUE;
-    }
-
-    gchar **parts = g_strsplit(contents, "\n", 4);
+static void update_check_dialog_apply(UpdateCheckDialogCtx *ctx, const char *status) {
+    gchar **parts = g_strsplit(status, "\n", 4);
     gboolean done = parts[0] && strcmp(parts[0], "1") == 0;
     gboolean error = parts[1] && strcmp(parts[1], "1") == 0;
     const char *title = parts[2] ? parts[2] : "";
@@ -590,20 +587,47 @@ static gboolean update_check_dialog_poll(gpointer data) {
     }
 
     g_strfreev(parts);
-    g_free(contents);
+}
 
-    return TRUE;
+static gboolean update_check_dialog_on_status(GIOChannel *channel, GIOCondition cond, gpointer data) {
+    UpdateCheckDialogCtx *ctx = (UpdateCheckDialogCtx *)data;
+    GIOStatus status = G_IO_STATUS_EOF;
+
+    if (cond & G_IO_IN) {
+        char buf[4096];
+        gsize n = 0;
+        status = g_io_channel_read_chars(channel, buf, sizeof(buf), &n, NULL);
+        if (n > 0) g_string_append_len(ctx->pending, buf, (gssize)n);
+
+        // Several snapshots may arrive in one read; only the newest complete one matters.
+        char *latest = NULL;
+        char *nul;
+        while ((nul = memchr(ctx->pending->str, '\0', ctx->pending->len)) != NULL) {
+            g_free(latest);
+            latest = g_strndup(ctx->pending->str, (gsize)(nul - ctx->pending->str));
+            g_string_erase(ctx->pending, 0, nul - ctx->pending->str + 1);
+        }
+        if (latest) {
+            update_check_dialog_apply(ctx, latest);
+            g_free(latest);
+        }
+    }
+
+    if (status == G_IO_STATUS_NORMAL || status == G_IO_STATUS_AGAIN) {
+        return TRUE;
+    }
+    ctx->watch_id = 0;
+    return FALSE;
 }
 
-int show_update_check_dialog(const char *status_path) {
-    if (!status_path || !status_path[0]) return 1;
+int show_update_check_dialog(void) {
     if (!gtk_init_check(NULL, NULL)) {
         return 2;
     }
 
     UpdateCheckDialogCtx ctx;
     memset(&ctx, 0, sizeof(ctx));
-    ctx.path = g_strdup(status_path);
+    ctx.pending = g_string_new(NULL);
 
     ctx.dialog = gtk_dialog_new_with_buttons(
         "crowd-cast updates", NULL, GTK_DIALOG_MODAL,
@@ -639,17 +663,23 @@ int show_update_check_dialog(const char *status_path) {
     gtk_box_pack_start(GTK_BOX(text_col), ctx.body, TRUE, TRUE, 0);
 
     gtk_widget_show_all(ctx.dialog);
-    update_check_dialog_poll(&ctx);
-    ctx.poll_id = g_timeout_add(250, update_check_dialog_poll, &ctx);
+
+    // Raw bytes, one read per wakeup: no encoding conversion, no read-ahead buffering.
+    GIOChannel *channel = g_io_channel_unix_new(STDIN_FILENO);
+    g_io_channel_set_encoding(channel, NULL, NULL);
+    g_io_channel_set_buffered(channel, FALSE);
+    ctx.watch_id = g_io_add_watch(channel, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                  update_check_dialog_on_status, &ctx);
 
     gtk_dialog_run(GTK_DIALOG(ctx.dialog));
 
-    if (ctx.poll_id != 0) {
-        g_source_remove(ctx.poll_id);
-        ctx.poll_id = 0;
+    if (ctx.watch_id != 0) {
+        g_source_remove(ctx.watch_id);
+        ctx.watch_id = 0;
     }
+    g_io_channel_unref(channel);
     gtk_widget_destroy(ctx.dialog);
     while (gtk_events_pending()) gtk_main_iteration();
-    g_free(ctx.path);
+    g_string_free(ctx.pending, TRUE);
     return 0;
 }
@@ -6,27 +6,52 @@
 //! (`uploads/<version>/<user>/logs/`). The metadata pipeline ignores them —
 //! it only matches `recording_*.mp4` / `input_*.msgpack` keys.
 //!
-//! Shipping rule: a file whose on-disk size differs from the size recorded
-//! at its last successful upload is re-uploaded in full, overwriting the
-//! same S3 key. That one rule covers all three file kinds:
-//! - the live daily log re-ships as it grows (same-day remote debugging,
-//!   at most one tick of lag),
-//! - a rotated daily ships one final time after midnight and then never
+//! Shipping rule: each pass uploads only the bytes a file gained since its
+//! last shipped offset, zstd-compressed, as the next numbered part
+//! `<remote_name>.NNNN.zst`. Concatenated zstd frames decompress to the
+//! concatenated input, so `cat <remote_name>.*.zst | zstd -d` rebuilds the
+//! file. The one rule covers every file kind:
+//! - the live daily log ships its new lines as it grows (same-day remote
+//!   debugging, at most one tick of lag),
+//! - a rotated daily ships its last lines after midnight and then never
 //!   again,
-//! - the cumulative crash.log re-ships whenever a new crash appends to it.
+//! - the cumulative crash.log ships each new crash as it is appended,
+//! - the daily metrics snapshot file (see `crate::metrics`) ships each
+//!   snapshot as it is appended, like the live daily log.
+//!
+//! A file that was shipped whole before parts existed keeps that object
+//! (`<remote_name>`) as the prefix its parts continue from, starting at part
+//! 1. A file that shrank was replaced: it ships again from offset 0, in
+//! parts numbered after the old ones.
+//!
+//! Compressed parts need a backend that accepts `.zst` keys. Where the
+//! presign endpoint refuses one, shipping falls back to the original rule for
+//! the rest of the process: a file whose size changed is re-uploaded whole
+//! as plain text to `<remote_name>`. The recorded offset still advances, so
+//! parts pick up where the whole upload ended once the backend accepts them.
 
 use std::collections::HashMap;
-use std::path::PathBuf;
+use std::io::{Read, Seek, SeekFrom};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, Ordering};
 use std::time::Duration;
 
+use serde::{Deserialize, Serialize};
 use tracing::{debug, warn};
 
-use super::Uploader;
+use super::{presign_refused, Uploader};
 
 /// Only ship files touched within this window. Bounds the first-rollout
 /// backfill and skips stale files from long-dead installs.
 const MAX_LOG_AGE: Duration = Duration::from_secs(30 * 24 * 60 * 60);
 
+/// Uncompressed bytes per part, so a first pass over a large file ships it
+/// in bounded uploads rather than one
+const MAX_PART_BYTES: u64 = 8 * 1024 * 1024;
+
+/// Logs are repetitive text; a low level already shrinks them ~10x
+const ZSTD_LEVEL: i32 = 3;
+
 /// Map a local log file name to its S3 name under `logs/`, or `None` for
 /// files we don't ship. Rotated dailies are renamed
 /// `crowd-cast.log.YYYY-MM-DD` -> `crowd-cast-YYYY-MM-DD.log` because the
@@ -35,6 +60,13 @@ fn remote_log_name(local_name: &str) -> Option<String> {
     if local_name == "crash.log" {
         return Some(local_name.to_string());
     }
+    if local_name
+        .strip_prefix(crate::metrics::METRICS_FILE_PREFIX)
+        .and_then(|rest| rest.strip_suffix(".log"))
+        .is_some_and(|date| !date.is_empty())
+    {
+        return Some(local_name.to_string());
+    }
     let date = local_name.strip_prefix("crowd-cast.log.")?;
     if date.is_empty() {
         return None;
@@ -42,10 +74,66 @@ fn remote_log_name(local_name: &str) -> Option<String> {
     Some(format!("crowd-cast-{}.log", date))
 }
 
+/// What has been shipped of one log file
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
+struct Shipped {
+    /// Bytes of the file shipped so far
+    offset: u64,
+    /// Number the next part uploads as
+    next_part: u32,
+}
+
+impl Default for Shipped {
+    fn default() -> Self {
+        Self {
+            offset: 0,
+            next_part: 1,
+        }
+    }
+}
+
+/// A state entry as stored. Entries written before part shipping are the
+/// size that was uploaded whole to the file's own key.
+#[derive(Deserialize)]
+#[serde(untagged)]
+enum StoredShipped {
+    Parts(Shipped),
+    Whole(u64),
+}
+
+impl From<StoredShipped> for Shipped {
+    fn from(stored: StoredShipped) -> Self {
+        match stored {
+            StoredShipped::Parts(shipped) => shipped,
+            StoredShipped::Whole(len) => Shipped {
+                offset: len,
+                next_part: 1,
+            },
+        }
+    }
+}
+
+fn part_name(remote_name: &str, part: u32) -> String {
+    format!("{}.{:04}.zst", remote_name, part)
+}
+
+/// Read up to `max` bytes of `path` from `offset` and compress them as one
+/// zstd frame. Returns the frame and the uncompressed byte count.
+fn read_part(path: &Path, offset: u64, max: u64) -> std::io::Result<(Vec<u8>, u64)> {
+    let mut file = std::fs::File::open(path)?;
+    file.seek(SeekFrom::Start(offset))?;
+    let mut raw = Vec::new();
+    file.take(max).read_to_end(&mut raw)?;
+    let compressed = zstd::bulk::compress(&raw, ZSTD_LEVEL)?;
+    Ok((compressed, raw.len() as u64))
+}
+
 pub struct LogShipper {
     uploader: Uploader,
     log_dir: PathBuf,
     state_path: PathBuf,
+    /// The backend refused a `.zst` part key; ship whole plain-text files
+    plain_text: AtomicBool,
 }
 
 impl LogShipper {
@@ -59,17 +147,19 @@ impl LogShipper {
             uploader,
             log_dir,
             state_path,
+            plain_text: AtomicBool::new(false),
         })
     }
 
-    fn read_state(&self) -> HashMap<String, u64> {
+    fn read_state(&self) -> HashMap<String, Shipped> {
         std::fs::read_to_string(&self.state_path)
             .ok()
-            .and_then(|s| serde_json::from_str(&s).ok())
+            .and_then(|s| serde_json::from_str::<HashMap<String, StoredShipped>>(&s).ok())
+            .map(|state| state.into_iter().map(|(k, v)| (k, v.into())).collect())
             .unwrap_or_default()
     }
 
-    fn write_state(&self, state: &HashMap<String, u64>) {
+    fn write_state(&self, state: &HashMap<String, Shipped>) {
         if let Some(parent) = self.state_path.parent() {
             let _ = std::fs::create_dir_all(parent);
         }
@@ -83,9 +173,9 @@ impl LogShipper {
         }
     }
 
-    /// One shipping pass: upload every log file whose size changed since its
-    /// last successful upload. Best-effort — failures are logged and retried
-    /// on the next pass (the recorded size stays stale until success).
+    /// One shipping pass: upload what every log file gained since its last
+    /// shipped offset. Best-effort — failures are logged and retried on the
+    /// next pass (the recorded offset only advances past uploaded parts).
     pub async fn run_once(&self) {
         let entries = match std::fs::read_dir(&self.log_dir) {
             Ok(entries) => entries,
@@ -98,6 +188,7 @@ impl LogShipper {
         let mut state = self.read_state();
         let mut shipped = 0u32;
         let mut present: std::collections::HashSet<String> = std::collections::HashSet::new();
+        let mut changed: Vec<(String, PathBuf, String, u64)> = Vec::new();
 
         for entry in entries.flatten() {
             let Ok(file_name) = entry.file_name().into_string() else {
@@ -121,26 +212,89 @@ impl LogShipper {
             if !recently_touched {
                 continue;
             }
-            if state.get(&file_name) == Some(&metadata.len()) {
+            let done = state.entry(file_name.clone()).or_default();
+            if metadata.len() == done.offset {
                 continue;
             }
+            if metadata.len() < done.offset {
+                debug!(
+                    "{} shrank below its shipped offset; shipping it again from the start",
+                    file_name
+                );
+                done.offset = 0;
+            }
+            changed.push((file_name, entry.path(), remote_name, metadata.len()));
+        }
 
-            match self
-                .uploader
-                .upload_log_file(&entry.path(), &remote_name)
-                .await
-            {
-                Ok(uploaded_len) => {
-                    // Record the byte count actually read for upload — if the
-                    // live file grew mid-upload, the size mismatch re-ships it
-                    // next pass.
-                    state.insert(file_name, uploaded_len);
-                    self.write_state(&state);
-                    shipped += 1;
+        // One presign round-trip for every changed file's next part instead of one each.
+        if changed.len() > 1 && !self.plain_text.load(Ordering::Relaxed) {
+            let part_names: Vec<String> = changed
+                .iter()
+                .map(|(file_name, _, remote, _)| part_name(remote, state[file_name].next_part))
+                .collect();
+            self.uploader.prefetch_log_presigns(&part_names).await;
+        }
+
+        // Ship up to the length seen above; whatever is appended meanwhile goes next pass.
+        for (file_name, path, remote_name, len) in changed {
+            let mut done = state[&file_name];
+            while done.offset < len {
+                if self.plain_text.load(Ordering::Relaxed) {
+                    let timer = crate::metrics::metrics().upload_log_file.start();
+                    let uploaded = self.uploader.upload_log_file(&path, &remote_name).await;
+                    drop(timer);
+                    match uploaded {
+                        Ok(uploaded_len) => {
+                            done.offset = uploaded_len;
+                            state.insert(file_name.clone(), done);
+                            self.write_state(&state);
+                            shipped += 1;
+                        }
+                        Err(e) => warn!("Log shipping failed for {}: {:#}", remote_name, e),
+                    }
+                    break;
+                }
+                let max = (len - done.offset).min(MAX_PART_BYTES);
+                let read_path = path.clone();
+                let offset = done.offset;
+                let read =
+                    tokio::task::spawn_blocking(move || read_part(&read_path, offset, max)).await;
+                let (body, raw_len) = match read {
+                    Ok(Ok(part)) => part,
+                    Ok(Err(e)) => {
+                        warn!("Failed to read log part of {}: {}", file_name, e);
+                        break;
+                    }
+                    Err(e) => {
+                        warn!("Log part read task failed for {}: {}", file_name, e);
+                        break;
+                    }
+                };
+                if raw_len == 0 {
+                    break; // truncated under us; next pass sees the new length
                 }
-                Err(e) => {
-                    warn!("Log shipping failed for {}: {:#}", remote_name, e);
+                let name = part_name(&remote_name, done.next_part);
+                let timer = crate::metrics::metrics().upload_log_file.start();
+                let uploaded = self.uploader.upload_log_part(&name, body).await;
+                drop(timer);
+                if let Err(e) = uploaded {
+                    if presign_refused(&e) {
+                        warn!(
+                            "Backend refused compressed log part {} ({:#}); shipping whole \
+                             plain-text logs instead",
+                            name, e
+                        );
+                        self.plain_text.store(true, Ordering::Relaxed);
+                        continue;
+                    }
+                    warn!("Log shipping failed for {}: {:#}", name, e);
+                    break;
                 }
+                done.offset += raw_len;
+                done.next_part += 1;
+                state.insert(file_name.clone(), done);
+                self.write_state(&state);
+                shipped += 1;
             }
         }
 
@@ -159,14 +313,14 @@ impl LogShipper {
         // growing and shipping quiesces; S3 itself is the evidence that
         // shipping works.
         if shipped > 0 {
-            debug!("Shipped {} log file(s) to S3", shipped);
+            debug!("Shipped {} log part(s) to S3", shipped);
         }
     }
 }
 
 #[cfg(test)]
 mod tests {
-    use super::remote_log_name;
+    use super::*;
 
     #[test]
     fn rotated_daily_gets_log_extension() {
@@ -181,10 +335,66 @@ mod tests {
         assert_eq!(remote_log_name("crash.log").as_deref(), Some("crash.log"));
     }
 
+    #[test]
+    fn metrics_snapshot_ships_as_is() {
+        assert_eq!(
+            remote_log_name("metrics-2026-07-22.log").as_deref(),
+            Some("metrics-2026-07-22.log")
+        );
+        assert_eq!(remote_log_name("metrics-.log"), None);
+    }
+
     #[test]
     fn unrelated_files_are_skipped() {
         assert_eq!(remote_log_name("perf-sampler.csv"), None);
         assert_eq!(remote_log_name("crowd-cast.log."), None);
         assert_eq!(remote_log_name("notes.txt"), None);
     }
+
+    #[test]
+    fn legacy_whole_file_state_becomes_the_part_prefix() {
+        let json = r#"{"crash.log":1234,"crowd-cast.log":{"offset":99,"next_part":4}}"#;
+        let stored: HashMap<String, StoredShipped> = serde_json::from_str(json).unwrap();
+        let state: HashMap<String, Shipped> =
+            stored.into_iter().map(|(k, v)| (k, v.into())).collect();
+        assert_eq!(
+            state["crash.log"],
+            Shipped {
+                offset: 1234,
+                next_part: 1
+            }
+        );
+        assert_eq!(
+            state["crowd-cast.log"],
+            Shipped {
+                offset: 99,
+                next_part: 4
+            }
+        );
+    }
+
+    #[test]
+    fn parts_concatenate_back_to_the_file() {
+        let dir = std::env::temp_dir().join(format!("crowd-cast-logparts-{}", std::process::id()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let path = dir.join("crowd-cast.log");
+        let contents: Vec<u8> = (0..10_000u32)
+            .flat_map(|i| format!("line {}\n", i).into_bytes())
+            .collect();
+        std::fs::write(&path, &contents).unwrap();
+
+        let mut stitched = Vec::new();
+        let mut offset = 0;
+        while offset < contents.len() as u64 {
+            let (frame, raw_len) = read_part(&path, offset, 4096).unwrap();
+            assert!(raw_len <= 4096);
+            stitched.extend_from_slice(&frame);
+            offset += raw_len;
+        }
+        let decoded = zstd::stream::decode_all(stitched.as_slice()).unwrap();
+        assert_eq!(decoded, contents);
+        assert_eq!(part_name("crash.log", 7), "crash.log.0007.zst");
+
+        let _ = std::fs::remove_dir_all(&dir);
+    }
 }
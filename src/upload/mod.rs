@@ -2,6 +2,8 @@
 
 mod log_shipper;
 mod presigned;
+mod scheduler;
 
 pub use log_shipper::LogShipper;
 pub use presigned::*;
+pub use scheduler::{TrafficClass, UploadScheduler, UploadStats};
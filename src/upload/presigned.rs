@@ -1,11 +1,26 @@
 //! Pre-signed URL upload implementation
 //!
 //! Supports streaming uploads to minimize RAM usage for large video files.
+//!
+//! Segment video larger than one part goes up as an S3 multipart upload: the
+//! presign endpoint creates the upload and hands out per-part URLs, and every
+//! acknowledged part (its ETag) is persisted to `multipart_uploads.json` beside
+//! the segment store's index. A retry after a dropped connection re-presigns only
+//! the parts that never completed instead of re-sending the whole file.
+//!
+//! A fragmented MP4 only ever grows, so its multipart upload can also start
+//! while the file is still being recorded: [`Uploader::upload_growing_parts`]
+//! sends the whole parts that already exist, and the final [`Uploader::upload`]
+//! resumes that upload with the rest.
 
 use anyhow::{Context, Result};
 use reqwest::{Body, Client};
 use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+use std::time::{Duration, Instant};
 use tokio::fs::File;
+use tokio::io::{AsyncReadExt, AsyncSeekExt};
 use tokio_util::io::ReaderStream;
 use tracing::{debug, error, info, warn};
 
@@ -16,6 +31,8 @@ use crate::auth::AuthManager;
 use crate::config::Config;
 use crate::data::CompletedChunk;
 
+use super::{TrafficClass, UploadScheduler, UploadStats};
+
 /// Request to Lambda endpoint for pre-signed URLs
 #[derive(Debug, Serialize)]
 struct PresignRequest {
@@ -27,7 +44,7 @@ struct PresignRequest {
 }
 
 /// Response from Lambda endpoint with pre-signed URLs
-#[derive(Debug, Deserialize)]
+#[derive(Debug, Clone, Deserialize)]
 struct PresignResponse {
     #[serde(rename = "uploadUrl")]
     upload_url: String,
@@ -36,6 +53,274 @@ struct PresignResponse {
     content_type: String,
 }
 
+/// Request to Lambda endpoint for several pre-signed URLs in one round-trip
+#[derive(Debug, Serialize)]
+struct PresignBatchRequest<'a> {
+    /// Always `presignBatch`
+    action: &'static str,
+    #[serde(rename = "fileNames")]
+    file_names: &'a [String],
+    version: &'a str,
+    #[serde(rename = "userId")]
+    user_id: &'a str,
+}
+
+/// Response to a [`PresignBatchRequest`], one entry per requested file in order
+#[derive(Debug, Deserialize)]
+struct PresignBatchResponse {
+    urls: Vec<PresignResponse>,
+}
+
+/// Consecutive failed batch answers (5xx or a malformed body) after which
+/// batch presigning is skipped for [`BATCH_RETRY_AFTER`]
+const BATCH_FAILURE_LIMIT: u32 = 3;
+const BATCH_RETRY_AFTER: Duration = Duration::from_secs(30 * 60);
+
+/// Whether a batch presign is worth the round-trip against this backend. A
+/// handler that doesn't know the action may answer 400/404 (remembered for
+/// good) or crash into a 5xx; repeated failures of the latter kind back off
+/// so every pass doesn't pay for a failed batch before falling back.
+#[derive(Debug, Default)]
+struct BatchSupport {
+    unsupported: bool,
+    failures: u32,
+    retry_at: Option<Instant>,
+}
+
+impl BatchSupport {
+    fn usable(&self, now: Instant) -> bool {
+        !self.unsupported && self.retry_at.map_or(true, |at| now >= at)
+    }
+
+    fn succeeded(&mut self) {
+        self.failures = 0;
+        self.retry_at = None;
+    }
+
+    /// Record a failed batch answer; `true` when this starts a back-off
+    fn failed(&mut self, now: Instant) -> bool {
+        self.failures += 1;
+        if self.failures < BATCH_FAILURE_LIMIT {
+            return false;
+        }
+        self.retry_at = Some(now + BATCH_RETRY_AFTER);
+        true
+    }
+}
+
+/// How long a prefetched pre-signed URL stays usable. Well under the
+/// backend's URL expiry so a cached URL is never stale by the time its
+/// (possibly multi-minute) upload finishes sending.
+const PRESIGN_CACHE_TTL: Duration = Duration::from_secs(5 * 60);
+
+/// S3 rejects multipart parts smaller than 5 MiB (except the last one).
+const MIN_MULTIPART_PART_SIZE: u64 = 5 * 1024 * 1024;
+
+/// Request to the presign endpoint for one step of a multipart upload. Shares
+/// the endpoint with [`PresignRequest`]; `action` selects the operation.
+#[derive(Debug, Serialize)]
+struct MultipartRequest<'a> {
+    /// `createMultipart`, `presignParts` or `completeMultipart`
+    action: &'static str,
+    #[serde(rename = "fileName")]
+    file_name: &'a str,
+    version: &'a str,
+    #[serde(rename = "userId")]
+    user_id: &'a str,
+    #[serde(rename = "uploadId", skip_serializing_if = "Option::is_none")]
+    upload_id: Option<&'a str>,
+    #[serde(rename = "partNumbers", skip_serializing_if = "Vec::is_empty")]
+    part_numbers: Vec<u32>,
+    #[serde(skip_serializing_if = "Vec::is_empty")]
+    parts: Vec<CompletedPart>,
+}
+
+/// Response to a [`MultipartRequest`]. Every field is optional so a backend
+/// without multipart support (which answers with a plain single-object
+/// presign) is detected by the missing `uploadId` rather than a parse error.
+#[derive(Debug, Deserialize)]
+struct MultipartResponse {
+    #[serde(rename = "uploadId", default)]
+    upload_id: Option<String>,
+    #[serde(default)]
+    key: Option<String>,
+    #[serde(rename = "partUrls", default)]
+    part_urls: Vec<PartUrl>,
+}
+
+/// A pre-signed URL for one part of a multipart upload
+#[derive(Debug, Deserialize)]
+struct PartUrl {
+    #[serde(rename = "partNumber")]
+    part_number: u32,
+    #[serde(rename = "uploadUrl")]
+    upload_url: String,
+}
+
+/// A part S3 has acknowledged, identified by the ETag it returned
+#[derive(Debug, Clone, PartialEq, Eq, Serialize, Deserialize)]
+struct CompletedPart {
+    #[serde(rename = "partNumber")]
+    part_number: u32,
+    etag: String,
+}
+
+/// Progress of one in-flight multipart upload, persisted across retries and
+/// restarts. Keyed by chunk ID in `multipart_uploads.json`.
+#[derive(Debug, Clone, Serialize, Deserialize)]
+struct MultipartState {
+    upload_id: String,
+    key: String,
+    /// Size of the file when the upload was created; a mismatch means the
+    /// local file changed and the saved parts can't be trusted. Zero while the
+    /// file is still growing.
+    file_size: u64,
+    part_size: u64,
+    completed: Vec<CompletedPart>,
+    /// Set for an upload started on a file that was still being recorded (see
+    /// [`Uploader::upload_growing_parts`]): only whole parts were sent, and
+    /// they are kept if the finished file is still at this path.
+    #[serde(default, skip_serializing_if = "Option::is_none")]
+    growing: Option<PathBuf>,
+}
+
+impl MultipartState {
+    /// Whether the saved parts are still valid for `file_size` bytes at `video_path`
+    fn matches(&self, video_path: &Path, file_size: u64, part_size: u64) -> bool {
+        if self.part_size != part_size {
+            return false;
+        }
+        match &self.growing {
+            // Parts sent while growing are whole parts, so they are the same
+            // byte ranges in any file at least as long as they reach
+            Some(path) => {
+                path == video_path
+                    && self
+                        .completed
+                        .iter()
+                        .all(|p| u64::from(p.part_number) * part_size <= file_size)
+            }
+            None => self.file_size == file_size,
+        }
+    }
+}
+
+fn multipart_state_path() -> Option<PathBuf> {
+    directories::ProjectDirs::from("dev", "crowd-cast", "agent")
+        .map(|p| p.data_dir().join("multipart_uploads.json"))
+}
+
+fn read_multipart_states() -> HashMap<String, MultipartState> {
+    multipart_state_path()
+        .and_then(|p| std::fs::read_to_string(&p).ok())
+        .and_then(|s| serde_json::from_str(&s).ok())
+        .unwrap_or_default()
+}
+
+fn write_multipart_states(states: &HashMap<String, MultipartState>) {
+    let Some(path) = multipart_state_path() else {
+        return;
+    };
+    if states.is_empty() {
+        let _ = std::fs::remove_file(&path);
+        return;
+    }
+    if let Some(parent) = path.parent() {
+        let _ = std::fs::create_dir_all(parent);
+    }
+    match serde_json::to_string(states) {
+        Ok(json) => {
+            if let Err(e) = std::fs::write(&path, json) {
+                warn!("Failed to write multipart upload state: {}", e);
+            }
+        }
+        Err(e) => warn!("Failed to serialize multipart upload state: {}", e),
+    }
+}
+
+fn save_multipart_state(chunk_id: &str, state: &MultipartState) {
+    let mut states = read_multipart_states();
+    states.insert(chunk_id.to_string(), state.clone());
+    write_multipart_states(&states);
+}
+
+/// Drop the saved multipart progress for `chunk_id`. Called once the upload
+/// completes, and by the engine when it gives up on a segment. The orphaned
+/// S3 upload (if any) is reaped by the bucket's abort-incomplete lifecycle rule.
+pub fn forget_multipart_upload(chunk_id: &str) {
+    let mut states = read_multipart_states();
+    if states.remove(chunk_id).is_some() {
+        write_multipart_states(&states);
+    }
+}
+
+/// A presign-endpoint request that got an HTTP answer other than success.
+/// Kept as a typed error so callers can tell a definitive refusal from a
+/// transport failure (which surfaces as a plain `reqwest` error).
+#[derive(Debug)]
+struct EndpointRejected {
+    action: &'static str,
+    status: reqwest::StatusCode,
+    body: String,
+}
+
+impl std::fmt::Display for EndpointRejected {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        write!(f, "{} returned HTTP {}", self.action, self.status)
+    }
+}
+
+impl std::error::Error for EndpointRejected {}
+
+impl EndpointRejected {
+    /// Whether the backend refused the request itself (a 4xx). Auth, timeout
+    /// and rate-limit 4xx say nothing about the request and are retried, as
+    /// are 5xx.
+    fn is_refusal(&self) -> bool {
+        use reqwest::StatusCode;
+        self.status.is_client_error()
+            && !matches!(
+                self.status,
+                StatusCode::UNAUTHORIZED
+                    | StatusCode::FORBIDDEN
+                    | StatusCode::REQUEST_TIMEOUT
+                    | StatusCode::TOO_MANY_REQUESTS
+            )
+    }
+
+    /// Whether the backend says the multipart upload itself is gone (aborted,
+    /// expired or never created), so saved progress can't be resumed
+    fn upload_is_gone(&self) -> bool {
+        self.body.contains("NoSuchUpload") || self.is_refusal()
+    }
+}
+
+/// Whether `err` from [`Uploader::request_multipart`] means the saved
+/// multipart upload should be forgotten and started over
+fn multipart_upload_gone(err: &anyhow::Error) -> bool {
+    err.downcast_ref::<EndpointRejected>()
+        .is_some_and(EndpointRejected::upload_is_gone)
+}
+
+/// Whether `err` is the presign endpoint refusing the requested key (e.g. a
+/// backend that doesn't accept its file extension), as opposed to a transient
+/// failure
+pub fn presign_refused(err: &anyhow::Error) -> bool {
+    err.downcast_ref::<EndpointRejected>()
+        .is_some_and(EndpointRejected::is_refusal)
+}
+
+/// Number of parts a file of `file_size` bytes splits into at `part_size`.
+fn part_count(file_size: u64, part_size: u64) -> u32 {
+    file_size.div_ceil(part_size).max(1) as u32
+}
+
+/// Byte range `(offset, len)` of 1-based part `part_number`.
+fn part_range(file_size: u64, part_size: u64, part_number: u32) -> (u64, u64) {
+    let offset = (part_number as u64 - 1) * part_size;
+    (offset, part_size.min(file_size.saturating_sub(offset)))
+}
+
 /// Uploader for completed chunks
 ///
 /// Uses streaming uploads to avoid loading entire video files into RAM.
@@ -43,18 +328,46 @@ struct PresignResponse {
 pub struct Uploader {
     client: Client,
     auth: Option<Arc<Mutex<AuthManager>>>,
+    /// Part size for multipart video uploads, or `None` when multipart is
+    /// disabled in config.
+    multipart_part_size: Option<u64>,
+    /// Pre-signed URLs fetched ahead of their upload, keyed by file name
+    presign_cache: Arc<std::sync::Mutex<HashMap<String, (PresignResponse, Instant)>>>,
+    /// Whether to try batch presigns; presigns go one file at a time once
+    /// the backend has refused or repeatedly failed them.
+    batch: Arc<std::sync::Mutex<BatchSupport>>,
+    scheduler: Arc<UploadScheduler>,
 }
 
 impl Uploader {
     /// Create a new uploader
     pub fn new(config: &Config, auth: Option<Arc<Mutex<AuthManager>>>) -> Self {
-        let _ = config;
+        let multipart_part_size = config.upload.multipart_uploads.then(|| {
+            (config.upload.multipart_part_size_mib * 1024 * 1024).max(MIN_MULTIPART_PART_SIZE)
+        });
         Self {
             client: Client::builder()
                 .connect_timeout(std::time::Duration::from_secs(30))
                 .build()
                 .unwrap_or_else(|_| Client::new()),
             auth,
+            multipart_part_size,
+            presign_cache: Arc::default(),
+            batch: Arc::default(),
+            scheduler: UploadScheduler::new(&config.upload),
+        }
+    }
+
+    /// The backend keys the upload prefix off this version (`uploads/<version>/...`). Explicit
+    /// binary choice, NOT a fallback: a test build (CROWD_CAST_UPLOAD_TEST set) uploads to a
+    /// segregated, deletable `uploads/TEST_VERSION/` prefix; every other build uploads to the
+    /// crate version, which cargo guarantees at compile time (`env!`, not `option_env!`).
+    /// Independent of the auto-updater's version.
+    fn upload_version() -> &'static str {
+        if option_env!("CROWD_CAST_UPLOAD_TEST").is_some() {
+            "TEST_VERSION"
+        } else {
+            env!("CARGO_PKG_VERSION")
         }
     }
 
@@ -120,10 +433,21 @@ impl Uploader {
             req = req.header("Authorization", format!("Bearer {}", token));
         }
 
-        let presign_response: PresignResponse = req
+        let response = req
             .send()
             .await
-            .context("Failed to request pre-signed URL")?
+            .context("Failed to request pre-signed URL")?;
+        if !response.status().is_success() {
+            let status = response.status();
+            let body = response.text().await.unwrap_or_default();
+            return Err(EndpointRejected {
+                action: "presign",
+                status,
+                body,
+            }
+            .into());
+        }
+        let presign_response: PresignResponse = response
             .json()
             .await
             .context("Failed to parse pre-signed URL response")?;
@@ -136,7 +460,10 @@ impl Uploader {
     /// This method streams video files directly from disk to the network,
     /// avoiding the need to load the entire file into RAM. This is critical
     /// for segments that can be several hundred MB.
-    pub async fn upload(&self, chunk: &CompletedChunk) -> Result<()> {
+    ///
+    /// The keylog goes first: it is small, and its PUT latency is the
+    /// scheduler's congestion signal. Returns what the upload measured.
+    pub async fn upload(&self, chunk: &CompletedChunk) -> Result<UploadStats> {
         let endpoint = Self::compile_time_endpoint()
             .context("Lambda endpoint not configured at compile time")?;
 
@@ -144,157 +471,824 @@ impl Uploader {
             "Uploading chunk {} for session {}",
             chunk.chunk_id, chunk.session_id
         );
+        let started = Instant::now();
 
-        // The backend keys the upload prefix off this version (`uploads/<version>/...`). Explicit
-        // binary choice, NOT a fallback: a test build (CROWD_CAST_UPLOAD_TEST set) uploads to a
-        // segregated, deletable `uploads/TEST_VERSION/` prefix; every other build uploads to the
-        // crate version, which cargo guarantees at compile time (`env!`, not `option_env!`).
-        // Independent of the auto-updater's version.
-        let version = if option_env!("CROWD_CAST_UPLOAD_TEST").is_some() {
-            "TEST_VERSION"
-        } else {
-            env!("CARGO_PKG_VERSION")
-        };
+        let version = Self::upload_version();
         let user_id = Self::compute_user_id();
         let auth_token = self.get_auth_token().await;
         let auth_token_ref = auth_token.as_deref();
 
-        // 1. Get pre-signed URL for video (if path is available)
-        let mut video_presign: Option<PresignResponse> = None;
-        let mut video_file_name: Option<String> = None;
+        // 1. Get pre-signed URLs for the keylog and (single-PUT) video in one
+        //    round-trip, or straight from the prefetch cache
+        let keylog_file_name = self.keylog_file_name(chunk);
+        let file_names = self.chunk_presign_file_names(chunk).await?;
+        let mut presigns = self
+            .presign_files(endpoint, &file_names, version, &user_id, auth_token_ref)
+            .await?
+            .into_iter();
+        let keylog_presign = presigns.next().context("Missing keylog pre-signed URL")?;
+        let video_presign = presigns.next();
+        debug!(
+            "Got pre-signed URL for keylogs chunk {} (key: {})",
+            chunk.chunk_id, keylog_presign.key
+        );
 
-        if let Some(ref video_path) = chunk.video_path {
-            let video_file = video_path
-                .file_name()
-                .and_then(|name| name.to_str())
-                .context("Failed to get video filename")?;
-            let file_name = format!("recordings/{}", video_file);
-            let presign_response = self
-                .request_presigned_url(endpoint, &file_name, version, &user_id, auth_token_ref)
-                .await?;
-            debug!(
-                "Got pre-signed URL for video chunk {} (key: {})",
-                chunk.chunk_id, presign_response.key
+        // 2. Upload input log, streamed from the file persisted at rotation
+        let keylog_started = Instant::now();
+        let keylog_path = &chunk.keylog_path;
+        let keylog_file = File::open(keylog_path)
+            .await
+            .with_context(|| format!("Failed to open keylog file: {:?}", keylog_path))?;
+        let input_len = keylog_file
+            .metadata()
+            .await
+            .with_context(|| format!("Failed to get keylog file metadata: {:?}", keylog_path))?
+            .len();
+
+        let keylog_content_type = if keylog_presign.content_type.is_empty() {
+            chunk.keylog_format.content_type()
+        } else {
+            keylog_presign.content_type.as_str()
+        };
+
+        let body = self
+            .scheduler
+            .throttle(ReaderStream::new(keylog_file), TrafficClass::Priority);
+        let response = self
+            .client
+            .put(&keylog_presign.upload_url)
+            .header("Content-Type", keylog_content_type)
+            .header("Content-Length", input_len)
+            .timeout(std::time::Duration::from_secs(30))
+            .body(Body::wrap_stream(body))
+            .send()
+            .await
+            .context("Failed to send keylog upload request")?;
+
+        if !response.status().is_success() {
+            let status = response.status();
+            let body_text = response.text().await.unwrap_or_default();
+            let preview = &body_text[..body_text.len().min(500)];
+            error!(
+                "Keylog upload failed for chunk {}: HTTP {} — {}",
+                chunk.chunk_id, status, preview
             );
-            video_presign = Some(presign_response);
-            video_file_name = Some(file_name);
+            anyhow::bail!("Keylog upload returned HTTP {}", status);
         }
+        crate::metrics::metrics().upload_bytes.add(input_len);
+        let keylog_elapsed = keylog_started.elapsed();
 
-        // 2. Get pre-signed URL for keylogs
-        let keylog_file_name = format!("keylogs/input_{}.msgpack", chunk.chunk_id);
-        let keylog_presign = self
-            .request_presigned_url(
-                endpoint,
-                &keylog_file_name,
-                version,
-                &user_id,
-                auth_token_ref,
-            )
-            .await?;
-        debug!(
-            "Got pre-signed URL for keylogs chunk {} (key: {})",
-            chunk.chunk_id, keylog_presign.key
+        info!(
+            "Uploaded input log for chunk {} ({} events)",
+            chunk.chunk_id, chunk.event_count
         );
 
-        // 3. Upload video file using streaming (if path is available)
+        // 3. Upload video file (if path is available)
+        let mut video_file_name: Option<String> = None;
+        let mut video_len = 0;
         if let Some(ref video_path) = chunk.video_path {
-            let presign = video_presign
-                .as_ref()
-                .context("Missing video pre-signed URL")?;
+            let file_name = Self::video_file_name(video_path)?;
 
-            // Get file size for Content-Length header
+            // Get file size for Content-Length header and part planning
             let metadata = tokio::fs::metadata(video_path)
                 .await
                 .with_context(|| format!("Failed to get video file metadata: {:?}", video_path))?;
             let file_size = metadata.len();
 
-            // Open file and create streaming body
-            let file = File::open(video_path)
-                .await
-                .with_context(|| format!("Failed to open video file: {:?}", video_path))?;
+            let presign = match video_presign {
+                Some(presign) => Some(presign),
+                None => {
+                    let part_size = self
+                        .multipart_part_size
+                        .context("Missing video pre-signed URL")?;
+                    let done = self
+                        .upload_video_multipart(
+                            endpoint,
+                            &chunk.chunk_id,
+                            video_path,
+                            &file_name,
+                            file_size,
+                            part_size,
+                            version,
+                            &user_id,
+                            auth_token_ref,
+                        )
+                        .await?;
+                    if done {
+                        None
+                    } else {
+                        Some(
+                            self.request_presigned_url(
+                                endpoint,
+                                &file_name,
+                                version,
+                                &user_id,
+                                auth_token_ref,
+                            )
+                            .await?,
+                        )
+                    }
+                }
+            };
 
-            // Use ReaderStream to stream the file without loading it all into RAM
-            let stream = ReaderStream::new(file);
-            let body = Body::wrap_stream(stream);
+            if let Some(presign) = presign {
+                debug!(
+                    "Got pre-signed URL for video chunk {} (key: {})",
+                    chunk.chunk_id, presign.key
+                );
+                self.upload_video_single(&chunk.chunk_id, video_path, &presign, file_size)
+                    .await?;
+            }
 
-            let content_type = if presign.content_type.is_empty() {
-                "video/mp4"
-            } else {
-                presign.content_type.as_str()
+            info!(
+                "Uploaded video for chunk {} ({:.2} MB)",
+                chunk.chunk_id,
+                file_size as f64 / (1024.0 * 1024.0)
+            );
+            video_file_name = Some(file_name);
+            video_len = file_size;
+        }
+
+        if let Some(file_name) = video_file_name {
+            debug!("Uploaded video file: {}", file_name);
+        }
+        debug!("Uploaded keylog file: {}", keylog_file_name);
+
+        Ok(UploadStats {
+            bytes: input_len + video_len,
+            elapsed: started.elapsed(),
+            keylog_elapsed,
+        })
+    }
+
+    /// Scheduler pacing this uploader's transfers
+    pub fn scheduler(&self) -> &Arc<UploadScheduler> {
+        &self.scheduler
+    }
+
+    /// Request timeout for a `len`-byte body: `base`, stretched when the
+    /// bandwidth cap alone would need longer
+    fn transfer_timeout(&self, base: Duration, len: u64) -> Duration {
+        match self.scheduler.bandwidth_limit() {
+            Some(rate) => base.max(Duration::from_secs_f64(len as f64 / rate * 2.0)),
+            None => base,
+        }
+    }
+
+    fn keylog_file_name(&self, chunk: &CompletedChunk) -> String {
+        format!(
+            "keylogs/input_{}.{}",
+            chunk.chunk_id,
+            chunk.keylog_format.extension()
+        )
+    }
+
+    fn video_file_name(video_path: &Path) -> Result<String> {
+        let video_file = video_path
+            .file_name()
+            .and_then(|name| name.to_str())
+            .context("Failed to get video filename")?;
+        Ok(format!("recordings/{}", video_file))
+    }
+
+    /// Files of `chunk` that take a plain pre-signed PUT URL: the keylog
+    /// first, then the video unless it goes up as a multipart upload.
+    async fn chunk_presign_file_names(&self, chunk: &CompletedChunk) -> Result<Vec<String>> {
+        let mut file_names = vec![self.keylog_file_name(chunk)];
+        if let Some(ref video_path) = chunk.video_path {
+            let multipart = match self.multipart_part_size {
+                Some(part_size) => tokio::fs::metadata(video_path)
+                    .await
+                    .is_ok_and(|m| m.len() > part_size),
+                None => false,
             };
+            if !multipart {
+                file_names.push(Self::video_file_name(video_path)?);
+            }
+        }
+        Ok(file_names)
+    }
+
+    /// Pre-signed URLs for `file_names`, in order. Served from the prefetch
+    /// cache where possible; the rest are fetched in a single batch request
+    /// (or one by one if the backend has no batch support).
+    async fn presign_files(
+        &self,
+        endpoint: &str,
+        file_names: &[String],
+        version: &str,
+        user_id: &str,
+        auth_token: Option<&str>,
+    ) -> Result<Vec<PresignResponse>> {
+        let mut cached: Vec<Option<PresignResponse>> = {
+            let mut cache = self.presign_cache.lock().unwrap_or_else(|e| e.into_inner());
+            cache.retain(|_, (_, fetched_at)| fetched_at.elapsed() < PRESIGN_CACHE_TTL);
+            file_names
+                .iter()
+                .map(|name| cache.remove(name).map(|(presign, _)| presign))
+                .collect()
+        };
+
+        let missing: Vec<String> = file_names
+            .iter()
+            .zip(&cached)
+            .filter(|(_, hit)| hit.is_none())
+            .map(|(name, _)| name.clone())
+            .collect();
+        if !missing.is_empty() {
+            let mut fetched = self
+                .request_presigned_urls(endpoint, &missing, version, user_id, auth_token)
+                .await?
+                .into_iter();
+            for slot in cached.iter_mut().filter(|slot| slot.is_none()) {
+                *slot = fetched.next();
+            }
+        }
+
+        cached
+            .into_iter()
+            .map(|presign| presign.context("Presign response missing a URL"))
+            .collect()
+    }
 
-            let response = self
+    /// Fetch pre-signed URLs for several files, batched into one POST when the
+    /// backend supports it.
+    async fn request_presigned_urls(
+        &self,
+        endpoint: &str,
+        file_names: &[String],
+        version: &str,
+        user_id: &str,
+        auth_token: Option<&str>,
+    ) -> Result<Vec<PresignResponse>> {
+        let batch_usable = || {
+            self.batch
+                .lock()
+                .unwrap_or_else(|e| e.into_inner())
+                .usable(Instant::now())
+        };
+        if file_names.len() > 1 && batch_usable() {
+            let request = PresignBatchRequest {
+                action: "presignBatch",
+                file_names,
+                version,
+                user_id,
+            };
+            let mut req = self
                 .client
-                .put(&presign.upload_url)
-                .header("Content-Type", content_type)
-                .header("Content-Length", file_size)
-                .timeout(std::time::Duration::from_secs(600))
-                .body(body)
+                .post(endpoint)
+                .json(&request)
+                .timeout(std::time::Duration::from_secs(30));
+            if let Some(token) = auth_token {
+                req = req.header("Authorization", format!("Bearer {}", token));
+            }
+
+            let response = req
                 .send()
                 .await
-                .context("Failed to send video upload request")?;
-
-            if !response.status().is_success() {
-                let status = response.status();
-                let body_text = response.text().await.unwrap_or_default();
-                let preview = &body_text[..body_text.len().min(500)];
-                error!(
-                    "Video upload failed for chunk {}: HTTP {} — {}",
-                    chunk.chunk_id, status, preview
+                .context("Failed to request pre-signed URLs")?;
+            // A 400/404 means a backend that doesn't know the action, and is
+            // remembered. A 5xx or malformed answer counts toward a back-off;
+            // auth and rate-limit answers say nothing about batch support.
+            let status = response.status();
+            let failed = if status.is_success() {
+                match response.json::<PresignBatchResponse>().await {
+                    Ok(batch) if batch.urls.len() == file_names.len() => {
+                        self.batch
+                            .lock()
+                            .unwrap_or_else(|e| e.into_inner())
+                            .succeeded();
+                        return Ok(batch.urls);
+                    }
+                    Ok(_) => warn!("Batch presign returned the wrong number of URLs"),
+                    Err(e) => warn!("Failed to parse batch presign response: {}", e),
+                }
+                true
+            } else if matches!(
+                status,
+                reqwest::StatusCode::BAD_REQUEST | reqwest::StatusCode::NOT_FOUND
+            ) {
+                debug!("Presign endpoint has no batch support, presigning files one by one");
+                self.batch
+                    .lock()
+                    .unwrap_or_else(|e| e.into_inner())
+                    .unsupported = true;
+                false
+            } else {
+                debug!("Batch presign got HTTP {}, presigning one by one", status);
+                status.is_server_error()
+            };
+            if failed
+                && self
+                    .batch
+                    .lock()
+                    .unwrap_or_else(|e| e.into_inner())
+                    .failed(Instant::now())
+            {
+                warn!(
+                    "Batch presign failed {} times in a row, presigning one by one for {} min",
+                    BATCH_FAILURE_LIMIT,
+                    BATCH_RETRY_AFTER.as_secs() / 60
                 );
-                anyhow::bail!("Video upload returned HTTP {}", status);
             }
+        }
 
-            info!(
-                "Uploaded video for chunk {} ({:.2} MB)",
-                chunk.chunk_id,
-                file_size as f64 / (1024.0 * 1024.0)
+        let mut presigns = Vec::with_capacity(file_names.len());
+        for file_name in file_names {
+            presigns.push(
+                self.request_presigned_url(endpoint, file_name, version, user_id, auth_token)
+                    .await?,
             );
         }
+        Ok(presigns)
+    }
 
-        // 4. Upload input log (small enough to fit in RAM)
-        let input_bytes =
-            rmp_serde::to_vec(&chunk.events).context("Failed to serialize input events")?;
+    /// Fetch pre-signed URLs for `file_names` in one batch and cache them for
+    /// the uploads that follow. Failures are only logged — each upload then
+    /// presigns for itself.
+    async fn prefetch_presigned(&self, file_names: Vec<String>) {
+        let Some(endpoint) = Self::compile_time_endpoint() else {
+            return;
+        };
+        let missing: Vec<String> = {
+            let cache = self.presign_cache.lock().unwrap_or_else(|e| e.into_inner());
+            file_names
+                .into_iter()
+                .filter(|name| {
+                    cache
+                        .get(name)
+                        .map_or(true, |(_, fetched_at)| fetched_at.elapsed() >= PRESIGN_CACHE_TTL)
+                })
+                .collect()
+        };
+        if missing.is_empty() {
+            return;
+        }
 
-        let keylog_content_type = if keylog_presign.content_type.is_empty() {
-            "application/msgpack"
+        let user_id = Self::compute_user_id();
+        let auth_token = self.get_auth_token().await;
+        match self
+            .request_presigned_urls(
+                endpoint,
+                &missing,
+                Self::upload_version(),
+                &user_id,
+                auth_token.as_deref(),
+            )
+            .await
+        {
+            Ok(presigns) => {
+                let now = Instant::now();
+                let mut cache = self.presign_cache.lock().unwrap_or_else(|e| e.into_inner());
+                for (name, presign) in missing.into_iter().zip(presigns) {
+                    cache.insert(name, (presign, now));
+                }
+            }
+            Err(e) => debug!("Presign prefetch failed: {:#}", e),
+        }
+    }
+
+    /// Presign every file of `chunks` ahead of their uploads (e.g. a burst of
+    /// retries coming due together), so each upload starts without its own
+    /// presign round-trip.
+    pub async fn prefetch_chunk_presigns(&self, chunks: &[&CompletedChunk]) {
+        let mut file_names = Vec::new();
+        for chunk in chunks {
+            match self.chunk_presign_file_names(chunk).await {
+                Ok(names) => file_names.extend(names),
+                Err(e) => debug!("Skipping presign prefetch for {}: {:#}", chunk.chunk_id, e),
+            }
+        }
+        self.prefetch_presigned(file_names).await;
+    }
+
+    /// Presign a set of log files (by remote name) ahead of
+    /// [`Self::upload_log_part`] calls for them.
+    pub async fn prefetch_log_presigns(&self, remote_names: &[String]) {
+        self.prefetch_presigned(
+            remote_names
+                .iter()
+                .map(|name| format!("logs/{}", name))
+                .collect(),
+        )
+        .await;
+    }
+
+    /// Upload a video file with a single streaming PUT
+    async fn upload_video_single(
+        &self,
+        chunk_id: &str,
+        video_path: &Path,
+        presign: &PresignResponse,
+        file_size: u64,
+    ) -> Result<()> {
+        // Open file and create streaming body
+        let file = File::open(video_path)
+            .await
+            .with_context(|| format!("Failed to open video file: {:?}", video_path))?;
+
+        // Use ReaderStream to stream the file without loading it all into RAM
+        let stream = ReaderStream::new(file);
+        let body = Body::wrap_stream(self.scheduler.throttle(stream, TrafficClass::Bulk));
+
+        let content_type = if presign.content_type.is_empty() {
+            "video/mp4"
         } else {
-            keylog_presign.content_type.as_str()
+            presign.content_type.as_str()
         };
 
         let response = self
             .client
-            .put(&keylog_presign.upload_url)
-            .header("Content-Type", keylog_content_type)
-            .timeout(std::time::Duration::from_secs(30))
-            .body(input_bytes)
+            .put(&presign.upload_url)
+            .header("Content-Type", content_type)
+            .header("Content-Length", file_size)
+            .timeout(self.transfer_timeout(Duration::from_secs(600), file_size))
+            .body(body)
             .send()
             .await
-            .context("Failed to send keylog upload request")?;
+            .context("Failed to send video upload request")?;
 
         if !response.status().is_success() {
             let status = response.status();
             let body_text = response.text().await.unwrap_or_default();
             let preview = &body_text[..body_text.len().min(500)];
             error!(
-                "Keylog upload failed for chunk {}: HTTP {} — {}",
-                chunk.chunk_id, status, preview
+                "Video upload failed for chunk {}: HTTP {} — {}",
+                chunk_id, status, preview
             );
-            anyhow::bail!("Keylog upload returned HTTP {}", status);
+            anyhow::bail!("Video upload returned HTTP {}", status);
         }
+        crate::metrics::metrics().upload_bytes.add(file_size);
 
-        info!(
-            "Uploaded input log for chunk {} ({} events)",
-            chunk.chunk_id,
-            chunk.events.len()
+        Ok(())
+    }
+
+    /// Send one step of a multipart upload to the presign endpoint
+    async fn request_multipart(
+        &self,
+        endpoint: &str,
+        request: &MultipartRequest<'_>,
+        auth_token: Option<&str>,
+    ) -> Result<MultipartResponse> {
+        let mut req = self
+            .client
+            .post(endpoint)
+            .json(request)
+            .timeout(std::time::Duration::from_secs(30));
+        if let Some(token) = auth_token {
+            req = req.header("Authorization", format!("Bearer {}", token));
+        }
+
+        let response = req
+            .send()
+            .await
+            .with_context(|| format!("Failed to send {} request", request.action))?;
+        if !response.status().is_success() {
+            let status = response.status();
+            let body_text = response.text().await.unwrap_or_default();
+            let preview = &body_text[..body_text.len().min(500)];
+            warn!("{} failed: HTTP {} — {}", request.action, status, preview);
+            return Err(EndpointRejected {
+                action: request.action,
+                status,
+                body: body_text,
+            }
+            .into());
+        }
+
+        response
+            .json()
+            .await
+            .with_context(|| format!("Failed to parse {} response", request.action))
+    }
+
+    /// Upload a video file as an S3 multipart upload, resuming from any parts
+    /// persisted by an earlier attempt.
+    ///
+    /// Returns `Ok(false)` when the backend doesn't support multipart uploads;
+    /// the caller then falls back to a single streaming PUT.
+    #[allow(clippy::too_many_arguments)]
+    async fn upload_video_multipart(
+        &self,
+        endpoint: &str,
+        chunk_id: &str,
+        video_path: &Path,
+        file_name: &str,
+        file_size: u64,
+        part_size: u64,
+        version: &str,
+        user_id: &str,
+        auth_token: Option<&str>,
+    ) -> Result<bool> {
+        let total_parts = part_count(file_size, part_size);
+
+        // Resume only if the saved upload matches the file on disk.
+        let saved = read_multipart_states().remove(chunk_id).filter(|state| {
+            let matches = state.matches(video_path, file_size, part_size);
+            if !matches {
+                debug!(
+                    "Discarding stale multipart state for chunk {} (file or part size changed)",
+                    chunk_id
+                );
+            }
+            matches
+        });
+
+        let (mut state, part_urls) = match saved {
+            Some(mut state) => {
+                // The file has stopped growing; pin its final size
+                state.file_size = file_size;
+                state.growing = None;
+                let pending: Vec<u32> = (1..=total_parts)
+                    .filter(|n| !state.completed.iter().any(|p| p.part_number == *n))
+                    .collect();
+                let request = MultipartRequest {
+                    action: "presignParts",
+                    file_name,
+                    version,
+                    user_id,
+                    upload_id: Some(&state.upload_id),
+                    part_numbers: pending.clone(),
+                    parts: Vec::new(),
+                };
+                let response = if pending.is_empty() {
+                    None
+                } else {
+                    match self.request_multipart(endpoint, &request, auth_token).await {
+                        Ok(response) => Some(response),
+                        Err(e) => {
+                            // Start over on the next attempt only if the upload
+                            // was aborted or expired server-side; a dropped
+                            // connection or 5xx resumes the same upload.
+                            if multipart_upload_gone(&e) {
+                                forget_multipart_upload(chunk_id);
+                            }
+                            return Err(e.context("Failed to resume multipart upload"));
+                        }
+                    }
+                };
+                info!(
+                    "Resuming multipart upload for chunk {} ({}/{} parts done)",
+                    chunk_id,
+                    state.completed.len(),
+                    total_parts
+                );
+                (state, response.map(|r| r.part_urls).unwrap_or_default())
+            }
+            None => {
+                let request = MultipartRequest {
+                    action: "createMultipart",
+                    file_name,
+                    version,
+                    user_id,
+                    upload_id: None,
+                    part_numbers: (1..=total_parts).collect(),
+                    parts: Vec::new(),
+                };
+                let response = self.request_multipart(endpoint, &request, auth_token).await?;
+                let (Some(upload_id), Some(key)) = (response.upload_id, response.key) else {
+                    debug!("Presign endpoint has no multipart support, using single PUT");
+                    return Ok(false);
+                };
+                debug!(
+                    "Created multipart upload for chunk {} (key: {}, {} parts)",
+                    chunk_id, key, total_parts
+                );
+                let state = MultipartState {
+                    upload_id,
+                    key,
+                    file_size,
+                    part_size,
+                    completed: Vec::new(),
+                    growing: None,
+                };
+                save_multipart_state(chunk_id, &state);
+                (state, response.part_urls)
+            }
+        };
+
+        for part in part_urls {
+            if part.part_number == 0 || part.part_number > total_parts {
+                anyhow::bail!("Presign endpoint returned invalid part number {}", part.part_number);
+            }
+            let (offset, len) = part_range(file_size, part_size, part.part_number);
+            let etag = self
+                .upload_part(chunk_id, video_path, &part, offset, len)
+                .await?;
+            state.completed.push(CompletedPart {
+                part_number: part.part_number,
+                etag,
+            });
+            // Persist after every part so a dropped connection only costs
+            // the part in flight.
+            save_multipart_state(chunk_id, &state);
+        }
+
+        if state.completed.len() != total_parts as usize {
+            anyhow::bail!(
+                "Multipart upload for chunk {} incomplete ({}/{} parts)",
+                chunk_id,
+                state.completed.len(),
+                total_parts
+            );
+        }
+
+        state.completed.sort_by_key(|p| p.part_number);
+        let request = MultipartRequest {
+            action: "completeMultipart",
+            file_name,
+            version,
+            user_id,
+            upload_id: Some(&state.upload_id),
+            part_numbers: Vec::new(),
+            parts: state.completed.clone(),
+        };
+        self.request_multipart(endpoint, &request, auth_token)
+            .await
+            .context("Failed to complete multipart upload")?;
+        forget_multipart_upload(chunk_id);
+
+        debug!(
+            "Completed multipart upload for chunk {} ({} parts)",
+            chunk_id, total_parts
         );
+        Ok(true)
+    }
 
-        if let Some(file_name) = video_file_name {
-            debug!("Uploaded video file: {}", file_name);
+    /// Stream one byte range of the video file to a part URL, returning the
+    /// ETag S3 assigned to it.
+    async fn upload_part(
+        &self,
+        chunk_id: &str,
+        video_path: &Path,
+        part: &PartUrl,
+        offset: u64,
+        len: u64,
+    ) -> Result<String> {
+        let mut file = File::open(video_path)
+            .await
+            .with_context(|| format!("Failed to open video file: {:?}", video_path))?;
+        file.seek(std::io::SeekFrom::Start(offset))
+            .await
+            .context("Failed to seek to part offset")?;
+        let body = Body::wrap_stream(
+            self.scheduler
+                .throttle(ReaderStream::new(file.take(len)), TrafficClass::Bulk),
+        );
+
+        let response = self
+            .client
+            .put(&part.upload_url)
+            .header("Content-Length", len)
+            .timeout(self.transfer_timeout(Duration::from_secs(300), len))
+            .body(body)
+            .send()
+            .await
+            .context("Failed to send video part upload request")?;
+
+        if !response.status().is_success() {
+            let status = response.status();
+            let body_text = response.text().await.unwrap_or_default();
+            let preview = &body_text[..body_text.len().min(500)];
+            error!(
+                "Video part {} upload failed for chunk {}: HTTP {} — {}",
+                part.part_number, chunk_id, status, preview
+            );
+            anyhow::bail!("Video part upload returned HTTP {}", status);
         }
-        debug!("Uploaded keylog file: {}", keylog_file_name);
+        crate::metrics::metrics().upload_bytes.add(len);
 
-        Ok(())
+        response
+            .headers()
+            .get("ETag")
+            .and_then(|v| v.to_str().ok())
+            .map(str::to_string)
+            .context("Video part upload response missing ETag")
+    }
+
+    /// Start (or continue) the multipart upload of a video that is still being
+    /// recorded, sending the whole parts within its first `ready_len` bytes.
+    /// The caller only passes a length the file is known to have reached, and
+    /// must not run this concurrently with [`Self::upload`] for the same chunk.
+    ///
+    /// Returns the bytes now uploaded from the start of the file; 0 when
+    /// multipart uploads are off or the backend doesn't support them.
+    pub async fn upload_growing_parts(
+        &self,
+        chunk_id: &str,
+        video_path: &Path,
+        ready_len: u64,
+    ) -> Result<u64> {
+        let Some(part_size) = self.multipart_part_size else {
+            return Ok(0);
+        };
+        let endpoint = Self::compile_time_endpoint()
+            .context("Lambda endpoint not configured at compile time")?;
+        let ready_parts = (ready_len / part_size) as u32;
+        if ready_parts == 0 {
+            return Ok(0);
+        }
+
+        let version = Self::upload_version();
+        let user_id = Self::compute_user_id();
+        let auth_token = self.get_auth_token().await;
+        let auth_token_ref = auth_token.as_deref();
+        let file_name = Self::video_file_name(video_path)?;
+
+        let saved = read_multipart_states()
+            .remove(chunk_id)
+            .filter(|state| state.growing.as_deref() == Some(video_path))
+            .filter(|state| state.part_size == part_size);
+        let (mut state, part_urls) = match saved {
+            Some(state) => {
+                let pending: Vec<u32> = (1..=ready_parts)
+                    .filter(|n| !state.completed.iter().any(|p| p.part_number == *n))
+                    .collect();
+                if pending.is_empty() {
+                    return Ok(state.completed.len() as u64 * part_size);
+                }
+                let request = MultipartRequest {
+                    action: "presignParts",
+                    file_name: &file_name,
+                    version,
+                    user_id: &user_id,
+                    upload_id: Some(&state.upload_id),
+                    part_numbers: pending,
+                    parts: Vec::new(),
+                };
+                let response = match self
+                    .request_multipart(endpoint, &request, auth_token_ref)
+                    .await
+                {
+                    Ok(response) => response,
+                    Err(e) => {
+                        // Same rule as the final upload's resume: only a
+                        // definitive answer means starting over
+                        if multipart_upload_gone(&e) {
+                            forget_multipart_upload(chunk_id);
+                        }
+                        return Err(e.context("Failed to continue multipart upload"));
+                    }
+                };
+                (state, response.part_urls)
+            }
+            None => {
+                let request = MultipartRequest {
+                    action: "createMultipart",
+                    file_name: &file_name,
+                    version,
+                    user_id: &user_id,
+                    upload_id: None,
+                    part_numbers: (1..=ready_parts).collect(),
+                    parts: Vec::new(),
+                };
+                let response = self
+                    .request_multipart(endpoint, &request, auth_token_ref)
+                    .await?;
+                let (Some(upload_id), Some(key)) = (response.upload_id, response.key) else {
+                    debug!("Presign endpoint has no multipart support, not uploading early");
+                    return Ok(0);
+                };
+                debug!(
+                    "Created multipart upload for recording chunk {} (key: {})",
+                    chunk_id, key
+                );
+                let state = MultipartState {
+                    upload_id,
+                    key,
+                    file_size: 0,
+                    part_size,
+                    completed: Vec::new(),
+                    growing: Some(video_path.to_path_buf()),
+                };
+                save_multipart_state(chunk_id, &state);
+                (state, response.part_urls)
+            }
+        };
+
+        for part in part_urls {
+            if part.part_number == 0 || part.part_number > ready_parts {
+                anyhow::bail!(
+                    "Presign endpoint returned invalid part number {}",
+                    part.part_number
+                );
+            }
+            let offset = u64::from(part.part_number - 1) * part_size;
+            let etag = self
+                .upload_part(chunk_id, video_path, &part, offset, part_size)
+                .await?;
+            state.completed.push(CompletedPart {
+                part_number: part.part_number,
+                etag,
+            });
+            save_multipart_state(chunk_id, &state);
+        }
+        debug!(
+            "Uploaded {} part(s) of recording chunk {} early",
+            state.completed.len(),
+            chunk_id
+        );
+        Ok(state.completed.len() as u64 * part_size)
     }
 
     /// Check if uploader is configured
@@ -302,34 +1296,85 @@ impl Uploader {
         Self::compile_time_endpoint().is_some()
     }
 
-    /// Upload an app log file under the `logs/` sub-prefix
-    /// (`uploads/<version>/<user>/logs/<remote_name>`), so participant
-    /// issues can be debugged without manually collecting log files.
-    ///
-    /// Returns the number of bytes uploaded — the caller records it and
-    /// re-ships the file when its size changes (see `LogShipper`).
-    pub async fn upload_log_file(
-        &self,
-        local_path: &std::path::Path,
-        remote_name: &str,
-    ) -> Result<u64> {
+    /// Upload one compressed part of an app log file under the `logs/`
+    /// sub-prefix (`uploads/<version>/<user>/logs/<remote_name>`), so
+    /// participant issues can be debugged without manually collecting log
+    /// files. The caller tracks which byte range the part covers (see
+    /// `LogShipper`).
+    pub async fn upload_log_part(&self, remote_name: &str, body: Vec<u8>) -> Result<()> {
         let endpoint = Self::compile_time_endpoint()
             .context("Lambda endpoint not configured at compile time")?;
 
-        // Same explicit version choice as chunk uploads: test builds go to
-        // the segregated TEST_VERSION prefix, everything else to the crate
-        // version.
-        let version = if option_env!("CROWD_CAST_UPLOAD_TEST").is_some() {
-            "TEST_VERSION"
+        let version = Self::upload_version();
+        let user_id = Self::compute_user_id();
+        let auth_token = self.get_auth_token().await;
+
+        let file_name = format!("logs/{}", remote_name);
+        let presign = self
+            .presign_files(
+                endpoint,
+                std::slice::from_ref(&file_name),
+                version,
+                &user_id,
+                auth_token.as_deref(),
+            )
+            .await?
+            .remove(0);
+        debug!("Got pre-signed URL for log part (key: {})", presign.key);
+
+        let body_len = body.len() as u64;
+        let content_type = if presign.content_type.is_empty() {
+            "application/zstd"
         } else {
-            env!("CARGO_PKG_VERSION")
+            presign.content_type.as_str()
         };
+
+        let response = self
+            .client
+            .put(&presign.upload_url)
+            .header("Content-Type", content_type)
+            .timeout(std::time::Duration::from_secs(60))
+            .body(body)
+            .send()
+            .await
+            .context("Failed to send log upload request")?;
+
+        if !response.status().is_success() {
+            let status = response.status();
+            let body_text = response.text().await.unwrap_or_default();
+            let preview = &body_text[..body_text.len().min(500)];
+            warn!(
+                "Log upload failed for {}: HTTP {} — {}",
+                remote_name, status, preview
+            );
+            anyhow::bail!("Log upload returned HTTP {}", status);
+        }
+        crate::metrics::metrics().upload_bytes.add(body_len);
+
+        Ok(())
+    }
+
+    /// Upload a whole app log file as plain text to
+    /// `uploads/<version>/<user>/logs/<remote_name>`, overwriting the previous
+    /// upload. The fallback for backends that don't accept compressed parts;
+    /// returns the number of bytes uploaded.
+    pub async fn upload_log_file(&self, local_path: &Path, remote_name: &str) -> Result<u64> {
+        let endpoint = Self::compile_time_endpoint()
+            .context("Lambda endpoint not configured at compile time")?;
+
+        let version = Self::upload_version();
         let user_id = Self::compute_user_id();
         let auth_token = self.get_auth_token().await;
 
         let file_name = format!("logs/{}", remote_name);
         let presign = self
-            .request_presigned_url(endpoint, &file_name, version, &user_id, auth_token.as_deref())
+            .request_presigned_url(
+                endpoint,
+                &file_name,
+                version,
+                &user_id,
+                auth_token.as_deref(),
+            )
             .await?;
         debug!("Got pre-signed URL for log file (key: {})", presign.key);
 
@@ -359,9 +1404,13 @@ impl Uploader {
             let status = response.status();
             let body_text = response.text().await.unwrap_or_default();
             let preview = &body_text[..body_text.len().min(500)];
-            warn!("Log upload failed for {}: HTTP {} — {}", remote_name, status, preview);
+            warn!(
+                "Log upload failed for {}: HTTP {} — {}",
+                remote_name, status, preview
+            );
             anyhow::bail!("Log upload returned HTTP {}", status);
         }
+        crate::metrics::metrics().upload_bytes.add(uploaded_len);
 
         Ok(uploaded_len)
     }
@@ -384,4 +1433,154 @@ mod tests {
         assert!(json.contains("0.0.1"));
         assert!(json.contains("test-user"));
     }
+
+    #[test]
+    fn growing_parts_stay_valid_for_the_finished_file() {
+        let part_size = MIN_MULTIPART_PART_SIZE;
+        let path = Path::new("/rec/recording_a.mp4");
+        let state = MultipartState {
+            upload_id: "u".into(),
+            key: "k".into(),
+            file_size: 0,
+            part_size,
+            completed: vec![CompletedPart {
+                part_number: 2,
+                etag: "e".into(),
+            }],
+            growing: Some(path.to_path_buf()),
+        };
+        assert!(state.matches(path, 2 * part_size + 7, part_size));
+        assert!(
+            !state.matches(path, 2 * part_size - 1, part_size),
+            "file shrank"
+        );
+        assert!(!state.matches(Path::new("/rec/other.mp4"), 3 * part_size, part_size));
+        assert!(!state.matches(path, 3 * part_size, 2 * part_size));
+    }
+
+    #[test]
+    fn only_definitive_rejections_forget_multipart_state() {
+        let rejected = |status: u16, body: &str| -> anyhow::Error {
+            EndpointRejected {
+                action: "presignParts",
+                status: reqwest::StatusCode::from_u16(status).unwrap(),
+                body: body.to_string(),
+            }
+            .into()
+        };
+        assert!(multipart_upload_gone(&rejected(404, "")));
+        assert!(multipart_upload_gone(&rejected(400, "upload id expired")));
+        assert!(multipart_upload_gone(&rejected(500, "NoSuchUpload")));
+        assert!(!multipart_upload_gone(&rejected(503, "Slow Down")));
+        assert!(!multipart_upload_gone(&rejected(429, "")));
+        assert!(!multipart_upload_gone(&rejected(401, "")));
+        assert!(!multipart_upload_gone(
+            &anyhow::anyhow!("connection reset").context("Failed to send presignParts request")
+        ));
+        // Context added on the way up doesn't hide the rejection
+        assert!(multipart_upload_gone(&rejected(404, "").context("resume")));
+    }
+
+    #[test]
+    fn presign_refusal_excludes_transient_statuses() {
+        let rejected = |status: u16| -> anyhow::Error {
+            EndpointRejected {
+                action: "presign",
+                status: reqwest::StatusCode::from_u16(status).unwrap(),
+                body: String::new(),
+            }
+            .into()
+        };
+        assert!(presign_refused(&rejected(400)));
+        assert!(!presign_refused(&rejected(403)));
+        assert!(!presign_refused(&rejected(502)));
+        assert!(!presign_refused(&anyhow::anyhow!("timed out")));
+    }
+
+    #[test]
+    fn repeated_batch_failures_back_off() {
+        let start = Instant::now();
+        let mut batch = BatchSupport::default();
+        assert!(!batch.failed(start));
+        assert!(!batch.failed(start));
+        assert!(batch.usable(start));
+        assert!(batch.failed(start));
+        assert!(!batch.usable(start));
+        // One retry after the back-off; another failure backs off again
+        let later = start + BATCH_RETRY_AFTER;
+        assert!(batch.usable(later));
+        assert!(batch.failed(later));
+        assert!(!batch.usable(later));
+        batch.succeeded();
+        assert!(batch.usable(later));
+        batch.unsupported = true;
+        assert!(!batch.usable(later + BATCH_RETRY_AFTER));
+    }
+
+    #[test]
+    fn test_part_ranges_cover_file() {
+        let part_size = 16 * 1024 * 1024;
+        let file_size = 3 * part_size + 1234;
+        assert_eq!(part_count(file_size, part_size), 4);
+        assert_eq!(part_range(file_size, part_size, 1), (0, part_size));
+        assert_eq!(part_range(file_size, part_size, 4), (3 * part_size, 1234));
+        let total: u64 = (1..=4).map(|n| part_range(file_size, part_size, n).1).sum();
+        assert_eq!(total, file_size);
+
+        // Exact multiple: no empty trailing part
+        assert_eq!(part_count(2 * part_size, part_size), 2);
+    }
+
+    #[test]
+    fn test_multipart_request_serialization() {
+        let request = MultipartRequest {
+            action: "completeMultipart",
+            file_name: "recordings/test.mp4",
+            version: "0.0.1",
+            user_id: "test-user",
+            upload_id: Some("abc"),
+            part_numbers: Vec::new(),
+            parts: vec![CompletedPart {
+                part_number: 1,
+                etag: "\"e1\"".to_string(),
+            }],
+        };
+        let json = serde_json::to_string(&request).unwrap();
+        assert!(json.contains("\"uploadId\":\"abc\""));
+        assert!(json.contains("\"partNumber\":1"));
+        assert!(!json.contains("partNumbers"));
+
+        // An old backend answers with a plain presign: no uploadId → fallback
+        let response: MultipartResponse =
+            serde_json::from_str(r#"{"uploadUrl":"u","key":"k","contentType":"video/mp4"}"#)
+                .unwrap();
+        assert!(response.upload_id.is_none());
+    }
+
+    #[tokio::test]
+    async fn test_presign_files_served_from_cache() {
+        let uploader = Uploader::new(&Config::default(), None);
+        let names = vec!["keylogs/input_a.msgpack".to_string(), "logs/x.log".to_string()];
+        {
+            let mut cache = uploader.presign_cache.lock().unwrap();
+            for name in &names {
+                let presign = PresignResponse {
+                    upload_url: format!("https://example.invalid/{}", name),
+                    key: name.clone(),
+                    content_type: String::new(),
+                };
+                cache.insert(name.clone(), (presign, Instant::now()));
+            }
+        }
+
+        // Every name is cached, so no request goes to the (unreachable) endpoint
+        let presigns = uploader
+            .presign_files("http://127.0.0.1:9/", &names, "0.0.1", "u", None)
+            .await
+            .unwrap();
+        let keys: Vec<&str> = presigns.iter().map(|p| p.key.as_str()).collect();
+        assert_eq!(keys, ["keylogs/input_a.msgpack", "logs/x.log"]);
+        // Cached URLs are single-use
+        assert!(uploader.presign_cache.lock().unwrap().is_empty());
+    }
 }